@@ -0,0 +1,209 @@
+#include "AssetDependencyGraph.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+std::string AssetDependencyGraph::normalize(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+std::vector<std::string> AssetDependencyGraph::parseIncludes(const char* pText, size_t size)
+{
+    std::vector<std::string> includes;
+
+    const char* p = pText;
+    const char* pEnd = pText + size;
+    bool lineStart = true;
+    while (p < pEnd)
+    {
+        char c = *p;
+        if (c == '\n')
+        {
+            lineStart = true;
+            ++p;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r')
+        {
+            ++p;
+            continue;
+        }
+
+        // Comments, a block comment may hide a whole #include line
+        if (c == '/' && p + 1 < pEnd && p[1] == '/')
+        {
+            while (p < pEnd && *p != '\n')
+            {
+                ++p;
+            }
+            continue;
+        }
+        if (c == '/' && p + 1 < pEnd && p[1] == '*')
+        {
+            p += 2;
+            while (p + 1 < pEnd && !(p[0] == '*' && p[1] == '/'))
+            {
+                ++p;
+            }
+            p = (std::min)(p + 2, pEnd);
+            continue;
+        }
+
+        if (c == '#' && lineStart)
+        {
+            ++p;
+            while (p < pEnd && (*p == ' ' || *p == '\t'))
+            {
+                ++p;
+            }
+            static const char Directive[] = "include";
+            const size_t directiveLength = sizeof(Directive) - 1;
+            if ((size_t)(pEnd - p) > directiveLength && std::equal(Directive, Directive + directiveLength, p))
+            {
+                p += directiveLength;
+                while (p < pEnd && (*p == ' ' || *p == '\t'))
+                {
+                    ++p;
+                }
+                if (p < pEnd && (*p == '"' || *p == '<'))
+                {
+                    char close = *p == '"' ? '"' : '>';
+                    const char* pName = ++p;
+                    while (p < pEnd && *p != close && *p != '\n')
+                    {
+                        ++p;
+                    }
+                    if (p < pEnd && *p == close && p > pName)
+                    {
+                        includes.emplace_back(pName, p);
+                    }
+                }
+            }
+        }
+
+        // Rest of the line can't start a directive
+        lineStart = false;
+        while (p < pEnd && *p != '\n' && !(p[0] == '/' && p + 1 < pEnd && (p[1] == '/' || p[1] == '*')))
+        {
+            ++p;
+        }
+    }
+
+    return includes;
+}
+
+void AssetDependencyGraph::addAsset(const std::string& path, bool scanIncludes)
+{
+    std::string file = normalize(path);
+    m_assets.insert(file);
+    if (scanIncludes)
+    {
+        scan(file);
+    }
+    else
+    {
+        m_binaryAssets.insert(file);
+        m_includes.emplace(file, std::vector<std::string>());
+    }
+}
+
+void AssetDependencyGraph::rescan(const std::string& path)
+{
+    std::string file = normalize(path);
+    // Binary assets have nothing to rescan, and files nobody includes don't matter
+    if (m_binaryAssets.count(file) != 0 || m_includes.count(file) == 0)
+    {
+        return;
+    }
+    scan(file);
+}
+
+void AssetDependencyGraph::setIncludes(const std::string& path, const std::vector<std::string>& includes)
+{
+    link(normalize(path), includes);
+}
+
+void AssetDependencyGraph::scan(const std::string& file)
+{
+    std::ifstream stream(std::filesystem::path(file), std::ios::binary);
+    std::vector<char> text((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    std::vector<std::string> includes = parseIncludes(text.data(), text.size());
+
+    link(file, includes);
+
+    // A copy, scanning the includes adds to m_includes
+    std::vector<std::string> normalized = m_includes[file];
+    for (const std::string& include : normalized)
+    {
+        // Cycles and diamonds stop at files already read
+        if (m_includes.count(include) == 0)
+        {
+            scan(include);
+        }
+    }
+}
+
+void AssetDependencyGraph::link(const std::string& file, const std::vector<std::string>& includes)
+{
+    std::vector<std::string>& current = m_includes[file];
+    for (const std::string& include : current)
+    {
+        m_includedBy[include].erase(file);
+    }
+
+    current.clear();
+    for (const std::string& include : includes)
+    {
+        std::string normalized = normalize(include);
+        if (std::find(current.begin(), current.end(), normalized) == current.end())
+        {
+            current.push_back(normalized);
+            m_includedBy[normalized].insert(file);
+        }
+    }
+}
+
+std::vector<std::string> AssetDependencyGraph::affectedAssets(const std::string& path) const
+{
+    std::vector<std::string> affected;
+
+    std::unordered_set<std::string> visited;
+    std::vector<std::string> stack = { normalize(path) };
+    while (!stack.empty())
+    {
+        std::string file = std::move(stack.back());
+        stack.pop_back();
+        if (!visited.insert(file).second)
+        {
+            continue;
+        }
+
+        if (m_assets.count(file) != 0)
+        {
+            affected.push_back(file);
+        }
+
+        auto it = m_includedBy.find(file);
+        if (it != m_includedBy.end())
+        {
+            stack.insert(stack.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    std::sort(affected.begin(), affected.end());
+    return affected;
+}
+
+std::vector<std::string> AssetDependencyGraph::files() const
+{
+    std::vector<std::string> result;
+    for (const auto& file : m_includes)
+    {
+        result.push_back(file.first);
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
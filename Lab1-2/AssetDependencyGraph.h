@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Which assets have to be rebuilt when a file changes. Assets are the files
+// something is built from (shaders, textures), the graph adds whatever they
+// #include, transitively. Include names are taken as paths relative to the
+// working directory, the same way the shader include handler opens them.
+// Portable (std only), runs headless.
+class AssetDependencyGraph
+{
+public:
+	// Reads the file and everything it includes. scanIncludes == false for binary assets
+	void addAsset(const std::string& path, bool scanIncludes = true);
+
+	// Re-reads the includes of a changed file, an edit may have added or removed some
+	void rescan(const std::string& path);
+
+	// Same as reading them from disk, for files that aren't there
+	void setIncludes(const std::string& path, const std::vector<std::string>& includes);
+
+	// Assets depending on path (path itself if it is one), sorted
+	std::vector<std::string> affectedAssets(const std::string& path) const;
+
+	// Every asset and include seen so far, i.e. what to watch
+	std::vector<std::string> files() const;
+
+	bool isAsset(const std::string& path) const { return m_assets.count(normalize(path)) != 0; }
+
+	// Names from #include "..." and #include <...>, comments skipped
+	static std::vector<std::string> parseIncludes(const char* pText, size_t size);
+
+	static std::string normalize(const std::string& path);
+
+private:
+	void scan(const std::string& file);
+	void link(const std::string& file, const std::vector<std::string>& includes);
+
+private:
+	std::unordered_set<std::string> m_assets;
+	std::unordered_set<std::string> m_binaryAssets;
+	// Each file to what it includes and back
+	std::unordered_map<std::string, std::vector<std::string>> m_includes;
+	std::unordered_map<std::string, std::unordered_set<std::string>> m_includedBy;
+};
@@ -0,0 +1,131 @@
+#include "AsyncTextureLoader.h"
+
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+AsyncTextureLoader::AsyncTextureLoader(ThreadPool* pool)
+    : m_pPool(pool)
+    , m_pending(0)
+    , m_inFlight(0)
+{
+}
+
+AsyncTextureLoader::~AsyncTextureLoader()
+{
+    // Callbacks of loads that never got pumped are dropped together with the queue
+    waitInFlight();
+}
+
+void AsyncTextureLoader::load(const std::wstring& filename, DirectX::DDS_FLAGS flags, Callback onComplete)
+{
+    produce(filename, [flags](TextureLoadResult& texture)
+    {
+        return loadDDS(texture.filename, flags, texture);
+    }, std::move(onComplete));
+}
+
+void AsyncTextureLoader::produce(const std::wstring& filename, Producer producer, Callback onComplete)
+{
+    ++m_pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_inFlight;
+    }
+
+    m_pPool->submit([this, filename, producer = std::move(producer), onComplete = std::move(onComplete)]()
+    {
+        auto completed = std::make_unique<Completed>();
+        completed->onComplete = std::move(onComplete);
+        completed->texture.filename = filename;
+        completed->texture.result = producer(completed->texture);
+
+        m_completed.push(std::move(completed));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_inFlight;
+        m_inFlightDone.notify_all();
+    });
+}
+
+size_t AsyncTextureLoader::pump(size_t maxCount)
+{
+    size_t count = 0;
+    std::unique_ptr<Completed> completed;
+    while (count < maxCount && m_completed.pop(completed))
+    {
+        if (completed->onComplete)
+        {
+            completed->onComplete(completed->texture);
+        }
+        completed.reset();
+
+        --m_pending;
+        ++count;
+    }
+    return count;
+}
+
+void AsyncTextureLoader::flush()
+{
+    while (m_pending.load() > 0)
+    {
+        waitInFlight();
+        pump();
+    }
+}
+
+void AsyncTextureLoader::waitInFlight()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_inFlightDone.wait(lock, [this]() { return m_inFlight == 0; });
+}
+
+HRESULT AsyncTextureLoader::loadDDS(const std::wstring& filename, DirectX::DDS_FLAGS flags, TextureLoadResult& texture)
+{
+    texture.filename = filename;
+
+    std::vector<uint8_t> data;
+    {
+        std::ifstream file(std::filesystem::path(filename), std::ios::binary | std::ios::ate);
+        if (!file)
+        {
+            texture.result = E_FAIL;
+            return texture.result;
+        }
+
+        std::streamoff size = file.tellg();
+        if (size <= 0)
+        {
+            texture.result = E_FAIL;
+            return texture.result;
+        }
+
+        data.resize((size_t)size);
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(data.data()), size))
+        {
+            texture.result = E_FAIL;
+            return texture.result;
+        }
+    }
+
+    // LoadFromDDSMemory checks the header, the DX10 extension and that the file holds all the pixel data
+    texture.result = DirectX::LoadFromDDSMemory(data.data(), data.size(), flags, &texture.metadata, texture.image);
+    if (FAILED(texture.result))
+    {
+        return texture.result;
+    }
+
+    const DirectX::TexMetadata& info = texture.metadata;
+    if (info.dimension != DirectX::TEX_DIMENSION_TEXTURE2D
+        || info.width == 0 || info.height == 0
+        || info.mipLevels == 0 || info.arraySize == 0
+        || texture.image.GetImageCount() != info.mipLevels * info.arraySize)
+    {
+        texture.image.Release();
+        texture.result = E_INVALIDARG;
+    }
+
+    return texture.result;
+}
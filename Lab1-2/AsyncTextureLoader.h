@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "DirectXTex.h"
+
+#include "ThreadPool.h"
+#include "CompletionQueue.h"
+
+struct TextureLoadResult
+{
+	std::wstring filename;
+	HRESULT result = S_OK;
+	DirectX::TexMetadata metadata = {};
+	DirectX::ScratchImage image;
+};
+
+// Reads, parses and validates DDS files on a worker pool.
+// Finished CPU images come back through a lock-free queue and the callbacks
+// run inside pump(), i.e. on the thread that owns the device context.
+class AsyncTextureLoader
+{
+public:
+	using Callback = std::function<void(TextureLoadResult& texture)>;
+	// Fills texture (filename is already set) on a worker and returns the result
+	using Producer = std::function<HRESULT(TextureLoadResult& texture)>;
+
+	AsyncTextureLoader(ThreadPool* pool);
+	~AsyncTextureLoader();
+
+	void load(const std::wstring& filename, DirectX::DDS_FLAGS flags, Callback onComplete);
+
+	// Same as load(), for textures that are made rather than read, e.g. baked from another file
+	void produce(const std::wstring& filename, Producer producer, Callback onComplete);
+
+	// Runs callbacks of finished loads, at most maxCount per call. Returns the number of callbacks run
+	size_t pump(size_t maxCount = SIZE_MAX);
+
+	// Blocks until every queued load is finished and its callback has run
+	void flush();
+
+	size_t pending() const { return m_pending.load(); }
+
+	ThreadPool* pool() const { return m_pPool; }
+
+	// Loads and validates a single file on the calling thread
+	static HRESULT loadDDS(const std::wstring& filename, DirectX::DDS_FLAGS flags, TextureLoadResult& texture);
+
+private:
+	struct Completed
+	{
+		TextureLoadResult texture;
+		Callback onComplete;
+	};
+
+	void waitInFlight();
+
+private:
+	ThreadPool* m_pPool;
+	CompletionQueue<std::unique_ptr<Completed>> m_completed;
+
+	// Loads not yet handed to pump()
+	std::atomic<size_t> m_pending;
+
+	// Jobs still touching the loader from worker threads
+	size_t m_inFlight;
+	std::mutex m_mutex;
+	std::condition_variable m_inFlightDone;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+// Lock-free multi-producer / single-consumer queue (intrusive Vyukov MPSC).
+// Worker threads push finished items, the render thread pops them once per frame.
+template <typename T>
+class CompletionQueue
+{
+public:
+	CompletionQueue()
+	{
+		Node* stub = new Node();
+		m_head.store(stub);
+		m_pTail = stub;
+	}
+
+	~CompletionQueue()
+	{
+		T item;
+		while (pop(item))
+		{
+		}
+		delete m_pTail;
+	}
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	// Safe to call from any thread
+	void push(T item)
+	{
+		Node* node = new Node();
+		node->value = std::move(item);
+		Node* prev = m_head.exchange(node, std::memory_order_acq_rel);
+		prev->next.store(node, std::memory_order_release);
+	}
+
+	// Consumer thread only. Returns false when the queue is empty
+	// (or a producer is between exchange() and the link store; the item shows up on the next call)
+	bool pop(T& item)
+	{
+		Node* tail = m_pTail;
+		Node* next = tail->next.load(std::memory_order_acquire);
+		if (next == nullptr)
+		{
+			return false;
+		}
+
+		item = std::move(next->value);
+		m_pTail = next;
+		delete tail;
+		return true;
+	}
+
+	bool empty() const
+	{
+		return m_pTail->next.load(std::memory_order_acquire) == nullptr;
+	}
+
+private:
+	struct Node
+	{
+		std::atomic<Node*> next{ nullptr };
+		T value{};
+	};
+
+	std::atomic<Node*> m_head;
+	Node* m_pTail;
+};
@@ -0,0 +1,148 @@
+#include "D3DResources.h"
+
+#include <thread>
+
+static void releaseUnknown(void* object)
+{
+    static_cast<IUnknown*>(object)->Release();
+}
+
+// Only the formats the scene creates, anything else is counted as 4 bytes per texel
+static size_t texelBytes(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+        return 16;
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+        return 12;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R32G32_FLOAT:
+        return 8;
+    case DXGI_FORMAT_R16_UINT:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+D3DResources::D3DResources()
+{
+    static const char* Names[TypeCount] = { "Textures", "Buffers", "Views", "Shaders", "Input layouts", "States", "Queries" };
+    for (int i = 0; i < TypeCount; i++)
+    {
+        m_types[i] = m_pool.registerType(Names[i], releaseUnknown);
+    }
+}
+
+ResourcePool::Unique D3DResources::texture(ID3D11Texture2D* texture)
+{
+    size_t bytes = 0;
+    if (texture != nullptr)
+    {
+        D3D11_TEXTURE2D_DESC desc;
+        texture->GetDesc(&desc);
+
+        UINT width = desc.Width;
+        UINT height = desc.Height;
+        UINT mips = desc.MipLevels != 0 ? desc.MipLevels : 1;
+        for (UINT mip = 0; mip < mips; mip++)
+        {
+            bytes += (size_t)width * height * texelBytes(desc.Format);
+            width = (std::max)(width / 2, 1u);
+            height = (std::max)(height / 2, 1u);
+        }
+        bytes *= desc.ArraySize * desc.SampleDesc.Count;
+    }
+    return m_pool.createUnique(m_types[Texture], texture, bytes);
+}
+
+ResourcePool::Unique D3DResources::buffer(ID3D11Buffer* buffer)
+{
+    size_t bytes = 0;
+    if (buffer != nullptr)
+    {
+        D3D11_BUFFER_DESC desc;
+        buffer->GetDesc(&desc);
+        bytes = desc.ByteWidth;
+    }
+    return m_pool.createUnique(m_types[Buffer], buffer, bytes);
+}
+
+ResourcePool::Unique D3DResources::add(Type type, ID3D11DeviceChild* object)
+{
+    assert(type != Texture && type != Buffer);
+    return m_pool.createUnique(m_types[type], object, 0);
+}
+
+FrameFence::FrameFence(ID3D11Device* device, size_t depth)
+    : m_queries(depth, nullptr)
+    , m_signaled(0)
+    , m_completed(0)
+{
+    D3D11_QUERY_DESC desc = {};
+    desc.Query = D3D11_QUERY_EVENT;
+    for (ID3D11Query*& query : m_queries)
+    {
+        HRESULT result = device->CreateQuery(&desc, &query);
+        assert(SUCCEEDED(result));
+    }
+}
+
+FrameFence::~FrameFence()
+{
+    for (ID3D11Query*& query : m_queries)
+    {
+        if (query != nullptr)
+        {
+            query->Release();
+            query = nullptr;
+        }
+    }
+}
+
+bool FrameFence::isDone(ID3D11DeviceContext* context, uint64_t value, UINT flags)
+{
+    ID3D11Query* query = m_queries[value % m_queries.size()];
+    if (query == nullptr)
+    {
+        // Without a query only the swap chain's latency bounds the frames in flight
+        return value + m_queries.size() - 1 <= m_signaled;
+    }
+
+    BOOL done = FALSE;
+    return context->GetData(query, &done, sizeof(done), flags) == S_OK && done;
+}
+
+uint64_t FrameFence::signal(ID3D11DeviceContext* context)
+{
+    uint64_t value = m_signaled + 1;
+
+    // The query of this slot still belongs to an older frame, which has to finish first
+    if (value > m_queries.size())
+    {
+        uint64_t previous = value - m_queries.size();
+        while (m_completed < previous && !isDone(context, previous, 0))
+        {
+            std::this_thread::yield();
+        }
+        m_completed = (std::max)(m_completed, previous);
+    }
+
+    ID3D11Query* query = m_queries[value % m_queries.size()];
+    if (query != nullptr)
+    {
+        context->End(query);
+    }
+    m_signaled = value;
+    return value;
+}
+
+uint64_t FrameFence::completed(ID3D11DeviceContext* context)
+{
+    while (m_completed < m_signaled && isDone(context, m_completed + 1, D3D11_ASYNC_GETDATA_DONOTFLUSH))
+    {
+        m_completed++;
+    }
+    return m_completed;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "framework.h"
+#include "ResourcePool.h"
+
+// ResourcePool with the D3D11 object kinds registered as types. Objects are
+// released through IUnknown, textures and buffers are accounted from their descs.
+class D3DResources
+{
+public:
+	enum Type
+	{
+		Texture,
+		Buffer,
+		View,
+		Shader,
+		InputLayout,
+		State,
+		Query,
+		TypeCount
+	};
+
+	D3DResources();
+
+	ResourcePool& pool() { return m_pool; }
+
+	// Each takes over the caller's reference
+	ResourcePool::Unique texture(ID3D11Texture2D* texture);
+	ResourcePool::Unique buffer(ID3D11Buffer* buffer);
+	ResourcePool::Unique add(Type type, ID3D11DeviceChild* object);
+
+private:
+	ResourcePool m_pool;
+	ResourcePool::TypeId m_types[TypeCount];
+};
+
+// Frame counter the GPU advances, on a ring of event queries. Values start at 1
+class FrameFence
+{
+public:
+	// depth - frames that may be in flight before signal() blocks
+	FrameFence(ID3D11Device* device, size_t depth = 4);
+	~FrameFence();
+
+	FrameFence(const FrameFence&) = delete;
+	FrameFence& operator=(const FrameFence&) = delete;
+
+	// After the last submission of a frame, returns the frame's value
+	uint64_t signal(ID3D11DeviceContext* context);
+
+	// Latest value the GPU has passed, doesn't block or flush
+	uint64_t completed(ID3D11DeviceContext* context);
+
+	uint64_t signaled() const { return m_signaled; }
+
+private:
+	bool isDone(ID3D11DeviceContext* context, uint64_t value, UINT flags);
+
+private:
+	std::vector<ID3D11Query*> m_queries;
+	uint64_t m_signaled;
+	uint64_t m_completed;
+};
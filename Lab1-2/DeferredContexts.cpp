@@ -0,0 +1,68 @@
+#include "DeferredContexts.h"
+
+DeferredContexts::DeferredContexts(ID3D11Device* device, ID3D11DeviceContext* immediate, size_t passCount)
+    : m_pImmediate(immediate)
+    , m_contexts(passCount, nullptr)
+    , m_lists(passCount, nullptr)
+    , m_valid(true)
+    , m_driverCommandLists(false)
+{
+    D3D11_FEATURE_DATA_THREADING threading = {};
+    HRESULT result = device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading));
+    m_driverCommandLists = SUCCEEDED(result) && threading.DriverCommandLists;
+
+    for (size_t i = 0; i < passCount && m_valid; i++)
+    {
+        result = device->CreateDeferredContext(0, &m_contexts[i]);
+        assert(SUCCEEDED(result));
+        m_valid = SUCCEEDED(result);
+    }
+}
+
+DeferredContexts::~DeferredContexts()
+{
+    terminate();
+}
+
+void DeferredContexts::terminate()
+{
+    for (ID3D11CommandList*& list : m_lists)
+    {
+        if (list != nullptr)
+        {
+            list->Release();
+            list = nullptr;
+        }
+    }
+
+    for (ID3D11DeviceContext*& context : m_contexts)
+    {
+        if (context != nullptr)
+        {
+            context->Release();
+            context = nullptr;
+        }
+    }
+}
+
+ID3D11DeviceContext* DeferredContexts::beginPass(size_t pass)
+{
+    // FinishCommandList() left the context in its default state
+    return m_contexts[pass];
+}
+
+void DeferredContexts::finishPass(size_t pass)
+{
+    HRESULT result = m_contexts[pass]->FinishCommandList(FALSE, &m_lists[pass]);
+    assert(SUCCEEDED(result));
+}
+
+void DeferredContexts::executePass(size_t pass)
+{
+    if (m_lists[pass] != nullptr)
+    {
+        m_pImmediate->ExecuteCommandList(m_lists[pass], FALSE);
+        m_lists[pass]->Release();
+        m_lists[pass] = nullptr;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "framework.h"
+#include "PassRecorder.h"
+
+// PassRecorder backend on D3D11 deferred contexts, one per pass. Command lists
+// are executed on the immediate context without restoring its state.
+class DeferredContexts : public PassRecorder<ID3D11DeviceContext>::Backend
+{
+public:
+	DeferredContexts(ID3D11Device* device, ID3D11DeviceContext* immediate, size_t passCount);
+	~DeferredContexts();
+
+	ID3D11DeviceContext* beginPass(size_t pass) override;
+	void finishPass(size_t pass) override;
+	void executePass(size_t pass) override;
+
+	bool isValid() const { return m_valid; }
+	// false - the runtime emulates command lists, recording still runs in parallel but the driver gains nothing
+	bool driverCommandLists() const { return m_driverCommandLists; }
+
+private:
+	void terminate();
+
+private:
+	ID3D11DeviceContext* m_pImmediate;
+
+	std::vector<ID3D11DeviceContext*> m_contexts;
+	std::vector<ID3D11CommandList*> m_lists;
+
+	bool m_valid;
+	bool m_driverCommandLists;
+};
@@ -0,0 +1,594 @@
+#include "EnvironmentBaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cwctype>
+#include <filesystem>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    constexpr DXGI_FORMAT WorkFormat = DXGI_FORMAT_R32G32B32A32_FLOAT;
+
+    void forEachRow(ThreadPool* pool, size_t count, const std::function<void(size_t begin, size_t end)>& func)
+    {
+        if (pool != nullptr)
+        {
+            pool->parallelFor(count, 4, func);
+        }
+        else
+        {
+            func(0, count);
+        }
+    }
+
+    inline XMVECTOR loadTexel(const Image& image, size_t x, size_t y)
+    {
+        return XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(image.pixels + y * image.rowPitch) + x);
+    }
+
+    // x, y in texels (centers at +0.5). x wraps around if wrapX is set, everything else is clamped
+    XMVECTOR sampleBilinear(const Image& image, float x, float y, bool wrapX)
+    {
+        x -= 0.5f;
+        y -= 0.5f;
+        const float fx = floorf(x);
+        const float fy = floorf(y);
+
+        const ptrdiff_t width = (ptrdiff_t)image.width;
+        const ptrdiff_t height = (ptrdiff_t)image.height;
+        ptrdiff_t x0 = (ptrdiff_t)fx;
+        ptrdiff_t x1 = x0 + 1;
+        if (wrapX)
+        {
+            x0 = ((x0 % width) + width) % width;
+            x1 = ((x1 % width) + width) % width;
+        }
+        else
+        {
+            x0 = (std::min)((std::max)(x0, (ptrdiff_t)0), width - 1);
+            x1 = (std::min)((std::max)(x1, (ptrdiff_t)0), width - 1);
+        }
+        const ptrdiff_t y0 = (std::min)((std::max)((ptrdiff_t)fy, (ptrdiff_t)0), height - 1);
+        const ptrdiff_t y1 = (std::min)((std::max)((ptrdiff_t)fy + 1, (ptrdiff_t)0), height - 1);
+
+        XMVECTOR top = XMVectorLerp(loadTexel(image, x0, y0), loadTexel(image, x1, y0), x - fx);
+        XMVECTOR bottom = XMVectorLerp(loadTexel(image, x0, y1), loadTexel(image, x1, y1), x - fx);
+        return XMVectorLerp(top, bottom, y - fy);
+    }
+
+    // u, v in [-1, 1] across the face, v pointing down. Faces in D3D order: +X, -X, +Y, -Y, +Z, -Z
+    XMVECTOR faceDirection(size_t face, float u, float v)
+    {
+        XMVECTOR dir;
+        switch (face)
+        {
+        case 0: dir = XMVectorSet(1.0f, -v, -u, 0.0f); break;
+        case 1: dir = XMVectorSet(-1.0f, -v, u, 0.0f); break;
+        case 2: dir = XMVectorSet(u, 1.0f, v, 0.0f); break;
+        case 3: dir = XMVectorSet(u, -1.0f, -v, 0.0f); break;
+        case 4: dir = XMVectorSet(u, -v, 1.0f, 0.0f); break;
+        default: dir = XMVectorSet(-u, -v, -1.0f, 0.0f); break;
+        }
+        return XMVector3Normalize(dir);
+    }
+
+    // Inverse of faceDirection, s and t in [0, 1]
+    void cubeCoords(FXMVECTOR dir, size_t& face, float& s, float& t)
+    {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, dir);
+        const float ax = fabsf(d.x);
+        const float ay = fabsf(d.y);
+        const float az = fabsf(d.z);
+
+        float major, u, v;
+        if (ax >= ay && ax >= az)
+        {
+            face = d.x >= 0.0f ? 0 : 1;
+            major = ax;
+            u = d.x >= 0.0f ? -d.z : d.z;
+            v = -d.y;
+        }
+        else if (ay >= az)
+        {
+            face = d.y >= 0.0f ? 2 : 3;
+            major = ay;
+            u = d.x;
+            v = d.y >= 0.0f ? d.z : -d.z;
+        }
+        else
+        {
+            face = d.z >= 0.0f ? 4 : 5;
+            major = az;
+            u = d.z >= 0.0f ? d.x : -d.x;
+            v = -d.y;
+        }
+
+        s = 0.5f * (u / major + 1.0f);
+        t = 0.5f * (v / major + 1.0f);
+    }
+
+    // The panorama's center column looks down -Z, its top row straight up
+    XMVECTOR sampleEquirect(const Image& image, FXMVECTOR dir)
+    {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, dir);
+        const float u = 0.5f + atan2f(d.x, -d.z) * (0.5f / XM_PI);
+        const float v = acosf((std::min)((std::max)(d.y, -1.0f), 1.0f)) / XM_PI;
+        return sampleBilinear(image, u * image.width, v * image.height, true);
+    }
+
+    XMVECTOR sampleCube(const ScratchImage& cube, FXMVECTOR dir, float lod)
+    {
+        size_t face;
+        float s, t;
+        cubeCoords(dir, face, s, t);
+
+        const size_t lastMip = cube.GetMetadata().mipLevels - 1;
+        lod = (std::min)((std::max)(lod, 0.0f), (float)lastMip);
+        const size_t mip = (size_t)lod;
+
+        const Image* image = cube.GetImage(mip, face, 0);
+        XMVECTOR color = sampleBilinear(*image, s * image->width, t * image->height, false);
+        if (mip < lastMip && lod > (float)mip)
+        {
+            image = cube.GetImage(mip + 1, face, 0);
+            color = XMVectorLerp(color, sampleBilinear(*image, s * image->width, t * image->height, false), lod - (float)mip);
+        }
+        return color;
+    }
+
+    float areaElement(float x, float y)
+    {
+        return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+    }
+
+    // Solid angle of the texel centered at (u, v); halfTexel is half its width in [-1, 1] face coordinates
+    float texelSolidAngle(float u, float v, float halfTexel)
+    {
+        const float x0 = u - halfTexel;
+        const float x1 = u + halfTexel;
+        const float y0 = v - halfTexel;
+        const float y1 = v + halfTexel;
+        return areaElement(x0, y0) - areaElement(x0, y1) - areaElement(x1, y0) + areaElement(x1, y1);
+    }
+
+    void shBasis(FXMVECTOR dir, float (&basis)[9])
+    {
+        XMFLOAT3 d;
+        XMStoreFloat3(&d, dir);
+        basis[0] = 0.282095f;
+        basis[1] = 0.488603f * d.y;
+        basis[2] = 0.488603f * d.z;
+        basis[3] = 0.488603f * d.x;
+        basis[4] = 1.092548f * d.x * d.y;
+        basis[5] = 1.092548f * d.y * d.z;
+        basis[6] = 0.315392f * (3.0f * d.z * d.z - 1.0f);
+        basis[7] = 1.092548f * d.x * d.z;
+        basis[8] = 0.546274f * (d.x * d.x - d.y * d.y);
+    }
+
+    HRESULT projectSH(const ScratchImage& cube, ThreadPool* pool, EnvironmentBaker::SH9& sh)
+    {
+        const size_t size = cube.GetMetadata().width;
+        const float invSize = 1.0f / (float)size;
+
+        // One partial sum per row keeps the result independent of how rows land on threads
+        struct RowSum
+        {
+            XMFLOAT4 coeffs[9];
+            float weight;
+        };
+        std::vector<RowSum> rows(6 * size);
+
+        forEachRow(pool, rows.size(), [&](size_t begin, size_t end)
+        {
+            for (size_t row = begin; row < end; row++)
+            {
+                const size_t face = row / size;
+                const size_t y = row % size;
+                const Image* image = cube.GetImage(0, face, 0);
+                const float v = 2.0f * ((float)y + 0.5f) * invSize - 1.0f;
+
+                XMVECTOR sum[9] = {};
+                float weight = 0.0f;
+                for (size_t x = 0; x < size; x++)
+                {
+                    const float u = 2.0f * ((float)x + 0.5f) * invSize - 1.0f;
+                    const float solidAngle = texelSolidAngle(u, v, invSize);
+
+                    float basis[9];
+                    shBasis(faceDirection(face, u, v), basis);
+
+                    const XMVECTOR color = loadTexel(*image, x, y);
+                    for (size_t i = 0; i < 9; i++)
+                    {
+                        sum[i] = XMVectorMultiplyAdd(color, XMVectorReplicate(basis[i] * solidAngle), sum[i]);
+                    }
+                    weight += solidAngle;
+                }
+
+                for (size_t i = 0; i < 9; i++)
+                {
+                    XMStoreFloat4(&rows[row].coeffs[i], sum[i]);
+                }
+                rows[row].weight = weight;
+            }
+        });
+
+        XMVECTOR total[9] = {};
+        float weight = 0.0f;
+        for (const RowSum& row : rows)
+        {
+            for (size_t i = 0; i < 9; i++)
+            {
+                total[i] = XMVectorAdd(total[i], XMLoadFloat4(&row.coeffs[i]));
+            }
+            weight += row.weight;
+        }
+        if (weight <= 0.0f)
+        {
+            return E_UNEXPECTED;
+        }
+
+        // The texel solid angles add up to 4pi up to float error; rescale so a constant environment projects exactly
+        const float scale = 4.0f * XM_PI / weight;
+        for (size_t i = 0; i < 9; i++)
+        {
+            XMStoreFloat3(&sh.coeffs[i], XMVectorScale(total[i], scale));
+        }
+        return S_OK;
+    }
+
+    // Radiance chain for the samples to read. A texel is the solid angle weighted mean of the texels
+    // it covers, so every level holds the same energy; a per-face box filter would weight the small
+    // corner texels like the center ones and brighten sources near a corner
+    HRESULT buildRadianceChain(const ScratchImage& base, size_t mipLevels, ThreadPool* pool, ScratchImage& radiance)
+    {
+        const size_t size = base.GetMetadata().width;
+        HRESULT hr = radiance.InitializeCube(WorkFormat, size, size, 1, mipLevels);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        for (size_t face = 0; face < 6; face++)
+        {
+            const Image* pSrc = base.GetImage(0, face, 0);
+            memcpy(radiance.GetImage(0, face, 0)->pixels, pSrc->pixels, pSrc->slicePitch);
+        }
+
+        for (size_t mip = 1; mip < mipLevels; mip++)
+        {
+            const size_t srcSize = radiance.GetImage(mip - 1, 0, 0)->width;
+            const size_t dstSize = radiance.GetImage(mip, 0, 0)->width;
+            const float invSrcSize = 1.0f / (float)srcSize;
+            const float ratio = (float)srcSize / (float)dstSize;
+
+            forEachRow(pool, 6 * dstSize, [&](size_t begin, size_t end)
+            {
+                for (size_t row = begin; row < end; row++)
+                {
+                    const size_t face = row / dstSize;
+                    const size_t y = row % dstSize;
+                    const Image* src = radiance.GetImage(mip - 1, face, 0);
+                    const Image* dst = radiance.GetImage(mip, face, 0);
+                    XMFLOAT4* pDst = reinterpret_cast<XMFLOAT4*>(dst->pixels + y * dst->rowPitch);
+                    const float y0 = (float)y * ratio;
+                    const float y1 = (float)(y + 1) * ratio;
+
+                    for (size_t x = 0; x < dstSize; x++)
+                    {
+                        const float x0 = (float)x * ratio;
+                        const float x1 = (float)(x + 1) * ratio;
+
+                        // Source texels only partly inside (odd sizes) count by the part that is
+                        XMVECTOR sum = XMVectorZero();
+                        float weight = 0.0f;
+                        for (size_t sy = (size_t)y0; sy < srcSize && (float)sy < y1; sy++)
+                        {
+                            const float coverY = (std::min)(y1, (float)(sy + 1)) - (std::max)(y0, (float)sy);
+                            const float v = 2.0f * ((float)sy + 0.5f) * invSrcSize - 1.0f;
+                            for (size_t sx = (size_t)x0; sx < srcSize && (float)sx < x1; sx++)
+                            {
+                                const float coverX = (std::min)(x1, (float)(sx + 1)) - (std::max)(x0, (float)sx);
+                                const float u = 2.0f * ((float)sx + 0.5f) * invSrcSize - 1.0f;
+                                const float w = coverX * coverY * texelSolidAngle(u, v, invSrcSize);
+                                sum = XMVectorMultiplyAdd(loadTexel(*src, sx, sy), XMVectorReplicate(w), sum);
+                                weight += w;
+                            }
+                        }
+
+                        XMStoreFloat4(pDst + x, XMVectorSetW(XMVectorScale(sum, 1.0f / weight), 1.0f));
+                    }
+                }
+            });
+        }
+        return S_OK;
+    }
+
+    struct GGXSample
+    {
+        XMFLOAT3 direction;     // tangent space, normal along +Z
+        float weight;           // N.L
+        float lod;              // radiance mip matching the sample's footprint
+    };
+
+    float radicalInverse(uint32_t bits)
+    {
+        bits = (bits << 16u) | (bits >> 16u);
+        bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+        bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+        bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+        bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+        return (float)bits * 2.3283064365386963e-10f;
+    }
+
+    // Importance samples of the GGX lobe with N = V = R. Each sample reads the radiance mip whose texels
+    // cover about the solid angle it stands for (filtered importance sampling), so few samples stay smooth
+    std::vector<GGXSample> buildSamples(float roughness, size_t sampleCount, size_t faceSize, size_t lastMip)
+    {
+        const float alpha = roughness * roughness;
+        const float alpha2 = alpha * alpha;
+        const float texelSolidAngle = 4.0f * XM_PI / (6.0f * (float)faceSize * (float)faceSize);
+
+        std::vector<GGXSample> samples;
+        samples.reserve(sampleCount);
+        for (size_t i = 0; i < sampleCount; i++)
+        {
+            const float phi = 2.0f * XM_PI * (float)i / (float)sampleCount;
+            const float xi = radicalInverse((uint32_t)i);
+            const float cosTheta = sqrtf((1.0f - xi) / (1.0f + (alpha2 - 1.0f) * xi));
+            const float sinTheta = sqrtf((std::max)(1.0f - cosTheta * cosTheta, 0.0f));
+
+            // L = reflect(-V, H) with V = N
+            GGXSample sample;
+            sample.direction.x = 2.0f * cosTheta * sinTheta * cosf(phi);
+            sample.direction.y = 2.0f * cosTheta * sinTheta * sinf(phi);
+            sample.direction.z = 2.0f * cosTheta * cosTheta - 1.0f;
+            sample.weight = sample.direction.z;
+            if (sample.weight <= 0.0f)
+            {
+                continue;
+            }
+
+            // pdf(L) = D(H) * N.H / (4 V.H) = D(H) / 4
+            const float denom = cosTheta * cosTheta * (alpha2 - 1.0f) + 1.0f;
+            const float pdf = alpha2 / (4.0f * XM_PI * denom * denom);
+            const float sampleSolidAngle = 1.0f / ((float)sampleCount * pdf);
+            sample.lod = (std::min)((std::max)(0.5f * log2f(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f), (float)lastMip);
+
+            samples.push_back(sample);
+        }
+        return samples;
+    }
+
+    void prefilterLevel(const ScratchImage& radiance, size_t mip, const std::vector<GGXSample>& samples, ThreadPool* pool, const ScratchImage& result)
+    {
+        const size_t size = result.GetImage(mip, 0, 0)->width;
+        const float invSize = 1.0f / (float)size;
+
+        forEachRow(pool, 6 * size, [&](size_t begin, size_t end)
+        {
+            for (size_t row = begin; row < end; row++)
+            {
+                const size_t face = row / size;
+                const size_t y = row % size;
+                const Image* image = result.GetImage(mip, face, 0);
+                XMFLOAT4* pDst = reinterpret_cast<XMFLOAT4*>(image->pixels + y * image->rowPitch);
+                const float v = 2.0f * ((float)y + 0.5f) * invSize - 1.0f;
+
+                for (size_t x = 0; x < size; x++)
+                {
+                    const float u = 2.0f * ((float)x + 0.5f) * invSize - 1.0f;
+                    const XMVECTOR normal = faceDirection(face, u, v);
+                    const XMVECTOR up = fabsf(XMVectorGetY(normal)) < 0.999f ? g_XMIdentityR1 : g_XMIdentityR0;
+                    const XMVECTOR tangent = XMVector3Normalize(XMVector3Cross(up, normal));
+                    const XMVECTOR bitangent = XMVector3Cross(normal, tangent);
+
+                    XMVECTOR sum = XMVectorZero();
+                    float weight = 0.0f;
+                    for (const GGXSample& sample : samples)
+                    {
+                        XMVECTOR dir = XMVectorScale(normal, sample.direction.z);
+                        dir = XMVectorMultiplyAdd(tangent, XMVectorReplicate(sample.direction.x), dir);
+                        dir = XMVectorMultiplyAdd(bitangent, XMVectorReplicate(sample.direction.y), dir);
+
+                        sum = XMVectorMultiplyAdd(sampleCube(radiance, dir, sample.lod), XMVectorReplicate(sample.weight), sum);
+                        weight += sample.weight;
+                    }
+
+                    XMStoreFloat4(pDst + x, XMVectorSetW(XMVectorScale(sum, 1.0f / weight), 1.0f));
+                }
+            }
+        });
+    }
+}
+
+XMVECTOR EnvironmentBaker::SH9::irradiance(FXMVECTOR normal) const
+{
+    // Cosine lobe convolution per band
+    static const float band[9] = {
+        XM_PI,
+        2.0f * XM_PI / 3.0f, 2.0f * XM_PI / 3.0f, 2.0f * XM_PI / 3.0f,
+        XM_PI / 4.0f, XM_PI / 4.0f, XM_PI / 4.0f, XM_PI / 4.0f, XM_PI / 4.0f
+    };
+
+    float basis[9];
+    shBasis(XMVector3Normalize(normal), basis);
+
+    XMVECTOR result = XMVectorZero();
+    for (size_t i = 0; i < 9; i++)
+    {
+        result = XMVectorMultiplyAdd(XMLoadFloat3(&coeffs[i]), XMVectorReplicate(band[i] * basis[i]), result);
+    }
+    return XMVectorMax(result, XMVectorZero());
+}
+
+HRESULT EnvironmentBaker::bake(const Image& equirect, const Options& options, ScratchImage& cubemap, SH9* pIrradiance)
+{
+    if (equirect.pixels == nullptr || equirect.width == 0 || equirect.height == 0
+        || options.faceSize == 0 || options.sampleCount == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    const size_t size = options.faceSize;
+    size_t maxLevels = 1;
+    for (size_t s = size; s > 1; s >>= 1)
+    {
+        maxLevels++;
+    }
+    const size_t mipLevels = options.mipLevels != 0 ? (std::min)(options.mipLevels, maxLevels) : maxLevels;
+
+    // Runs on worker threads, so WIC (which needs COM on every thread) is kept out of the way
+    const TEX_FILTER_FLAGS filter = TEX_FILTER_DEFAULT | TEX_FILTER_FORCE_NON_WIC;
+
+    HRESULT hr = S_OK;
+    ScratchImage converted;
+    const Image* pSource = &equirect;
+    if (equirect.format != WorkFormat)
+    {
+        if (IsCompressed(equirect.format))
+        {
+            hr = Decompress(equirect, WorkFormat, converted);
+        }
+        else
+        {
+            hr = Convert(equirect, WorkFormat, filter, TEX_THRESHOLD_DEFAULT, converted);
+        }
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        pSource = converted.GetImage(0, 0, 0);
+    }
+    const Image& source = *pSource;
+
+    ScratchImage base;
+    hr = base.InitializeCube(WorkFormat, size, size, 1, 1);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const float invSize = 1.0f / (float)size;
+    forEachRow(options.pool, 6 * size, [&](size_t begin, size_t end)
+    {
+        for (size_t row = begin; row < end; row++)
+        {
+            const size_t face = row / size;
+            const size_t y = row % size;
+            const Image* image = base.GetImage(0, face, 0);
+            XMFLOAT4* pDst = reinterpret_cast<XMFLOAT4*>(image->pixels + y * image->rowPitch);
+            const float v = 2.0f * ((float)y + 0.5f) * invSize - 1.0f;
+
+            for (size_t x = 0; x < size; x++)
+            {
+                const float u = 2.0f * ((float)x + 0.5f) * invSize - 1.0f;
+                XMStoreFloat4(pDst + x, XMVectorSetW(sampleEquirect(source, faceDirection(face, u, v)), 1.0f));
+            }
+        }
+    });
+    converted.Release();
+
+    if (pIrradiance != nullptr)
+    {
+        hr = projectSH(base, options.pool, *pIrradiance);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+    }
+
+    ScratchImage result;
+    if (mipLevels > 1)
+    {
+        // Downsampled chain for the samples to read, and the chain the prefiltered levels go to
+        ScratchImage radiance;
+        hr = buildRadianceChain(base, mipLevels, options.pool, radiance);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        base.Release();
+
+        hr = result.InitializeCube(WorkFormat, size, size, 1, mipLevels);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        for (size_t face = 0; face < 6; face++)
+        {
+            const Image* pSrc = radiance.GetImage(0, face, 0);
+            const Image* pDst = result.GetImage(0, face, 0);
+            memcpy(pDst->pixels, pSrc->pixels, pSrc->slicePitch);
+        }
+
+        for (size_t mip = 1; mip < mipLevels; mip++)
+        {
+            const float roughness = (float)mip / (float)(mipLevels - 1);
+            std::vector<GGXSample> samples = buildSamples(roughness, options.sampleCount, size, mipLevels - 1);
+            prefilterLevel(radiance, mip, samples, options.pool, result);
+        }
+    }
+    else
+    {
+        result = std::move(base);
+    }
+
+    if (options.format == WorkFormat)
+    {
+        cubemap = std::move(result);
+        return S_OK;
+    }
+
+    if (IsCompressed(options.format))
+    {
+        return Compress(result.GetImages(), result.GetImageCount(), result.GetMetadata(), options.format,
+            TEX_COMPRESS_PARALLEL, TEX_THRESHOLD_DEFAULT, cubemap);
+    }
+
+    return Convert(result.GetImages(), result.GetImageCount(), result.GetMetadata(), options.format,
+        filter, TEX_THRESHOLD_DEFAULT, cubemap);
+}
+
+HRESULT EnvironmentBaker::bakeFile(const std::wstring& filename, const Options& options, ScratchImage& cubemap, SH9* pIrradiance)
+{
+    std::wstring extension = std::filesystem::path(filename).extension().wstring();
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c) { return (wchar_t)std::towlower(c); });
+
+    ScratchImage image;
+    HRESULT hr = E_INVALIDARG;
+    if (extension == L".hdr")
+    {
+        hr = LoadFromHDRFile(filename.c_str(), nullptr, image);
+    }
+    else if (extension == L".dds")
+    {
+        hr = LoadFromDDSFile(filename.c_str(), DDS_FLAGS_NONE, nullptr, image);
+    }
+    else if (extension == L".tga")
+    {
+        hr = LoadFromTGAFile(filename.c_str(), TGA_FLAGS_NONE, nullptr, image);
+    }
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    return bake(*image.GetImage(0, 0, 0), options, cubemap, pIrradiance);
+}
+
+HRESULT EnvironmentBaker::saveDDS(const ScratchImage& cubemap, const std::wstring& filename)
+{
+    if (cubemap.GetImageCount() == 0 || !cubemap.GetMetadata().IsCubemap())
+    {
+        return E_INVALIDARG;
+    }
+
+    return SaveToDDSFile(cubemap.GetImages(), cubemap.GetImageCount(), cubemap.GetMetadata(), DDS_FLAGS_NONE, filename.c_str());
+}
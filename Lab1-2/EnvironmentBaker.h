@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+
+#include "DirectXTex.h"
+
+#include "ThreadPool.h"
+
+// Turns an equirectangular HDR panorama into a cubemap on the CPU, either offline (bakeFile + saveDDS)
+// or at startup. Mip 0 is the environment itself; every further mip is GGX-prefiltered for
+// roughness = mip / (mipLevels - 1), so a shader picks the level from the surface roughness.
+// Diffuse lighting comes as 9 spherical harmonics coefficients.
+class EnvironmentBaker
+{
+public:
+	struct Options
+	{
+		size_t faceSize = 512;
+		// 0 - full chain down to 1x1
+		size_t mipLevels = 0;
+		// GGX importance samples per texel of the prefiltered mips
+		size_t sampleCount = 64;
+
+		DXGI_FORMAT format = DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+		// Faces are baked on these workers (nullptr - on the calling thread)
+		ThreadPool* pool = nullptr;
+	};
+
+	// Radiance projected onto the real SH basis of bands 0-2
+	struct SH9
+	{
+		DirectX::XMFLOAT3 coeffs[9] = {};
+
+		// Irradiance arriving at a surface facing normal (cosine-convolved radiance)
+		DirectX::XMVECTOR irradiance(DirectX::FXMVECTOR normal) const;
+	};
+
+	static HRESULT bake(const DirectX::Image& equirect, const Options& options, DirectX::ScratchImage& cubemap, SH9* pIrradiance = nullptr);
+
+	// Loads .hdr, .dds or .tga panoramas
+	static HRESULT bakeFile(const std::wstring& filename, const Options& options, DirectX::ScratchImage& cubemap, SH9* pIrradiance = nullptr);
+
+	static HRESULT saveDDS(const DirectX::ScratchImage& cubemap, const std::wstring& filename);
+};
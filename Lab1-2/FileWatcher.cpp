@@ -0,0 +1,260 @@
+#include "FileWatcher.h"
+
+#include <filesystem>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FileWatcher::FileWatcher(std::chrono::milliseconds interval, std::chrono::milliseconds settle)
+    : m_interval(interval)
+    , m_settle(settle)
+    , m_notifyFd(-1)
+    , m_stop(false)
+{
+#ifdef __linux__
+    m_notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+    stop();
+
+#ifdef __linux__
+    if (m_notifyFd >= 0)
+    {
+        close(m_notifyFd);
+    }
+#endif
+}
+
+void FileWatcher::watch(const std::string& path)
+{
+    std::filesystem::path normalized = std::filesystem::path(path).lexically_normal();
+
+    File file;
+    file.path = path;
+    file.directory = normalized.parent_path().generic_string();
+    if (file.directory.empty())
+    {
+        file.directory = ".";
+    }
+    file.name = normalized.filename().generic_string();
+    readStamp(file);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const File& existing : m_files)
+    {
+        if (existing.path == path)
+        {
+            return;
+        }
+    }
+
+    if (m_notifyFd >= 0)
+    {
+        addDirectoryWatch(file.directory);
+        for (const auto& directory : m_directories)
+        {
+            if (directory.second == file.directory)
+            {
+                file.polled = false;
+            }
+        }
+    }
+    m_files.push_back(std::move(file));
+}
+
+void FileWatcher::addDirectoryWatch(const std::string& directory)
+{
+#ifdef __linux__
+    for (const auto& existing : m_directories)
+    {
+        if (existing.second == directory)
+        {
+            return;
+        }
+    }
+
+    // Whole directory rather than the file, saving through a rename replaces the inode
+    int wd = inotify_add_watch(m_notifyFd, directory.c_str(),
+        IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+    if (wd >= 0)
+    {
+        m_directories[wd] = directory;
+    }
+#endif
+}
+
+void FileWatcher::readStamp(File& file)
+{
+    std::error_code error;
+    auto time = std::filesystem::last_write_time(file.path, error);
+    file.time = error ? -1 : (int64_t)time.time_since_epoch().count();
+    uintmax_t size = std::filesystem::file_size(file.path, error);
+    file.size = error ? -1 : (int64_t)size;
+}
+
+void FileWatcher::readEvents(Clock::time_point now)
+{
+#ifdef __linux__
+    alignas(inotify_event) char buffer[4096];
+    bool overflowed = false;
+    for (;;)
+    {
+        ssize_t length = read(m_notifyFd, buffer, sizeof(buffer));
+        if (length <= 0)
+        {
+            break;
+        }
+
+        for (ssize_t offset = 0; offset < length;)
+        {
+            const inotify_event* pEvent = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + pEvent->len;
+
+            if (pEvent->mask & IN_Q_OVERFLOW)
+            {
+                overflowed = true;
+                continue;
+            }
+
+            auto directory = m_directories.find(pEvent->wd);
+            if (pEvent->len == 0 || directory == m_directories.end())
+            {
+                continue;
+            }
+
+            for (File& file : m_files)
+            {
+                if (!file.polled && file.name == pEvent->name && file.directory == directory->second)
+                {
+                    file.dirty = true;
+                    file.lastEvent = now;
+                }
+            }
+        }
+    }
+
+    // The queue dropped events, so any file may have changed unseen: compare
+    // each one against the stamp it had when it was last reported
+    if (overflowed)
+    {
+        for (File& file : m_files)
+        {
+            if (!file.polled)
+            {
+                int64_t time = file.time;
+                int64_t size = file.size;
+                readStamp(file);
+                if (file.time != time || file.size != size)
+                {
+                    file.dirty = true;
+                    file.lastEvent = now;
+                }
+            }
+        }
+    }
+#endif
+}
+
+size_t FileWatcher::scanLocked(Clock::time_point now)
+{
+    if (m_notifyFd >= 0)
+    {
+        readEvents(now);
+    }
+
+    size_t ready = 0;
+    for (File& file : m_files)
+    {
+        if (file.polled)
+        {
+            int64_t time = file.time;
+            int64_t size = file.size;
+            readStamp(file);
+            if (file.time != time || file.size != size)
+            {
+                file.dirty = true;
+                file.lastEvent = now;
+            }
+        }
+
+        if (file.dirty && now - file.lastEvent >= m_settle)
+        {
+            file.dirty = false;
+            if (!file.polled)
+            {
+                // Kept current for the rescan after an overflow
+                readStamp(file);
+            }
+            bool queued = false;
+            for (const std::string& path : m_ready)
+            {
+                queued = queued || path == file.path;
+            }
+            if (!queued)
+            {
+                m_ready.push_back(file.path);
+            }
+            ++ready;
+        }
+    }
+    return ready;
+}
+
+size_t FileWatcher::scan()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return scanLocked(Clock::now());
+}
+
+void FileWatcher::poll(std::vector<std::string>& changed)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    changed.insert(changed.end(), m_ready.begin(), m_ready.end());
+    m_ready.clear();
+}
+
+size_t FileWatcher::watchedCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_files.size();
+}
+
+void FileWatcher::start()
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+
+    m_stop = false;
+    m_thread = std::thread(&FileWatcher::threadLoop, this);
+}
+
+void FileWatcher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+void FileWatcher::threadLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        scanLocked(Clock::now());
+        m_wake.wait_for(lock, m_interval, [this]() { return m_stop; });
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Reports files that changed on disk. Watches single files, not trees; a file
+// that doesn't exist yet is fine, creating it counts as a change. On Linux the
+// containing directories are watched with inotify, elsewhere the files are
+// polled (write time and size), which for a few dozen files costs nothing.
+// Editors save in several writes or through a rename, so a change is only
+// reported once the file has been quiet for the settle time.
+// Portable (std only), runs headless.
+class FileWatcher
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	// interval - how often the background thread looks, settle - quiet time before a change is reported
+	FileWatcher(std::chrono::milliseconds interval = std::chrono::milliseconds(200),
+		std::chrono::milliseconds settle = std::chrono::milliseconds(100));
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	// Paths are reported back exactly as given here. Watching a file twice is a no-op
+	void watch(const std::string& path);
+
+	// Scans on a background thread until stop() or destruction
+	void start();
+	void stop();
+
+	// Looks for changes once on the calling thread, for use without start().
+	// Returns the number of changes that became ready
+	size_t scan();
+
+	// Files changed since the last call, each once. Safe to call from any thread
+	void poll(std::vector<std::string>& changed);
+
+	size_t watchedCount();
+	bool usesNativeEvents() const { return m_notifyFd >= 0; }
+
+private:
+	struct File
+	{
+		std::string path;
+		// Split for matching directory events
+		std::string directory;
+		std::string name;
+		// No directory watch, falls back to polling
+		bool polled = true;
+		// Write time (file clock ticks) and size, -1 - missing. Watched files
+		// only compare them after the event queue overflowed
+		int64_t time = -1;
+		int64_t size = -1;
+		bool dirty = false;
+		Clock::time_point lastEvent;
+	};
+
+	size_t scanLocked(Clock::time_point now);
+	void readStamp(File& file);
+	void readEvents(Clock::time_point now);
+	void addDirectoryWatch(const std::string& directory);
+	void threadLoop();
+
+private:
+	std::chrono::milliseconds m_interval;
+	std::chrono::milliseconds m_settle;
+
+	std::mutex m_mutex;
+	std::vector<File> m_files;
+	std::vector<std::string> m_ready;
+
+	// inotify: descriptor per watched directory, -1 when unavailable
+	int m_notifyFd;
+	std::unordered_map<int, std::string> m_directories;
+
+	std::thread m_thread;
+	std::condition_variable m_wake;
+	bool m_stop;
+};
@@ -0,0 +1,139 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+
+FrameArena::FrameArena(size_t blockSize)
+    : m_blockSize((std::max)(blockSize, (size_t)256))
+    , m_offset(0)
+    , m_used(0)
+    , m_peak(0)
+    , m_capacity(0)
+    , m_heapAllocations(0)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    for (Block& block : m_blocks)
+    {
+        ::operator delete(block.data);
+    }
+}
+
+void FrameArena::addBlock(size_t minSize)
+{
+    Block block;
+    block.size = (std::max)(minSize, m_blockSize);
+    block.data = static_cast<char*>(::operator new(block.size));
+    m_blocks.push_back(block);
+    m_offset = 0;
+
+    m_capacity.store(m_capacity.load(std::memory_order_relaxed) + block.size, std::memory_order_relaxed);
+    m_heapAllocations.store(m_heapAllocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment)
+{
+    assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+
+    if (!m_blocks.empty())
+    {
+        const Block& block = m_blocks.back();
+        uintptr_t address = reinterpret_cast<uintptr_t>(block.data) + m_offset;
+        size_t padding = (alignment - address % alignment) % alignment;
+        if (m_offset + padding + size <= block.size)
+        {
+            m_offset += padding + size;
+            m_used.store(m_used.load(std::memory_order_relaxed) + padding + size, std::memory_order_relaxed);
+            return block.data + m_offset - size;
+        }
+    }
+
+    // Blocks come from operator new, aligned for any fundamental type; larger alignments pad inside
+    addBlock(size + alignment);
+    return allocate(size, alignment);
+}
+
+void FrameArena::reset()
+{
+    size_t used = m_used.load(std::memory_order_relaxed);
+    if (used > m_peak.load(std::memory_order_relaxed))
+    {
+        m_peak.store(used, std::memory_order_relaxed);
+    }
+    m_used.store(0, std::memory_order_relaxed);
+    m_offset = 0;
+
+    if (m_blocks.size() > 1)
+    {
+        // Next time the whole frame fits in one block
+        size_t total = 0;
+        for (Block& block : m_blocks)
+        {
+            total += block.size;
+            ::operator delete(block.data);
+        }
+        m_blocks.clear();
+        m_capacity.store(0, std::memory_order_relaxed);
+        addBlock(total);
+    }
+}
+
+static std::atomic<uint64_t> s_nextArenasId(1);
+
+FrameArenas::FrameArenas(size_t blockSize)
+    : m_id(s_nextArenasId++)
+    , m_blockSize(blockSize)
+{
+}
+
+FrameArena& FrameArenas::local()
+{
+    // The arena last looked up on this thread
+    thread_local uint64_t t_owner = 0;
+    thread_local FrameArena* t_pArena = nullptr;
+    if (t_owner == m_id)
+    {
+        return *t_pArena;
+    }
+
+    std::thread::id thread = std::this_thread::get_id();
+    FrameArena* pArena = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const Entry& entry : m_arenas)
+        {
+            if (entry.thread == thread)
+            {
+                pArena = entry.arena.get();
+            }
+        }
+
+        if (pArena == nullptr)
+        {
+            m_arenas.push_back({ thread, std::make_unique<FrameArena>(m_blockSize) });
+            pArena = m_arenas.back().arena.get();
+        }
+    }
+
+    t_owner = m_id;
+    t_pArena = pArena;
+    return *pArena;
+}
+
+FrameArenas::Stats FrameArenas::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    Stats stats;
+    stats.threads = m_arenas.size();
+    for (const Entry& entry : m_arenas)
+    {
+        stats.peak += entry.arena->peak();
+        stats.capacity += entry.arena->capacity();
+        stats.heapAllocations += entry.arena->heapAllocations();
+    }
+    return stats;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bump allocator for data that only lives until the end of a frame. Freeing
+// single allocations does nothing, reset() drops everything at once. When a
+// frame needed more than one block, reset() replaces them with one block big
+// enough for all, so a steady workload stops touching the heap.
+// Single thread, see FrameArenas for one per thread.
+// Portable (std only).
+class FrameArena
+{
+public:
+	explicit FrameArena(size_t blockSize = 64 * 1024);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// alignment - a power of two
+	void* allocate(size_t size, size_t alignment);
+
+	// At the end of the frame, nothing allocated before may be used afterwards
+	void reset();
+
+	// Any thread
+	size_t used() const { return m_used.load(std::memory_order_relaxed); }
+	// Most used by any frame so far
+	size_t peak() const { return m_peak.load(std::memory_order_relaxed); }
+	size_t capacity() const { return m_capacity.load(std::memory_order_relaxed); }
+	// Blocks taken from the heap so far
+	uint64_t heapAllocations() const { return m_heapAllocations.load(std::memory_order_relaxed); }
+
+private:
+	struct Block
+	{
+		char* data;
+		size_t size;
+	};
+
+	void addBlock(size_t minSize);
+
+private:
+	size_t m_blockSize;
+	std::vector<Block> m_blocks;
+	// Bump position in the last block
+	size_t m_offset;
+
+	std::atomic<size_t> m_used;
+	std::atomic<size_t> m_peak;
+	std::atomic<size_t> m_capacity;
+	std::atomic<uint64_t> m_heapAllocations;
+};
+
+// std allocator on a FrameArena, deallocate() is a no-op
+template <typename T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	// Implicit, so containers take the arena directly: ArenaVector<int> v(arena)
+	ArenaAllocator(FrameArena& arena) : m_pArena(&arena) {}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) : m_pArena(other.arena()) {}
+
+	T* allocate(size_t count)
+	{
+		return static_cast<T*>(m_pArena->allocate(count * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T*, size_t) {}
+
+	FrameArena* arena() const { return m_pArena; }
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U>& other) const { return m_pArena == other.arena(); }
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const { return m_pArena != other.arena(); }
+
+private:
+	FrameArena* m_pArena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// One FrameArena per thread, created on the first local() of that thread.
+// Each thread resets its own arena when its part of the frame is done.
+class FrameArenas
+{
+public:
+	struct Stats
+	{
+		size_t threads = 0;
+		// Sums over the threads
+		size_t peak = 0;
+		size_t capacity = 0;
+		uint64_t heapAllocations = 0;
+	};
+
+	explicit FrameArenas(size_t blockSize = 64 * 1024);
+
+	FrameArenas(const FrameArenas&) = delete;
+	FrameArenas& operator=(const FrameArenas&) = delete;
+
+	// The calling thread's arena. Lock-free after the first call on a thread,
+	// as long as the thread doesn't alternate between FrameArenas
+	FrameArena& local();
+
+	// Any thread
+	Stats stats() const;
+
+private:
+	struct Entry
+	{
+		std::thread::id thread;
+		std::unique_ptr<FrameArena> arena;
+	};
+
+	// Tells instances apart in the per-thread cache, unlike an address it is never reused
+	uint64_t m_id;
+	size_t m_blockSize;
+	mutable std::mutex m_mutex;
+	std::vector<Entry> m_arenas;
+};
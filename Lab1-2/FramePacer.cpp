@@ -0,0 +1,173 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+class SystemTime : public FramePacer::TimeSource
+{
+public:
+    double now() override
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void sleep(double seconds) override
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    }
+
+    void spin() override
+    {
+        std::this_thread::yield();
+    }
+};
+
+FramePacer::TimeSource& FramePacer::systemTime()
+{
+    static SystemTime time;
+    return time;
+}
+
+FramePacer::FramePacer(TimeSource* time)
+    : FramePacer(Options(), time)
+{
+}
+
+FramePacer::FramePacer(const Options& options, TimeSource* time)
+    : m_options(options)
+    , m_pTime(time != nullptr ? time : &systemTime())
+    , m_minimized(false)
+    , m_focused(true)
+    , m_started(false)
+    , m_deadline(0.0)
+    , m_lastFrame(0.0)
+    , m_oversleepMean(options.sleepSlack)
+    , m_oversleepVariance(0.0)
+    , m_frameTimes((std::max)(options.window, (size_t)1), 0.0)
+    , m_frameCursor(0)
+{
+    m_stats.sleepSlackMs = options.sleepSlack * 1000.0;
+}
+
+void FramePacer::setActivity(bool minimized, bool focused)
+{
+    m_minimized = minimized;
+    m_focused = focused;
+}
+
+double FramePacer::framePeriod() const
+{
+    bool idle = m_minimized || (m_options.throttleWhenUnfocused && !m_focused);
+    double fps = idle && m_options.idleFps > 0.0 ? m_options.idleFps : m_options.targetFps;
+    return fps > 0.0 ? 1.0 / fps : 0.0;
+}
+
+void FramePacer::waitForNextFrame()
+{
+    double now = m_pTime->now();
+    if (!m_started)
+    {
+        m_started = true;
+        m_deadline = now;
+        m_lastFrame = now;
+    }
+
+    m_stats.sleptMs = 0.0;
+    m_stats.spunMs = 0.0;
+
+    double period = framePeriod();
+    if (period <= 0.0)
+    {
+        m_deadline = now;
+        recordFrame(now);
+        return;
+    }
+
+    // Deadlines advance by whole periods, so a late frame doesn't shift the ones after it
+    m_deadline += period;
+    if (m_deadline <= now)
+    {
+        // Too late to catch up without a burst of frames, start over from now
+        m_stats.missedFrames++;
+        m_deadline = now;
+        recordFrame(now);
+        return;
+    }
+
+    // Mean plus three deviations of the oversleep covers nearly every wakeup
+    double slack = (std::min)(m_oversleepMean + 3.0 * sqrt(m_oversleepVariance), m_options.maxSleepSlack);
+    slack = (std::max)(slack, 0.0);
+    m_stats.sleepSlackMs = slack * 1000.0;
+
+    double remaining = m_deadline - now;
+    if (remaining > slack)
+    {
+        double request = remaining - slack;
+        double before = now;
+        m_pTime->sleep(request);
+        now = m_pTime->now();
+
+        double oversleep = (std::max)(now - before - request, 0.0);
+        const double alpha = 0.1;
+        double difference = oversleep - m_oversleepMean;
+        m_oversleepMean += alpha * difference;
+        m_oversleepVariance = (1.0 - alpha) * (m_oversleepVariance + alpha * difference * difference);
+
+        m_stats.sleptMs = (now - before) * 1000.0;
+    }
+
+    double spinStart = now;
+    while (now < m_deadline)
+    {
+        m_pTime->spin();
+        now = m_pTime->now();
+    }
+    m_stats.spunMs = (now - spinStart) * 1000.0;
+
+    recordFrame(now);
+}
+
+void FramePacer::recordFrame(double now)
+{
+    if (m_stats.frames > 0)
+    {
+        m_frameTimes[m_frameCursor % m_frameTimes.size()] = now - m_lastFrame;
+        m_frameCursor++;
+    }
+    m_lastFrame = now;
+    m_stats.frames++;
+    m_stats.idle = m_minimized || (m_options.throttleWhenUnfocused && !m_focused);
+    if (m_stats.idle)
+    {
+        m_stats.idleFrames++;
+    }
+
+    size_t count = (std::min)(m_frameCursor, m_frameTimes.size());
+    if (count == 0)
+    {
+        return;
+    }
+
+    double sum = 0.0;
+    double minTime = m_frameTimes[0];
+    double maxTime = m_frameTimes[0];
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += m_frameTimes[i];
+        minTime = (std::min)(minTime, m_frameTimes[i]);
+        maxTime = (std::max)(maxTime, m_frameTimes[i]);
+    }
+    double mean = sum / count;
+    double squares = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+        squares += (m_frameTimes[i] - mean) * (m_frameTimes[i] - mean);
+    }
+
+    m_stats.averageMs = mean * 1000.0;
+    m_stats.minMs = minTime * 1000.0;
+    m_stats.maxMs = maxTime * 1000.0;
+    m_stats.jitterMs = sqrt(squares / count) * 1000.0;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Holds the frame loop to a target rate without burning a core. Waiting for the
+// next frame sleeps for most of the time left and spins only for the last bit;
+// how much is left to spinning follows the measured oversleep of the OS timer.
+// Minimized or unfocused windows drop to an idle rate.
+// Portable (std only). Time comes from a TimeSource, so tests run on a virtual clock.
+class FramePacer
+{
+public:
+	class TimeSource
+	{
+	public:
+		virtual ~TimeSource() = default;
+		// Seconds from any fixed point
+		virtual double now() = 0;
+		// May return late, never early
+		virtual void sleep(double seconds) = 0;
+		// One step of the final spin
+		virtual void spin() = 0;
+	};
+
+	// steady_clock, sleep_for and yield
+	static TimeSource& systemTime();
+
+	struct Options
+	{
+		// 0 - no limit, e.g. when presenting with vsync
+		double targetFps = 60.0;
+		// Used while minimized or unfocused, 0 - same as targetFps
+		double idleFps = 10.0;
+		bool throttleWhenUnfocused = true;
+		// Starting guess of how late sleep() returns
+		double sleepSlack = 0.002;
+		double maxSleepSlack = 0.020;
+		// Frames the jitter statistics cover
+		size_t window = 120;
+	};
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+		uint64_t idleFrames = 0;
+		// Over the window, between consecutive waitForNextFrame() returns
+		double averageMs = 0.0;
+		double minMs = 0.0;
+		double maxMs = 0.0;
+		// Standard deviation of the frame time
+		double jitterMs = 0.0;
+		// Last frame
+		double sleptMs = 0.0;
+		double spunMs = 0.0;
+		double sleepSlackMs = 0.0;
+		// Frames the deadline was already missed, the schedule restarts from there
+		uint64_t missedFrames = 0;
+		bool idle = false;
+	};
+
+	explicit FramePacer(TimeSource* time = nullptr);
+	FramePacer(const Options& options, TimeSource* time = nullptr);
+
+	void setTargetFps(double fps) { m_options.targetFps = fps; }
+	void setIdleFps(double fps) { m_options.idleFps = fps; }
+	void setThrottleWhenUnfocused(bool throttle) { m_options.throttleWhenUnfocused = throttle; }
+	const Options& options() const { return m_options; }
+
+	// Once per frame before deciding whether to render
+	void setActivity(bool minimized, bool focused);
+
+	// Nothing is visible while minimized, the loop only keeps the messages flowing
+	bool shouldRender() const { return !m_minimized; }
+
+	// At the end of the frame, returns when the next one is due
+	void waitForNextFrame();
+
+	const Stats& stats() const { return m_stats; }
+
+private:
+	double framePeriod() const;
+	void recordFrame(double now);
+
+private:
+	Options m_options;
+	TimeSource* m_pTime;
+
+	bool m_minimized;
+	bool m_focused;
+
+	bool m_started;
+	double m_deadline;
+	double m_lastFrame;
+
+	// Oversleep estimate, exponential moving mean and variance
+	double m_oversleepMean;
+	double m_oversleepVariance;
+
+	std::vector<double> m_frameTimes;
+	size_t m_frameCursor;
+
+	Stats m_stats;
+};
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Two-stage frame pipeline: a worker thread simulates frame N+1 while the render
+// thread draws frame N. The render thread hands in the input of a frame with
+// submit() and takes the finished snapshot with acquire(). There are two snapshot
+// slots, the one being drawn and the one being simulated; the drawn one is only
+// handed out as const and nothing writes it until the next acquire(). Slots are
+// reused, so containers in a snapshot keep their capacity from frame to frame.
+// Portable (std only).
+template <typename Input, typename Snapshot>
+class FramePipeline
+{
+public:
+	// Runs on the worker. The slot still holds a frame from two submits ago
+	using StepFn = std::function<void(const Input& input, Snapshot& snapshot)>;
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+		// Last frame
+		double stepMs = 0.0;
+		// Render thread blocked in acquire(), 0 when the worker kept ahead
+		double waitMs = 0.0;
+		// Worker waited for input or for the drawn slot
+		double idleMs = 0.0;
+	};
+
+	explicit FramePipeline(StepFn step)
+		: m_step(std::move(step))
+		, m_submitted(0)
+		, m_produced(0)
+		, m_acquired(0)
+		, m_stop(false)
+	{
+		m_thread = std::thread(&FramePipeline::workerLoop, this);
+	}
+
+	// Frames submitted but not acquired are dropped
+	~FramePipeline()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		m_thread.join();
+	}
+
+	FramePipeline(const FramePipeline&) = delete;
+	FramePipeline& operator=(const FramePipeline&) = delete;
+
+	// Render thread. At most two frames are in flight, so with two pending
+	// the oldest has to be acquired first; until then nothing is submitted and
+	// false is returned, as the worker may still be reading that input
+	bool submit(const Input& input)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_submitted - m_acquired >= 2)
+			{
+				return false;
+			}
+			// The input two frames back was consumed, its frame has been acquired
+			m_inputs[m_submitted % 2] = input;
+			++m_submitted;
+		}
+		m_wake.notify_all();
+		return true;
+	}
+
+	// Render thread. Waits for the oldest pending frame; the previously acquired
+	// snapshot is released and must not be used any more
+	const Snapshot& acquire()
+	{
+		auto start = Clock::now();
+		std::unique_lock<std::mutex> lock(m_mutex);
+		assert(m_acquired < m_submitted);
+		m_ready.wait(lock, [this]() { return m_produced > m_acquired; });
+		m_stats.waitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		uint64_t frame = m_acquired++;
+		lock.unlock();
+		m_wake.notify_all();
+		return m_slots[frame % 2];
+	}
+
+	// Submitted frames not acquired yet
+	size_t pending() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return (size_t)(m_submitted - m_acquired);
+	}
+
+	Stats stats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_stats;
+	}
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	// A slot is free once the frame before the one it held is acquired
+	bool canStep() const
+	{
+		return m_produced < m_submitted && (m_produced < 2 || m_acquired >= m_produced);
+	}
+
+	void workerLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		for (;;)
+		{
+			auto idleStart = Clock::now();
+			m_wake.wait(lock, [this]() { return m_stop || canStep(); });
+			if (m_stop)
+			{
+				return;
+			}
+
+			uint64_t frame = m_produced;
+			auto stepStart = Clock::now();
+			lock.unlock();
+
+			m_step(m_inputs[frame % 2], m_slots[frame % 2]);
+
+			auto stepEnd = Clock::now();
+			lock.lock();
+			++m_produced;
+			m_stats.frames = m_produced;
+			m_stats.stepMs = std::chrono::duration<double, std::milli>(stepEnd - stepStart).count();
+			m_stats.idleMs = std::chrono::duration<double, std::milli>(stepStart - idleStart).count();
+			m_ready.notify_all();
+		}
+	}
+
+private:
+	StepFn m_step;
+
+	Input m_inputs[2];
+	Snapshot m_slots[2];
+
+	// Frame counters, frame n uses input and slot n % 2
+	uint64_t m_submitted;
+	uint64_t m_produced;
+	uint64_t m_acquired;
+	bool m_stop;
+
+	mutable std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_ready;
+	std::thread m_thread;
+
+	Stats m_stats;
+};
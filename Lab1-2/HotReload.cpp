@@ -0,0 +1,217 @@
+#include "HotReload.h"
+
+#include <memory>
+
+HotReload::HotReload(ThreadPool* pool, ShaderIncludeCache* includes)
+    : m_pPool(pool)
+    , m_pIncludes(includes)
+    , m_started(false)
+    , m_inFlight(0)
+{
+}
+
+HotReload::~HotReload()
+{
+    m_watcher.stop();
+    // Builds finished but not swapped are dropped with the queue
+    flush();
+}
+
+void HotReload::addShaders(QueueFn queueShaders, ReloadFn reload)
+{
+    ShaderOwner owner;
+    owner.queueShaders = std::move(queueShaders);
+    owner.reload = std::move(reload);
+
+    ShaderBuildQueue queue;
+    owner.queueShaders(queue);
+    for (const ShaderBuildQueue::Job& job : queue.jobs())
+    {
+        std::string source = AssetDependencyGraph::normalize(job.source);
+        if (!job.source.empty() && !m_graph.isAsset(source))
+        {
+            m_graph.addAsset(source);
+        }
+        bool known = false;
+        for (const std::string& existing : owner.sources)
+        {
+            known = known || existing == source;
+        }
+        if (!job.source.empty() && !known)
+        {
+            owner.sources.push_back(source);
+        }
+    }
+
+    m_owners.push_back(std::move(owner));
+}
+
+void HotReload::addTexture(const std::string& filename, TextureFn reload)
+{
+    std::string normalized = AssetDependencyGraph::normalize(filename);
+    m_graph.addAsset(normalized, false);
+    m_textures.push_back({ normalized, std::move(reload) });
+}
+
+void HotReload::start()
+{
+    watchGraph();
+    m_watcher.start();
+    m_started = true;
+}
+
+void HotReload::watchGraph()
+{
+    // Already watched files are skipped, so this also picks up includes added by an edit
+    for (const std::string& file : m_graph.files())
+    {
+        m_watcher.watch(file);
+    }
+    m_stats.watchedFiles = m_watcher.watchedCount();
+}
+
+void HotReload::notifyChanged(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_changedMutex);
+    m_changed.push_back(filename);
+}
+
+void HotReload::update()
+{
+    std::vector<std::string> changed;
+    {
+        std::lock_guard<std::mutex> lock(m_changedMutex);
+        changed.swap(m_changed);
+    }
+    m_watcher.poll(changed);
+
+    if (!changed.empty())
+    {
+        std::unordered_set<std::string> affected;
+        for (const std::string& file : changed)
+        {
+            m_stats.changes++;
+            // The next compile reads the new contents, and picks up includes added by the edit
+            m_pIncludes->invalidate(AssetDependencyGraph::normalize(file));
+            m_graph.rescan(file);
+            for (const std::string& asset : m_graph.affectedAssets(file))
+            {
+                affected.insert(asset);
+            }
+        }
+
+        if (m_started)
+        {
+            watchGraph();
+        }
+
+        for (Texture& texture : m_textures)
+        {
+            if (affected.count(texture.filename) != 0)
+            {
+                texture.reload();
+                m_stats.textureReloads++;
+            }
+        }
+
+        for (ShaderOwner& owner : m_owners)
+        {
+            for (const std::string& source : owner.sources)
+            {
+                if (affected.count(source) != 0)
+                {
+                    owner.dirty.insert(source);
+                }
+            }
+        }
+    }
+
+    // Swap what finished since the last frame
+    Build build;
+    while (m_finished.pop(build))
+    {
+        ShaderOwner& owner = m_owners[build.owner];
+        owner.building = false;
+        m_stats.lastBuildMs = build.ms;
+        m_stats.shadersCompiled += build.jobs;
+
+        if (!build.failed.empty())
+        {
+            m_stats.failures++;
+            m_stats.lastError = build.failed;
+            continue;
+        }
+        if (!owner.reload())
+        {
+            m_stats.failures++;
+            continue;
+        }
+        m_stats.swaps++;
+    }
+
+    // An owner builds one batch at a time, changes made meanwhile wait for the next
+    for (size_t i = 0; i < m_owners.size(); i++)
+    {
+        if (!m_owners[i].building && !m_owners[i].dirty.empty())
+        {
+            startBuild(i);
+        }
+    }
+}
+
+void HotReload::startBuild(size_t ownerIndex)
+{
+    ShaderOwner& owner = m_owners[ownerIndex];
+
+    ShaderBuildQueue all;
+    owner.queueShaders(all);
+    auto pQueue = std::make_shared<ShaderBuildQueue>();
+    for (const ShaderBuildQueue::Job& job : all.jobs())
+    {
+        if (owner.dirty.count(AssetDependencyGraph::normalize(job.source)) != 0)
+        {
+            pQueue->add(job.name, job.compile, job.source);
+        }
+    }
+    owner.dirty.clear();
+    if (pQueue->jobs().empty())
+    {
+        return;
+    }
+
+    owner.building = true;
+    m_stats.builds++;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_inFlight;
+    }
+
+    // A handful of jobs, one task per owner; owners edited together still build in parallel
+    m_pPool->submit([this, ownerIndex, pQueue]()
+    {
+        pQueue->run(nullptr);
+
+        Build build;
+        build.owner = ownerIndex;
+        build.jobs = pQueue->jobs().size();
+        build.ms = pQueue->stats().wallMs;
+        for (const ShaderBuildQueue::Job& job : pQueue->jobs())
+        {
+            if (!job.succeeded)
+            {
+                build.failed += (build.failed.empty() ? "" : ", ") + job.name;
+            }
+        }
+        m_finished.push(std::move(build));
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        --m_inFlight;
+        m_inFlightDone.notify_all();
+    });
+}
+
+void HotReload::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_inFlightDone.wait(lock, [this]() { return m_inFlight == 0; });
+}
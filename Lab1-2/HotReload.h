@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "AssetDependencyGraph.h"
+#include "CompletionQueue.h"
+#include "FileWatcher.h"
+#include "ShaderBuildQueue.h"
+#include "ShaderCache.h"
+#include "ThreadPool.h"
+
+// Rebuilds what an edited file affects while the app keeps running.
+// Shader owners hand in the same job list they build at startup; when a source
+// or anything it includes changes, only the jobs of the affected files are
+// compiled again, on the pool and into the shader cache. The owner then
+// recreates its objects from the cache inside update(), between two frames,
+// so a frame sees either all old or all new shaders. A failed compile leaves
+// the old shaders in place. Textures are only re-requested, the texture loader
+// already delivers them at a frame boundary.
+// Portable (std only), runs headless.
+class HotReload
+{
+public:
+	using QueueFn = std::function<void(ShaderBuildQueue& queue)>;
+	// Runs inside update(). false - the old objects are kept
+	using ReloadFn = std::function<bool()>;
+	using TextureFn = std::function<void()>;
+
+	struct Stats
+	{
+		size_t watchedFiles = 0;
+		uint64_t changes = 0;
+		uint64_t builds = 0;
+		uint64_t shadersCompiled = 0;
+		uint64_t swaps = 0;
+		uint64_t textureReloads = 0;
+		uint64_t failures = 0;
+		double lastBuildMs = 0.0;
+		// Jobs of the last failed build
+		std::string lastError;
+	};
+
+	// includes - the cache the compile jobs read includes through, edited files are dropped from it
+	HotReload(ThreadPool* pool, ShaderIncludeCache* includes);
+	~HotReload();
+
+	HotReload(const HotReload&) = delete;
+	HotReload& operator=(const HotReload&) = delete;
+
+	void addShaders(QueueFn queueShaders, ReloadFn reload);
+	void addTexture(const std::string& filename, TextureFn reload);
+
+	// Watches every file known so far on the watcher's thread
+	void start();
+
+	// Once per frame on the thread owning the device, before anything is drawn
+	void update();
+
+	// Same as a change reported by the watcher, picked up by the next update()
+	void notifyChanged(const std::string& filename);
+
+	// Blocks until every background build is finished, its swap still waits for update()
+	void flush();
+
+	FileWatcher& watcher() { return m_watcher; }
+	const AssetDependencyGraph& graph() const { return m_graph; }
+	const Stats& stats() const { return m_stats; }
+
+private:
+	struct ShaderOwner
+	{
+		QueueFn queueShaders;
+		ReloadFn reload;
+		std::vector<std::string> sources;
+		// Sources changed since the last build started
+		std::unordered_set<std::string> dirty;
+		bool building = false;
+	};
+
+	struct Build
+	{
+		size_t owner = 0;
+		size_t jobs = 0;
+		double ms = 0.0;
+		std::string failed;
+	};
+
+	struct Texture
+	{
+		std::string filename;
+		TextureFn reload;
+	};
+
+	void watchGraph();
+	void startBuild(size_t ownerIndex);
+
+private:
+	ThreadPool* m_pPool;
+	ShaderIncludeCache* m_pIncludes;
+
+	FileWatcher m_watcher;
+	AssetDependencyGraph m_graph;
+	bool m_started;
+
+	std::vector<ShaderOwner> m_owners;
+	std::vector<Texture> m_textures;
+
+	std::mutex m_changedMutex;
+	std::vector<std::string> m_changed;
+
+	CompletionQueue<Build> m_finished;
+	size_t m_inFlight;
+	std::mutex m_mutex;
+	std::condition_variable m_inFlightDone;
+
+	Stats m_stats;
+};
@@ -1,35 +1,35 @@
 #include "LightModel.h"
 
-LightModel::LightModel(ID3D11Device* device)
+static const wchar_t* VertexShaderFile = L"resources/shaders/light_source_vs.hlsl";
+static const wchar_t* PixelShaderFile = L"resources/shaders/light_source_ps.hlsl";
+
+LightModel::LightModel(ID3D11Device* device, D3DResources* resources)
 	: m_pDevice(device)
-    , m_pIndexBuffer(nullptr)
-    , m_pInputLayout(nullptr)
-    , m_pPixelShader(nullptr)
-    , m_pVertexBuffer(nullptr)
-    , m_pVertexShader(nullptr)
+    , m_pResources(resources)
 {
 	initBuffers();
-	initInputLayout();
+	createShaders(m_vertexShader, m_pixelShader, m_inputLayout);
 }
 
-LightModel::~LightModel()
+void LightModel::queueShaders(ShaderBuildQueue& queue)
 {
-	terminate();
+    queueShader(queue, VertexShaderFile, {}, shader_stage::Vertex);
+    queueShader(queue, PixelShaderFile, {}, shader_stage::Pixel);
 }
 
 void LightModel::render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer)
 {
-    context->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    ID3D11Buffer* vertexBuffers[] = { m_pVertexBuffer };
+    context->IASetIndexBuffer(m_indexBuffer.get<ID3D11Buffer>(), DXGI_FORMAT_R16_UINT, 0);
+    ID3D11Buffer* vertexBuffers[] = { m_vertexBuffer.get<ID3D11Buffer>() };
     UINT strides[] = { 12 };
     UINT offsets[] = { 0 };
-    context->IASetVertexBuffers(0, 1, &m_pVertexBuffer, strides, offsets);
-    context->IASetInputLayout(m_pInputLayout);
+    context->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+    context->IASetInputLayout(m_inputLayout.get<ID3D11InputLayout>());
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    context->VSSetShader(m_pVertexShader, nullptr, 0);
+    context->VSSetShader(m_vertexShader.get<ID3D11VertexShader>(), nullptr, 0);
     context->VSSetConstantBuffers(0, 1, &sceneBuffer);
     context->VSSetConstantBuffers(1, 1, &geomBuffer);
-    context->PSSetShader(m_pPixelShader, nullptr, 0);
+    context->PSSetShader(m_pixelShader.get<ID3D11PixelShader>(), nullptr, 0);
     context->DrawIndexed(indexCount, 0, 0);
 }
 
@@ -98,12 +98,14 @@ bool LightModel::initBuffers()
     D3D11_SUBRESOURCE_DATA vertexData = {};
     vertexData.pSysMem = sphereVertices.data();
     vertexData.SysMemPitch = sphereVertices.size() * sizeof(DirectX::XMFLOAT3);
-    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &m_pVertexBuffer);
+    ID3D11Buffer* pVertexBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &pVertexBuffer);
+    m_vertexBuffer = m_pResources->buffer(pVertexBuffer);
 
     if (!SUCCEEDED(result))
         return false;
 
-    result = SetResourceName(m_pVertexBuffer, "light source vertex buffer");
+    result = SetResourceName(pVertexBuffer, "light source vertex buffer");
 
     D3D11_BUFFER_DESC indexBufferDesc = {};
     indexBufferDesc.ByteWidth = UINT16(indices.size() * sizeof(UINT16));
@@ -116,17 +118,19 @@ bool LightModel::initBuffers()
     D3D11_SUBRESOURCE_DATA indexData = {};
     indexData.pSysMem = indices.data();
     indexData.SysMemPitch = UINT16(indices.size() * sizeof(UINT16));
-    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &m_pIndexBuffer);
+    ID3D11Buffer* pIndexBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &pIndexBuffer);
+    m_indexBuffer = m_pResources->buffer(pIndexBuffer);
 
     if (!SUCCEEDED(result))
         return false;
 
-    result = SetResourceName(m_pIndexBuffer, "light source index buffer");
+    result = SetResourceName(pIndexBuffer, "light source index buffer");
 
     return true;
 }
 
-bool LightModel::initInputLayout()
+bool LightModel::createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader, ResourcePool::Unique& inputLayout)
 {
     static const D3D11_INPUT_ELEMENT_DESC inputDesc[] = 
     {
@@ -138,19 +142,25 @@ bool LightModel::initInputLayout()
     ID3DBlob* pVertexShaderCode = nullptr;
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/light_source_vs.hlsl", {}, shader_stage::Vertex, (ID3D11DeviceChild**)&m_pVertexShader, &pVertexShaderCode);
+        ID3D11VertexShader* pVertexShader = nullptr;
+        result = compileShader(m_pDevice, VertexShaderFile, {}, shader_stage::Vertex, (ID3D11DeviceChild**)&pVertexShader, &pVertexShaderCode);
+        vertexShader = m_pResources->add(D3DResources::Shader, pVertexShader);
     }
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/light_source_ps.hlsl", {}, shader_stage::Pixel, (ID3D11DeviceChild**)&m_pPixelShader);
+        ID3D11PixelShader* pPixelShader = nullptr;
+        result = compileShader(m_pDevice, PixelShaderFile, {}, shader_stage::Pixel, (ID3D11DeviceChild**)&pPixelShader);
+        pixelShader = m_pResources->add(D3DResources::Shader, pPixelShader);
     }
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(inputDesc, 1, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pInputLayout);
+        ID3D11InputLayout* pInputLayout = nullptr;
+        result = m_pDevice->CreateInputLayout(inputDesc, 1, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &pInputLayout);
+        inputLayout = m_pResources->add(D3DResources::InputLayout, pInputLayout);
         if (SUCCEEDED(result))
         {
-            result = SetResourceName(m_pInputLayout, "InputLayout");
+            result = SetResourceName(pInputLayout, "InputLayout");
         }
     }
 
@@ -160,38 +170,22 @@ bool LightModel::initInputLayout()
         pVertexShaderCode = nullptr;
     }
 
-    return result;
+    return SUCCEEDED(result) && vertexShader && pixelShader && inputLayout;
 }
 
-void LightModel::terminate()
+bool LightModel::reloadShaders()
 {
-    if (m_pInputLayout != nullptr)
-    {
-        m_pInputLayout->Release();
-        m_pInputLayout = nullptr;
-    }
-
-    if (m_pPixelShader != nullptr)
-    {
-        m_pPixelShader->Release();
-        m_pPixelShader = nullptr;
-    }
-
-    if (m_pVertexShader != nullptr)
+    ResourcePool::Unique vertexShader;
+    ResourcePool::Unique pixelShader;
+    ResourcePool::Unique inputLayout;
+    if (!createShaders(vertexShader, pixelShader, inputLayout))
     {
-        m_pVertexShader->Release();
-        m_pVertexShader = nullptr;
-    }
-
-    if (m_pIndexBuffer != nullptr)
-    {
-        m_pIndexBuffer->Release();
-        m_pIndexBuffer = nullptr;
+        // The old set stays
+        return false;
     }
 
-    if (m_pVertexBuffer != nullptr)
-    {
-        m_pVertexBuffer->Release();
-        m_pVertexBuffer = nullptr;
-    }
+    m_vertexShader = std::move(vertexShader);
+    m_pixelShader = std::move(pixelShader);
+    m_inputLayout = std::move(inputLayout);
+    return true;
 }
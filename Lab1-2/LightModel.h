@@ -1,30 +1,34 @@
 #pragma once
 
 #include "framework.h"
+#include "D3DResources.h"
 
 class LightModel
 {
 public:
-	LightModel(ID3D11Device* device);
-	~LightModel();
+	LightModel(ID3D11Device* device, D3DResources* resources);
+
+	static void queueShaders(ShaderBuildQueue& queue);
+
+	// Recreates the shader objects from the shader cache, false - the old ones are kept
+	bool reloadShaders();
 
 	void render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer);
 
 private:
 	bool initBuffers();
-	bool initInputLayout();
-
-	void terminate();
+	bool createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader, ResourcePool::Unique& inputLayout);
 
 private:
 	ID3D11Device* m_pDevice;
+	D3DResources* m_pResources;
 
-	ID3D11Buffer* m_pIndexBuffer;
-	ID3D11Buffer* m_pVertexBuffer;
+	ResourcePool::Unique m_indexBuffer;
+	ResourcePool::Unique m_vertexBuffer;
 
-	ID3D11PixelShader* m_pPixelShader;
-	ID3D11VertexShader* m_pVertexShader;
-	ID3D11InputLayout* m_pInputLayout;
+	ResourcePool::Unique m_pixelShader;
+	ResourcePool::Unique m_vertexShader;
+	ResourcePool::Unique m_inputLayout;
 
 	size_t indexCount;
 	size_t vertexCount;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// Records the render passes of a frame in parallel, one recording context per
+// pass, then has the backend execute the recorded lists in pass order on the
+// calling thread. Passes can't rely on state left by an earlier one, each sets
+// up everything it draws with. Serially the same passes record straight into
+// the immediate context, in order.
+// Portable (std only), the graphics API is behind Backend.
+template <typename Context>
+class PassRecorder
+{
+public:
+	using RecordFn = std::function<void(Context* context)>;
+
+	class Backend
+	{
+	public:
+		virtual ~Backend() = default;
+		// Worker threads, each pass on its own context
+		virtual Context* beginPass(size_t pass) = 0;
+		virtual void finishPass(size_t pass) = 0;
+		// Calling thread, in pass order
+		virtual void executePass(size_t pass) = 0;
+	};
+
+	struct Stats
+	{
+		size_t passes = 0;
+		bool parallel = false;
+		// Last frame. recordMs sums every pass, wallMs is until the last one finished
+		double recordMs = 0.0;
+		double wallMs = 0.0;
+		double executeMs = 0.0;
+		std::vector<double> passMs;
+	};
+
+	explicit PassRecorder(ThreadPool* pool)
+		: m_pPool(pool)
+	{
+	}
+
+	void addPass(const std::string& name, RecordFn record)
+	{
+		m_passes.push_back({ name, std::move(record) });
+		m_stats.passes = m_passes.size();
+		m_stats.passMs.resize(m_passes.size(), 0.0);
+	}
+
+	size_t passCount() const { return m_passes.size(); }
+	const std::string& passName(size_t pass) const { return m_passes[pass].name; }
+
+	// backend == nullptr - every pass records into immediate on the calling thread
+	void run(Backend* backend, Context* immediate)
+	{
+		auto start = Clock::now();
+		m_stats.parallel = backend != nullptr;
+
+		if (backend == nullptr)
+		{
+			for (size_t i = 0; i < m_passes.size(); i++)
+			{
+				auto passStart = Clock::now();
+				m_passes[i].record(immediate);
+				m_stats.passMs[i] = msSince(passStart);
+			}
+			m_stats.wallMs = msSince(start);
+			m_stats.executeMs = 0.0;
+		}
+		else
+		{
+			m_pPool->parallelFor(m_passes.size(), 1, [this, backend](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; i++)
+				{
+					auto passStart = Clock::now();
+					Context* context = backend->beginPass(i);
+					m_passes[i].record(context);
+					backend->finishPass(i);
+					m_stats.passMs[i] = msSince(passStart);
+				}
+			});
+			m_stats.wallMs = msSince(start);
+
+			auto executeStart = Clock::now();
+			for (size_t i = 0; i < m_passes.size(); i++)
+			{
+				backend->executePass(i);
+			}
+			m_stats.executeMs = msSince(executeStart);
+		}
+
+		m_stats.recordMs = 0.0;
+		for (double ms : m_stats.passMs)
+		{
+			m_stats.recordMs += ms;
+		}
+	}
+
+	const Stats& stats() const { return m_stats; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	static double msSince(Clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	struct Pass
+	{
+		std::string name;
+		RecordFn record;
+	};
+
+	ThreadPool* m_pPool;
+	std::vector<Pass> m_passes;
+	Stats m_stats;
+};
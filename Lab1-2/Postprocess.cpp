@@ -1,39 +1,41 @@
 #include "Postprocess.h"
 
-Postprocess::Postprocess(ID3D11Device* device, int width, int height)
+static const wchar_t* VertexShaderFile = L"resources/shaders/filter_vs.hlsl";
+static const wchar_t* PixelShaderFile = L"resources/shaders/filter_ps.hlsl";
+
+Postprocess::Postprocess(ID3D11Device* device, D3DResources* resources, int width, int height)
     : m_pDevice(device)
-    , m_pPixelShader(nullptr)
-    , m_pVertexShader(nullptr)
-    , m_pScene(nullptr)
-    , m_pSceneRTV(nullptr)
-    , m_pSceneSRV(nullptr)
+    , m_pResources(resources)
     , m_width(width)
     , m_height(height)
 {
-    initShaders();
+    createShaders(m_vertexShader, m_pixelShader);
     initResources();
 }
 
-Postprocess::~Postprocess()
+void Postprocess::queueShaders(ShaderBuildQueue& queue)
 {
-	terminate();
+    queueShader(queue, VertexShaderFile, {}, shader_stage::Vertex);
+    queueShader(queue, PixelShaderFile, {}, shader_stage::Pixel);
 }
 
-void Postprocess::render(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, ID3D11SamplerState* sampler)
+void Postprocess::render(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, ID3D11Buffer* sceneBuffer, ID3D11SamplerState* sampler)
 {
     ID3D11RenderTargetView* views[] = { backBuffer };
     context->OMSetRenderTargets(1, views, nullptr);
     ID3D11SamplerState* samplers[] = { sampler };
     context->PSSetSamplers(0, 1, samplers);
-    ID3D11ShaderResourceView* textures[] = { m_pSceneSRV };
+    ID3D11ShaderResourceView* textures[] = { m_sceneSRV.get<ID3D11ShaderResourceView>() };
     context->PSSetShaderResources(0, 1, textures);
     context->OMSetDepthStencilState(nullptr, 0);
     context->OMSetBlendState(nullptr, nullptr, 0xFFFFFFFF);
     context->RSSetState(nullptr);
     context->IASetInputLayout(nullptr);
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    context->VSSetShader(m_pVertexShader, nullptr, 0);
-    context->PSSetShader(m_pPixelShader, nullptr, 0);
+    context->VSSetShader(m_vertexShader.get<ID3D11VertexShader>(), nullptr, 0);
+    context->PSSetShader(m_pixelShader.get<ID3D11PixelShader>(), nullptr, 0);
+    // The filter switch is in the scene parameters
+    context->PSSetConstantBuffers(0, 1, &sceneBuffer);
     context->Draw(3, 0);
 }
 
@@ -42,23 +44,10 @@ bool Postprocess::reinit(int width, int height)
     m_width = width;
     m_height = height;
 
-    if (m_pSceneSRV != nullptr)
-    {
-        m_pSceneSRV->Release();
-        m_pSceneSRV = nullptr;
-    }
-
-    if (m_pSceneRTV != nullptr)
-    {
-        m_pSceneRTV->Release();
-        m_pSceneRTV = nullptr;
-    }
-
-    if (m_pScene != nullptr)
-    {
-        m_pScene->Release();
-        m_pScene = nullptr;
-    }
+    // Frames still in flight may sample the old texture, the pool keeps it until they are done
+    m_sceneSRV.reset();
+    m_sceneRTV.reset();
+    m_scene.reset();
 
     if (!initResources())
         return false;
@@ -66,20 +55,35 @@ bool Postprocess::reinit(int width, int height)
     return true;
 }
 
-bool Postprocess::initShaders()
+bool Postprocess::createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader)
 {
-    HRESULT result = S_OK;
+    ID3D11VertexShader* pVertexShader = nullptr;
+    ID3D11PixelShader* pPixelShader = nullptr;
 
+    HRESULT result = compileShader(m_pDevice, VertexShaderFile, {}, shader_stage::Vertex, (ID3D11DeviceChild**)&pVertexShader);
+    vertexShader = m_pResources->add(D3DResources::Shader, pVertexShader);
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/filter_vs.hlsl", {}, shader_stage::Vertex, (ID3D11DeviceChild**)&m_pVertexShader);
+        result = compileShader(m_pDevice, PixelShaderFile, {}, shader_stage::Pixel, (ID3D11DeviceChild**)&pPixelShader);
+        pixelShader = m_pResources->add(D3DResources::Shader, pPixelShader);
     }
-    if (SUCCEEDED(result))
+
+    return SUCCEEDED(result) && vertexShader && pixelShader;
+}
+
+bool Postprocess::reloadShaders()
+{
+    ResourcePool::Unique vertexShader;
+    ResourcePool::Unique pixelShader;
+    if (!createShaders(vertexShader, pixelShader))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/filter_ps.hlsl", {}, shader_stage::Pixel, (ID3D11DeviceChild**)&m_pPixelShader);
+        // The old pair stays
+        return false;
     }
 
-	return false;
+    m_vertexShader = std::move(vertexShader);
+    m_pixelShader = std::move(pixelShader);
+    return true;
 }
 
 bool Postprocess::initResources()
@@ -97,63 +101,36 @@ bool Postprocess::initResources()
     filterDesc.Width = m_width;
     filterDesc.MipLevels = 1;
 
-    HRESULT result = m_pDevice->CreateTexture2D(&filterDesc, nullptr, &m_pScene);
+    ID3D11Texture2D* pScene = nullptr;
+    HRESULT result = m_pDevice->CreateTexture2D(&filterDesc, nullptr, &pScene);
+    m_scene = m_pResources->texture(pScene);
     if (FAILED(result))
     {
         return false;
     }
 
-    //result = SetResourceName(m_pScene, "scene texture");
+    //result = SetResourceName(pScene, "scene texture");
 
     // we will draw scene in this RTV
-    result = m_pDevice->CreateRenderTargetView(m_pScene, nullptr, &m_pSceneRTV);
+    ID3D11RenderTargetView* pSceneRTV = nullptr;
+    result = m_pDevice->CreateRenderTargetView(pScene, nullptr, &pSceneRTV);
+    m_sceneRTV = m_pResources->add(D3DResources::View, pSceneRTV);
     if (FAILED(result))
     {
         return false;
     }
 
-    //result = SetResourceName(m_pSceneRTV, "scene render target");
+    //result = SetResourceName(pSceneRTV, "scene render target");
 
-    result = m_pDevice->CreateShaderResourceView(m_pScene, nullptr, &m_pSceneSRV);
+    ID3D11ShaderResourceView* pSceneSRV = nullptr;
+    result = m_pDevice->CreateShaderResourceView(pScene, nullptr, &pSceneSRV);
+    m_sceneSRV = m_pResources->add(D3DResources::View, pSceneSRV);
     if (FAILED(result))
     {
         return false;
     }
 
-    //result = SetResourceName(m_pSceneRTV, "scene shader resource");
+    //result = SetResourceName(pSceneSRV, "scene shader resource");
 
 	return true;
 }
-
-void Postprocess::terminate()
-{
-    if (m_pSceneSRV != nullptr)
-    {
-        m_pSceneSRV->Release();
-        m_pSceneSRV = nullptr;
-    }
-
-    if (m_pSceneRTV != nullptr)
-    {
-        m_pSceneRTV->Release();
-        m_pSceneRTV = nullptr;
-    }
-
-    if (m_pScene != nullptr)
-    {
-        m_pScene->Release();
-        m_pScene = nullptr;
-    }
-
-    if (m_pVertexShader != nullptr)
-    {
-        m_pVertexShader->Release();
-        m_pVertexShader = nullptr;
-    }
-
-    if (m_pPixelShader != nullptr)
-    {
-        m_pPixelShader->Release();
-        m_pPixelShader = nullptr;
-    }
-}
@@ -1,34 +1,38 @@
 #pragma once
 
 #include "framework.h"
+#include "D3DResources.h"
 
 class Postprocess
 {
 public:
-	Postprocess(ID3D11Device* device, int width, int height);
-	~Postprocess();
+	Postprocess(ID3D11Device* device, D3DResources* resources, int width, int height);
 
-	void render(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, ID3D11SamplerState* sampler);
+	static void queueShaders(ShaderBuildQueue& queue);
+
+	// Recreates the shader objects from the shader cache, false - the old ones are kept
+	bool reloadShaders();
+
+	void render(ID3D11DeviceContext* context, ID3D11RenderTargetView* backBuffer, ID3D11Buffer* sceneBuffer, ID3D11SamplerState* sampler);
 
 	bool reinit(int width, int height);
 
-	ID3D11RenderTargetView* getRenderTarget() { return m_pSceneRTV; }
+	ID3D11RenderTargetView* getRenderTarget() { return m_sceneRTV.get<ID3D11RenderTargetView>(); }
 
 private:
-	bool initShaders();
+	bool createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader);
 	bool initResources();
 
-	void terminate();
-
 private:
 	ID3D11Device* m_pDevice;
+	D3DResources* m_pResources;
 
-	ID3D11PixelShader* m_pPixelShader;
-	ID3D11VertexShader* m_pVertexShader;
+	ResourcePool::Unique m_pixelShader;
+	ResourcePool::Unique m_vertexShader;
 
-	ID3D11Texture2D* m_pScene;
-	ID3D11RenderTargetView* m_pSceneRTV;
-	ID3D11ShaderResourceView* m_pSceneSRV;
+	ResourcePool::Unique m_scene;
+	ResourcePool::Unique m_sceneRTV;
+	ResourcePool::Unique m_sceneSRV;
 
 	int m_width;
 	int m_height;
@@ -10,10 +10,17 @@
 using namespace DirectX;
 
 static const float rotationSpeed = PI / 6;
+static const char* FrameTimesFile = "frame_times.txt";
 static const float sensitivity = PI;
 
+static double msSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
 bool Render::init(HWND window)
 {
+    auto initStart = std::chrono::steady_clock::now();
     HRESULT result;
 
     // Create a DirectX graphics interface factory.
@@ -100,6 +107,14 @@ bool Render::init(HWND window)
         pFactory = nullptr;
     }
 
+    // Scene objects keep handles into it from here on
+    m_pResources = new D3DResources();
+    m_pFrameFence = new FrameFence(m_pDevice);
+    m_pResources->pool().setFrameFence(m_pFrameFence->signaled() + 1);
+
+    m_startup.deviceMs = msSince(initStart);
+    auto stageStart = std::chrono::steady_clock::now();
+
     result = initScene();
     if (!SUCCEEDED(result))
         return result;
@@ -139,28 +154,135 @@ bool Render::init(HWND window)
         m_sceneBuffer.AmbientColor = { 0.57 * 1.0f / 3.0f, 0.541 * 1.0f / 3.0f, 0.722 * 1.0f / 4.0f, 1.0 };
     }
 
+    m_pThreadPool = new ThreadPool();
+    m_pTextureLoader = new AsyncTextureLoader(m_pThreadPool);
+    m_pTextureStreamer = new TextureStreamer((size_t)m_streamingBudgetKb * 1024);
+    m_startup.sceneSetupMs = msSince(stageStart);
+
+    // All scene shaders are compiled at once on the pool, the constructors below only create the objects from the cache
+    stageStart = std::chrono::steady_clock::now();
+    ShaderBuildQueue shaderQueue;
+    TexturedCube::queueShaders(shaderQueue);
+    Skybox::queueShaders(shaderQueue);
+    TransparentRect::queueShaders(shaderQueue);
+    Postprocess::queueShaders(shaderQueue);
+    LightModel::queueShaders(shaderQueue);
+    shaderQueue.run(m_pThreadPool);
+    m_startup.shaders = shaderQueue.stats();
+    m_startup.shadersMs = msSince(stageStart);
+    stageStart = std::chrono::steady_clock::now();
+
     //m_pTriangle = new Triangle(m_pDevice);
     m_pCamera = new Camera;
     //m_pCube = new Cube(m_pDevice);
-    m_pCube = new TexturedCube(m_pDevice);
+    m_pCube = new TexturedCube(m_pDevice, m_pResources, m_pTextureLoader, m_pTextureStreamer);
     //m_pCube2 = new TexturedCube(m_pDevice);
-    m_pSkybox = new Skybox(m_pDevice);
-    m_pRect1 = new TransparentRect(m_pDevice, 1.0f, 0, 0, 128);
-    m_pRect2 = new TransparentRect(m_pDevice, -1.0f, 128, 0, 0);
-    m_pPostprocess = new Postprocess(m_pDevice, m_width, m_height);
+    m_pSkybox = new Skybox(m_pDevice, m_pResources, m_pTextureLoader);
+    m_pRect1 = new TransparentRect(m_pDevice, m_pResources, 1.0f, 0, 0, 128);
+    m_pRect2 = new TransparentRect(m_pDevice, m_pResources, -1.0f, 128, 0, 0);
+    m_pPostprocess = new Postprocess(m_pDevice, m_pResources, m_width, m_height);
 
     lights.resize(3);
     for (int i = 0; i < 3; i++)
     {
-        LightModel* temp = new LightModel(m_pDevice);
+        LightModel* temp = new LightModel(m_pDevice, m_pResources);
         lights[i] = temp;
     }
 
+    // Edited shaders and textures are rebuilt while running and swapped in by update()
+    m_pHotReload = new HotReload(m_pThreadPool, &shaderIncludes());
+    m_pHotReload->addShaders(TexturedCube::queueShaders, [this]() { return m_pCube->reloadShaders(); });
+    m_pHotReload->addShaders(Skybox::queueShaders, [this]() { return m_pSkybox->reloadShaders(); });
+    m_pHotReload->addShaders(TransparentRect::queueShaders, [this]()
+    {
+        bool reloaded = m_pRect1->reloadShaders();
+        return m_pRect2->reloadShaders() && reloaded;
+    });
+    m_pHotReload->addShaders(Postprocess::queueShaders, [this]() { return m_pPostprocess->reloadShaders(); });
+    m_pHotReload->addShaders(LightModel::queueShaders, [this]()
+    {
+        bool reloaded = true;
+        for (LightModel* light : lights)
+        {
+            reloaded = light->reloadShaders() && reloaded;
+        }
+        return reloaded;
+    });
+    m_pCube->watchTextures(*m_pHotReload);
+    m_pSkybox->watchTextures(*m_pHotReload);
+    m_pHotReload->start();
+
+    // Frame N+1 is simulated on its own thread while frame N is uploaded and drawn
+    m_pFramePipeline = new FramePipeline<FrameInput, FrameSnapshot>([this](const FrameInput& input, FrameSnapshot& frame)
+    {
+        simulate(input, frame);
+    });
+
+    // Passes set up all of their own state, so each can record on a deferred context
+    m_pPassRecorder = new PassRecorder<ID3D11DeviceContext>(m_pThreadPool);
+    m_pPassRecorder->addPass("Opaque", [this](ID3D11DeviceContext* context)
+    {
+        bindSceneState(context, false);
+        m_pCube->render(context, m_sceneBufferGPU.get<ID3D11Buffer>(), m_geomBuffer.get<ID3D11Buffer>(), m_samplerState.get<ID3D11SamplerState>(), m_pFrame->scene.SceneParams);
+    });
+    m_pPassRecorder->addPass("Skybox", [this](ID3D11DeviceContext* context)
+    {
+        bindSceneState(context, false);
+        m_pSkybox->render(context, m_width, m_height, m_sceneBufferGPU.get<ID3D11Buffer>(), m_samplerState.get<ID3D11SamplerState>());
+    });
+    m_pPassRecorder->addPass("Light proxies", [this](ID3D11DeviceContext* context)
+    {
+        bindSceneState(context, false);
+        for (int i = 0; i < m_pFrame->scene.SceneParams.x; i++)
+        {
+            lights[i]->render(context, m_sceneBufferGPU.get<ID3D11Buffer>(), m_lightSourceGeomBuffers[i].get<ID3D11Buffer>());
+        }
+    });
+    m_pPassRecorder->addPass("Transparent", [this](ID3D11DeviceContext* context)
+    {
+        bindSceneState(context, true);
+        drawTransparentSorted(context);
+    });
+    m_pPassRecorder->addPass("Postprocess", [this](ID3D11DeviceContext* context)
+    {
+        setViewport(context);
+        m_pPostprocess->render(context, m_pBackBufferRTV, m_sceneBufferGPU.get<ID3D11Buffer>(), m_samplerState.get<ID3D11SamplerState>());
+    });
+    m_pDeferredContexts = new DeferredContexts(m_pDevice, m_pDeviceContext, m_pPassRecorder->passCount());
+    if (!m_pDeferredContexts->isValid())
+    {
+        delete m_pDeferredContexts;
+        m_pDeferredContexts = nullptr;
+    }
+
+    m_startup.objectsMs = msSince(stageStart);
+    m_startup.totalMs = msSince(initStart);
+    m_startup.shaderCache = shaderCache().stats();
+
+    char buffer[256];
+    sprintf_s(buffer, "Startup %.1f ms: device %.1f, scene setup %.1f, shaders %.1f (%d jobs, %.1f ms serial, %d threads), objects %.1f\n",
+        m_startup.totalMs, m_startup.deviceMs, m_startup.sceneSetupMs, m_startup.shadersMs, (int)m_startup.shaders.jobs,
+        m_startup.shaders.compileMs, (int)m_startup.shaders.threads, m_startup.objectsMs);
+    OutputDebugStringA(buffer);
+
     return SUCCEEDED(result);
 }
 
 void Render::terminate()
 {
+    // The simulation worker, hot reload and loader callbacks point into the scene objects, so they go first
+    delete m_pFramePipeline;
+    m_pFramePipeline = nullptr;
+    m_pFrame = nullptr;
+    delete m_pPassRecorder;
+    m_pPassRecorder = nullptr;
+    delete m_pDeferredContexts;
+    m_pDeferredContexts = nullptr;
+    delete m_pHotReload;
+    delete m_pTextureLoader;
+    delete m_pThreadPool;
+    delete m_pTextureStreamer;
+
     for (int i = 0; i < 3; i++)
     {
         delete lights[i];
@@ -175,85 +297,33 @@ void Render::terminate()
     delete m_pRect2;
     delete m_pPostprocess;
 
-    ImGui_ImplDX11_Shutdown();
-    ImGui_ImplWin32_Shutdown();
-    ImGui::DestroyContext();
-    
-    if (m_pSamplerState != nullptr)
-    {
-        m_pSamplerState->Release();
-        m_pSamplerState = nullptr;
-    }
-
+    // The handles below point into the pool, so they go before it
+    m_samplerState.reset();
     for (int i = 0; i < 3; i++)
     {
-        if (m_pLightSourceGeomBuffers[i] != nullptr)
-        {
-            m_pLightSourceGeomBuffers[i]->Release();
-            m_pLightSourceGeomBuffers[i] = nullptr;
-        }
-    }
-
-    if (m_pGeomBuffer2 != nullptr)
-    {
-        m_pGeomBuffer2->Release();
-        m_pGeomBuffer2 = nullptr;
+        m_lightSourceGeomBuffers[i].reset();
     }
+    m_geomBuffer2.reset();
+    m_geomBuffer.reset();
+    m_sceneBufferGPU.reset();
+    m_transparentBlendState.reset();
+    m_blendState.reset();
+    m_transparentDepthState.reset();
+    m_depthState.reset();
+    m_depthBufferDSV.reset();
+    m_depthBuffer.reset();
+    m_rasterizerState.reset();
+
+    // Whatever the objects above destroyed is still pending, the pool releases it with the rest
+    delete m_pResources;
+    m_pResources = nullptr;
+    delete m_pFrameFence;
+    m_pFrameFence = nullptr;
 
-    if (m_pGeomBuffer != nullptr)
-    {
-        m_pGeomBuffer->Release();
-        m_pGeomBuffer = nullptr;
-    }
-
-    if (m_pSceneBuffer != nullptr)
-    {
-        m_pSceneBuffer->Release();
-        m_pSceneBuffer = nullptr;
-    }
-
-    if (m_pTransparentBlendState != nullptr)
-    {
-        m_pTransparentBlendState->Release();
-        m_pTransparentBlendState = nullptr;
-    }
-
-    if (m_pBlendState != nullptr)
-    {
-        m_pBlendState->Release();
-        m_pBlendState = nullptr;
-    }
-
-    if (m_pTransparentDepthState != nullptr)
-    {
-        m_pTransparentDepthState->Release();
-        m_pTransparentDepthState = nullptr;
-    }
-
-    if (m_pDepthState != nullptr)
-    {
-        m_pDepthState->Release();
-        m_pDepthState = nullptr;
-    }
-
-    if (m_pDepthBufferDSV != nullptr)
-    {
-        m_pDepthBufferDSV->Release();
-        m_pDepthBufferDSV = nullptr;
-    }
-
-    if (m_pDepthBuffer != nullptr)
-    {
-        m_pDepthBuffer->Release();
-        m_pDepthBuffer = nullptr;
-    }
+    ImGui_ImplDX11_Shutdown();
+    ImGui_ImplWin32_Shutdown();
+    ImGui::DestroyContext();
     
-    if (m_pRasterizerState != nullptr)
-    {
-        m_pRasterizerState->Release();
-        m_pRasterizerState = nullptr;
-    }
-
     if (m_pBackBufferRTV != nullptr)
     {
         m_pBackBufferRTV->Release();
@@ -284,67 +354,43 @@ bool Render::render()
 {
     m_pDeviceContext->ClearState();
 
-    //ID3D11RenderTargetView* views[] = { m_pBackBufferRTV };
-    ID3D11RenderTargetView* colorBuffer = m_pPostprocess->getRenderTarget();
-    ID3D11RenderTargetView* views[] = { colorBuffer };
-    m_pDeviceContext->OMSetRenderTargets(1, views, m_pDepthBufferDSV);
-
     static const FLOAT BackColor[4] = { 0.25f, 0.25f, 0.25f, 1.0f };
     //m_pDeviceContext->ClearRenderTargetView(m_pBackBufferRTV, BackColor);
-    m_pDeviceContext->ClearRenderTargetView(colorBuffer, BackColor);
-    m_pDeviceContext->ClearDepthStencilView(m_pDepthBufferDSV, D3D11_CLEAR_DEPTH, 1.0f, 0);
-
-    D3D11_VIEWPORT viewport;
-    viewport.TopLeftX = 0;
-    viewport.TopLeftY = 0;
-    viewport.Width = (FLOAT)m_width;
-    viewport.Height = (FLOAT)m_height;
-    viewport.MinDepth = 0.0f;
-    viewport.MaxDepth = 1.0f;
-    m_pDeviceContext->RSSetViewports(1, &viewport);
-
-    D3D11_RECT rect;
-    rect.left = 0;
-    rect.top = 0;
-    rect.right = m_width;
-    rect.bottom = m_height;
-    m_pDeviceContext->RSSetScissorRects(1, &rect);
-    m_pDeviceContext->RSSetState(m_pRasterizerState);
-    m_pDeviceContext->OMSetDepthStencilState(m_pDepthState, 0);
-    m_pDeviceContext->OMSetBlendState(m_pBlendState, nullptr, 0xFFFFFFFF);
+    m_pDeviceContext->ClearRenderTargetView(m_pPostprocess->getRenderTarget(), BackColor);
+    m_pDeviceContext->ClearDepthStencilView(m_depthBufferDSV.get<ID3D11DepthStencilView>(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
     //m_pTriangle->render(m_pDeviceContext, m_width, m_height);
-
-    m_pCube->render(m_pDeviceContext, m_pSceneBuffer, m_pGeomBuffer, m_pSamplerState);
     //m_pCube2->render(m_pDeviceContext, m_pSceneBuffer, m_pGeomBuffer2, m_pSamplerState);
 
-    m_pSkybox->render(m_pDeviceContext, m_width, m_height, m_pSceneBuffer, m_pSamplerState);
+    // Opaque instances, skybox, light proxies, transparent, postprocess - recorded in parallel and executed in this order
+    bool deferred = m_deferredPasses && m_pDeferredContexts != nullptr;
+    m_pPassRecorder->run(deferred ? m_pDeferredContexts : nullptr, m_pDeviceContext);
 
-    for (int i = 0; i < m_sceneBuffer.SceneParams.x; i++)
-    {
-        lights[i]->render(m_pDeviceContext, m_pSceneBuffer, m_pLightSourceGeomBuffers[i]);
-    }
-
-    m_pDeviceContext->OMSetDepthStencilState(m_pTransparentDepthState, 0);
-    m_pDeviceContext->OMSetBlendState(m_pTransparentBlendState, nullptr, 0xFFFFFFFF);
-    //m_pDeviceContext->OMSetDepthStencilState(m_pTransparentDepthState, 0);
-
-    drawTransparentSorted();
-    //m_pRect1->render(m_pDeviceContext, m_pSceneBuffer);
-    //m_pRect2->render(m_pDeviceContext, m_pSceneBuffer);
-
-    m_pPostprocess->render(m_pDeviceContext, m_pBackBufferRTV, m_pSamplerState);
+    // ImGui draws into whatever is bound, and executed command lists leave nothing bound
+    ID3D11RenderTargetView* views[] = { m_pBackBufferRTV };
+    m_pDeviceContext->OMSetRenderTargets(1, views, nullptr);
 
     // Rendering
     ImGui::Render();
     ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 
-    HRESULT result = m_pSwapChain->Present(0, 0);
+    HRESULT result = m_pSwapChain->Present(m_vsync ? 1 : 0, 0);
     assert(SUCCEEDED(result));
 
+    // Objects destroyed while this frame was built go with its fence, older frames' ones are released if the GPU is past them
+    uint64_t fence = m_pFrameFence->signal(m_pDeviceContext);
+    m_pResources->pool().setFrameFence(fence + 1);
+    m_pResources->pool().collect(m_pFrameFence->completed(m_pDeviceContext));
+
     return SUCCEEDED(result);
 }
 
+void Render::endFrame()
+{
+    // update() allocates from the render thread's arena too, and may run without render()
+    m_frameArenas.local().reset();
+}
+
 bool Render::resize(UINT width, UINT height)
 {
     if (width != m_width || height != m_height)
@@ -355,18 +401,6 @@ bool Render::resize(UINT width, UINT height)
             m_pBackBufferRTV = nullptr;
         }
 
-        if (m_pDepthBuffer != nullptr)
-        {
-            m_pDepthBuffer->Release();
-            m_pDepthBuffer = nullptr;
-        }
-
-        if (m_pDepthBufferDSV != nullptr)
-        {
-            m_pDepthBufferDSV->Release();
-            m_pDepthBufferDSV = nullptr;
-        }
-
         HRESULT result = m_pSwapChain->ResizeBuffers(2, width, height, DXGI_FORMAT_R8G8B8A8_UNORM, 0);
         assert(SUCCEEDED(result));
 
@@ -388,6 +422,18 @@ bool Render::resize(UINT width, UINT height)
 
 bool Render::update()
 {
+    // Nothing of this frame is drawn yet, so rebuilt shaders are swapped in here, all at once
+    m_pHotReload->update();
+    const HotReload::Stats& reloadStats = m_pHotReload->stats();
+    if (reloadStats.failures != m_hotReloadFailures)
+    {
+        m_hotReloadFailures = reloadStats.failures;
+        OutputDebugStringA(("Hot reload kept the old shaders, failed: " + reloadStats.lastError + "\n").c_str());
+    }
+
+    // Hand textures finished by the loader workers to their owners
+    m_pTextureLoader->pump();
+
     // Start the Dear ImGui frame
     ImGui_ImplDX11_NewFrame();
     ImGui_ImplWin32_NewFrame();
@@ -396,7 +442,7 @@ bool Render::update()
     {
         ImGui::Begin("Lights (3 maximum)");
 
-        //ImGui::Checkbox("Use normal maps", &m_useNormalMap);
+        ImGui::Checkbox("Use normal maps", &m_useNormalMap);
         ImGui::Checkbox("Show normals", &m_showNormals);
         ImGui::Checkbox("Use filter", &m_useFilter);
 
@@ -431,21 +477,248 @@ bool Render::update()
         ImGui::End();
     }
 
+    {
+        ImGui::Begin("Startup");
+        ImGui::Text("Total: %.1f ms", m_startup.totalMs);
+        ImGui::Text("Device and swap chain: %.1f ms", m_startup.deviceMs);
+        ImGui::Text("Scene setup: %.1f ms", m_startup.sceneSetupMs);
+        ImGui::Text("Shaders: %.1f ms on %d threads (%.1f ms serial)", m_startup.shadersMs, (int)m_startup.shaders.threads, m_startup.shaders.compileMs);
+        ImGui::Text("Slowest shader: %s, %.1f ms", m_startup.shaders.longestJob.c_str(), m_startup.shaders.longestMs);
+        ImGui::Text("Shader cache: %d hits, %d misses", (int)m_startup.shaderCache.hits, (int)m_startup.shaderCache.misses);
+        ImGui::Text("Scene objects: %.1f ms", m_startup.objectsMs);
+        const ShaderPermutations& permutations = m_pCube->getPixelPermutations();
+        ImGui::Text("Cube pixel shader: %d variants, %d KB", (int)permutations.variantCount(), (int)(permutations.totalSize() / 1024));
+        ImGui::End();
+    }
 
-    size_t usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
-    if (m_prevSec == 0)
     {
-        m_prevSec = usec; // Initial update
+        ImGui::Begin("Frame pacing");
+        // With vsync Present() blocks, the pacer only keeps the idle throttle
+        ImGui::Checkbox("VSync", &m_vsync);
+        if (!m_vsync)
+        {
+            ImGui::SliderInt("Target FPS (0 - no limit)", &m_targetFps, 0, 240);
+        }
+        m_framePacer.setTargetFps(m_vsync ? 0.0 : (double)m_targetFps);
+        bool throttle = m_framePacer.options().throttleWhenUnfocused;
+        if (ImGui::Checkbox("Throttle when unfocused", &throttle))
+        {
+            m_framePacer.setThrottleWhenUnfocused(throttle);
+        }
+        const FramePacer::Stats& pacing = m_framePacer.stats();
+        ImGui::Text("Frame: %.2f ms avg, %.2f..%.2f ms, jitter %.3f ms", pacing.averageMs, pacing.minMs, pacing.maxMs, pacing.jitterMs);
+        ImGui::Text("Slept %.2f ms, spun %.2f ms, sleep slack %.2f ms", pacing.sleptMs, pacing.spunMs, pacing.sleepSlackMs);
+        ImGui::Text("Missed deadlines: %d", (int)pacing.missedFrames);
+        ImGui::End();
     }
 
-    double deltaSec = (usec - m_prevSec) / 1000000.0;
-    m_angle = m_angle + deltaSec * rotationSpeed;
+    {
+        ImGui::Begin("Hot reload");
+        ImGui::Text("Watching %d files%s", (int)reloadStats.watchedFiles, m_pHotReload->watcher().usesNativeEvents() ? " (native events)" : "");
+        ImGui::Text("Changes: %d, shader builds: %d (%d shaders)", (int)reloadStats.changes, (int)reloadStats.builds, (int)reloadStats.shadersCompiled);
+        ImGui::Text("Swaps: %d, texture reloads: %d, last build %.1f ms", (int)reloadStats.swaps, (int)reloadStats.textureReloads, reloadStats.lastBuildMs);
+        if (reloadStats.failures > 0)
+        {
+            ImGui::TextWrapped("Failed builds: %d, last: %s", (int)reloadStats.failures, reloadStats.lastError.c_str());
+        }
+        ImGui::End();
+    }
 
-    GeomBuffer geomBuffer;
+    {
+        ImGui::Begin("Frame pipeline");
+        // Off - the worker still simulates, but the render thread waits for it every frame
+        ImGui::Checkbox("Simulate next frame while drawing", &m_pipelined);
+        FramePipeline<FrameInput, FrameSnapshot>::Stats pipelineStats = m_pFramePipeline->stats();
+        ImGui::Text("Simulation: %.2f ms, worker idle %.2f ms", pipelineStats.stepMs, pipelineStats.idleMs);
+        ImGui::Text("Render thread waited %.2f ms", pipelineStats.waitMs);
+        FrameArenas::Stats arenaStats = m_frameArenas.stats();
+        ImGui::Text("Frame arenas: %d threads, peak %.1f of %.1f KB, %d heap blocks", (int)arenaStats.threads,
+            arenaStats.peak / 1024.0, arenaStats.capacity / 1024.0, (int)arenaStats.heapAllocations);
+
+        ImGui::Separator();
+        if (m_pDeferredContexts != nullptr)
+        {
+            ImGui::Checkbox("Record passes on deferred contexts", &m_deferredPasses);
+            if (!m_pDeferredContexts->driverCommandLists())
+            {
+                ImGui::TextWrapped("The driver has no native command lists, the runtime emulates them");
+            }
+        }
+        else
+        {
+            ImGui::Text("Deferred contexts are not available");
+        }
+        const PassRecorder<ID3D11DeviceContext>::Stats& passStats = m_pPassRecorder->stats();
+        ImGui::Text("Recording: %.2f ms wall, %.2f ms over all passes, execute %.2f ms", passStats.wallMs, passStats.recordMs, passStats.executeMs);
+        for (size_t i = 0; i < m_pPassRecorder->passCount(); i++)
+        {
+            ImGui::Text("  %s: %.3f ms", m_pPassRecorder->passName(i).c_str(), passStats.passMs[i]);
+        }
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("GPU resources");
+        const ResourcePool::Stats& poolStats = m_pResources->pool().stats();
+        ImGui::Text("Live: %d in %d slots, waiting for the GPU: %d", (int)poolStats.live, (int)poolStats.slots, (int)poolStats.pending);
+        ImGui::Text("Frame fence: %d signaled, %d completed", (int)m_pFrameFence->signaled(), (int)m_pFrameFence->completed(m_pDeviceContext));
+        for (const ResourcePool::TypeStats& type : m_pResources->pool().typeStats())
+        {
+            ImGui::Text("  %s: %d, %.1f KB (pending %d, %.1f KB)", type.name.c_str(), (int)type.live, type.liveBytes / 1024.0,
+                (int)type.pending, type.pendingBytes / 1024.0);
+        }
+        ImGui::End();
+    }
+
+    {
+        ImGui::Begin("Simulation clock");
+        bool paused = m_simulationClock.paused();
+        if (ImGui::Checkbox("Paused", &paused))
+        {
+            m_simulationClock.setPaused(paused);
+        }
+        float timeScale = (float)m_simulationClock.timeScale();
+        if (ImGui::SliderFloat("Time scale", &timeScale, 0.0f, 4.0f))
+        {
+            m_simulationClock.setTimeScale(timeScale);
+        }
+        if (ImGui::SliderInt("Steps per second", &m_stepsPerSecond, 10, 240))
+        {
+            m_simulationClock.setStep(1.0 / m_stepsPerSecond);
+        }
+
+        // Frame times recorded here and replayed later put a benchmark on the same timeline every run
+        SimulationClock::Mode mode = m_simulationClock.mode();
+        if (mode == SimulationClock::Mode::Record)
+        {
+            if (ImGui::Button("Stop recording"))
+            {
+                m_simulationClock.stopRecording();
+                m_simulationClock.saveRecording(FrameTimesFile);
+            }
+            ImGui::SameLine();
+            ImGui::Text("%d frames", (int)m_simulationClock.recording().size());
+        }
+        else if (mode == SimulationClock::Mode::Replay)
+        {
+            ImGui::Text("Replaying, %d frames left", (int)m_simulationClock.replayRemaining());
+        }
+        else
+        {
+            if (ImGui::Button("Record frame times"))
+            {
+                m_simulationClock.startRecording();
+            }
+            ImGui::SameLine();
+            std::vector<double> frameTimes;
+            if (ImGui::Button("Replay") && SimulationClock::loadRecording(FrameTimesFile, frameTimes))
+            {
+                m_simulationClock.startReplay(frameTimes);
+                m_resetSimulation = true;
+            }
+        }
+
+        const SimulationClock::Stats& clockStats = m_simulationClock.stats();
+        ImGui::Text("Frame %.2f ms, %d steps, %.2f s dropped", clockStats.frameMs, (int)clockStats.steps, clockStats.droppedTime);
+        ImGui::End();
+    }
+
+    FrameInput input;
+    input.steps = m_unsubmittedSteps + m_simulationClock.advance();
+    input.step = m_simulationClock.step();
+    input.alpha = m_simulationClock.alpha();
+    input.resetSimulation = m_resetSimulation;
+    input.camera = *m_pCamera;
+    input.scene = m_sceneBuffer;
+    input.width = m_width;
+    input.height = m_height;
+    input.computeCull = m_computeCull;
+
+    // First frame, or pipelining is off
+    bool submitted = false;
+    if (m_pFramePipeline->pending() == 0)
+    {
+        m_pFramePipeline->submit(input);
+        submitted = true;
+    }
+    m_pFrame = &m_pFramePipeline->acquire();
+    if (m_pipelined)
+    {
+        // Input of this frame also drives the next one, one frame of latency for the overlap
+        if (submitted)
+        {
+            // Its steps are simulated already
+            input.steps = 0;
+            input.resetSimulation = false;
+        }
+        m_pFramePipeline->submit(input);
+        submitted = true;
+    }
+    // Pipelining just turned off: the pending frame came from the last input and
+    // this one goes nowhere, so its steps and reset move on to the next frame
+    if (submitted)
+    {
+        m_unsubmittedSteps = 0;
+        m_resetSimulation = false;
+    }
+    else
+    {
+        m_unsubmittedSteps = input.steps;
+    }
+    const FrameSnapshot& frame = *m_pFrame;
+
+    m_pDeviceContext->UpdateSubresource(m_geomBuffer.get<ID3D11Buffer>(), 0, nullptr, &frame.geom, 0, 0);
+
+    ID3D11Buffer* pSceneBuffer = m_sceneBufferGPU.get<ID3D11Buffer>();
+    D3D11_MAPPED_SUBRESOURCE subresource;
+    HRESULT result = m_pDeviceContext->Map(pSceneBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
+    assert(SUCCEEDED(result));
+    if (SUCCEEDED(result))
+    {
+        memcpy(subresource.pData, &frame.scene, sizeof(SceneBuffer));
+
+        m_pDeviceContext->Unmap(pSceneBuffer, 0);
+    }
+
+    for (int i = 0; i < frame.scene.SceneParams.x; i++)
+    {
+        m_pDeviceContext->UpdateSubresource(m_lightSourceGeomBuffers[i].get<ID3D11Buffer>(), 0, nullptr, &frame.lightGeom[i], 0, 0);
+    }
+
+    // Instances first, GPU culling reads them
+    m_pCube->update(m_pDeviceContext, frame.instances, frame.computeCull, m_frameArenas.local());
+    if (frame.computeCull)
+    {
+        m_pCube->cullInCompute(m_pDeviceContext, pSceneBuffer);
+    }
+    m_pCube->showStats(m_computeCull);
+
+    streamTextures(frame);
+
+    return SUCCEEDED(result);
+}
+
+void Render::simulate(const FrameInput& input, FrameSnapshot& frame)
+{
+    if (input.resetSimulation)
+    {
+        m_angle = 0;
+        m_prevAngle = 0;
+    }
+
+    // Whole fixed steps, the frame shows a state between the last two
+    for (int i = 0; i < input.steps; i++)
+    {
+        m_prevAngle = m_angle;
+        m_angle = m_angle + input.step * rotationSpeed;
+    }
+    double angle = m_prevAngle + (m_angle - m_prevAngle) * input.alpha;
+
+    GeomBuffer& geomBuffer = frame.geom;
 
     // Model matrix
     // Angle is reversed, as DirectXMath calculates it as clockwise
-    DirectX::XMMATRIX m = DirectX::XMMatrixRotationAxis(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f), -(float)m_angle);
+    DirectX::XMMATRIX m = DirectX::XMMatrixRotationAxis(DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 1.0f), -(float)angle);
 
     geomBuffer.M = m;
     m = DirectX::XMMatrixInverse(nullptr, m);
@@ -454,27 +727,24 @@ bool Render::update()
     geomBuffer.params.x = 64.0f;
     geomBuffer.params.y = 1;
 
-    m_pDeviceContext->UpdateSubresource(m_pGeomBuffer, 0, nullptr, &geomBuffer, 0, 0);
-
-    m_prevSec = usec;
-
     // Setup camera
+    const Camera& camera = input.camera;
     DirectX::XMFLOAT3 cameraPos;
     DirectX::XMMATRIX v;
     {
-        DirectX::XMFLOAT3 pos = m_pCamera->poi;
-        DirectX::XMFLOAT3 temp = DirectX::XMFLOAT3{ cosf(m_pCamera->theta) * cosf(m_pCamera->phi), sinf(m_pCamera->theta), cosf(m_pCamera->theta) * sinf(m_pCamera->phi) };
+        DirectX::XMFLOAT3 pos = camera.poi;
+        DirectX::XMFLOAT3 temp = DirectX::XMFLOAT3{ cosf(camera.theta) * cosf(camera.phi), sinf(camera.theta), cosf(camera.theta) * sinf(camera.phi) };
         DirectX::XMVECTOR vector = XMLoadFloat3(&temp);
-        vector = XMVectorScale(vector, m_pCamera->r);
+        vector = XMVectorScale(vector, camera.r);
         DirectX::XMVECTOR posVector = XMLoadFloat3(&pos);
         posVector = XMVectorAdd(posVector, vector);
         XMStoreFloat3(&pos, posVector);
-        float upTheta = m_pCamera->theta + (float)PI / 2;
-        DirectX::XMFLOAT3 up = DirectX::XMFLOAT3{ cosf(upTheta) * cosf(m_pCamera->phi), sinf(upTheta), cosf(upTheta) * sinf(m_pCamera->phi) };
+        float upTheta = camera.theta + (float)PI / 2;
+        DirectX::XMFLOAT3 up = DirectX::XMFLOAT3{ cosf(upTheta) * cosf(camera.phi), sinf(upTheta), cosf(upTheta) * sinf(camera.phi) };
 
         v = DirectX::XMMatrixLookAtLH(
             DirectX::XMVectorSet(pos.x, pos.y, pos.z, 0.0f),
-            DirectX::XMVectorSet(m_pCamera->poi.x, m_pCamera->poi.y, m_pCamera->poi.z, 0.0f),
+            DirectX::XMVectorSet(camera.poi.x, camera.poi.y, camera.poi.z, 0.0f),
             DirectX::XMVectorSet(up.x, up.y, up.z, 0.0f)
         );
 
@@ -484,47 +754,79 @@ bool Render::update()
     float f = 100.0f;
     float n = 0.1f;
     float fov = (float)PI / 3;
-    float c = 1.0f / tanf(fov / 2);
-    float aspectRatio = (float)m_height / m_width;
+    float aspectRatio = (float)input.height / input.width;
     DirectX::XMMATRIX p = DirectX::XMMatrixPerspectiveLH(tanf(fov / 2) * 2 * n, tanf(fov / 2) * 2 * n * aspectRatio, n, f);
 
-    D3D11_MAPPED_SUBRESOURCE subresource;
-    HRESULT result = m_pDeviceContext->Map(m_pSceneBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &subresource);
-    assert(SUCCEEDED(result));
-    if (SUCCEEDED(result))
-    {
-        //m_sceneBuffer = reinterpret_cast<SceneBuffer*>(subresource.pData);
-        calcFrustum();
-        m_sceneBuffer.VP = DirectX::XMMatrixMultiply(v, p);
-        m_sceneBuffer.CameraPos = cameraPos;
-        for (int i = 0; i < 6; i++)
-            m_sceneBuffer.Frustum[i] = frustumPlanes[i];
-        
-        memcpy(subresource.pData, &m_sceneBuffer, sizeof(SceneBuffer));
-
-        m_pDeviceContext->Unmap(m_pSceneBuffer, 0);
-    }
+    calcFrustum(input, frame.frustumPlanes);
+    frame.scene = input.scene;
+    frame.scene.VP = DirectX::XMMatrixMultiply(v, p);
+    frame.scene.CameraPos = cameraPos;
+    for (int i = 0; i < 6; i++)
+        frame.scene.Frustum[i] = frame.frustumPlanes[i];
 
-    for (int i = 0; i < m_sceneBuffer.SceneParams.x; i++)
+    for (int i = 0; i < frame.scene.SceneParams.x; i++)
     {
-        GeomBuffer lightSourceGB;
-        lightSourceGB.M = DirectX::XMMatrixTranslation(m_sceneBuffer.lights[i].Pos.x, m_sceneBuffer.lights[i].Pos.y, m_sceneBuffer.lights[i].Pos.z);
+        GeomBuffer& lightSourceGB = frame.lightGeom[i];
+        lightSourceGB.M = DirectX::XMMatrixTranslation(frame.scene.lights[i].Pos.x, frame.scene.lights[i].Pos.y, frame.scene.lights[i].Pos.z);
         lightSourceGB.NormalM = DirectX::XMMatrixIdentity();
         lightSourceGB.params.x = i;
-
-        m_pDeviceContext->UpdateSubresource(m_pLightSourceGeomBuffers[i], 0, nullptr, &lightSourceGB, 0, 0);
     }
-    if (m_computeCull)
+
+    // GPU culling results stay on the GPU, so in that mode every instance counts as visible
+    frame.computeCull = input.computeCull;
+    m_pCube->animate(-(float)angle, frame.instances);
+    if (frame.computeCull)
     {
-        m_pCube->cullInCompute(m_pDeviceContext, m_pSceneBuffer);
+        for (InstanceState& instance : frame.instances)
+        {
+            instance.visible = true;
+        }
     }
     else
     {
-        cull();
+        cull(frame.frustumPlanes, frame.instances);
     }
-    m_pCube->update(m_pDeviceContext, -m_angle, m_computeCull);
 
-    return SUCCEEDED(result);
+    // Mip requests for texture streaming, from the same camera position the transparent sort uses
+    DirectX::XMFLOAT3 eye;
+    eye.x = camera.poi.x + cosf(camera.theta) * cosf(camera.phi) * camera.r;
+    eye.y = camera.poi.y + sinf(camera.theta) * camera.r;
+    eye.z = camera.poi.z + cosf(camera.theta) * sinf(camera.phi) * camera.r;
+
+    float pixelsPerUnitAtOne = input.width / (2.0f * tanf(fov / 2));
+
+    auto& AABB = m_pCube->getAABB();
+    frame.mipFootprints.resize(frame.instances.size());
+    for (int i = 0; i < frame.instances.size(); i++)
+    {
+        if (!frame.instances[i].visible)
+        {
+            frame.mipFootprints[i] = -1.0f;
+            continue;
+        }
+
+        float dx = (AABB[i].first.x + AABB[i].second.x) * 0.5f - eye.x;
+        float dy = (AABB[i].first.y + AABB[i].second.y) * 0.5f - eye.y;
+        float dz = (AABB[i].first.z + AABB[i].second.z) * 0.5f - eye.z;
+        float dist = (std::max)(sqrtf(dx * dx + dy * dy + dz * dz), 0.1f);
+
+        // Cube faces are 1x1 and map a whole atlas entry
+        frame.mipFootprints[i] = pixelsPerUnitAtOne / dist;
+    }
+
+    float d0 = 0.0f, d1 = 0.0f;
+    for (int i = 0; i < 4; i++)
+    {
+        d0 = (std::max)(d0, (float)(pow((eye.x - m_pRect1->coords[i].x), 2)
+                                  + pow((eye.y - m_pRect1->coords[i].y), 2) 
+                                  + pow((eye.z - m_pRect1->coords[i].z), 2)));
+        d1 = (std::max)(d1, (float)(pow((eye.x - m_pRect2->coords[i].x), 2)
+                                  + pow((eye.y - m_pRect2->coords[i].y), 2)
+                                  + pow((eye.z - m_pRect2->coords[i].z), 2)));
+    }
+    frame.rect1Nearer = d0 < d1;
+
+    m_frameArenas.local().reset();
 }
 
 void Render::mouseLeftButton(bool pressed, int posX, int posY)
@@ -596,14 +898,16 @@ HRESULT Render::initScene()
     sceneBufferDesc.MiscFlags = 0;
     sceneBufferDesc.StructureByteStride = 0;
 
-    HRESULT result = m_pDevice->CreateBuffer(&sceneBufferDesc, nullptr, &m_pSceneBuffer);
+    ID3D11Buffer* pSceneBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&sceneBufferDesc, nullptr, &pSceneBuffer);
+    m_sceneBufferGPU = m_pResources->buffer(pSceneBuffer);
     assert(SUCCEEDED(result));
 
     if (!SUCCEEDED(result))
     {
         return result;
     }
-    result = SetResourceName(m_pSceneBuffer, "scene buffer");
+    result = SetResourceName(pSceneBuffer, "scene buffer");
 
     D3D11_BUFFER_DESC geomBufferDesc = {};
     geomBufferDesc.ByteWidth = sizeof(GeomBuffer);
@@ -623,13 +927,15 @@ HRESULT Render::initScene()
     data.SysMemPitch = sizeof(geomBuffer);
     data.SysMemSlicePitch = 0;
 
-    result = m_pDevice->CreateBuffer(&geomBufferDesc, &data, &m_pGeomBuffer);
+    ID3D11Buffer* pGeomBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&geomBufferDesc, &data, &pGeomBuffer);
+    m_geomBuffer = m_pResources->buffer(pGeomBuffer);
     assert(SUCCEEDED(result));
     if (!SUCCEEDED(result))
     {
         return result;
     }
-    result = SetResourceName(m_pGeomBuffer, "geom buffer");
+    result = SetResourceName(pGeomBuffer, "geom buffer");
 
     GeomBuffer geomBuffer2;
     geomBuffer2.M = DirectX::XMMatrixTranslation(2.0f, 0.0f, 2.0f);
@@ -638,13 +944,15 @@ HRESULT Render::initScene()
     //geomBuffer2.params.x = 64;
     data.pSysMem = &geomBuffer2;
 
-    result = m_pDevice->CreateBuffer(&geomBufferDesc, &data, &m_pGeomBuffer2);
+    ID3D11Buffer* pGeomBuffer2 = nullptr;
+    result = m_pDevice->CreateBuffer(&geomBufferDesc, &data, &pGeomBuffer2);
+    m_geomBuffer2 = m_pResources->buffer(pGeomBuffer2);
     assert(SUCCEEDED(result));
     if (!SUCCEEDED(result))
     {
         return result;
     }
-    result = SetResourceName(m_pGeomBuffer2, "geom buffer 2");
+    result = SetResourceName(pGeomBuffer2, "geom buffer 2");
 
     D3D11_BUFFER_DESC lightGeomBufferDesc = {};
     lightGeomBufferDesc.ByteWidth = sizeof(GeomBuffer);
@@ -656,7 +964,9 @@ HRESULT Render::initScene()
 
     for (int i = 0; i < 3; i++)
     {
-        result = m_pDevice->CreateBuffer(&lightGeomBufferDesc, nullptr, &m_pLightSourceGeomBuffers[i]);
+        ID3D11Buffer* pLightSourceGeomBuffer = nullptr;
+        result = m_pDevice->CreateBuffer(&lightGeomBufferDesc, nullptr, &pLightSourceGeomBuffer);
+        m_lightSourceGeomBuffers[i] = m_pResources->buffer(pLightSourceGeomBuffer);
         assert(SUCCEEDED(result));
         if (!SUCCEEDED(result))
         {
@@ -678,7 +988,9 @@ HRESULT Render::initScene()
         desc.ScissorEnable = FALSE;
         desc.MultisampleEnable = FALSE;
 
-        result = m_pDevice->CreateRasterizerState(&desc, &m_pRasterizerState);
+        ID3D11RasterizerState* pRasterizerState = nullptr;
+        result = m_pDevice->CreateRasterizerState(&desc, &pRasterizerState);
+        m_rasterizerState = m_pResources->add(D3DResources::State, pRasterizerState);
         assert(SUCCEEDED(result));
     }
 
@@ -686,7 +998,7 @@ HRESULT Render::initScene()
     {
         return result;
     }
-    result = SetResourceName(m_pRasterizerState, "rasterizer state");
+    result = SetResourceName(m_rasterizerState.get<ID3D11RasterizerState>(), "rasterizer state");
     
     D3D11_DEPTH_STENCIL_DESC depthDesc = {};
     depthDesc.DepthEnable = TRUE;
@@ -694,12 +1006,14 @@ HRESULT Render::initScene()
     depthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
     depthDesc.StencilEnable = FALSE;
 
-    result = m_pDevice->CreateDepthStencilState(&depthDesc, &m_pDepthState);
+    ID3D11DepthStencilState* pDepthState = nullptr;
+    result = m_pDevice->CreateDepthStencilState(&depthDesc, &pDepthState);
+    m_depthState = m_pResources->add(D3DResources::State, pDepthState);
     if (!SUCCEEDED(result))
     {
         return result;
     }
-    result = SetResourceName(m_pDepthState, "depth state");
+    result = SetResourceName(pDepthState, "depth state");
 
     D3D11_DEPTH_STENCIL_DESC transparentDepthDesc = {};
     transparentDepthDesc.DepthEnable = TRUE;
@@ -707,12 +1021,14 @@ HRESULT Render::initScene()
     transparentDepthDesc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
     transparentDepthDesc.StencilEnable = FALSE;
 
-    result = m_pDevice->CreateDepthStencilState(&transparentDepthDesc, &m_pTransparentDepthState);
+    ID3D11DepthStencilState* pTransparentDepthState = nullptr;
+    result = m_pDevice->CreateDepthStencilState(&transparentDepthDesc, &pTransparentDepthState);
+    m_transparentDepthState = m_pResources->add(D3DResources::State, pTransparentDepthState);
     if (!SUCCEEDED(result))
     {
         return result;
     }
-    result = SetResourceName(m_pTransparentDepthState, "depth state");
+    result = SetResourceName(pTransparentDepthState, "depth state");
 
     return result;
 }
@@ -731,11 +1047,13 @@ HRESULT Render::initSamplers()
     samplerDesc.ComparisonFunc = D3D11_COMPARISON_NEVER;
     samplerDesc.BorderColor[0] = samplerDesc.BorderColor[1] = samplerDesc.BorderColor[2] = samplerDesc.BorderColor[3] = 1.0f;
 
-    HRESULT result = m_pDevice->CreateSamplerState(&samplerDesc, &m_pSamplerState);
+    ID3D11SamplerState* pSamplerState = nullptr;
+    HRESULT result = m_pDevice->CreateSamplerState(&samplerDesc, &pSamplerState);
+    m_samplerState = m_pResources->add(D3DResources::State, pSamplerState);
 
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pSamplerState, "sampler state");
+        result = SetResourceName(pSamplerState, "sampler state");
     }
 
     return result;
@@ -756,23 +1074,28 @@ HRESULT Render::initDepthStencil()
     desc.Width = m_width;
     desc.MipLevels = 1;
 
-    HRESULT result = m_pDevice->CreateTexture2D(&desc, nullptr, &m_pDepthBuffer);
+    // On resize the old pair is released once the GPU is done with it
+    ID3D11Texture2D* pDepthBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateTexture2D(&desc, nullptr, &pDepthBuffer);
+    m_depthBuffer = m_pResources->texture(pDepthBuffer);
     
     if (FAILED(result))
     {
         return result;
     }
 
-    result = SetResourceName(m_pDepthBuffer, "depth buffer");
+    result = SetResourceName(pDepthBuffer, "depth buffer");
 
-    result = m_pDevice->CreateDepthStencilView(m_pDepthBuffer, nullptr, &m_pDepthBufferDSV);
+    ID3D11DepthStencilView* pDepthBufferDSV = nullptr;
+    result = m_pDevice->CreateDepthStencilView(pDepthBuffer, nullptr, &pDepthBufferDSV);
+    m_depthBufferDSV = m_pResources->add(D3DResources::View, pDepthBufferDSV);
 
     if (FAILED(result))
     {
         return result;
     }
 
-    result = SetResourceName(m_pDepthBufferDSV, "depth buffer view");
+    result = SetResourceName(pDepthBufferDSV, "depth buffer view");
 
     return result;
 }
@@ -791,69 +1114,88 @@ HRESULT Render::initBlendState()
     desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
     desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
 
-    HRESULT result = m_pDevice->CreateBlendState(&desc, &m_pBlendState);
+    ID3D11BlendState* pBlendState = nullptr;
+    HRESULT result = m_pDevice->CreateBlendState(&desc, &pBlendState);
+    m_blendState = m_pResources->add(D3DResources::State, pBlendState);
 
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pBlendState, "blend state");
+        result = SetResourceName(pBlendState, "blend state");
     }
 
     desc.RenderTarget[0].BlendEnable = TRUE;
 
-    result = m_pDevice->CreateBlendState(&desc, &m_pTransparentBlendState);
+    ID3D11BlendState* pTransparentBlendState = nullptr;
+    result = m_pDevice->CreateBlendState(&desc, &pTransparentBlendState);
+    m_transparentBlendState = m_pResources->add(D3DResources::State, pTransparentBlendState);
 
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pTransparentBlendState, "blend state");
+        result = SetResourceName(pTransparentBlendState, "blend state");
     }
 
     return result;
 }
 
-void Render::drawTransparentSorted()
+void Render::setViewport(ID3D11DeviceContext* context)
 {
-    float d0 = 0.0f, d1 = 0.0f;
-    DirectX::XMFLOAT3 cameraPos;
-    cameraPos.x = m_pCamera->poi.x + cosf(m_pCamera->theta) * cosf(m_pCamera->phi) * m_pCamera->r;
-    cameraPos.y = m_pCamera->poi.y + sinf(m_pCamera->theta) * m_pCamera->r;
-    cameraPos.z = m_pCamera->poi.z + cosf(m_pCamera->theta)* sinf(m_pCamera->phi)* m_pCamera->r;
+    D3D11_VIEWPORT viewport;
+    viewport.TopLeftX = 0;
+    viewport.TopLeftY = 0;
+    viewport.Width = (FLOAT)m_width;
+    viewport.Height = (FLOAT)m_height;
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    context->RSSetViewports(1, &viewport);
 
-    for (int i = 0; i < 4; i++)
+    D3D11_RECT rect;
+    rect.left = 0;
+    rect.top = 0;
+    rect.right = m_width;
+    rect.bottom = m_height;
+    context->RSSetScissorRects(1, &rect);
+}
+
+void Render::bindSceneState(ID3D11DeviceContext* context, bool transparent)
+{
+    ID3D11RenderTargetView* views[] = { m_pPostprocess->getRenderTarget() };
+    context->OMSetRenderTargets(1, views, m_depthBufferDSV.get<ID3D11DepthStencilView>());
+
+    setViewport(context);
+    context->RSSetState(m_rasterizerState.get<ID3D11RasterizerState>());
+    if (transparent)
+    {
+        context->OMSetDepthStencilState(m_transparentDepthState.get<ID3D11DepthStencilState>(), 0);
+        context->OMSetBlendState(m_transparentBlendState.get<ID3D11BlendState>(), nullptr, 0xFFFFFFFF);
+    }
+    else
     {
-        d0 = (std::max)(d0, (float)(pow((cameraPos.x - m_pRect1->coords[i].x), 2)
-                                  + pow((cameraPos.y - m_pRect1->coords[i].y), 2) 
-                                  + pow((cameraPos.z - m_pRect1->coords[i].z), 2)));
-        d1 = (std::max)(d1, (float)(pow((cameraPos.x - m_pRect2->coords[i].x), 2)
-                                  + pow((cameraPos.y - m_pRect2->coords[i].y), 2)
-                                  + pow((cameraPos.z - m_pRect2->coords[i].z), 2)));
+        context->OMSetDepthStencilState(m_depthState.get<ID3D11DepthStencilState>(), 0);
+        context->OMSetBlendState(m_blendState.get<ID3D11BlendState>(), nullptr, 0xFFFFFFFF);
     }
+}
 
-    if (d0 < d1)
+void Render::drawTransparentSorted(ID3D11DeviceContext* context)
+{
+    ID3D11Buffer* pSceneBuffer = m_sceneBufferGPU.get<ID3D11Buffer>();
+    if (m_pFrame->rect1Nearer)
     {
-        m_pRect2->render(m_pDeviceContext, m_pSceneBuffer);
-        m_pRect1->render(m_pDeviceContext, m_pSceneBuffer);
+        m_pRect2->render(context, pSceneBuffer);
+        m_pRect1->render(context, pSceneBuffer);
     }
     else
     {
-        m_pRect1->render(m_pDeviceContext, m_pSceneBuffer);
-        m_pRect2->render(m_pDeviceContext, m_pSceneBuffer);
+        m_pRect1->render(context, pSceneBuffer);
+        m_pRect2->render(context, pSceneBuffer);
     }
 }
 
-void Render::cull()
+void Render::cull(const std::vector<DirectX::XMFLOAT4>& frustum, std::vector<InstanceState>& instances)
 {
     auto& AABB = m_pCube->getAABB();
-    auto& instances = m_pCube->getInstances();
     for (int i = 0; i < instances.size(); i++)
     {
-        if (isBoxInside(frustumPlanes, AABB[i]))
-        {
-            instances[i].params.w = 1;
-        }
-        else
-        {
-            instances[i].params.w = 0;
-        }
+        instances[i].visible = isBoxInside(frustum, AABB[i]);
     }
 }
 
@@ -898,22 +1240,24 @@ bool Render::isBoxInside(const std::vector<DirectX::XMFLOAT4>& frustum, std::pai
     return true;
 }
 
-void Render::calcFrustum()
+void Render::calcFrustum(const FrameInput& input, std::vector<DirectX::XMFLOAT4>& frustumPlanes)
 {
-    DirectX::XMFLOAT3 cameraDir = { -cosf(m_pCamera->theta) * cosf(m_pCamera->phi), -sinf(m_pCamera->theta), -cosf(m_pCamera->theta) * sinf(m_pCamera->phi) };
-    float upTheta = m_pCamera->theta + (float)PI / 2;
-    DirectX::XMFLOAT3 cameraUp = DirectX::XMFLOAT3{ cosf(upTheta) * cosf(m_pCamera->phi), sinf(upTheta), cosf(upTheta) * sinf(m_pCamera->phi) };
+    const Camera& camera = input.camera;
+    DirectX::XMFLOAT3 cameraDir = { -cosf(camera.theta) * cosf(camera.phi), -sinf(camera.theta), -cosf(camera.theta) * sinf(camera.phi) };
+    float upTheta = camera.theta + (float)PI / 2;
+    DirectX::XMFLOAT3 cameraUp = DirectX::XMFLOAT3{ cosf(upTheta) * cosf(camera.phi), sinf(upTheta), cosf(upTheta) * sinf(camera.phi) };
     DirectX::XMFLOAT3 cameraRight = { cameraUp.y * cameraDir.z - cameraUp.z * cameraDir.y, -cameraUp.x * cameraDir.z + cameraUp.z * cameraDir.x, cameraUp.x * cameraDir.y - cameraUp.y * cameraDir.x };
-    DirectX::XMFLOAT3 cameraPos = { (m_pCamera->poi.x - cameraDir.x) * m_pCamera->r, (m_pCamera->poi.y - cameraDir.y) * m_pCamera->r, (m_pCamera->poi.z - cameraDir.z) * m_pCamera->r };
+    DirectX::XMFLOAT3 cameraPos = { (camera.poi.x - cameraDir.x) * camera.r, (camera.poi.y - cameraDir.y) * camera.r, (camera.poi.z - cameraDir.z) * camera.r };
     // planes.first - near, planes.second - far
-    std::pair<std::vector<DirectX::XMFLOAT3>, std::vector<DirectX::XMFLOAT3>> planes;
+    FrameArena& arena = m_frameArenas.local();
+    std::pair<ArenaVector<DirectX::XMFLOAT3>, ArenaVector<DirectX::XMFLOAT3>> planes(arena, arena);
     planes.first.resize(4);
     planes.second.resize(4);
 
     float f = 100.0f;
     float n = 0.1f;
     float fov = (float)PI / 3;
-    float aspectRatio = (float)m_height / m_width;
+    float aspectRatio = (float)input.height / input.width;
 
     planes.first[0] = {
         cameraPos.x + cameraDir.x * n - cameraRight.x * n * tanf(fov / 2) - cameraUp.x * n * tanf(fov / 2) * aspectRatio,
@@ -966,3 +1310,30 @@ void Render::calcFrustum()
     frustumPlanes[4] = buildPlane(planes.first[3], planes.second[3], planes.second[0], planes.first[0]);
     frustumPlanes[5] = buildPlane(planes.second[1], planes.second[0], planes.second[3], planes.second[2]);
 }
+
+void Render::streamTextures(const FrameSnapshot& frame)
+{
+    for (int i = 0; i < frame.mipFootprints.size(); i++)
+    {
+        if (frame.mipFootprints[i] >= 0.0f)
+        {
+            m_pCube->requestTextureMips(i, frame.mipFootprints[i]);
+        }
+    }
+
+    m_pTextureStreamer->setBudget((size_t)m_streamingBudgetKb * 1024);
+
+    m_streamingCommands.clear();
+    m_pTextureStreamer->update(m_streamingCommands);
+    m_pCube->applyStreamingCommands(m_streamingCommands);
+
+    const TextureStreamer::Stats& stats = m_pTextureStreamer->stats();
+    ImGui::Begin("Texture streaming");
+    ImGui::SliderInt("Budget (KB)", &m_streamingBudgetKb, 256, 8192);
+    ImGui::Text("Resident: %d KB", (int)(stats.residentBytes / 1024));
+    ImGui::Text("Loads: %d, evictions: %d, denied: %d", (int)stats.loadsIssued, (int)stats.evictions, (int)stats.deniedLoads);
+    const TextureAtlasBuilder::Stats& atlas = m_pCube->getAtlasStats();
+    ImGui::Text("Atlas: %d pages, %.1f%% used, built in %.1f ms", (int)atlas.pages, atlas.efficiency() * 100.0f,
+        atlas.packMs + atlas.mipMs + atlas.encodeMs);
+    ImGui::End();
+}
@@ -7,6 +7,17 @@
 #include "TransparentRect.h"
 #include "LightModel.h"
 #include "Postprocess.h"
+#include "ThreadPool.h"
+#include "AsyncTextureLoader.h"
+#include "TextureStreamer.h"
+#include "HotReload.h"
+#include "FramePacer.h"
+#include "FramePipeline.h"
+#include "SimulationClock.h"
+#include "FrameArena.h"
+#include "PassRecorder.h"
+#include "DeferredContexts.h"
+#include "D3DResources.h"
 
 #define PI 3.14159265358979323846
 
@@ -33,6 +44,18 @@ struct GeomBuffer
     DirectX::XMFLOAT4 params; // x - shininess, y - use
 };
 
+// Where the time between Render::init() being called and the first frame goes
+struct StartupTimings
+{
+    double deviceMs = 0.0;
+    double sceneSetupMs = 0.0;
+    double shadersMs = 0.0;
+    double objectsMs = 0.0;
+    double totalMs = 0.0;
+    ShaderBuildQueue::Stats shaders;
+    ShaderCache::Stats shaderCache;
+};
+
 struct Camera
 {
     DirectX::XMFLOAT3 poi = {0, 0, 0};
@@ -41,6 +64,38 @@ struct Camera
     float theta = (float)PI / 4;    // Angle from plane x0z
 };
 
+// What the render thread hands to the simulation of a frame
+struct FrameInput
+{
+    // Fixed steps to simulate, and where between the last two states the frame is
+    int steps = 0;
+    double step = 0.0;
+    double alpha = 0.0;
+    // Back to the starting state, e.g. before a replay
+    bool resetSimulation = false;
+    Camera camera;
+    // Lights and flags as the UI left them
+    SceneBuffer scene;
+    UINT width = 16;
+    UINT height = 16;
+    bool computeCull = true;
+};
+
+// Everything a frame draws with, filled by Render::simulate() on the pipeline worker
+struct FrameSnapshot
+{
+    GeomBuffer geom;
+    SceneBuffer scene;
+    GeomBuffer lightGeom[3];
+    std::vector<DirectX::XMFLOAT4> frustumPlanes;
+    std::vector<InstanceState> instances;
+    // Screen size of a cube face per instance, < 0 - culled, no mips requested
+    std::vector<float> mipFootprints;
+    bool computeCull = true;
+    // Transparent rects are drawn back to front
+    bool rect1Nearer = false;
+};
+
 class Render
 {
 public:
@@ -53,37 +108,40 @@ public:
         , m_height(16)
         //, m_pTriangle(nullptr)
         , m_pCube(nullptr)
-        , m_pSceneBuffer(nullptr)
         , m_pCamera(nullptr)
-        , m_pGeomBuffer(nullptr)
         //, m_isRotating(true)
-        , m_prevSec(0)
+        , m_stepsPerSecond(120)
+        , m_unsubmittedSteps(0)
+        , m_resetSimulation(false)
         , m_mousePosX(0)
         , m_mousePosY(0)
         , m_isButtonPressed(false)
-        , m_pSamplerState(nullptr)
         , m_pSkybox(nullptr)
         , m_pCube2(nullptr)
-        , m_pRasterizerState(nullptr)
-        , m_pDepthBuffer(nullptr)
-        , m_pDepthBufferDSV(nullptr)
-        , m_pGeomBuffer2(nullptr)
-        , m_pDepthState(nullptr)
         , m_pRect1(nullptr)
         , m_pRect2(nullptr)
-        , m_pBlendState(nullptr)
-        , m_pTransparentDepthState(nullptr)
-        , m_pTransparentBlendState(nullptr)
         , m_useNormalMap(true)
         , m_showNormals(false)
         , m_pPostprocess(nullptr)
         , m_useFilter(false)
         , m_computeCull(true)
+        , m_pThreadPool(nullptr)
+        , m_pTextureLoader(nullptr)
+        , m_pTextureStreamer(nullptr)
+        , m_pHotReload(nullptr)
+        , m_pFramePipeline(nullptr)
+        , m_pFrame(nullptr)
+        , m_pipelined(true)
+        , m_pPassRecorder(nullptr)
+        , m_pDeferredContexts(nullptr)
+        , m_deferredPasses(false)
+        , m_pResources(nullptr)
+        , m_pFrameFence(nullptr)
+        , m_hotReloadFailures(0)
+        , m_targetFps(60)
+        , m_vsync(false)
+        , m_streamingBudgetKb(4096)
     {
-        for (int i = 0; i < 3; i++)
-        {
-            m_pLightSourceGeomBuffers[i] = nullptr;
-        }
     }
 
     ~Render() { terminate(); }
@@ -94,11 +152,16 @@ public:
     bool resize(UINT width, UINT height);
 
     bool update();
+    // Once per pass of the frame loop, also when update() or render() didn't run
+    void endFrame();
 
     void mouseLeftButton(bool pressed, int posX, int posY);
     void mouseMove(int posX, int posY);
     void mouseWheel(int delta);
 
+    // The frame loop waits on it after every frame, its settings are in the UI
+    FramePacer& framePacer() { return m_framePacer; }
+
 private:
     void terminate();
 
@@ -108,38 +171,46 @@ private:
     HRESULT initDepthStencil();
     HRESULT initBlendState();
 
-    void drawTransparentSorted();
+    // Runs on the pipeline worker. Touches only the simulation state and scene data fixed after init()
+    void simulate(const FrameInput& input, FrameSnapshot& frame);
+
+    void setViewport(ID3D11DeviceContext* context);
+    // Render target, viewport and fixed-function state of the scene passes
+    void bindSceneState(ID3D11DeviceContext* context, bool transparent);
+    void drawTransparentSorted(ID3D11DeviceContext* context);
 
-    void cull();
+    void cull(const std::vector<DirectX::XMFLOAT4>& frustum, std::vector<InstanceState>& instances);
     DirectX::XMFLOAT4 buildPlane(const DirectX::XMFLOAT3& p0, const DirectX::XMFLOAT3& p1, const DirectX::XMFLOAT3& p2, const DirectX::XMFLOAT3& p3);
     bool isBoxInside(const std::vector<DirectX::XMFLOAT4>& frustum, std::pair<DirectX::XMFLOAT3, DirectX::XMFLOAT3>& AABB);
 
-    void calcFrustum();
+    void calcFrustum(const FrameInput& input, std::vector<DirectX::XMFLOAT4>& frustumPlanes);
+
+    void streamTextures(const FrameSnapshot& frame);
 
 private:
     ID3D11Device* m_pDevice;
     ID3D11DeviceContext* m_pDeviceContext;
 
     IDXGISwapChain* m_pSwapChain;
+    // Not in the pool: ResizeBuffers() needs it released at once, not when the GPU is done
     ID3D11RenderTargetView* m_pBackBufferRTV;
 
-    ID3D11RasterizerState* m_pRasterizerState;
+    ResourcePool::Unique m_rasterizerState;
 
-    ID3D11Texture2D* m_pDepthBuffer;
-    ID3D11DepthStencilView* m_pDepthBufferDSV;
-    ID3D11DepthStencilState* m_pDepthState;
-    ID3D11DepthStencilState* m_pTransparentDepthState;
+    ResourcePool::Unique m_depthBuffer;
+    ResourcePool::Unique m_depthBufferDSV;
+    ResourcePool::Unique m_depthState;
+    ResourcePool::Unique m_transparentDepthState;
 
-    ID3D11BlendState* m_pBlendState;
-    ID3D11BlendState* m_pTransparentBlendState;
+    ResourcePool::Unique m_blendState;
+    ResourcePool::Unique m_transparentBlendState;
 
-    ID3D11Buffer* m_pSceneBuffer;
-    ID3D11Buffer* m_pGeomBuffer;
-    ID3D11Buffer* m_pGeomBuffer2;
-    ID3D11Buffer* m_pGeomBufferInst;
-    ID3D11Buffer* m_pLightSourceGeomBuffers[3];
+    ResourcePool::Unique m_sceneBufferGPU;
+    ResourcePool::Unique m_geomBuffer;
+    ResourcePool::Unique m_geomBuffer2;
+    ResourcePool::Unique m_lightSourceGeomBuffers[3];
 
-    ID3D11SamplerState* m_pSamplerState;
+    ResourcePool::Unique m_samplerState;
 
     UINT m_width;
     UINT m_height;
@@ -153,12 +224,53 @@ private:
     TransparentRect* m_pRect2;
     Postprocess* m_pPostprocess;
 
+    ThreadPool* m_pThreadPool;
+    AsyncTextureLoader* m_pTextureLoader;
+    TextureStreamer* m_pTextureStreamer;
+    int m_streamingBudgetKb;
+    std::vector<TextureStreamer::Command> m_streamingCommands;
+
+    HotReload* m_pHotReload;
+    // Failures already reported to the debug output
+    uint64_t m_hotReloadFailures;
+
+    FramePipeline<FrameInput, FrameSnapshot>* m_pFramePipeline;
+    // Snapshot of the frame being drawn, valid until the next update()
+    const FrameSnapshot* m_pFrame;
+    bool m_pipelined;
+
+    PassRecorder<ID3D11DeviceContext>* m_pPassRecorder;
+    // nullptr when deferred contexts can't be created, the passes then always record serially
+    DeferredContexts* m_pDeferredContexts;
+    bool m_deferredPasses;
+
+    // Scene objects keep handles into it, what they destroy is released once the frame fence passes
+    D3DResources* m_pResources;
+    FrameFence* m_pFrameFence;
+
+    // Transient data of a frame, the render thread and the simulation worker each reset their own
+    FrameArenas m_frameArenas;
+
+    // Measured on the render thread, the worker gets whole steps through FrameInput
+    SimulationClock m_simulationClock;
+    int m_stepsPerSecond;
+    // Both wait for the next submitted input, a frame whose input isn't submitted must not lose them
+    int m_unsubmittedSteps;
+    bool m_resetSimulation;
+
+    FramePacer m_framePacer;
+    int m_targetFps;
+    bool m_vsync;
+
+    StartupTimings m_startup;
+
     SceneBuffer m_sceneBuffer;
 
     Camera* m_pCamera;
-    double m_angle = 0;
 
-    size_t m_prevSec = 0;
+    // Simulation state, only the pipeline worker touches it
+    double m_angle = 0;
+    double m_prevAngle = 0;
 
     //bool m_isRotating;
 
@@ -172,6 +284,5 @@ private:
 
     std::vector<LightModel*> lights;
     std::vector<GeomBuffer> geomBuffers;
-    std::vector<DirectX::XMFLOAT4> frustumPlanes;
 };
 
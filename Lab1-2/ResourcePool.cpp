@@ -0,0 +1,125 @@
+#include "ResourcePool.h"
+
+#include <cassert>
+
+ResourcePool::ResourcePool()
+    : m_frameFence(0)
+{
+}
+
+ResourcePool::~ResourcePool()
+{
+    collect(UINT64_MAX);
+
+    // Owners are normally gone by now, anything still live is released too
+    for (uint32_t i = 0; i < (uint32_t)m_objects.size(); i++)
+    {
+        if (m_objects[i] != nullptr)
+        {
+            TypeId type = m_types[i];
+            m_typeStats[type].live--;
+            m_typeStats[type].liveBytes -= m_bytes[i];
+            m_stats.live--;
+            releaseObject(type, m_objects[i]);
+            m_objects[i] = nullptr;
+        }
+    }
+}
+
+ResourcePool::TypeId ResourcePool::registerType(const std::string& name, ReleaseFn release)
+{
+    m_release.push_back(release);
+    TypeStats stats;
+    stats.name = name;
+    m_typeStats.push_back(stats);
+    return (TypeId)(m_release.size() - 1);
+}
+
+ResourcePool::Handle ResourcePool::create(TypeId type, void* object, size_t bytes)
+{
+    assert(type < m_release.size());
+    if (object == nullptr)
+    {
+        return Handle();
+    }
+
+    uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = (uint32_t)m_objects.size();
+        m_objects.push_back(nullptr);
+        m_generations.push_back(1);
+        m_types.push_back(0);
+        m_bytes.push_back(0);
+        m_stats.slots = m_objects.size();
+    }
+
+    m_objects[index] = object;
+    m_types[index] = type;
+    m_bytes[index] = bytes;
+
+    m_typeStats[type].live++;
+    m_typeStats[type].liveBytes += bytes;
+    m_stats.live++;
+    m_stats.created++;
+
+    Handle handle;
+    handle.index = index;
+    handle.generation = m_generations[index];
+    return handle;
+}
+
+void ResourcePool::destroy(Handle handle)
+{
+    if (get(handle) == nullptr)
+    {
+        return;
+    }
+
+    uint32_t index = handle.index;
+    TypeId type = m_types[index];
+    m_pending.push_back({ m_objects[index], type, m_bytes[index], m_frameFence });
+
+    m_typeStats[type].live--;
+    m_typeStats[type].liveBytes -= m_bytes[index];
+    m_typeStats[type].pending++;
+    m_typeStats[type].pendingBytes += m_bytes[index];
+    m_stats.live--;
+    m_stats.pending++;
+
+    m_objects[index] = nullptr;
+    m_bytes[index] = 0;
+    // Every handle to the slot so far is stale now, 0 stays reserved for null
+    m_generations[index]++;
+    if (m_generations[index] == 0)
+    {
+        m_generations[index] = 1;
+    }
+    m_freeSlots.push_back(index);
+}
+
+void ResourcePool::collect(uint64_t completedFence)
+{
+    size_t count = 0;
+    while (count < m_pending.size() && m_pending[count].fence <= completedFence)
+    {
+        const Pending& pending = m_pending[count];
+        m_typeStats[pending.type].pending--;
+        m_typeStats[pending.type].pendingBytes -= pending.bytes;
+        m_stats.pending--;
+        releaseObject(pending.type, pending.object);
+        count++;
+    }
+    m_pending.erase(m_pending.begin(), m_pending.begin() + count);
+}
+
+void ResourcePool::releaseObject(TypeId type, void* object)
+{
+    m_release[type](object);
+    m_stats.released++;
+}
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Registry of GPU objects behind generational handles. A handle is a slot index
+// and the generation of the slot; destroying bumps the generation, so stale
+// handles look up nullptr instead of whatever reuses the slot. Slots are stored
+// as parallel arrays, lookup is an index and a compare. Destroyed objects are
+// released only once the GPU has passed the frame they were destroyed in.
+// Memory is accounted per resource type.
+// Not thread-safe: create(), destroy() and collect() on one thread; get() from
+// any thread while none of those runs, e.g. when passes record in parallel.
+// Portable (std only), objects are void* with a release function per type.
+class ResourcePool
+{
+public:
+	using TypeId = uint32_t;
+	using ReleaseFn = void (*)(void* object);
+
+	struct Handle
+	{
+		uint32_t index = 0;
+		// 0 - null handle, live slots start at 1
+		uint32_t generation = 0;
+
+		bool isNull() const { return generation == 0; }
+		bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+		bool operator!=(const Handle& other) const { return !(*this == other); }
+	};
+
+	// Owns a handle and destroys it when it goes out of scope or is reset. Move only
+	class Unique
+	{
+	public:
+		Unique() : m_pPool(nullptr) {}
+		Unique(ResourcePool* pool, Handle handle) : m_pPool(pool), m_handle(handle) {}
+		~Unique() { reset(); }
+
+		Unique(Unique&& other) : m_pPool(other.m_pPool), m_handle(other.release()) {}
+		Unique& operator=(Unique&& other)
+		{
+			if (this != &other)
+			{
+				reset();
+				m_pPool = other.m_pPool;
+				m_handle = other.release();
+			}
+			return *this;
+		}
+
+		Unique(const Unique&) = delete;
+		Unique& operator=(const Unique&) = delete;
+
+		void reset()
+		{
+			if (m_pPool != nullptr && !m_handle.isNull())
+			{
+				m_pPool->destroy(m_handle);
+			}
+			m_handle = Handle();
+		}
+
+		// Gives up ownership without destroying
+		Handle release()
+		{
+			Handle handle = m_handle;
+			m_handle = Handle();
+			return handle;
+		}
+
+		Handle handle() const { return m_handle; }
+		explicit operator bool() const { return !m_handle.isNull(); }
+
+		template <typename T>
+		T* get() const { return m_pPool != nullptr ? m_pPool->get<T>(m_handle) : nullptr; }
+
+	private:
+		ResourcePool* m_pPool;
+		Handle m_handle;
+	};
+
+	struct TypeStats
+	{
+		std::string name;
+		size_t live = 0;
+		size_t liveBytes = 0;
+		// Destroyed, waiting for the GPU
+		size_t pending = 0;
+		size_t pendingBytes = 0;
+	};
+
+	struct Stats
+	{
+		size_t slots = 0;
+		size_t live = 0;
+		size_t pending = 0;
+		uint64_t created = 0;
+		uint64_t released = 0;
+	};
+
+	ResourcePool();
+	// Releases whatever is left, pending or live; the GPU must be idle by then
+	~ResourcePool();
+
+	ResourcePool(const ResourcePool&) = delete;
+	ResourcePool& operator=(const ResourcePool&) = delete;
+
+	TypeId registerType(const std::string& name, ReleaseFn release);
+
+	// Takes over the object's reference. object == nullptr gives a null handle
+	Handle create(TypeId type, void* object, size_t bytes);
+	Unique createUnique(TypeId type, void* object, size_t bytes) { return Unique(this, create(type, object, bytes)); }
+
+	// nullptr for null, destroyed and stale handles
+	void* get(Handle handle) const
+	{
+		if (handle.index >= m_generations.size() || m_generations[handle.index] != handle.generation)
+		{
+			return nullptr;
+		}
+		return m_objects[handle.index];
+	}
+
+	template <typename T>
+	T* get(Handle handle) const { return static_cast<T*>(get(handle)); }
+
+	bool isValid(Handle handle) const { return get(handle) != nullptr; }
+
+	// The handle is dead at once, the object waits for the current frame fence
+	void destroy(Handle handle);
+
+	// Fence value the GPU signals after the work recorded from now on
+	void setFrameFence(uint64_t fence) { m_frameFence = fence; }
+	uint64_t frameFence() const { return m_frameFence; }
+
+	// Releases what was destroyed in frames up to completedFence
+	void collect(uint64_t completedFence);
+
+	const std::vector<TypeStats>& typeStats() const { return m_typeStats; }
+	const Stats& stats() const { return m_stats; }
+
+private:
+	struct Pending
+	{
+		void* object;
+		TypeId type;
+		size_t bytes;
+		uint64_t fence;
+	};
+
+	void releaseObject(TypeId type, void* object);
+
+private:
+	// Slot arrays, indexed by Handle::index
+	std::vector<void*> m_objects;
+	std::vector<uint32_t> m_generations;
+	std::vector<TypeId> m_types;
+	std::vector<size_t> m_bytes;
+	std::vector<uint32_t> m_freeSlots;
+
+	std::vector<ReleaseFn> m_release;
+	std::vector<TypeStats> m_typeStats;
+
+	// Ordered by fence
+	std::vector<Pending> m_pending;
+	uint64_t m_frameFence;
+
+	Stats m_stats;
+};
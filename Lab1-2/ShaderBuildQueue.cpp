@@ -0,0 +1,46 @@
+#include "ShaderBuildQueue.h"
+
+#include <chrono>
+
+bool ShaderBuildQueue::run(ThreadPool* pool)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    auto compileRange = [this](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            Job& job = m_jobs[i];
+            auto jobStart = std::chrono::steady_clock::now();
+            job.succeeded = job.compile();
+            job.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - jobStart).count();
+        }
+    };
+
+    // Compile times differ a lot, so the smallest chunks let idle workers pick up the remaining jobs
+    if (pool != nullptr)
+    {
+        pool->parallelFor(m_jobs.size(), 1, compileRange);
+    }
+    else
+    {
+        compileRange(0, m_jobs.size());
+    }
+
+    m_stats = {};
+    m_stats.jobs = m_jobs.size();
+    m_stats.threads = pool != nullptr ? pool->size() + 1 : 1;
+    m_stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    for (const Job& job : m_jobs)
+    {
+        m_stats.failed += job.succeeded ? 0 : 1;
+        m_stats.compileMs += job.ms;
+        if (job.ms > m_stats.longestMs)
+        {
+            m_stats.longestMs = job.ms;
+            m_stats.longestJob = job.name;
+        }
+    }
+
+    return m_stats.failed == 0;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "ThreadPool.h"
+
+// Collects shader compile jobs and runs them all at once on a thread pool.
+// A job only produces bytecode (into ShaderCache), it never touches the device,
+// so the owners create their shader objects afterwards on their own thread and
+// hit the cache. Jobs don't depend on each other, the graph is flat.
+class ShaderBuildQueue
+{
+public:
+	// Runs on any thread, false - the shader failed to compile
+	using CompileFn = std::function<bool()>;
+
+	struct Job
+	{
+		std::string name;
+		CompileFn compile;
+		// File the job compiles, lets a rebuild pick the jobs of the files that changed
+		std::string source;
+		bool succeeded = false;
+		double ms = 0.0;
+	};
+
+	struct Stats
+	{
+		size_t jobs = 0;
+		size_t failed = 0;
+		unsigned threads = 0;
+		// Time from run() to the last job finishing
+		double wallMs = 0.0;
+		// Sum over the jobs, i.e. what a serial build would have taken
+		double compileMs = 0.0;
+		double longestMs = 0.0;
+		std::string longestJob;
+	};
+
+	void add(const std::string& name, CompileFn compile, const std::string& source = std::string()) { m_jobs.push_back({ name, std::move(compile), source }); }
+
+	// Blocks until every job is done. The calling thread takes part. Without a pool the jobs run serially
+	bool run(ThreadPool* pool);
+
+	const std::vector<Job>& jobs() const { return m_jobs; }
+	const Stats& stats() const { return m_stats; }
+
+private:
+	std::vector<Job> m_jobs;
+	Stats m_stats;
+};
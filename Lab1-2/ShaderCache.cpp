@@ -0,0 +1,240 @@
+#include "ShaderCache.h"
+
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+static const uint32_t EntryMagic = 0x31434853; // "SHC1"
+
+struct EntryHeader
+{
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t key;
+    uint64_t size;
+    uint64_t payloadHash;
+};
+
+// FNV-1a, plenty for a few hundred keys and needs no dependency
+static const uint64_t HashSeed = 0xcbf29ce484222325ull;
+
+static uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= pBytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Length first, so ("ab", "c") and ("a", "bc") hash differently
+static uint64_t hashField(uint64_t hash, const void* data, size_t size)
+{
+    uint64_t length = size;
+    hash = hashBytes(hash, &length, sizeof(length));
+    return hashBytes(hash, data, size);
+}
+
+static uint64_t hashString(uint64_t hash, const std::string& value)
+{
+    return hashField(hash, value.data(), value.size());
+}
+
+ShaderCache::ShaderCache(const std::wstring& directory, uint64_t salt)
+    : m_directory(directory)
+    , m_salt(salt)
+{
+    if (!m_directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(m_directory), error);
+    }
+}
+
+ShaderCache::Key ShaderCache::makeKey(const void* preprocessed, size_t size, const std::vector<std::string>& defines,
+    const std::string& entryPoint, const std::string& profile, uint32_t flags) const
+{
+    uint64_t hash = hashBytes(HashSeed, &m_salt, sizeof(m_salt));
+    hash = hashField(hash, preprocessed, size);
+    uint64_t defineCount = defines.size();
+    hash = hashBytes(hash, &defineCount, sizeof(defineCount));
+    for (const std::string& define : defines)
+    {
+        hash = hashString(hash, define);
+    }
+    hash = hashString(hash, entryPoint);
+    hash = hashString(hash, profile);
+    return hashBytes(hash, &flags, sizeof(flags));
+}
+
+std::wstring ShaderCache::entryPath(Key key) const
+{
+    wchar_t name[17];
+    for (int i = 0; i < 16; i++)
+    {
+        name[i] = L"0123456789abcdef"[(key >> (60 - 4 * i)) & 0xF];
+    }
+    name[16] = L'\0';
+    return (std::filesystem::path(m_directory) / (std::wstring(name) + L".cso")).wstring();
+}
+
+bool ShaderCache::load(Key key, std::vector<char>& bytecode)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_memoryMutex);
+        auto it = m_memory.find(key);
+        if (it != m_memory.end())
+        {
+            bytecode = it->second;
+            m_hits++;
+            m_memoryHits++;
+            return true;
+        }
+    }
+
+    if (m_directory.empty())
+    {
+        m_misses++;
+        return false;
+    }
+
+    std::ifstream file(std::filesystem::path(entryPath(key)), std::ios::binary);
+    EntryHeader header = {};
+    bool valid = file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        && header.magic == EntryMagic && header.key == key && header.size != 0 && header.size < (1ull << 30);
+    if (valid)
+    {
+        bytecode.resize((size_t)header.size);
+        // A truncated or damaged entry is just a miss, the next store replaces it
+        valid = file.read(bytecode.data(), (std::streamsize)header.size)
+            && file.peek() == std::char_traits<char>::eof()
+            && hashBytes(HashSeed, bytecode.data(), bytecode.size()) == header.payloadHash;
+    }
+
+    if (!valid)
+    {
+        bytecode.clear();
+        m_misses++;
+        return false;
+    }
+    m_hits++;
+
+    std::lock_guard<std::mutex> lock(m_memoryMutex);
+    m_memory.emplace(key, bytecode);
+    return true;
+}
+
+bool ShaderCache::store(Key key, const std::vector<char>& bytecode)
+{
+    if (bytecode.empty())
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_memoryMutex);
+        m_memory[key] = bytecode;
+    }
+    if (m_directory.empty())
+    {
+        return false;
+    }
+
+    EntryHeader header = {};
+    header.magic = EntryMagic;
+    header.key = key;
+    header.size = bytecode.size();
+    header.payloadHash = hashBytes(HashSeed, bytecode.data(), bytecode.size());
+
+    std::filesystem::path path(entryPath(key));
+    std::filesystem::path tempPath = path;
+    tempPath += L"." + std::to_wstring(std::hash<std::thread::id>()(std::this_thread::get_id())) + L".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(bytecode.data(), (std::streamsize)bytecode.size());
+        if (!file)
+        {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            m_writeFailures++;
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        std::filesystem::remove(tempPath, error);
+        m_writeFailures++;
+        return false;
+    }
+    return true;
+}
+
+bool ShaderCache::getOrCompile(Key key, const CompileFn& compile, std::vector<char>& bytecode)
+{
+    if (load(key, bytecode))
+    {
+        return true;
+    }
+    if (!compile(bytecode))
+    {
+        return false;
+    }
+    // A failed write only costs a compile next launch
+    store(key, bytecode);
+    return true;
+}
+
+const std::vector<char>* ShaderIncludeCache::read(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_files.find(filename);
+    if (it != m_files.end())
+    {
+        return it->second.get();
+    }
+
+    std::ifstream file(std::filesystem::path(filename), std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        return nullptr;
+    }
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    auto pData = std::make_unique<std::vector<char>>((size_t)size);
+    if (!file.read(pData->data(), size))
+    {
+        return nullptr;
+    }
+
+    const std::vector<char>* pResult = pData.get();
+    m_files.emplace(filename, std::move(pData));
+    return pResult;
+}
+
+void ShaderIncludeCache::invalidate(const std::string& filename)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_files.find(filename);
+    if (it != m_files.end())
+    {
+        m_retired.push_back(std::move(it->second));
+        m_files.erase(it);
+    }
+}
+
+void ShaderIncludeCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_files.clear();
+    m_retired.clear();
+}
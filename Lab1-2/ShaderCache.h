@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Content addressed on-disk cache of shader bytecode. Knows nothing about the
+// compiler: the key is a hash of the preprocessed source (includes already
+// expanded, so editing an include changes it), the defines, the entry point,
+// the target profile and the compile flags. One file per key, written through a
+// temporary file and a rename, so concurrent compiles never see half an entry.
+// Everything loaded or stored during the run is also kept in memory.
+class ShaderCache
+{
+public:
+	using Key = uint64_t;
+	// Produces bytecode on a miss, false - compile error (nothing is cached)
+	using CompileFn = std::function<bool(std::vector<char>& bytecode)>;
+
+	struct Stats
+	{
+		uint64_t hits = 0;
+		// Part of hits served without reading the disk
+		uint64_t memoryHits = 0;
+		uint64_t misses = 0;
+		uint64_t writeFailures = 0;
+	};
+
+	// An empty directory disables the disk, only the memory part is left.
+	// salt - anything else that changes the output for the same input, e.g. the compiler version
+	ShaderCache(const std::wstring& directory, uint64_t salt = 0);
+
+	Key makeKey(const void* preprocessed, size_t size, const std::vector<std::string>& defines,
+		const std::string& entryPoint, const std::string& profile, uint32_t flags) const;
+
+	bool load(Key key, std::vector<char>& bytecode);
+	// false - the entry only made it into memory
+	bool store(Key key, const std::vector<char>& bytecode);
+
+	// load(), and on a miss compile() followed by store()
+	bool getOrCompile(Key key, const CompileFn& compile, std::vector<char>& bytecode);
+
+	Stats stats() const { return { m_hits.load(), m_memoryHits.load(), m_misses.load(), m_writeFailures.load() }; }
+
+private:
+	std::wstring entryPath(Key key) const;
+
+private:
+	std::wstring m_directory;
+	uint64_t m_salt;
+
+	std::mutex m_memoryMutex;
+	std::unordered_map<Key, std::vector<char>> m_memory;
+
+	std::atomic<uint64_t> m_hits{ 0 };
+	std::atomic<uint64_t> m_memoryHits{ 0 };
+	std::atomic<uint64_t> m_misses{ 0 };
+	std::atomic<uint64_t> m_writeFailures{ 0 };
+};
+
+// Contents of shader include files, read from disk once per run and shared by
+// every compile. Returned buffers stay valid until clear()
+class ShaderIncludeCache
+{
+public:
+	const std::vector<char>* read(const std::string& filename);
+
+	// Next read() of the file goes to disk again, e.g. after it was edited.
+	// A compile still holding the old contents keeps using them
+	void invalidate(const std::string& filename);
+
+	// Next read() of every file goes to disk again
+	void clear();
+
+private:
+	std::mutex m_mutex;
+	std::unordered_map<std::string, std::unique_ptr<std::vector<char>>> m_files;
+	// Invalidated contents, kept until clear()
+	std::vector<std::unique_ptr<std::vector<char>>> m_retired;
+};
@@ -0,0 +1,115 @@
+#include "ShaderPermutations.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+
+size_t ShaderPermutations::addAxis(const std::string& define, uint32_t valueCount)
+{
+    assert(valueCount > 0);
+    m_axes.push_back({ define, (std::max)(valueCount, 1u), (uint32_t)variantCount() });
+    m_sizes.assign(variantCount(), 0);
+    return m_axes.size() - 1;
+}
+
+size_t ShaderPermutations::variantCount() const
+{
+    size_t count = 1;
+    for (const Axis& axis : m_axes)
+    {
+        count *= axis.valueCount;
+    }
+    return count;
+}
+
+ShaderPermutations::Key ShaderPermutations::key(const std::vector<uint32_t>& values) const
+{
+    assert(values.size() == m_axes.size());
+    Key result = 0;
+    for (size_t i = 0; i < m_axes.size() && i < values.size(); i++)
+    {
+        result += (std::min)(values[i], m_axes[i].valueCount - 1) * m_axes[i].stride;
+    }
+    return result;
+}
+
+ShaderPermutations::Key ShaderPermutations::key(const std::vector<std::string>& defines) const
+{
+    std::vector<uint32_t> values(m_axes.size(), 0);
+    for (const std::string& define : defines)
+    {
+        const size_t equals = define.find('=');
+        const std::string name = define.substr(0, equals);
+        const uint32_t value = (equals == std::string::npos) ? 1u : (uint32_t)std::strtoul(define.c_str() + equals + 1, nullptr, 10);
+        for (size_t i = 0; i < m_axes.size(); i++)
+        {
+            if (m_axes[i].define == name)
+            {
+                values[i] = value;
+            }
+        }
+    }
+    return key(values);
+}
+
+uint32_t ShaderPermutations::value(Key key, size_t axis) const
+{
+    return (key / m_axes[axis].stride) % m_axes[axis].valueCount;
+}
+
+std::vector<std::string> ShaderPermutations::defines(Key key) const
+{
+    std::vector<std::string> result;
+    for (size_t i = 0; i < m_axes.size(); i++)
+    {
+        result.push_back(m_axes[i].define + "=" + std::to_string(value(key, i)));
+    }
+    return result;
+}
+
+void ShaderPermutations::setVariantSize(Key key, size_t bytes)
+{
+    if (key < m_sizes.size())
+    {
+        m_sizes[key] = bytes;
+    }
+}
+
+size_t ShaderPermutations::totalSize() const
+{
+    size_t total = 0;
+    for (size_t size : m_sizes)
+    {
+        total += size;
+    }
+    return total;
+}
+
+bool ShaderPermutations::hasVariant(Key key) const
+{
+    return key < m_sizes.size() && m_sizes[key] > 0;
+}
+
+ShaderPermutations::Key ShaderPermutations::select(Key key) const
+{
+    for (size_t i = m_axes.size(); !hasVariant(key) && i > 0; i--)
+    {
+        key -= value(key, i - 1) * m_axes[i - 1].stride;
+    }
+    return hasVariant(key) ? key : 0;
+}
+
+std::string ShaderPermutations::report(const std::string& shaderName) const
+{
+    std::string result = shaderName + ": " + std::to_string(variantCount()) + " variants, " + std::to_string(totalSize()) + " bytes\n";
+    for (Key key = 0; key < (Key)variantCount(); key++)
+    {
+        result += "  ";
+        for (const std::string& define : defines(key))
+        {
+            result += define + " ";
+        }
+        result += hasVariant(key) ? std::to_string(m_sizes[key]) + " bytes\n" : std::string("missing\n");
+    }
+    return result;
+}
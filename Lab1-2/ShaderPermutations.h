@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Feature axes of one shader and the variants they span. A variant is compiled
+// with "NAME=value" defined for every axis, so the shader tests the feature with
+// a plain if on a constant and the compiler drops the dead side. Variant keys are
+// mixed radix numbers over the axes, dense in [0, variantCount()), so owners keep
+// the compiled variants in a plain array indexed by key.
+class ShaderPermutations
+{
+public:
+	using Key = uint32_t;
+
+	// Returns the axis index, used as the position in the values passed to key()
+	size_t addAxis(const std::string& define, uint32_t valueCount = 2);
+
+	size_t axisCount() const { return m_axes.size(); }
+	size_t variantCount() const;
+
+	// values[i] - value of axis i, out of range values are clamped
+	Key key(const std::vector<uint32_t>& values) const;
+	// "NAME=value" or "NAME" (value 1) in any order, repeats are harmless, axes left out are 0
+	// and names that are not axes are ignored
+	Key key(const std::vector<std::string>& defines) const;
+	uint32_t value(Key key, size_t axis) const;
+
+	// "NAME=value" for every axis, ready for compileShader()
+	std::vector<std::string> defines(Key key) const;
+
+	// Bytecode size of a compiled variant, for report(). A variant without one is missing
+	void setVariantSize(Key key, size_t bytes);
+	size_t totalSize() const;
+	bool hasVariant(Key key) const;
+
+	// key if that variant is there, otherwise the first one present after switching axes
+	// off from the last one back, so later axes should be the optional features. 0 if none is
+	Key select(Key key) const;
+
+	// One line per variant: defines and bytecode size
+	std::string report(const std::string& shaderName) const;
+
+private:
+	struct Axis
+	{
+		std::string define;
+		uint32_t valueCount;
+		uint32_t stride;
+	};
+
+private:
+	std::vector<Axis> m_axes;
+	std::vector<size_t> m_sizes;
+};
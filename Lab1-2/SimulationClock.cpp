@@ -0,0 +1,192 @@
+#include "SimulationClock.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
+SimulationClock::SimulationClock(FramePacer::TimeSource* time)
+    : SimulationClock(Options(), time)
+{
+}
+
+SimulationClock::SimulationClock(const Options& options, FramePacer::TimeSource* time)
+    : m_options(options)
+    , m_pTime(time != nullptr ? time : &FramePacer::systemTime())
+    , m_started(false)
+    , m_lastTime(0.0)
+    , m_accumulator(0.0)
+    , m_stepCount(0)
+    , m_timeScale(1.0)
+    , m_paused(false)
+    , m_liveTimeScale(1.0)
+    , m_livePaused(false)
+    , m_mode(Mode::Live)
+    , m_replayCursor(0)
+{
+}
+
+double SimulationClock::nextFrameTime()
+{
+    // The real clock keeps running during a replay, so going back to Live doesn't see one huge frame
+    double now = m_pTime->now();
+    double frameTime = m_started ? now - m_lastTime : 0.0;
+    m_started = true;
+    m_lastTime = now;
+
+    if (m_mode == Mode::Replay)
+    {
+        frameTime = m_replay[m_replayCursor++];
+        if (m_replayCursor == m_replay.size())
+        {
+            m_mode = Mode::Live;
+            m_timeScale = m_liveTimeScale;
+            m_paused = m_livePaused;
+        }
+    }
+    else if (m_mode == Mode::Record)
+    {
+        m_recording.push_back(frameTime);
+    }
+    return frameTime;
+}
+
+int SimulationClock::advance()
+{
+    // The last frame of a replay ends it and restores the live settings, it still runs at the replay's
+    double timeScale = m_timeScale;
+    bool paused = m_paused;
+    double frameTime = nextFrameTime();
+    m_stats.frames++;
+    m_stats.frameMs = frameTime * 1000.0;
+
+    if (frameTime > m_options.maxFrameTime)
+    {
+        m_stats.droppedTime += frameTime - m_options.maxFrameTime;
+        frameTime = m_options.maxFrameTime;
+    }
+
+    if (!paused)
+    {
+        m_accumulator += (std::max)(frameTime, 0.0) * timeScale;
+    }
+
+    int steps = (int)floor(m_accumulator / m_options.step);
+    if (steps > m_options.maxStepsPerFrame)
+    {
+        m_stats.droppedTime += (steps - m_options.maxStepsPerFrame) * m_options.step;
+        steps = m_options.maxStepsPerFrame;
+    }
+    m_accumulator -= floor(m_accumulator / m_options.step) * m_options.step;
+    // Rounding can leave a hair under zero or exactly one step
+    m_accumulator = (std::min)((std::max)(m_accumulator, 0.0), m_options.step * (1.0 - 1e-9));
+
+    m_stepCount += steps;
+    m_stats.steps = m_stepCount;
+    return steps;
+}
+
+void SimulationClock::setStep(double seconds)
+{
+    if (seconds <= 0.0)
+    {
+        return;
+    }
+
+    // Keep the interpolation factor where it was
+    m_accumulator = alpha() * seconds;
+    m_options.step = seconds;
+}
+
+void SimulationClock::setTimeScale(double scale)
+{
+    if (m_mode == Mode::Replay)
+    {
+        m_liveTimeScale = scale;
+    }
+    else
+    {
+        m_timeScale = scale;
+    }
+}
+
+void SimulationClock::setPaused(bool paused)
+{
+    if (m_mode == Mode::Replay)
+    {
+        m_livePaused = paused;
+    }
+    else
+    {
+        m_paused = paused;
+    }
+}
+
+void SimulationClock::startRecording()
+{
+    m_recording.clear();
+    m_mode = Mode::Record;
+}
+
+void SimulationClock::stopRecording()
+{
+    if (m_mode == Mode::Record)
+    {
+        m_mode = Mode::Live;
+    }
+}
+
+void SimulationClock::startReplay(const std::vector<double>& frameTimes)
+{
+    if (frameTimes.empty())
+    {
+        return;
+    }
+
+    // Restarting a replay keeps the settings put aside by the first one
+    if (m_mode != Mode::Replay)
+    {
+        m_liveTimeScale = m_timeScale;
+        m_livePaused = m_paused;
+    }
+    m_timeScale = 1.0;
+    m_paused = false;
+
+    m_replay = frameTimes;
+    m_replayCursor = 0;
+    m_accumulator = 0.0;
+    m_stepCount = 0;
+    m_mode = Mode::Replay;
+}
+
+bool SimulationClock::saveRecording(const std::string& filename) const
+{
+    std::ofstream file(filename);
+    if (!file)
+    {
+        return false;
+    }
+
+    file.precision(17);
+    for (double frameTime : m_recording)
+    {
+        file << frameTime << '\n';
+    }
+    return (bool)file;
+}
+
+bool SimulationClock::loadRecording(const std::string& filename, std::vector<double>& frameTimes)
+{
+    std::ifstream file(filename);
+    if (!file)
+    {
+        return false;
+    }
+
+    frameTimes.clear();
+    double frameTime;
+    while (file >> frameTime)
+    {
+        frameTimes.push_back(frameTime);
+    }
+    return file.eof() && !frameTimes.empty();
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "FramePacer.h"
+
+// Turns measured frame times into whole fixed simulation steps. The time left
+// over in the accumulator becomes the interpolation factor between the last two
+// simulated states. Long frames (window drag, resize) are clamped instead of
+// being simulated in a burst. Frame times can be recorded and replayed, so a
+// benchmark steps through exactly the same timeline on every run.
+// Portable (std only), time comes from a FramePacer::TimeSource.
+class SimulationClock
+{
+public:
+	struct Options
+	{
+		// Seconds of simulated time per step
+		double step = 1.0 / 120.0;
+		// Longer frames count as this long
+		double maxFrameTime = 0.25;
+		// Steps that don't fit are dropped rather than carried over
+		int maxStepsPerFrame = 8;
+	};
+
+	enum class Mode
+	{
+		Live,
+		Record,
+		Replay
+	};
+
+	struct Stats
+	{
+		uint64_t frames = 0;
+		uint64_t steps = 0;
+		// Seconds cut from long frames and dropped steps
+		double droppedTime = 0.0;
+		double frameMs = 0.0;
+	};
+
+	explicit SimulationClock(FramePacer::TimeSource* time = nullptr);
+	SimulationClock(const Options& options, FramePacer::TimeSource* time = nullptr);
+
+	// Once per frame, returns the number of fixed steps to simulate
+	int advance();
+
+	double step() const { return m_options.step; }
+	// Between the state before the last step (0) and after it (1)
+	double alpha() const { return m_accumulator / m_options.step; }
+	// Simulated seconds, whole steps only
+	double simulatedTime() const { return m_stepCount * m_options.step; }
+
+	void setStep(double seconds);
+	// A replay runs at scale 1 unpaused; set during one, these take effect when it ends
+	void setTimeScale(double scale);
+	double timeScale() const { return m_timeScale; }
+	void setPaused(bool paused);
+	bool paused() const { return m_paused; }
+
+	Mode mode() const { return m_mode; }
+	// Keeps the raw frame times from the next advance() on
+	void startRecording();
+	void stopRecording();
+	const std::vector<double>& recording() const { return m_recording; }
+	// Takes frame times from frameTimes instead of the clock, back to Live after the last one.
+	// The accumulator starts empty and the time scale and pause are put aside until the
+	// replay ends, so equal inputs give equal steps and alphas
+	void startReplay(const std::vector<double>& frameTimes);
+	size_t replayRemaining() const { return m_replay.size() - m_replayCursor; }
+
+	// One frame time per line, in seconds
+	bool saveRecording(const std::string& filename) const;
+	static bool loadRecording(const std::string& filename, std::vector<double>& frameTimes);
+
+	const Stats& stats() const { return m_stats; }
+
+private:
+	double nextFrameTime();
+
+private:
+	Options m_options;
+	FramePacer::TimeSource* m_pTime;
+
+	bool m_started;
+	double m_lastTime;
+	double m_accumulator;
+	uint64_t m_stepCount;
+	double m_timeScale;
+	bool m_paused;
+	// Live settings while a replay runs
+	double m_liveTimeScale;
+	bool m_livePaused;
+
+	Mode m_mode;
+	std::vector<double> m_recording;
+	std::vector<double> m_replay;
+	size_t m_replayCursor;
+
+	Stats m_stats;
+};
@@ -1,48 +1,56 @@
 #include "Skybox.h"
 
+#include <filesystem>
+
+#include "EnvironmentBaker.h"
+
 struct GeomBuffer
 {
     DirectX::XMMATRIX M;
     DirectX::XMFLOAT3 Size;
 };
 
-Skybox::Skybox(ID3D11Device* device)
+static const wchar_t* VertexShaderFile = L"resources/shaders/skybox_vs.hlsl";
+static const wchar_t* PixelShaderFile = L"resources/shaders/skybox_ps.hlsl";
+static const wchar_t* CubemapFile = L"resources/textures/cubemap.dds";
+static const wchar_t* PanoramaFile = L"resources/textures/skybox.hdr";
+
+Skybox::Skybox(ID3D11Device* device, D3DResources* resources, AsyncTextureLoader* textureLoader)
     : m_pDevice(device)
-    , m_pVertexBuffer(nullptr)
-    , m_pVertexShader(nullptr)
-    , m_pPixelShader(nullptr)
-    , m_pInputLayout(nullptr)
-    , m_pCubemapView(nullptr)
-    , m_pGeomBuffer(nullptr)
+    , m_pResources(resources)
+    , m_pTextureLoader(textureLoader)
 {
 	initBuffers();
-	initInputLayout();
+	createShaders(m_vertexShader, m_pixelShader, m_inputLayout);
     initTexture();
 }
 
-Skybox::~Skybox()
+void Skybox::queueShaders(ShaderBuildQueue& queue)
 {
-	terminate();
+    queueShader(queue, VertexShaderFile, {}, shader_stage::Vertex);
+    queueShader(queue, PixelShaderFile, {}, shader_stage::Pixel);
 }
 
 void Skybox::render(ID3D11DeviceContext* context, UINT width, UINT height, ID3D11Buffer* sceneBuffer, ID3D11SamplerState* samplerState)
 {
-    if (m_pCubemapView) 
+    ID3D11ShaderResourceView* pCubemapView = m_cubemapView.get<ID3D11ShaderResourceView>();
+    if (pCubemapView) 
     {
         UINT stride = { 12 };
         UINT offset = { 0 };
 
-        context->VSSetShader(m_pVertexShader, nullptr, 0);
-        context->PSSetShader(m_pPixelShader, nullptr, 0);
-        context->PSSetShaderResources(0, 1, &m_pCubemapView);
+        context->VSSetShader(m_vertexShader.get<ID3D11VertexShader>(), nullptr, 0);
+        context->PSSetShader(m_pixelShader.get<ID3D11PixelShader>(), nullptr, 0);
+        context->PSSetShaderResources(0, 1, &pCubemapView);
         context->PSSetSamplers(0, 1, &samplerState);
-        context->IASetInputLayout(m_pInputLayout);
+        context->IASetInputLayout(m_inputLayout.get<ID3D11InputLayout>());
 
-        context->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+        ID3D11Buffer* vertexBuffers[] = { m_vertexBuffer.get<ID3D11Buffer>() };
+        context->IASetVertexBuffers(0, 1, vertexBuffers, &stride, &offset);
         context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        context->VSSetConstantBuffers(0, 1, &sceneBuffer);
-        context->VSSetConstantBuffers(1, 1, &m_pGeomBuffer);
+        ID3D11Buffer* constantBuffers[] = { sceneBuffer, m_geomBuffer.get<ID3D11Buffer>() };
+        context->VSSetConstantBuffers(0, 2, constantBuffers);
 
         context->Draw(36, 0);
     }
@@ -106,13 +114,15 @@ bool Skybox::initBuffers()
     D3D11_SUBRESOURCE_DATA vertexData = {};
     vertexData.pSysMem = &skyboxVertices;
     vertexData.SysMemPitch = sizeof(skyboxVertices);
-    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &m_pVertexBuffer);
+    ID3D11Buffer* pVertexBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &pVertexBuffer);
+    m_vertexBuffer = m_pResources->buffer(pVertexBuffer);
     if (!SUCCEEDED(result))
     {
         return false;
     }
 
-    result = SetResourceName(m_pVertexBuffer, "skybox vertex buffer");
+    result = SetResourceName(pVertexBuffer, "skybox vertex buffer");
 
     D3D11_BUFFER_DESC desc = {};
     desc.ByteWidth = sizeof(GeomBuffer);
@@ -133,17 +143,19 @@ bool Skybox::initBuffers()
     data.SysMemPitch = sizeof(geomBuffer);
     data.SysMemSlicePitch = 0;
 
-    result = m_pDevice->CreateBuffer(&desc, &data, &m_pGeomBuffer);
+    ID3D11Buffer* pGeomBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&desc, &data, &pGeomBuffer);
+    m_geomBuffer = m_pResources->buffer(pGeomBuffer);
     assert(SUCCEEDED(result));
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pGeomBuffer, "skybox geom buffer");
+        result = SetResourceName(pGeomBuffer, "skybox geom buffer");
     }
 
     return true;
 }
 
-bool Skybox::initInputLayout()
+bool Skybox::createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader, ResourcePool::Unique& inputLayout)
 {
     D3D11_INPUT_ELEMENT_DESC inputDesc[] =
     {
@@ -155,87 +167,122 @@ bool Skybox::initInputLayout()
     ID3DBlob* pVertexShaderCode = nullptr;
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/skybox_vs.hlsl", {}, shader_stage::Vertex, (ID3D11DeviceChild**)&m_pVertexShader, &pVertexShaderCode);
+        ID3D11VertexShader* pVertexShader = nullptr;
+        result = compileShader(m_pDevice, VertexShaderFile, {}, shader_stage::Vertex, (ID3D11DeviceChild**)&pVertexShader, &pVertexShaderCode);
+        vertexShader = m_pResources->add(D3DResources::Shader, pVertexShader);
     }
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/skybox_ps.hlsl", {}, shader_stage::Pixel, (ID3D11DeviceChild**)&m_pPixelShader);
+        ID3D11PixelShader* pPixelShader = nullptr;
+        result = compileShader(m_pDevice, PixelShaderFile, {}, shader_stage::Pixel, (ID3D11DeviceChild**)&pPixelShader);
+        pixelShader = m_pResources->add(D3DResources::Shader, pPixelShader);
     }
 
-    if (!SUCCEEDED(result))
+    if (SUCCEEDED(result))
     {
-        return false;
+        ID3D11InputLayout* pInputLayout = nullptr;
+        result = m_pDevice->CreateInputLayout(inputDesc, 1, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &pInputLayout);
+        inputLayout = m_pResources->add(D3DResources::InputLayout, pInputLayout);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(pInputLayout, "skybox input layout");
+        }
     }
 
-    result = m_pDevice->CreateInputLayout(inputDesc, 1, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pInputLayout);
-    if (!SUCCEEDED(result))
+    if (pVertexShaderCode != nullptr)
     {
-        return false;
+        pVertexShaderCode->Release();
+        pVertexShaderCode = nullptr;
     }
 
-    result = SetResourceName(m_pInputLayout, "skybox input layout");
+    return SUCCEEDED(result) && vertexShader && pixelShader && inputLayout;
+}
 
-    if (pVertexShaderCode != nullptr)
+bool Skybox::reloadShaders()
+{
+    ResourcePool::Unique vertexShader;
+    ResourcePool::Unique pixelShader;
+    ResourcePool::Unique inputLayout;
+    if (!createShaders(vertexShader, pixelShader, inputLayout))
     {
-        pVertexShaderCode->Release();
-        pVertexShaderCode = nullptr;
+        // The old set stays
+        return false;
     }
 
+    m_vertexShader = std::move(vertexShader);
+    m_pixelShader = std::move(pixelShader);
+    m_inputLayout = std::move(inputLayout);
     return true;
 }
 
 bool Skybox::initTexture()
 {
-    HRESULT hr = DirectX::CreateDDSTextureFromFile(
-        m_pDevice,
-        L"resources/textures/cubemap.dds",
-        nullptr,
-        &m_pCubemapView
-    );
+    ID3D11ShaderResourceView* pCubemapView = nullptr;
+    HRESULT hr = createPlaceholderTexture(m_pDevice, 0xFF404040, 6, true, &pCubemapView);
+    m_cubemapView = m_pResources->add(D3DResources::View, pCubemapView);
 
     if (FAILED(hr)) 
     {
         return false;
     }
 
+    loadCubemap();
+
     return true;
 }
 
-void Skybox::terminate()
+void Skybox::loadCubemap()
 {
-    if (m_pGeomBuffer != nullptr)
-    {
-        m_pGeomBuffer->Release();
-        m_pGeomBuffer = nullptr;
-    }
-
-    if (m_pCubemapView != nullptr)
-    {
-        m_pCubemapView->Release();
-        m_pCubemapView = nullptr;
-    }
-
-    if (m_pInputLayout != nullptr)
+    auto onLoaded = [this](TextureLoadResult& texture)
     {
-        m_pInputLayout->Release();
-        m_pInputLayout = nullptr;
-    }
+        if (FAILED(texture.result) || !texture.metadata.IsCubemap())
+        {
+            return;
+        }
+
+        ID3D11ShaderResourceView* pSRV = nullptr;
+        HRESULT hr = DirectX::CreateShaderResourceView(m_pDevice, texture.image.GetImages(), texture.image.GetImageCount(), texture.metadata, &pSRV);
+        if (SUCCEEDED(hr))
+        {
+            // The placeholder is released once the GPU is done with it
+            m_cubemapView = m_pResources->add(D3DResources::View, pSRV);
+            hr = SetResourceName(pSRV, "skybox cubemap");
+        }
+    };
 
-    if (m_pPixelShader != nullptr)
+    // A panorama, if there is one, is baked into the cubemap on the loader's workers
+    // instead of using the precomputed one
+    const std::wstring panorama = PanoramaFile;
+    std::error_code error;
+    if (std::filesystem::exists(panorama, error))
     {
-        m_pPixelShader->Release();
-        m_pPixelShader = nullptr;
+        ThreadPool* pool = m_pTextureLoader->pool();
+        m_pTextureLoader->produce(panorama, [pool](TextureLoadResult& texture)
+        {
+            EnvironmentBaker::Options options;
+            options.faceSize = 512;
+            options.pool = pool;
+
+            HRESULT hr = EnvironmentBaker::bakeFile(texture.filename, options, texture.image);
+            if (SUCCEEDED(hr))
+            {
+                texture.metadata = texture.image.GetMetadata();
+            }
+            return hr;
+        }, onLoaded);
     }
-
-    if (m_pVertexShader != nullptr)
+    else
     {
-        m_pVertexShader->Release();
-        m_pVertexShader = nullptr;
+        m_pTextureLoader->load(CubemapFile, DirectX::DDS_FLAGS_NONE, onLoaded);
     }
+}
 
-    if (m_pVertexBuffer != nullptr)
+void Skybox::watchTextures(HotReload& hotReload)
+{
+    // Both, so dropping a panorama in while running switches to it
+    for (const wchar_t* filename : { PanoramaFile, CubemapFile })
     {
-        m_pVertexBuffer->Release();
-        m_pVertexBuffer = nullptr;
+        std::wstring name(filename);
+        hotReload.addTexture(std::string(name.begin(), name.end()), [this]() { loadCubemap(); });
     }
 }
@@ -1,34 +1,43 @@
 #pragma once
 
 #include "framework.h"
+#include "AsyncTextureLoader.h"
+#include "D3DResources.h"
+#include "HotReload.h"
 
 class Skybox
 {
 public:
-	Skybox(ID3D11Device* device);
-	~Skybox();
+	Skybox(ID3D11Device* device, D3DResources* resources, AsyncTextureLoader* textureLoader);
+
+	static void queueShaders(ShaderBuildQueue& queue);
+
+	// Recreates the shader objects from the shader cache, false - the old ones are kept
+	bool reloadShaders();
+	void watchTextures(HotReload& hotReload);
 
 	void render(ID3D11DeviceContext* context, UINT width, UINT height, ID3D11Buffer* sceneBuffer, ID3D11SamplerState* samplerState);
 
 private:
 	bool initBuffers();
-	bool initInputLayout();
+	bool createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader, ResourcePool::Unique& inputLayout);
 	bool initTexture();
-
-	void terminate();
+	void loadCubemap();
 
 private:
 	ID3D11Device* m_pDevice;
+	D3DResources* m_pResources;
+	AsyncTextureLoader* m_pTextureLoader;
 
-	ID3D11Buffer* m_pVertexBuffer;
+	ResourcePool::Unique m_vertexBuffer;
 
-	ID3D11PixelShader* m_pPixelShader;
-	ID3D11VertexShader* m_pVertexShader;
-	ID3D11InputLayout* m_pInputLayout;
+	ResourcePool::Unique m_pixelShader;
+	ResourcePool::Unique m_vertexShader;
+	ResourcePool::Unique m_inputLayout;
 
-	ID3D11ShaderResourceView* m_pCubemapView;
+	ResourcePool::Unique m_cubemapView;
 
-	ID3D11Buffer* m_pGeomBuffer;
+	ResourcePool::Unique m_geomBuffer;
 
 	//ID3D11Texture2D* m_pTexture;
 };
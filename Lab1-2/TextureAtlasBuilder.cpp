@@ -0,0 +1,336 @@
+#include "TextureAtlasBuilder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+// imgui_draw.cpp keeps its copy static as well, so both can live in one binary
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imstb_rectpack.h"
+
+static double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Entries must stay whole blocks on the last mip
+static size_t placementGrid(const TextureAtlasBuilder::Options& options, DXGI_FORMAT format)
+{
+    return (size_t)(DirectX::IsCompressed(format) ? 4 : 1) << (options.mipLevels - 1);
+}
+
+size_t TextureAtlasBuilder::paddedSize(const Options& options, DXGI_FORMAT format, size_t size)
+{
+    return alignUp(size + 2 * options.gutter, placementGrid(options, format));
+}
+
+HRESULT TextureAtlasBuilder::build(const Options& options, DirectX::ScratchImage& pages, std::vector<Entry>& entries, Stats* pStats) const
+{
+    if (m_sources.empty() || options.mipLevels == 0 || options.pageWidth == 0 || options.pageHeight == 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    DXGI_FORMAT format = options.format != DXGI_FORMAT_UNKNOWN ? options.format : m_sources[0].image->GetMetadata().format;
+
+    size_t grid = placementGrid(options, format);
+    if (options.pageWidth % grid != 0 || options.pageHeight % grid != 0)
+    {
+        return E_INVALIDARG;
+    }
+
+    // Padding and mips are done in 8 bits per channel, which covers the small LDR images an atlas is for
+    DXGI_FORMAT workFormat = DirectX::IsSRGB(format) ? DXGI_FORMAT_R8G8B8A8_UNORM_SRGB : DXGI_FORMAT_R8G8B8A8_UNORM;
+
+    Stats stats;
+    std::vector<Entry> placed(m_sources.size());
+    for (size_t i = 0; i < m_sources.size(); i++)
+    {
+        const DirectX::TexMetadata& info = m_sources[i].image->GetMetadata();
+        if (info.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || info.depth != 1 || DirectX::IsPlanar(info.format))
+        {
+            return E_INVALIDARG;
+        }
+
+        placed[i].name = m_sources[i].name;
+        placed[i].width = info.width;
+        placed[i].height = info.height;
+        stats.imageTexels += info.width * info.height;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t pageCount = 0;
+    HRESULT hr = pack(options, grid, placed, pageCount);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    stats.packMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<DirectX::ScratchImage> tiles(m_sources.size());
+    std::vector<HRESULT> results(m_sources.size(), S_OK);
+    auto tileRange = [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            results[i] = makeTile(*m_sources[i].image, placed[i], grid, workFormat, options, tiles[i]);
+        }
+    };
+    if (options.pool != nullptr)
+    {
+        options.pool->parallelFor(m_sources.size(), 1, tileRange);
+    }
+    else
+    {
+        tileRange(0, m_sources.size());
+    }
+    for (HRESULT tileResult : results)
+    {
+        if (FAILED(tileResult))
+        {
+            return tileResult;
+        }
+    }
+
+    DirectX::ScratchImage work;
+    hr = work.Initialize2D(workFormat, options.pageWidth, options.pageHeight, pageCount, options.mipLevels);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    memset(work.GetPixels(), 0, work.GetPixelsSize());
+
+    // Tile and page mips are both exact halvings of grid-aligned sizes, so mip m of a tile lands at (x >> m, y >> m)
+    for (size_t i = 0; i < placed.size(); i++)
+    {
+        const Entry& entry = placed[i];
+        size_t tileX = entry.x - options.gutter;
+        size_t tileY = entry.y - options.gutter;
+        for (size_t mip = 0; mip < options.mipLevels; mip++)
+        {
+            const DirectX::Image* pSrc = tiles[i].GetImage(mip, 0, 0);
+            const DirectX::Image* pDst = work.GetImage(mip, entry.page, 0);
+            uint8_t* pDstRow = pDst->pixels + (tileY >> mip) * pDst->rowPitch + (tileX >> mip) * sizeof(uint32_t);
+            for (size_t row = 0; row < pSrc->height; row++)
+            {
+                memcpy(pDstRow + row * pDst->rowPitch, pSrc->pixels + row * pSrc->rowPitch, pSrc->width * sizeof(uint32_t));
+            }
+        }
+        tiles[i].Release();
+    }
+    stats.mipMs = elapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    if (format == workFormat)
+    {
+        pages = std::move(work);
+    }
+    else if (DirectX::IsCompressed(format))
+    {
+        hr = DirectX::Compress(work.GetImages(), work.GetImageCount(), work.GetMetadata(), format,
+            options.compress | DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, pages);
+    }
+    else
+    {
+        hr = DirectX::Convert(work.GetImages(), work.GetImageCount(), work.GetMetadata(), format,
+            options.filter, DirectX::TEX_THRESHOLD_DEFAULT, pages);
+    }
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    stats.encodeMs = elapsedMs(start);
+
+    for (Entry& entry : placed)
+    {
+        entry.uvTransform = {
+            (float)entry.width / (float)options.pageWidth,
+            (float)entry.height / (float)options.pageHeight,
+            (float)entry.x / (float)options.pageWidth,
+            (float)entry.y / (float)options.pageHeight };
+    }
+    entries = std::move(placed);
+
+    stats.pages = pageCount;
+    stats.pageTexels = pageCount * options.pageWidth * options.pageHeight;
+    if (pStats != nullptr)
+    {
+        *pStats = stats;
+    }
+
+    return S_OK;
+}
+
+HRESULT TextureAtlasBuilder::pack(const Options& options, size_t grid, std::vector<Entry>& entries, size_t& pageCount)
+{
+    // Packing works in grid cells, which keeps every placement aligned and the skyline short
+    int gridWidth = (int)(options.pageWidth / grid);
+    int gridHeight = (int)(options.pageHeight / grid);
+
+    std::vector<stbrp_rect> pending(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        stbrp_rect& rect = pending[i];
+        rect = {};
+        rect.id = (int)i;
+        rect.w = (stbrp_coord)(alignUp(entries[i].width + 2 * options.gutter, grid) / grid);
+        rect.h = (stbrp_coord)(alignUp(entries[i].height + 2 * options.gutter, grid) / grid);
+        if (rect.w > gridWidth || rect.h > gridHeight)
+        {
+            return E_INVALIDARG;
+        }
+    }
+
+    std::vector<stbrp_node> nodes(gridWidth);
+    std::vector<stbrp_rect> rest;
+    pageCount = 0;
+    while (!pending.empty())
+    {
+        stbrp_context context;
+        stbrp_init_target(&context, gridWidth, gridHeight, nodes.data(), gridWidth);
+        stbrp_setup_heuristic(&context, STBRP_HEURISTIC_Skyline_BF_sortHeight);
+        stbrp_pack_rects(&context, pending.data(), (int)pending.size());
+
+        // Every rectangle fits an empty page by itself, so each page takes at least one
+        rest.clear();
+        for (const stbrp_rect& rect : pending)
+        {
+            if (!rect.was_packed)
+            {
+                rest.push_back(rect);
+                continue;
+            }
+            Entry& entry = entries[rect.id];
+            entry.page = pageCount;
+            entry.x = (size_t)rect.x * grid + options.gutter;
+            entry.y = (size_t)rect.y * grid + options.gutter;
+        }
+        pending.swap(rest);
+        pageCount++;
+    }
+
+    return S_OK;
+}
+
+HRESULT TextureAtlasBuilder::makeTile(const DirectX::ScratchImage& source, const Entry& entry, size_t grid, DXGI_FORMAT workFormat, const Options& options, DirectX::ScratchImage& tile)
+{
+    // Runs on worker threads, so WIC (which needs COM on every thread) is kept out of the way
+    DirectX::TEX_FILTER_FLAGS filter = options.filter | DirectX::TEX_FILTER_FORCE_NON_WIC;
+
+    const DirectX::Image* pImage = source.GetImage(0, 0, 0);
+    DirectX::ScratchImage decompressed;
+    DirectX::ScratchImage converted;
+    HRESULT hr = S_OK;
+    if (DirectX::IsCompressed(pImage->format))
+    {
+        hr = DirectX::Decompress(*pImage, DXGI_FORMAT_UNKNOWN, decompressed);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        pImage = decompressed.GetImage(0, 0, 0);
+    }
+    if (pImage->format != workFormat)
+    {
+        hr = DirectX::Convert(*pImage, workFormat, filter, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+        if (FAILED(hr))
+        {
+            return hr;
+        }
+        pImage = converted.GetImage(0, 0, 0);
+    }
+
+    // The gutter and the alignment slack on the right and bottom repeat the edge texels
+    size_t tileWidth = alignUp(entry.width + 2 * options.gutter, grid);
+    size_t tileHeight = alignUp(entry.height + 2 * options.gutter, grid);
+    DirectX::ScratchImage padded;
+    hr = padded.Initialize2D(workFormat, tileWidth, tileHeight, 1, 1);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+
+    const DirectX::Image* pPadded = padded.GetImage(0, 0, 0);
+    for (size_t y = 0; y < tileHeight; y++)
+    {
+        size_t srcY = (std::min)((size_t)(std::max)((ptrdiff_t)y - (ptrdiff_t)options.gutter, (ptrdiff_t)0), pImage->height - 1);
+        const uint32_t* pSrcRow = reinterpret_cast<const uint32_t*>(pImage->pixels + srcY * pImage->rowPitch);
+        uint32_t* pDstRow = reinterpret_cast<uint32_t*>(pPadded->pixels + y * pPadded->rowPitch);
+
+        for (size_t x = 0; x < options.gutter; x++)
+        {
+            pDstRow[x] = pSrcRow[0];
+        }
+        memcpy(pDstRow + options.gutter, pSrcRow, pImage->width * sizeof(uint32_t));
+        for (size_t x = options.gutter + pImage->width; x < tileWidth; x++)
+        {
+            pDstRow[x] = pSrcRow[pImage->width - 1];
+        }
+    }
+
+    if (options.mipLevels == 1)
+    {
+        tile = std::move(padded);
+        return S_OK;
+    }
+
+    return DirectX::GenerateMipMaps(*pPadded, filter, options.mipLevels, tile);
+}
+
+HRESULT TextureAtlasBuilder::saveTable(const std::wstring& filename, const std::vector<Entry>& entries)
+{
+    std::ofstream file(std::filesystem::path(filename), std::ios::out | std::ios::trunc);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    // One entry per line: name page x y width height uvScaleX uvScaleY uvOffsetX uvOffsetY
+    file.precision(std::numeric_limits<float>::max_digits10);
+    for (const Entry& entry : entries)
+    {
+        if (entry.name.empty() || entry.name.find_first_of(" \t\r\n") != std::string::npos)
+        {
+            return E_INVALIDARG;
+        }
+        file << entry.name << ' ' << entry.page << ' ' << entry.x << ' ' << entry.y << ' ' << entry.width << ' ' << entry.height << ' '
+            << entry.uvTransform.x << ' ' << entry.uvTransform.y << ' ' << entry.uvTransform.z << ' ' << entry.uvTransform.w << '\n';
+    }
+
+    return file ? S_OK : E_FAIL;
+}
+
+HRESULT TextureAtlasBuilder::loadTable(const std::wstring& filename, std::vector<Entry>& entries)
+{
+    std::ifstream file(std::filesystem::path(filename), std::ios::in);
+    if (!file)
+    {
+        return E_FAIL;
+    }
+
+    entries.clear();
+    Entry entry;
+    while (file >> entry.name >> entry.page >> entry.x >> entry.y >> entry.width >> entry.height
+        >> entry.uvTransform.x >> entry.uvTransform.y >> entry.uvTransform.z >> entry.uvTransform.w)
+    {
+        entries.push_back(entry);
+    }
+
+    return file.eof() ? S_OK : E_FAIL;
+}
+
+const TextureAtlasBuilder::Entry* TextureAtlasBuilder::findEntry(const std::vector<Entry>& entries, const std::string& name)
+{
+    auto it = std::find_if(entries.begin(), entries.end(), [&name](const Entry& entry) { return entry.name == name; });
+    return it != entries.end() ? &*it : nullptr;
+}
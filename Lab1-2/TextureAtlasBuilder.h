@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <DirectXMath.h>
+
+#include "DirectXTex.h"
+
+#include "ThreadPool.h"
+
+// Packs many small 2D images of any size and format into pages of one Texture2DArray.
+// Rectangles are placed with imstb_rectpack on a grid of blockSize << (mipLevels - 1) texels,
+// so every mip of every entry starts on a block boundary and no BC block mixes two entries.
+// Each entry is surrounded by a clamp-to-edge gutter and gets its own mip chain,
+// so filtering and mip selection never pull in a neighbour.
+class TextureAtlasBuilder
+{
+public:
+	struct Options
+	{
+		// Page format. UNKNOWN - format of the first source
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		size_t pageWidth = 1024;
+		size_t pageHeight = 1024;
+		// Also sets the placement grid, see above. Page sizes must be multiples of that grid
+		size_t mipLevels = 4;
+		// Texels of padding around every entry on mip 0, halved on each following mip
+		size_t gutter = 4;
+
+		DirectX::TEX_FILTER_FLAGS filter = DirectX::TEX_FILTER_DEFAULT;
+		DirectX::TEX_COMPRESS_FLAGS compress = DirectX::TEX_COMPRESS_DEFAULT;
+
+		// Sources are padded and mipmapped on these workers (nullptr - on the calling thread)
+		ThreadPool* pool = nullptr;
+	};
+
+	struct Entry
+	{
+		std::string name;
+		size_t page;
+		// Image rectangle on mip 0, gutter excluded
+		size_t x;
+		size_t y;
+		size_t width;
+		size_t height;
+		// xy - scale, zw - offset: atlas uv = uv * xy + zw, z of the array coordinate is the page
+		DirectX::XMFLOAT4 uvTransform;
+	};
+
+	struct Stats
+	{
+		size_t pages = 0;
+		// Source texels against the texels of all pages on mip 0
+		size_t imageTexels = 0;
+		size_t pageTexels = 0;
+		double packMs = 0.0;
+		double mipMs = 0.0;
+		double encodeMs = 0.0;
+
+		float efficiency() const { return pageTexels != 0 ? (float)imageTexels / (float)pageTexels : 0.0f; }
+	};
+
+	// The source must outlive build(). Only the first mip and array slice of it are used
+	void addSource(const DirectX::ScratchImage* image, const std::string& name) { m_sources.push_back({ image, name }); }
+	void clear() { m_sources.clear(); }
+	size_t sourceCount() const { return m_sources.size(); }
+
+	// Entries come out in the order the sources were added
+	HRESULT build(const Options& options, DirectX::ScratchImage& pages, std::vector<Entry>& entries, Stats* pStats = nullptr) const;
+
+	// Offline builds save the pages with DirectX::SaveToDDSFile and the entry table with this
+	static HRESULT saveTable(const std::wstring& filename, const std::vector<Entry>& entries);
+	static HRESULT loadTable(const std::wstring& filename, std::vector<Entry>& entries);
+
+	// Size an image of the given size takes on a page, gutter and grid alignment included
+	static size_t paddedSize(const Options& options, DXGI_FORMAT format, size_t size);
+
+	static const Entry* findEntry(const std::vector<Entry>& entries, const std::string& name);
+
+private:
+	struct Source
+	{
+		const DirectX::ScratchImage* image;
+		std::string name;
+	};
+
+	static HRESULT pack(const Options& options, size_t grid, std::vector<Entry>& entries, size_t& pageCount);
+	static HRESULT makeTile(const DirectX::ScratchImage& source, const Entry& entry, size_t grid, DXGI_FORMAT workFormat, const Options& options, DirectX::ScratchImage& tile);
+
+private:
+	std::vector<Source> m_sources;
+};
@@ -0,0 +1,236 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::TextureStreamer(size_t budgetBytes, uint32_t maxLoadsPerFrame)
+    : m_maxLoadsPerFrame(maxLoadsPerFrame)
+    , m_frame(0)
+{
+    m_stats.budgetBytes = budgetBytes;
+}
+
+TextureStreamer::TextureId TextureStreamer::registerTexture(const std::vector<size_t>& mipBytes, uint32_t tailMip)
+{
+    Texture texture;
+    texture.mipBytes = mipBytes;
+    texture.tailMip = (std::min)(tailMip, (uint32_t)mipBytes.size() - 1);
+    texture.residentMip = texture.tailMip;
+    texture.wantedMip = texture.tailMip;
+    texture.lastUsedFrame = m_frame;
+
+    m_stats.residentBytes += bytesFrom(texture, texture.tailMip);
+
+    m_textures.push_back(std::move(texture));
+    return (TextureId)(m_textures.size() - 1);
+}
+
+void TextureStreamer::replaceTexture(TextureId texture, const std::vector<size_t>& mipBytes, uint32_t tailMip)
+{
+    Texture& tex = m_textures[texture];
+    m_stats.residentBytes -= bytesFrom(tex, tex.residentMip);
+    if (tex.pendingMip != NoMip)
+    {
+        m_stats.inFlightBytes -= tex.mipBytes[tex.pendingMip];
+    }
+
+    tex.mipBytes = mipBytes;
+    tex.tailMip = (std::min)(tailMip, (uint32_t)mipBytes.size() - 1);
+    tex.residentMip = tex.tailMip;
+    tex.wantedMip = tex.tailMip;
+    tex.pendingMip = NoMip;
+    tex.requestedMip = NoMip;
+    tex.lastUsedFrame = m_frame;
+
+    m_stats.residentBytes += bytesFrom(tex, tex.tailMip);
+}
+
+void TextureStreamer::requestMip(TextureId texture, uint32_t mip)
+{
+    Texture& tex = m_textures[texture];
+    tex.requestedMip = (std::min)(tex.requestedMip, mip);
+}
+
+void TextureStreamer::update(std::vector<Command>& commands)
+{
+    ++m_frame;
+
+    std::vector<TextureId> candidates;
+    for (TextureId i = 0; i < (TextureId)m_textures.size(); i++)
+    {
+        Texture& tex = m_textures[i];
+        if (tex.requestedMip != NoMip)
+        {
+            tex.wantedMip = (std::min)(tex.requestedMip, tex.tailMip);
+            tex.lastUsedFrame = m_frame;
+        }
+        else
+        {
+            tex.wantedMip = tex.tailMip;
+        }
+        tex.requestedMip = NoMip;
+
+        if (tex.pendingMip == NoMip && tex.wantedMip < tex.residentMip)
+        {
+            candidates.push_back(i);
+        }
+    }
+
+    // Biggest shortfall first, one mip per texture per frame
+    std::sort(candidates.begin(), candidates.end(), [this](TextureId a, TextureId b)
+    {
+        const Texture& ta = m_textures[a];
+        const Texture& tb = m_textures[b];
+        uint32_t gapA = ta.residentMip - ta.wantedMip;
+        uint32_t gapB = tb.residentMip - tb.wantedMip;
+        if (gapA != gapB)
+        {
+            return gapA > gapB;
+        }
+        return ta.lastUsedFrame > tb.lastUsedFrame;
+    });
+
+    uint32_t issued = 0;
+    for (TextureId id : candidates)
+    {
+        if (issued >= m_maxLoadsPerFrame)
+        {
+            break;
+        }
+
+        Texture& tex = m_textures[id];
+        uint32_t mip = tex.residentMip - 1;
+        size_t cost = tex.mipBytes[mip];
+
+        while (m_stats.residentBytes + m_stats.inFlightBytes + cost > m_stats.budgetBytes)
+        {
+            if (!evictOne(id, commands))
+            {
+                break;
+            }
+        }
+        if (m_stats.residentBytes + m_stats.inFlightBytes + cost > m_stats.budgetBytes)
+        {
+            ++m_stats.deniedLoads;
+            continue;
+        }
+
+        tex.pendingMip = mip;
+        m_stats.inFlightBytes += cost;
+        commands.push_back({ CommandType::Load, id, mip });
+        ++m_stats.loadsIssued;
+        ++issued;
+    }
+
+    // The budget may have been lowered since the last frame
+    while (m_stats.residentBytes + m_stats.inFlightBytes > m_stats.budgetBytes)
+    {
+        if (!evictOne(NoMip, commands))
+        {
+            break;
+        }
+    }
+}
+
+void TextureStreamer::completeLoad(TextureId texture, uint32_t mip)
+{
+    Texture& tex = m_textures[texture];
+    if (tex.pendingMip != mip)
+    {
+        return;
+    }
+
+    size_t cost = tex.mipBytes[mip];
+    m_stats.inFlightBytes -= cost;
+    tex.pendingMip = NoMip;
+
+    if (mip < tex.residentMip)
+    {
+        m_stats.residentBytes += bytesFrom(tex, mip) - bytesFrom(tex, tex.residentMip);
+        tex.residentMip = mip;
+    }
+}
+
+uint32_t TextureStreamer::mipForFootprint(float texelsAcross, float pixelsAcross, uint32_t mipCount)
+{
+    if (mipCount == 0)
+    {
+        return 0;
+    }
+    if (pixelsAcross <= 0.0f)
+    {
+        return mipCount - 1;
+    }
+
+    float ratio = texelsAcross / pixelsAcross;
+    if (ratio <= 1.0f)
+    {
+        return 0;
+    }
+
+    uint32_t mip = (uint32_t)floorf(log2f(ratio));
+    return (std::min)(mip, mipCount - 1);
+}
+
+size_t TextureStreamer::bytesFrom(const Texture& texture, uint32_t mip) const
+{
+    size_t bytes = 0;
+    for (size_t i = mip; i < texture.mipBytes.size(); i++)
+    {
+        bytes += texture.mipBytes[i];
+    }
+    return bytes;
+}
+
+bool TextureStreamer::evictOne(TextureId keep, std::vector<Command>& commands)
+{
+    // Textures holding more than they were asked for go first, then the least recently used.
+    // Anything used this frame at its wanted level is left alone
+    TextureId victim = NoMip;
+    for (TextureId i = 0; i < (TextureId)m_textures.size(); i++)
+    {
+        const Texture& tex = m_textures[i];
+        if (i == keep || tex.pendingMip != NoMip || tex.residentMip >= tex.tailMip)
+        {
+            continue;
+        }
+
+        bool overResident = tex.residentMip < tex.wantedMip;
+        if (!overResident && tex.lastUsedFrame == m_frame)
+        {
+            continue;
+        }
+
+        if (victim == NoMip)
+        {
+            victim = i;
+            continue;
+        }
+
+        const Texture& best = m_textures[victim];
+        bool bestOverResident = best.residentMip < best.wantedMip;
+        if (overResident != bestOverResident)
+        {
+            if (overResident)
+            {
+                victim = i;
+            }
+        }
+        else if (tex.lastUsedFrame < best.lastUsedFrame)
+        {
+            victim = i;
+        }
+    }
+
+    if (victim == NoMip)
+    {
+        return false;
+    }
+
+    Texture& tex = m_textures[victim];
+    m_stats.residentBytes -= tex.mipBytes[tex.residentMip];
+    ++tex.residentMip;
+    ++m_stats.evictions;
+    commands.push_back({ CommandType::Evict, victim, tex.residentMip });
+    return true;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mip residency manager. Knows nothing about the graphics API: textures are
+// described by the byte size of every mip, culling reports the finest mip each
+// texture needs, and update() answers with load / evict commands that keep the
+// resident bytes under the budget. Mip tails are never evicted.
+class TextureStreamer
+{
+public:
+	using TextureId = uint32_t;
+	static const uint32_t NoMip = UINT32_MAX;
+
+	enum class CommandType
+	{
+		Load,  // make mips [mip, tail] resident
+		Evict, // drop everything finer than mip
+	};
+
+	struct Command
+	{
+		CommandType type;
+		TextureId texture;
+		uint32_t mip;
+	};
+
+	struct Stats
+	{
+		size_t budgetBytes = 0;
+		size_t residentBytes = 0;
+		size_t inFlightBytes = 0;
+		uint64_t loadsIssued = 0;
+		uint64_t evictions = 0;
+		uint64_t deniedLoads = 0;
+	};
+
+	TextureStreamer(size_t budgetBytes, uint32_t maxLoadsPerFrame = 2);
+
+	// mipBytes[i] - size of mip i summed over all array slices. Mips at or coarser than
+	// tailMip are resident from the start and count against the budget forever
+	TextureId registerTexture(const std::vector<size_t>& mipBytes, uint32_t tailMip);
+
+	// The texture was reloaded, possibly with other sizes: back to just its tail, nothing pending
+	void replaceTexture(TextureId texture, const std::vector<size_t>& mipBytes, uint32_t tailMip);
+
+	void setBudget(size_t budgetBytes) { m_stats.budgetBytes = budgetBytes; }
+
+	// Called during culling for every visible instance using the texture; the finest request of the frame wins
+	void requestMip(TextureId texture, uint32_t mip);
+
+	// Once per frame: turns this frame's requests into commands. Requests are reset afterwards
+	void update(std::vector<Command>& commands);
+
+	// The owner finished a Load command
+	void completeLoad(TextureId texture, uint32_t mip);
+
+	uint32_t residentMip(TextureId texture) const { return m_textures[texture].residentMip; }
+	uint32_t tailMip(TextureId texture) const { return m_textures[texture].tailMip; }
+	const Stats& stats() const { return m_stats; }
+
+	// Finest mip worth having when texelsAcross texels of the top level cover pixelsAcross screen pixels
+	static uint32_t mipForFootprint(float texelsAcross, float pixelsAcross, uint32_t mipCount);
+
+private:
+	struct Texture
+	{
+		std::vector<size_t> mipBytes;
+		uint32_t tailMip = 0;
+		uint32_t residentMip = 0;
+		uint32_t pendingMip = NoMip;
+		uint32_t requestedMip = NoMip;
+		uint32_t wantedMip = 0;
+		uint64_t lastUsedFrame = 0;
+	};
+
+	size_t bytesFrom(const Texture& texture, uint32_t mip) const;
+	bool evictOne(TextureId keep, std::vector<Command>& commands);
+
+private:
+	std::vector<Texture> m_textures;
+	uint32_t m_maxLoadsPerFrame;
+	uint64_t m_frame;
+	Stats m_stats;
+};
@@ -1,6 +1,9 @@
 #include "TexturedCube.h"
 #include "DirectXTex.h"
 
+// Mips no larger than this stay resident all the time
+static const size_t StreamTailSize = 64;
+
 struct CubeVertex
 {
     DirectX::XMFLOAT3 pos;
@@ -24,56 +27,86 @@ struct LightParams
     DirectX::XMFLOAT4 Params;
 };
 
-TexturedCube::TexturedCube(ID3D11Device* device)
+static const wchar_t* VertexShaderFile = L"resources/shaders/lighted_cube_vs.hlsl";
+static const wchar_t* PixelShaderFile = L"resources/shaders/lighted_cube_ps.hlsl";
+static const wchar_t* CullShaderFile = L"resources/shaders/frustum_cull_cs.hlsl";
+
+static const wchar_t* AtlasFiles[2] = { L"resources/textures/logo.dds", L"resources/textures/tiles.dds" };
+static const wchar_t* NormalMapFile = L"resources/textures/tiles_normal.dds";
+
+TexturedCube::TexturedCube(ID3D11Device* device, D3DResources* resources, AsyncTextureLoader* textureLoader, TextureStreamer* textureStreamer)
 	: m_pDevice(device)
-	, m_pInputLayout(nullptr)
-	, m_pPixelShader(nullptr)
-	, m_pVertexBuffer(nullptr)
-	, m_pVertexShader(nullptr)
-    , m_pLightingParamBuffer(nullptr)
+    , m_pResources(resources)
+    , m_pTextureLoader(textureLoader)
+    , m_pTextureStreamer(textureStreamer)
+    , m_pixelPermutations(pixelPermutations())
+    , m_slicesLoaded(0)
+    , m_atlasGeneration(0)
+    , m_arrayStreamId(TextureStreamer::NoMip)
+    , m_normalStreamId(TextureStreamer::NoMip)
     , instanceCount(0)
 {
     instanceCount = MAX_INST;
 	initBuffers();
-	initInputLayout();
+	createShaders(m_vertexShader, m_pixelShaders, m_computeShader, m_inputLayout);
 	initTexture();
     initInstances();
     initQuery();
 }
 
-TexturedCube::~TexturedCube()
+ShaderPermutations TexturedCube::pixelPermutations()
 {
-	terminate();
+    // Order matters, render() passes the values in the same order
+    ShaderPermutations permutations;
+    permutations.addAxis("NORMAL_MAP");
+    permutations.addAxis("SHOW_NORMALS");
+    return permutations;
 }
 
-void TexturedCube::render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer, ID3D11SamplerState* samplerState)
+void TexturedCube::queueShaders(ShaderBuildQueue& queue)
 {
-    if (m_pSRV)
+    queueShader(queue, VertexShaderFile, {}, shader_stage::Vertex);
+    ShaderPermutations permutations = pixelPermutations();
+    for (ShaderPermutations::Key key = 0; key < (ShaderPermutations::Key)permutations.variantCount(); key++)
+    {
+        queueShader(queue, PixelShaderFile, permutations.defines(key), shader_stage::Pixel);
+    }
+    queueShader(queue, CullShaderFile, {}, shader_stage::Compute);
+}
+
+void TexturedCube::render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer, ID3D11SamplerState* samplerState, const DirectX::XMINT4& sceneParams)
+{
+    ShaderPermutations::Key variant = m_pixelPermutations.select(
+        m_pixelPermutations.key(std::vector<uint32_t>{ sceneParams.y > 0 ? 1u : 0u, sceneParams.z > 0 ? 1u : 0u }));
+
+    ID3D11ShaderResourceView* textures[] = { m_atlasSRV.get<ID3D11ShaderResourceView>(), m_normalSRV.get<ID3D11ShaderResourceView>() };
+    if (textures[0])
     {
         UINT stride = { 44 };
         UINT offset = { 0 };
 
-        context->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-        context->VSSetShader(m_pVertexShader, nullptr, 0);
-        context->PSSetShader(m_pPixelShader, nullptr, 0);
-        context->PSSetShaderResources(0, 1, &m_pSRV);
-        context->PSSetShaderResources(1, 1, &m_pNormalSRV);
+        context->IASetIndexBuffer(m_indexBuffer.get<ID3D11Buffer>(), DXGI_FORMAT_R16_UINT, 0);
+        context->VSSetShader(m_vertexShader.get<ID3D11VertexShader>(), nullptr, 0);
+        context->PSSetShader(m_pixelShaders[variant].get<ID3D11PixelShader>(), nullptr, 0);
+        context->PSSetShaderResources(0, 2, textures);
         context->PSSetSamplers(0, 1, &samplerState);
-        context->IASetInputLayout(m_pInputLayout);
+        context->IASetInputLayout(m_inputLayout.get<ID3D11InputLayout>());
 
-        context->IASetVertexBuffers(0, 1, &m_pVertexBuffer, &stride, &offset);
+        ID3D11Buffer* vertexBuffers[] = { m_vertexBuffer.get<ID3D11Buffer>() };
+        context->IASetVertexBuffers(0, 1, vertexBuffers, &stride, &offset);
         context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        context->VSSetConstantBuffers(0, 1, &sceneBuffer);
-        context->VSSetConstantBuffers(1, 1, &m_pGeomBufferInst);
-        context->PSSetConstantBuffers(0, 1, &sceneBuffer);
-        context->PSSetConstantBuffers(1, 1, &m_pGeomBufferInst);
+        ID3D11Buffer* constantBuffers[] = { sceneBuffer, m_geomBufferInst.get<ID3D11Buffer>() };
+        context->VSSetConstantBuffers(0, 2, constantBuffers);
+        context->PSSetConstantBuffers(0, 2, constantBuffers);
         if (isCompute)
         {
-            context->CopyResource(m_pIndirectArgs, m_pIndirectArgsSrc);
-            context->Begin(m_queries[m_curFrame % 10]);
-            context->DrawIndexedInstancedIndirect(m_pIndirectArgs, 0);
-            context->End(m_queries[m_curFrame % 10]);
+            ID3D11Buffer* pIndirectArgs = m_indirectArgs.get<ID3D11Buffer>();
+            ID3D11Query* pQuery = m_queries[m_curFrame % 10].get<ID3D11Query>();
+            context->CopyResource(pIndirectArgs, m_indirectArgsSrc.get<ID3D11Buffer>());
+            context->Begin(pQuery);
+            context->DrawIndexedInstancedIndirect(pIndirectArgs, 0);
+            context->End(pQuery);
             ++m_curFrame;
         }
         else
@@ -83,52 +116,66 @@ void TexturedCube::render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffe
     }
 }
 
-void TexturedCube::update(ID3D11DeviceContext* context, float angle, bool& isCompute)
+void TexturedCube::animate(float angle, std::vector<InstanceState>& instances) const
 {
-    this->isCompute = isCompute;
-    
-        instanceCount = 0;
-        std::vector<GeomBufferInst> visibleInstances;
-        //visibleInstances.resize(20);
-        for (int i = 0; i < MAX_INST; i++)
+    instances.resize(MAX_INST);
+    for (int i = 0; i < MAX_INST; i++)
+    {
+        const DirectX::XMFLOAT3& offset = m_instanceOffsets[i];
+        // if tiles texture - rotate cube
+        if (m_instanceTexture[i] == 1)
         {
-            float offsetX = geomBuffers[i].M.r[3].m128_f32[0];
-            float offsetY = geomBuffers[i].M.r[3].m128_f32[1];
-            float offsetZ = geomBuffers[i].M.r[3].m128_f32[2];
-            // if tiles texture - rotate cube
-            if (geomBuffers[i].params.z)
-            {
-                geomBuffers[i].M = DirectX::XMMatrixMultiply(DirectX::XMMatrixRotationY(angle), DirectX::XMMatrixTranslation(offsetX, offsetY, offsetZ));
-                geomBuffers[i].NormalM = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, geomBuffers[i].M));
-            }
-            
-            if (!isCompute)
-            {
-                instanceCount += geomBuffers[i].params.w;
-                if ((int)geomBuffers[i].params.w)
-                {
-                    visibleInstances.push_back(geomBuffers[i]);
-                }
-            }
+            instances[i].M = DirectX::XMMatrixMultiply(DirectX::XMMatrixRotationY(angle), DirectX::XMMatrixTranslation(offset.x, offset.y, offset.z));
+            instances[i].NormalM = DirectX::XMMatrixTranspose(DirectX::XMMatrixInverse(nullptr, instances[i].M));
         }
-        if (!isCompute)
+        else
         {
-            visibleInstances.resize(20);
-            context->UpdateSubresource(m_pGeomBufferInst, 0, nullptr, visibleInstances.data(), 0, 0);
+            instances[i].M = DirectX::XMMatrixTranslation(offset.x, offset.y, offset.z);
+            instances[i].NormalM = DirectX::XMMatrixIdentity();
         }
-        context->UpdateSubresource(m_pGeomBufferInstCompute, 0, nullptr, geomBuffers.data(), 0, 0);
+    }
+}
+
+void TexturedCube::update(ID3D11DeviceContext* context, const std::vector<InstanceState>& instances, bool isCompute, FrameArena& arena)
+{
+    this->isCompute = isCompute;
 
+    // Transforms and visibility come from the simulation, atlas placement stays in geomBuffers
+    instanceCount = 0;
+    ArenaVector<GeomBufferInst> visibleInstances(arena);
+    visibleInstances.reserve(MAX_INST);
+    for (int i = 0; i < MAX_INST; i++)
     {
-        readQueries(context);
-        ImGui::Begin("Culling stats");
-        ImGui::Checkbox("GPU culling", &isCompute);
-        ImGui::Text("Instances: %d", MAX_INST);
-        if (isCompute)
-            ImGui::Text("Visible instances GPU %d", instanceCountGPU);
-        else
-            ImGui::Text("Visible instances %d", instanceCount);
-        ImGui::End();
+        geomBuffers[i].M = instances[i].M;
+        geomBuffers[i].NormalM = instances[i].NormalM;
+        geomBuffers[i].params.w = instances[i].visible ? 1.0f : 0.0f;
+
+        if (!isCompute && instances[i].visible)
+        {
+            instanceCount++;
+            visibleInstances.push_back(geomBuffers[i]);
+        }
+    }
+    if (!isCompute)
+    {
+        visibleInstances.resize(MAX_INST);
+        context->UpdateSubresource(m_geomBufferInst.get<ID3D11Buffer>(), 0, nullptr, visibleInstances.data(), 0, 0);
     }
+    context->UpdateSubresource(m_geomBufferInstCompute.get<ID3D11Buffer>(), 0, nullptr, geomBuffers.data(), 0, 0);
+
+    readQueries(context);
+}
+
+void TexturedCube::showStats(bool& isCompute)
+{
+    ImGui::Begin("Culling stats");
+    ImGui::Checkbox("GPU culling", &isCompute);
+    ImGui::Text("Instances: %d", MAX_INST);
+    if (this->isCompute)
+        ImGui::Text("Visible instances GPU %d", instanceCountGPU);
+    else
+        ImGui::Text("Visible instances %d", instanceCount);
+    ImGui::End();
 }
 
 void TexturedCube::cullInCompute(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer)
@@ -140,21 +187,21 @@ void TexturedCube::cullInCompute(ID3D11DeviceContext* context, ID3D11Buffer* sce
     args.BaseVertexLocation = 0;
     args.StartInstanceLocation = 0;
 
-    context->UpdateSubresource(m_pIndirectArgsSrc, 0, nullptr, &args, 0, 0);
+    context->UpdateSubresource(m_indirectArgsSrc.get<ID3D11Buffer>(), 0, nullptr, &args, 0, 0);
 
     UINT groupNumber = 1;
 
-    ID3D11Buffer* constBuffers[3] = { sceneBuffer, m_pCullParams, m_pGeomBufferInstCompute };
+    ID3D11Buffer* constBuffers[3] = { sceneBuffer, m_cullParams.get<ID3D11Buffer>(), m_geomBufferInstCompute.get<ID3D11Buffer>() };
     context->CSSetConstantBuffers(0, 3, constBuffers);
 
-    ID3D11UnorderedAccessView* uavBuffers[2] = { m_pIndirectArgsUAV, m_pGeomBufferInstGPU_UAV };
+    ID3D11UnorderedAccessView* uavBuffers[2] = { m_indirectArgsUAV.get<ID3D11UnorderedAccessView>(), m_geomBufferInstGPU_UAV.get<ID3D11UnorderedAccessView>() };
     context->CSSetUnorderedAccessViews(0, 2, uavBuffers, nullptr);
 
-    context->CSSetShader(m_pComputeShader, nullptr, 0);
+    context->CSSetShader(m_computeShader.get<ID3D11ComputeShader>(), nullptr, 0);
 
     context->Dispatch(groupNumber, 1, 1);
 
-    context->CopyResource(m_pGeomBufferInst, m_pGeomBufferInstGPU);
+    context->CopyResource(m_geomBufferInst.get<ID3D11Buffer>(), m_geomBufferInstGPU.get<ID3D11Buffer>());
 }
 
 bool TexturedCube::initBuffers()
@@ -214,14 +261,16 @@ bool TexturedCube::initBuffers()
     D3D11_SUBRESOURCE_DATA vertexData = {};
     vertexData.pSysMem = &cubeVertices;
     vertexData.SysMemPitch = sizeof(cubeVertices);
-    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &m_pVertexBuffer);
+    ID3D11Buffer* pVertexBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &pVertexBuffer);
+    m_vertexBuffer = m_pResources->buffer(pVertexBuffer);
 
     if (FAILED(result))
     {
         return false;
     }
 
-    result = SetResourceName(m_pVertexBuffer, "textured cube vertex buffer");
+    result = SetResourceName(pVertexBuffer, "textured cube vertex buffer");
 
     D3D11_BUFFER_DESC indexBufferDesc = {};
     indexBufferDesc.ByteWidth = sizeof(indices);
@@ -234,12 +283,14 @@ bool TexturedCube::initBuffers()
     D3D11_SUBRESOURCE_DATA indexData = {};
     indexData.pSysMem = &indices;
     indexData.SysMemPitch = sizeof(indices);
-    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &m_pIndexBuffer);
+    ID3D11Buffer* pIndexBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &pIndexBuffer);
+    m_indexBuffer = m_pResources->buffer(pIndexBuffer);
 
     if (FAILED(result))
         return false;
 
-    result = SetResourceName(m_pIndexBuffer, "textured cube index buffer");
+    result = SetResourceName(pIndexBuffer, "textured cube index buffer");
 
     D3D11_BUFFER_DESC lightParamsBufferDesc = {};
     lightParamsBufferDesc.ByteWidth = sizeof(LightParams);
@@ -255,12 +306,14 @@ bool TexturedCube::initBuffers()
     D3D11_SUBRESOURCE_DATA lightParamsData = {};
     lightParamsData.pSysMem = &params;
     lightParamsData.SysMemPitch = sizeof(LightParams);
-    result = m_pDevice->CreateBuffer(&lightParamsBufferDesc, &lightParamsData, &m_pLightingParamBuffer);
+    ID3D11Buffer* pLightingParamBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&lightParamsBufferDesc, &lightParamsData, &pLightingParamBuffer);
+    m_lightingParamBuffer = m_pResources->buffer(pLightingParamBuffer);
 
     if (FAILED(result))
         return false;
 
-    result = SetResourceName(m_pLightingParamBuffer, "lighting params buffer");
+    result = SetResourceName(pLightingParamBuffer, "lighting params buffer");
 
     D3D11_BUFFER_DESC desc;
     desc.ByteWidth = sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS);
@@ -270,10 +323,12 @@ bool TexturedCube::initBuffers()
     desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
     desc.StructureByteStride = sizeof(UINT);
 
-    result = m_pDevice->CreateBuffer(&desc, nullptr, &m_pIndirectArgsSrc);
+    ID3D11Buffer* pIndirectArgsSrc = nullptr;
+    result = m_pDevice->CreateBuffer(&desc, nullptr, &pIndirectArgsSrc);
+    m_indirectArgsSrc = m_pResources->buffer(pIndirectArgsSrc);
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pIndirectArgsSrc, "indirect args src buffer");
+        result = SetResourceName(pIndirectArgsSrc, "indirect args src buffer");
     }
     if (SUCCEEDED(result))
     {
@@ -284,11 +339,13 @@ bool TexturedCube::initBuffers()
         uavDesc.Buffer.NumElements = sizeof(D3D11_DRAW_INDEXED_INSTANCED_INDIRECT_ARGS) / sizeof(UINT);
         uavDesc.Buffer.Flags = 0;
 
-        result = m_pDevice->CreateUnorderedAccessView(m_pIndirectArgsSrc, &uavDesc, &m_pIndirectArgsUAV);
-    }
-    if (SUCCEEDED(result))
-    {
-        result = SetResourceName(m_pIndirectArgsUAV, "indirect args UAV");
+        ID3D11UnorderedAccessView* pIndirectArgsUAV = nullptr;
+        result = m_pDevice->CreateUnorderedAccessView(pIndirectArgsSrc, &uavDesc, &pIndirectArgsUAV);
+        m_indirectArgsUAV = m_pResources->add(D3DResources::View, pIndirectArgsUAV);
+        if (SUCCEEDED(result))
+        {
+            result = SetResourceName(pIndirectArgsUAV, "indirect args UAV");
+        }
     }
 
     if (SUCCEEDED(result))
@@ -301,10 +358,12 @@ bool TexturedCube::initBuffers()
         desc.MiscFlags = D3D11_RESOURCE_MISC_DRAWINDIRECT_ARGS;
         desc.StructureByteStride = 0;
 
-        result = m_pDevice->CreateBuffer(&desc, nullptr, &m_pIndirectArgs);
+        ID3D11Buffer* pIndirectArgs = nullptr;
+        result = m_pDevice->CreateBuffer(&desc, nullptr, &pIndirectArgs);
+        m_indirectArgs = m_pResources->buffer(pIndirectArgs);
         if (SUCCEEDED(result))
         {
-            result = SetResourceName(m_pIndirectArgs, "indirect args");
+            result = SetResourceName(pIndirectArgs, "indirect args");
         }
     }
 
@@ -319,10 +378,12 @@ bool TexturedCube::initBuffers()
         desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
         desc.StructureByteStride = sizeof(GeomBufferInst);
 
-        result = m_pDevice->CreateBuffer(&desc, nullptr, &m_pGeomBufferInstGPU);
+        ID3D11Buffer* pGeomBufferInstGPU = nullptr;
+        result = m_pDevice->CreateBuffer(&desc, nullptr, &pGeomBufferInstGPU);
+        m_geomBufferInstGPU = m_pResources->buffer(pGeomBufferInstGPU);
         if (SUCCEEDED(result))
         {
-            result = SetResourceName(m_pGeomBufferInstGPU, "instance buffer GPU");
+            result = SetResourceName(pGeomBufferInstGPU, "instance buffer GPU");
         }
         if (SUCCEEDED(result))
         {
@@ -333,18 +394,20 @@ bool TexturedCube::initBuffers()
             uavDesc.Buffer.NumElements = MAX_INST;
             uavDesc.Buffer.Flags = 0;
 
-            result = m_pDevice->CreateUnorderedAccessView(m_pGeomBufferInstGPU, &uavDesc, &m_pGeomBufferInstGPU_UAV);
-        }
-        if (SUCCEEDED(result))
-        {
-            result = SetResourceName(m_pGeomBufferInstGPU_UAV, "instance buffer GPU_UAV");
+            ID3D11UnorderedAccessView* pGeomBufferInstGPU_UAV = nullptr;
+            result = m_pDevice->CreateUnorderedAccessView(pGeomBufferInstGPU, &uavDesc, &pGeomBufferInstGPU_UAV);
+            m_geomBufferInstGPU_UAV = m_pResources->add(D3DResources::View, pGeomBufferInstGPU_UAV);
+            if (SUCCEEDED(result))
+            {
+                result = SetResourceName(pGeomBufferInstGPU_UAV, "instance buffer GPU_UAV");
+            }
         }
     }
 
     return true;
 }
 
-bool TexturedCube::initInputLayout()
+bool TexturedCube::createShaders(ResourcePool::Unique& vertexShader, std::vector<ResourcePool::Unique>& pixelShaders, ResourcePool::Unique& computeShader, ResourcePool::Unique& inputLayout)
 {
     D3D11_INPUT_ELEMENT_DESC inputDesc[] =
     {
@@ -359,23 +422,51 @@ bool TexturedCube::initInputLayout()
     ID3DBlob* pVertexShaderCode = nullptr;
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/lighted_cube_vs.hlsl", {}, shader_stage::Vertex, (ID3D11DeviceChild**)&m_pVertexShader, &pVertexShaderCode);
+        ID3D11VertexShader* pVertexShader = nullptr;
+        result = compileShader(m_pDevice, VertexShaderFile, {}, shader_stage::Vertex, (ID3D11DeviceChild**)&pVertexShader, &pVertexShaderCode);
+        vertexShader = m_pResources->add(D3DResources::Shader, pVertexShader);
+    }
+    // Every variant up front: there are only a few, and switching a feature must not stall a frame
+    pixelShaders.clear();
+    pixelShaders.resize(m_pixelPermutations.variantCount());
+    for (ShaderPermutations::Key key = 0; key < (ShaderPermutations::Key)pixelShaders.size() && SUCCEEDED(result); key++)
+    {
+        std::vector<std::string> defines = m_pixelPermutations.defines(key);
+        std::vector<LPCSTR> defineStrings;
+        for (const std::string& define : defines)
+        {
+            defineStrings.push_back(define.c_str());
+        }
+
+        ID3D11PixelShader* pPixelShader = nullptr;
+        ID3DBlob* pPixelShaderCode = nullptr;
+        result = compileShader(m_pDevice, PixelShaderFile, defineStrings, shader_stage::Pixel, (ID3D11DeviceChild**)&pPixelShader, &pPixelShaderCode);
+        pixelShaders[key] = m_pResources->add(D3DResources::Shader, pPixelShader);
+        if (pPixelShaderCode != nullptr)
+        {
+            m_pixelPermutations.setVariantSize(key, pPixelShaderCode->GetBufferSize());
+            pPixelShaderCode->Release();
+        }
     }
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/lighted_cube_ps.hlsl", {}, shader_stage::Pixel, (ID3D11DeviceChild**)&m_pPixelShader);
+        OutputDebugStringA(m_pixelPermutations.report("lighted_cube_ps").c_str());
     }
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/frustum_cull_cs.hlsl", {}, shader_stage::Compute, (ID3D11DeviceChild**)&m_pComputeShader);
+        ID3D11ComputeShader* pComputeShader = nullptr;
+        result = compileShader(m_pDevice, CullShaderFile, {}, shader_stage::Compute, (ID3D11DeviceChild**)&pComputeShader);
+        computeShader = m_pResources->add(D3DResources::Shader, pComputeShader);
     }
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(inputDesc, 4, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pInputLayout);
+        ID3D11InputLayout* pInputLayout = nullptr;
+        result = m_pDevice->CreateInputLayout(inputDesc, 4, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &pInputLayout);
+        inputLayout = m_pResources->add(D3DResources::InputLayout, pInputLayout);
         if (SUCCEEDED(result))
         {
-            result = SetResourceName(m_pInputLayout, "input layout");
+            result = SetResourceName(pInputLayout, "input layout");
         }
     }
 
@@ -385,113 +476,346 @@ bool TexturedCube::initInputLayout()
         pVertexShaderCode = nullptr;
     }
 
-    return result;
+    bool succeeded = SUCCEEDED(result) && vertexShader && computeShader && inputLayout;
+    for (const ResourcePool::Unique& pixelShader : pixelShaders)
+    {
+        succeeded = succeeded && pixelShader;
+    }
+    return succeeded;
+}
+
+bool TexturedCube::reloadShaders()
+{
+    ResourcePool::Unique vertexShader;
+    std::vector<ResourcePool::Unique> pixelShaders;
+    ResourcePool::Unique computeShader;
+    ResourcePool::Unique inputLayout;
+    if (!createShaders(vertexShader, pixelShaders, computeShader, inputLayout))
+    {
+        // The old set stays
+        return false;
+    }
+
+    m_vertexShader = std::move(vertexShader);
+    m_pixelShaders = std::move(pixelShaders);
+    m_computeShader = std::move(computeShader);
+    m_inputLayout = std::move(inputLayout);
+    return true;
 }
 
 bool TexturedCube::initTexture()
 {
-    std::vector<DirectX::TexMetadata> textureInfo;
-    std::vector<DirectX::ScratchImage> textures;
-    textureInfo.resize(2);
-    textures.resize(2);
-    HRESULT result = S_OK;
-    result = DirectX::LoadFromDDSFile(L"resources/textures/logo.dds", DirectX::DDS_FLAGS_NONE, &textureInfo[0], textures[0]);
-    result = DirectX::LoadFromDDSFile(L"resources/textures/tiles.dds", DirectX::DDS_FLAGS_NONE, &textureInfo[1], textures[1]);
+    // Placeholders are bound until the loader delivers the real data
+    ID3D11ShaderResourceView* pSRV = nullptr;
+    HRESULT result = createPlaceholderTexture(m_pDevice, 0xFF808080, 2, false, &pSRV);
+    m_atlasSRV = m_pResources->add(D3DResources::View, pSRV);
+    if (SUCCEEDED(result))
+    {
+        ID3D11ShaderResourceView* pNormalSRV = nullptr;
+        result = createPlaceholderTexture(m_pDevice, 0xFFFF8080, 1, false, &pNormalSRV);
+        m_normalSRV = m_pResources->add(D3DResources::View, pNormalSRV);
+    }
+    if (FAILED(result))
+    {
+        return false;
+    }
+
+    loadAtlasSources();
+    loadNormalMap();
+
+    return true;
+}
+
+void TexturedCube::loadAtlasSources()
+{
+    // A reload may overtake loads still in flight, only the latest set builds the atlas
+    uint32_t generation = ++m_atlasGeneration;
+    m_slicesLoaded = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        m_pTextureLoader->load(AtlasFiles[i], DirectX::DDS_FLAGS_NONE, [this, i, generation](TextureLoadResult& texture)
+        {
+            if (generation != m_atlasGeneration)
+            {
+                return;
+            }
+            m_slices[i] = std::move(texture);
+            if (++m_slicesLoaded == 2)
+            {
+                initTextureAtlas();
+            }
+        });
+    }
+}
+
+void TexturedCube::loadNormalMap()
+{
+    m_pTextureLoader->load(NormalMapFile, DirectX::DDS_FLAGS_NONE, [this](TextureLoadResult& texture)
+    {
+        initNormalMap(texture);
+    });
+}
+
+void TexturedCube::watchTextures(HotReload& hotReload)
+{
+    // The atlas needs both images again, whichever of them changed
+    for (const wchar_t* filename : AtlasFiles)
+    {
+        std::wstring name(filename);
+        hotReload.addTexture(std::string(name.begin(), name.end()), [this]() { loadAtlasSources(); });
+    }
+    std::wstring name(NormalMapFile);
+    hotReload.addTexture(std::string(name.begin(), name.end()), [this]() { loadNormalMap(); });
+}
+
+static std::vector<size_t> mipByteSizes(const DirectX::ScratchImage& image)
+{
+    const DirectX::TexMetadata& info = image.GetMetadata();
+    std::vector<size_t> sizes(info.mipLevels, 0);
+    for (size_t item = 0; item < info.arraySize; item++)
+    {
+        for (size_t mip = 0; mip < info.mipLevels; mip++)
+        {
+            sizes[mip] += image.GetImage(mip, item, 0)->slicePitch;
+        }
+    }
+    return sizes;
+}
+
+static uint32_t streamTailMip(const DirectX::TexMetadata& info)
+{
+    uint32_t mip = 0;
+    while (mip + 1 < info.mipLevels && (std::max)(info.width >> mip, info.height >> mip) > StreamTailSize)
+    {
+        ++mip;
+    }
+    // Top level of a block compressed texture must stay a multiple of the block size
+    while (mip > 0 && DirectX::IsCompressed(info.format) && (((info.width >> mip) % 4) != 0 || ((info.height >> mip) % 4) != 0))
+    {
+        --mip;
+    }
+    return mip;
+}
+
+bool TexturedCube::initTextureAtlas()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (FAILED(m_slices[i].result))
+        {
+            return false;
+        }
+    }
+
+    // Both images share one page of one texture, so their sizes no longer have to match
+    TextureAtlasBuilder builder;
+    builder.addSource(&m_slices[0].image, "logo");
+    builder.addSource(&m_slices[1].image, "tiles");
+
+    TextureAtlasBuilder::Options options;
+    options.mipLevels = 5;
+    options.gutter = 16;
+    // Recompression happens while loading, so the integer BC1/BC3 encoder is worth its small quality loss
+    options.compress = DirectX::TEX_COMPRESS_BC_FAST | DirectX::TEX_COMPRESS_BC_FAST_REFINE;
+
+    // One row of both images, the page grows to the larger of them
+    DXGI_FORMAT format = m_slices[0].image.GetMetadata().format;
+    size_t width = 0;
+    size_t height = 0;
+    for (int i = 0; i < 2; i++)
+    {
+        const DirectX::TexMetadata& info = m_slices[i].image.GetMetadata();
+        width += TextureAtlasBuilder::paddedSize(options, format, info.width);
+        height = (std::max)(height, TextureAtlasBuilder::paddedSize(options, format, info.height));
+    }
+    options.pageWidth = width;
+    options.pageHeight = height;
+
+    HRESULT result = builder.build(options, m_arrayImage, m_atlasEntries, &m_atlasStats);
+    for (int i = 0; i < 2; i++)
+    {
+        m_slices[i].image.Release();
+    }
+    if (FAILED(result))
+    {
+        return false;
+    }
+
+    for (int i = 0; i < MAX_INST; i++)
+    {
+        const TextureAtlasBuilder::Entry& entry = m_atlasEntries[m_instanceTexture[i]];
+        geomBuffers[i].params.z = (float)entry.page;
+        geomBuffers[i].uvTransform = entry.uvTransform;
+    }
+
+    const DirectX::TexMetadata& info = m_arrayImage.GetMetadata();
+    uint32_t tailMip = streamTailMip(info);
+    if (m_arrayStreamId == TextureStreamer::NoMip)
+    {
+        m_arrayStreamId = m_pTextureStreamer->registerTexture(mipByteSizes(m_arrayImage), tailMip);
+    }
+    else
+    {
+        m_pTextureStreamer->replaceTexture(m_arrayStreamId, mipByteSizes(m_arrayImage), tailMip);
+    }
+
+    return rebuildStreamedTexture(m_arrayImage, tailMip, "textured cube atlas", m_atlasTexture, m_atlasSRV);
+}
+
+bool TexturedCube::initNormalMap(TextureLoadResult& texture)
+{
+    if (FAILED(texture.result))
+    {
+        return false;
+    }
+
+    m_normalImage = std::move(texture.image);
+
+    uint32_t tailMip = streamTailMip(m_normalImage.GetMetadata());
+    if (m_normalStreamId == TextureStreamer::NoMip)
+    {
+        m_normalStreamId = m_pTextureStreamer->registerTexture(mipByteSizes(m_normalImage), tailMip);
+    }
+    else
+    {
+        m_pTextureStreamer->replaceTexture(m_normalStreamId, mipByteSizes(m_normalImage), tailMip);
+    }
+
+    return rebuildStreamedTexture(m_normalImage, tailMip, "normal map", m_normalTexture, m_normalSRV);
+}
+
+// Replaces texture and srv with a texture holding mips [firstMip, last] of the image
+bool TexturedCube::rebuildStreamedTexture(const DirectX::ScratchImage& image, size_t firstMip, const std::string& name, ResourcePool::Unique& texture, ResourcePool::Unique& srv)
+{
+    const DirectX::TexMetadata& info = image.GetMetadata();
+    UINT mipLevels = (UINT)(info.mipLevels - firstMip);
+    UINT arraySize = (UINT)info.arraySize;
 
     D3D11_TEXTURE2D_DESC txDesc = {};
-    txDesc.ArraySize = 2;
-    txDesc.Format = textureInfo[0].format;
-    txDesc.MipLevels = textureInfo[0].mipLevels;
+    txDesc.ArraySize = arraySize;
+    txDesc.Format = info.format;
+    txDesc.MipLevels = mipLevels;
     txDesc.Usage = D3D11_USAGE_IMMUTABLE;
     txDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
     txDesc.CPUAccessFlags = 0;
     txDesc.MiscFlags = 0;
     txDesc.SampleDesc.Count = 1;
     txDesc.SampleDesc.Quality = 0;
-    txDesc.Height = textureInfo[0].height;
-    txDesc.Width = textureInfo[0].width;
+    txDesc.Width = (UINT)(std::max)(info.width >> firstMip, (size_t)1);
+    txDesc.Height = (UINT)(std::max)(info.height >> firstMip, (size_t)1);
 
     std::vector<D3D11_SUBRESOURCE_DATA> data;
-    data.resize(textureInfo[0].mipLevels * 2);
-    for (UINT32 j = 0; j < 2; j++)
+    data.resize(mipLevels * arraySize);
+    for (UINT j = 0; j < arraySize; j++)
     {
-        UINT32 blockWidth = (txDesc.Width + 4u - 1u) / 4u;
-        UINT32 blockHeight = (txDesc.Height + 4u - 1u) / 4u;
-        UINT32 pitch = blockWidth * 8; // 8 bytes for DXGI_FORMAT_BC1_UNORM
-        const char* pSrcData = reinterpret_cast<const char*>(textures[j].GetPixels());
-
-        for (UINT32 i = 0; i < textureInfo[j].mipLevels; i++)
+        for (UINT i = 0; i < mipLevels; i++)
         {
-            data[j * textureInfo[j].mipLevels + i].pSysMem = pSrcData;
-            data[j * textureInfo[j].mipLevels + i].SysMemPitch = pitch;
-            data[j * textureInfo[j].mipLevels + i].SysMemSlicePitch = 0;
-
-            pSrcData += pitch * blockHeight;
-            blockHeight = 1u > blockHeight / 2 ? 1u : blockHeight / 2;
-            blockWidth = 1u > blockHeight / 2 ? 1u : blockWidth / 2;
-            pitch = blockWidth * 8;
+            const DirectX::Image* pImage = image.GetImage(firstMip + i, j, 0);
+            data[j * mipLevels + i].pSysMem = pImage->pixels;
+            data[j * mipLevels + i].SysMemPitch = (UINT)pImage->rowPitch;
+            data[j * mipLevels + i].SysMemSlicePitch = (UINT)pImage->slicePitch;
         }
     }
-    ID3D11Texture2D* texture;
-    texture = nullptr;
-    result = m_pDevice->CreateTexture2D(&txDesc, &data[0], &texture);
+
+    ID3D11Texture2D* pTexture = nullptr;
+    HRESULT result = m_pDevice->CreateTexture2D(&txDesc, data.data(), &pTexture);
     if (FAILED(result))
     {
         return false;
     }
 
     D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
-    desc.Format = textureInfo[0].format;
-    desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
-    desc.Texture2DArray.ArraySize = 2;
-    desc.Texture2DArray.FirstArraySlice = 0;
-    desc.Texture2DArray.MipLevels = textureInfo[0].mipLevels;
-    desc.Texture2DArray.MostDetailedMip = 0;
-
-    result = m_pDevice->CreateShaderResourceView(texture, &desc, &m_pSRV);
-
-    texture->Release();
-    
-    /*result = DirectX::CreateDDSTextureFromFile(
-        m_pDevice,
-        L"resources/textures/tiles.dds",
-        nullptr,
-        &m_pSRV
-    );
-
-    if (FAILED(result))
+    desc.Format = info.format;
+    if (arraySize > 1)
     {
-        return false;
-    }*/
+        desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        desc.Texture2DArray.ArraySize = arraySize;
+        desc.Texture2DArray.FirstArraySlice = 0;
+        desc.Texture2DArray.MipLevels = mipLevels;
+        desc.Texture2DArray.MostDetailedMip = 0;
+    }
+    else
+    {
+        desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        desc.Texture2D.MipLevels = mipLevels;
+        desc.Texture2D.MostDetailedMip = 0;
+    }
 
-    result = DirectX::CreateDDSTextureFromFile(
-        m_pDevice,
-        L"resources/textures/tiles_normal.dds",
-        nullptr,
-        &m_pNormalSRV
-    );
+    // Kept next to the view so the pool accounts the resident mips
+    ResourcePool::Unique newTexture = m_pResources->texture(pTexture);
 
+    ID3D11ShaderResourceView* pSRV = nullptr;
+    result = m_pDevice->CreateShaderResourceView(pTexture, &desc, &pSRV);
     if (FAILED(result))
     {
         return false;
     }
 
+    // The old pair is released once the GPU is done with it
+    texture = std::move(newTexture);
+    srv = m_pResources->add(D3DResources::View, pSRV);
+
+    result = SetResourceName(pSRV, name);
+
     return true;
 }
 
+void TexturedCube::requestTextureMips(int instance, float pixelsAcross)
+{
+    if (m_arrayStreamId != TextureStreamer::NoMip)
+    {
+        // The face shows a single atlas entry, so its size rather than the page's decides the mip
+        const DirectX::TexMetadata& info = m_arrayImage.GetMetadata();
+        const TextureAtlasBuilder::Entry& entry = m_atlasEntries[m_instanceTexture[instance]];
+        m_pTextureStreamer->requestMip(m_arrayStreamId, TextureStreamer::mipForFootprint((float)entry.width, pixelsAcross, (uint32_t)info.mipLevels));
+    }
+    if (m_normalStreamId != TextureStreamer::NoMip && geomBuffers[instance].params.y > 0)
+    {
+        const DirectX::TexMetadata& info = m_normalImage.GetMetadata();
+        m_pTextureStreamer->requestMip(m_normalStreamId, TextureStreamer::mipForFootprint((float)info.width, pixelsAcross, (uint32_t)info.mipLevels));
+    }
+}
+
+void TexturedCube::applyStreamingCommands(const std::vector<TextureStreamer::Command>& commands)
+{
+    for (const auto& command : commands)
+    {
+        bool isArray = command.texture == m_arrayStreamId;
+        if (!isArray && command.texture != m_normalStreamId)
+        {
+            continue;
+        }
+
+        // The CPU copy is the backing store, so a load completes as soon as the texture is rebuilt
+        bool rebuilt = isArray
+            ? rebuildStreamedTexture(m_arrayImage, command.mip, "textured cube atlas", m_atlasTexture, m_atlasSRV)
+            : rebuildStreamedTexture(m_normalImage, command.mip, "normal map", m_normalTexture, m_normalSRV);
+
+        if (rebuilt && command.type == TextureStreamer::CommandType::Load)
+        {
+            m_pTextureStreamer->completeLoad(command.texture, command.mip);
+        }
+    }
+}
+
 bool TexturedCube::initInstances()
 {
     const float diag = sqrtf(2.0f) / 2.0f * 0.5f;
 
     geomBuffers.resize(MAX_INST);
     AABB.resize(MAX_INST);
+    m_instanceTexture.resize(MAX_INST);
+    m_instanceOffsets.resize(MAX_INST);
 
     geomBuffers[0].M = DirectX::XMMatrixIdentity();
     geomBuffers[0].NormalM = DirectX::XMMatrixIdentity();
     geomBuffers[0].params.x = 64;
     geomBuffers[0].params.y = 1;
-    geomBuffers[0].params.z = 1;
+    geomBuffers[0].params.z = 0;
     geomBuffers[0].params.w = 1;
+    geomBuffers[0].uvTransform = { 1.0f, 1.0f, 0.0f, 0.0f };
+    m_instanceTexture[0] = 1;
+    m_instanceOffsets[0] = { 0.0f, 0.0f, 0.0f };
     AABB[0].first = {-diag, -0.5, -diag};
     AABB[0].second = { diag, 0.5, diag };
 
@@ -501,6 +825,9 @@ bool TexturedCube::initInstances()
     geomBuffers[1].params.y = 0;
     geomBuffers[1].params.z = 0;
     geomBuffers[1].params.w = 1;
+    geomBuffers[1].uvTransform = { 1.0f, 1.0f, 0.0f, 0.0f };
+    m_instanceTexture[1] = 0;
+    m_instanceOffsets[1] = { 2.0f, 0.0f, 2.0f };
     AABB[1].first = { 2.0f - diag, -0.5f, 2.0f - diag };
     AABB[1].second = { 2.0f + diag, 0.5f, 2.0f + diag };
 
@@ -510,9 +837,12 @@ bool TexturedCube::initInstances()
         geomBuffers[i].M = DirectX::XMMatrixTranslation(pos.x, pos.y, pos.z);
         geomBuffers[i].NormalM = DirectX::XMMatrixIdentity();
         geomBuffers[i].params.x = 50;
-        geomBuffers[i].params.z = rand() % 2;
-        geomBuffers[i].params.y = geomBuffers[i].params.z ? 1 : 0;
+        m_instanceTexture[i] = rand() % 2;
+        m_instanceOffsets[i] = pos;
+        geomBuffers[i].params.y = m_instanceTexture[i] ? 1 : 0;
+        geomBuffers[i].params.z = 0;
         geomBuffers[i].params.w = 1;
+        geomBuffers[i].uvTransform = { 1.0f, 1.0f, 0.0f, 0.0f };
         AABB[i].first = {pos.x - diag, pos.y - 0.5f, pos.z - diag};
         AABB[i].second = { pos.x + diag, pos.y + 0.5f, pos.z + diag };
     }
@@ -528,19 +858,23 @@ bool TexturedCube::initInstances()
     D3D11_SUBRESOURCE_DATA instanceData = {};
     instanceData.pSysMem = &geomBuffers[0];
     instanceData.SysMemPitch = sizeof(GeomBufferInst) * MAX_INST;
-    HRESULT result = m_pDevice->CreateBuffer(&instanceBufferDesc, &instanceData, &m_pGeomBufferInst);
+    ID3D11Buffer* pGeomBufferInst = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&instanceBufferDesc, &instanceData, &pGeomBufferInst);
+    m_geomBufferInst = m_pResources->buffer(pGeomBufferInst);
 
     if (FAILED(result))
         return false;
 
-    result = SetResourceName(m_pGeomBufferInst, "instance buffer");
+    result = SetResourceName(pGeomBufferInst, "instance buffer");
 
-    result = m_pDevice->CreateBuffer(&instanceBufferDesc, &instanceData, &m_pGeomBufferInstCompute);
+    ID3D11Buffer* pGeomBufferInstCompute = nullptr;
+    result = m_pDevice->CreateBuffer(&instanceBufferDesc, &instanceData, &pGeomBufferInstCompute);
+    m_geomBufferInstCompute = m_pResources->buffer(pGeomBufferInstCompute);
 
     if (FAILED(result))
         return false;
 
-    result = SetResourceName(m_pGeomBufferInstCompute, "instance buffer for compute");
+    result = SetResourceName(pGeomBufferInstCompute, "instance buffer for compute");
 
     D3D11_BUFFER_DESC cullParamsDesc;
     cullParamsDesc.ByteWidth = sizeof(CullParams);
@@ -560,10 +894,12 @@ bool TexturedCube::initInstances()
     D3D11_SUBRESOURCE_DATA cullData = {};
     cullData.pSysMem = &cp;
     cullData.SysMemPitch = sizeof(CullParams);
-    result = m_pDevice->CreateBuffer(&cullParamsDesc, &cullData, &m_pCullParams);
+    ID3D11Buffer* pCullParams = nullptr;
+    result = m_pDevice->CreateBuffer(&cullParamsDesc, &cullData, &pCullParams);
+    m_cullParams = m_pResources->buffer(pCullParams);
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pCullParams, "cull params buffer");
+        result = SetResourceName(pCullParams, "cull params buffer");
     }
 
     return true;
@@ -578,132 +914,20 @@ bool TexturedCube::initQuery()
     desc.MiscFlags = 0;
     for (int i = 0; i < 10 && SUCCEEDED(result); i++)
     {
-        result = m_pDevice->CreateQuery(&desc, &m_queries[i]);
+        ID3D11Query* pQuery = nullptr;
+        result = m_pDevice->CreateQuery(&desc, &pQuery);
+        m_queries[i] = m_pResources->add(D3DResources::Query, pQuery);
     }
     assert(SUCCEEDED(result));
     return true;
 }
 
-void TexturedCube::terminate()
-{
-    for (int i = 0; i < 10; i++)
-    {
-        if (m_queries[i] != nullptr)
-        {
-            m_queries[i]->Release();
-            m_queries[i] = nullptr;
-        }
-    }
-
-    if (m_pIndirectArgsUAV != nullptr)
-    {
-        m_pIndirectArgsUAV->Release();
-        m_pIndirectArgsUAV = nullptr;
-    }
-    
-    if (m_pIndirectArgsSrc != nullptr)
-    {
-        m_pIndirectArgsSrc->Release();
-        m_pIndirectArgsSrc = nullptr;
-    }
-    
-    if (m_pIndirectArgs != nullptr)
-    {
-        m_pIndirectArgs->Release();
-        m_pIndirectArgs = nullptr;
-    }
-
-    if (m_pGeomBufferInstGPU_UAV != nullptr)
-    {
-        m_pGeomBufferInstGPU_UAV->Release();
-        m_pGeomBufferInstGPU_UAV = nullptr;
-    }
-    
-    if (m_pGeomBufferInstGPU != nullptr)
-    {
-        m_pGeomBufferInstGPU->Release();
-        m_pGeomBufferInstGPU = nullptr;
-    }
-    
-    if (m_pGeomBufferInstCompute != nullptr)
-    {
-        m_pGeomBufferInstCompute->Release();
-        m_pGeomBufferInstCompute = nullptr;
-    }
-    
-    if (m_pCullParams != nullptr)
-    {
-        m_pCullParams->Release();
-        m_pCullParams = nullptr;
-    }
-
-    if (m_pGeomBufferInst != nullptr)
-    {
-        m_pGeomBufferInst->Release();
-        m_pGeomBufferInst = nullptr;
-    }
-
-    if (m_pNormalSRV != nullptr)
-    {
-        m_pNormalSRV->Release();
-        m_pNormalSRV = nullptr;
-    }
-
-    if (m_pSRV != nullptr)
-    {
-        m_pSRV->Release();
-        m_pSRV = nullptr;
-    }
-
-    if (m_pInputLayout != nullptr)
-    {
-        m_pInputLayout->Release();
-        m_pInputLayout = nullptr;
-    }
-
-    if (m_pComputeShader != nullptr)
-    {
-        m_pComputeShader->Release();
-        m_pComputeShader = nullptr;
-    }
-
-    if (m_pVertexShader != nullptr)
-    {
-        m_pVertexShader->Release();
-        m_pVertexShader = nullptr;
-    }
-
-    if (m_pPixelShader != nullptr)
-    {
-        m_pPixelShader->Release();
-        m_pPixelShader = nullptr;
-    }
-
-    if (m_pLightingParamBuffer != nullptr)
-    {
-        m_pLightingParamBuffer->Release();
-        m_pLightingParamBuffer = nullptr;
-    }
-
-    if (m_pVertexBuffer != nullptr)
-    {
-        m_pVertexBuffer->Release();
-        m_pVertexBuffer = nullptr;
-    }
-
-    if (m_pIndexBuffer != nullptr)
-    {
-        m_pIndexBuffer->Release();
-        m_pIndexBuffer = nullptr;
-    }
-}
-
 void TexturedCube::readQueries(ID3D11DeviceContext* context)
 {
     D3D11_QUERY_DATA_PIPELINE_STATISTICS stats;
     while (m_lastCompletedFrame < m_curFrame)
     {
-        HRESULT result = context->GetData(m_queries[m_lastCompletedFrame % 10], &stats, sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS), 0);
+        HRESULT result = context->GetData(m_queries[m_lastCompletedFrame % 10].get<ID3D11Query>(), &stats, sizeof(D3D11_QUERY_DATA_PIPELINE_STATISTICS), 0);
         if (result == S_OK)
         {
             instanceCountGPU = (int)stats.IAPrimitives / 12;
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "framework.h"
+#include "AsyncTextureLoader.h"
+#include "TextureStreamer.h"
+#include "TextureAtlasBuilder.h"
+#include "ShaderPermutations.h"
+#include "HotReload.h"
+#include "FrameArena.h"
+#include "D3DResources.h"
 
 #define MAX_INST 20
 
@@ -8,7 +15,16 @@ struct GeomBufferInst
 {
 	DirectX::XMMATRIX M;
 	DirectX::XMMATRIX NormalM;
-	DirectX::XMFLOAT4 params; // x - shininess, y - use normal map, z - texture index, w - is cube visible
+	DirectX::XMFLOAT4 params; // x - shininess, y - use normal map, z - atlas page, w - is cube visible
+	DirectX::XMFLOAT4 uvTransform; // xy - atlas uv scale, zw - atlas uv offset
+};
+
+// Per-instance result of the simulation step, see TexturedCube::animate()
+struct InstanceState
+{
+	DirectX::XMMATRIX M;
+	DirectX::XMMATRIX NormalM;
+	bool visible;
 };
 
 struct CullParams
@@ -21,56 +37,101 @@ struct CullParams
 class TexturedCube
 {
 public:
-	TexturedCube(ID3D11Device* device);
-	~TexturedCube();
+	TexturedCube(ID3D11Device* device, D3DResources* resources, AsyncTextureLoader* textureLoader, TextureStreamer* textureStreamer);
+
+	static void queueShaders(ShaderBuildQueue& queue);
 
-	void render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer, ID3D11SamplerState* samplerState);
+	// Recreates every shader object from the shader cache, false - the old ones are kept
+	bool reloadShaders();
+	void watchTextures(HotReload& hotReload);
 
-	void update(ID3D11DeviceContext* context, float angle, bool& isCompute);
+	// sceneParams - the values in the scene buffer, they pick the pixel shader variant
+	void render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer, ID3D11Buffer* geomBuffer, ID3D11SamplerState* samplerState, const DirectX::XMINT4& sceneParams);
+
+	// Safe on any thread, reads only what the constructor set up. visible is left to the culling
+	void animate(float angle, std::vector<InstanceState>& instances) const;
+	// Uploads the instances of the frame about to be drawn. arena - for data gone by the end of the frame
+	void update(ID3D11DeviceContext* context, const std::vector<InstanceState>& instances, bool isCompute, FrameArena& arena);
+	// The checkbox switches culling for the frames simulated after it
+	void showStats(bool& isCompute);
 
 	void cullInCompute(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer);
 
+	// pixelsAcross - screen size of one cube face of the instance, estimated during culling
+	void requestTextureMips(int instance, float pixelsAcross);
+	void applyStreamingCommands(const std::vector<TextureStreamer::Command>& commands);
+
 	std::vector<GeomBufferInst>& getInstances() { return geomBuffers; }
 	std::vector<std::pair<DirectX::XMFLOAT3, DirectX::XMFLOAT3>>& getAABB() { return AABB; }
-	ID3D11UnorderedAccessView* getIndirectArgsUAV() { return m_pIndirectArgsUAV; }
-	ID3D11UnorderedAccessView* getInstUAV() { return m_pGeomBufferInstGPU_UAV; }
+	ID3D11UnorderedAccessView* getIndirectArgsUAV() { return m_indirectArgsUAV.get<ID3D11UnorderedAccessView>(); }
+	ID3D11UnorderedAccessView* getInstUAV() { return m_geomBufferInstGPU_UAV.get<ID3D11UnorderedAccessView>(); }
+	const TextureAtlasBuilder::Stats& getAtlasStats() const { return m_atlasStats; }
+	const ShaderPermutations& getPixelPermutations() const { return m_pixelPermutations; }
 
 private:
 	bool initBuffers();
-	bool initInputLayout();
+	bool createShaders(ResourcePool::Unique& vertexShader, std::vector<ResourcePool::Unique>& pixelShaders, ResourcePool::Unique& computeShader, ResourcePool::Unique& inputLayout);
+	static ShaderPermutations pixelPermutations();
 	bool initTexture();
+	void loadAtlasSources();
+	void loadNormalMap();
+	bool initTextureAtlas();
+	bool initNormalMap(TextureLoadResult& texture);
+	bool rebuildStreamedTexture(const DirectX::ScratchImage& image, size_t firstMip, const std::string& name, ResourcePool::Unique& texture, ResourcePool::Unique& srv);
 	bool initInstances();
 	bool initQuery();
 
-	void terminate();
-
 	void readQueries(ID3D11DeviceContext* context);
 
 private:
 	ID3D11Device* m_pDevice;
-
-	ID3D11Buffer* m_pIndexBuffer;
-	ID3D11Buffer* m_pVertexBuffer;
-	ID3D11Buffer* m_pLightingParamBuffer;
-
-	ID3D11PixelShader* m_pPixelShader;
-	ID3D11VertexShader* m_pVertexShader;
-	ID3D11ComputeShader* m_pComputeShader;
-	ID3D11InputLayout* m_pInputLayout;
-
-	ID3D11ShaderResourceView* m_pSRV;
-	ID3D11ShaderResourceView* m_pNormalSRV;
-
-	ID3D11Buffer* m_pGeomBufferInst;
-	ID3D11Buffer* m_pCullParams;
-
-	ID3D11Buffer* m_pGeomBufferInstCompute;
-	ID3D11Buffer* m_pGeomBufferInstGPU;
-	ID3D11UnorderedAccessView* m_pGeomBufferInstGPU_UAV;
-
-	ID3D11Buffer* m_pIndirectArgs;
-	ID3D11Buffer* m_pIndirectArgsSrc;
-	ID3D11UnorderedAccessView* m_pIndirectArgsUAV;
+	D3DResources* m_pResources;
+	AsyncTextureLoader* m_pTextureLoader;
+	TextureStreamer* m_pTextureStreamer;
+
+	ResourcePool::Unique m_indexBuffer;
+	ResourcePool::Unique m_vertexBuffer;
+	ResourcePool::Unique m_lightingParamBuffer;
+
+	ShaderPermutations m_pixelPermutations;
+	// Indexed by ShaderPermutations::Key
+	std::vector<ResourcePool::Unique> m_pixelShaders;
+	ResourcePool::Unique m_vertexShader;
+	ResourcePool::Unique m_computeShader;
+	ResourcePool::Unique m_inputLayout;
+
+	// Null textures while the placeholders are bound
+	ResourcePool::Unique m_atlasTexture;
+	ResourcePool::Unique m_atlasSRV;
+	ResourcePool::Unique m_normalTexture;
+	ResourcePool::Unique m_normalSRV;
+
+	// Images arrive from the loader one by one, the atlas is built when all are here
+	TextureLoadResult m_slices[2];
+	int m_slicesLoaded;
+	uint32_t m_atlasGeneration;
+	std::vector<TextureAtlasBuilder::Entry> m_atlasEntries;
+	TextureAtlasBuilder::Stats m_atlasStats;
+	// Index into m_slices per instance, turned into an atlas page and uv transform once the atlas exists
+	std::vector<int> m_instanceTexture;
+	std::vector<DirectX::XMFLOAT3> m_instanceOffsets;
+
+	// CPU copies backing the streamed textures, only [residentMip, tail] is on the GPU
+	DirectX::ScratchImage m_arrayImage;
+	DirectX::ScratchImage m_normalImage;
+	TextureStreamer::TextureId m_arrayStreamId;
+	TextureStreamer::TextureId m_normalStreamId;
+
+	ResourcePool::Unique m_geomBufferInst;
+	ResourcePool::Unique m_cullParams;
+
+	ResourcePool::Unique m_geomBufferInstCompute;
+	ResourcePool::Unique m_geomBufferInstGPU;
+	ResourcePool::Unique m_geomBufferInstGPU_UAV;
+
+	ResourcePool::Unique m_indirectArgs;
+	ResourcePool::Unique m_indirectArgsSrc;
+	ResourcePool::Unique m_indirectArgsUAV;
 
 	std::vector<GeomBufferInst> geomBuffers;
 	std::vector<DirectX::XMINT4> visible;
@@ -82,6 +143,6 @@ private:
 
 	UINT64 m_curFrame = 0;
 	UINT64 m_lastCompletedFrame = 0;
-	ID3D11Query* m_queries[10];
+	ResourcePool::Unique m_queries[10];
 };
 
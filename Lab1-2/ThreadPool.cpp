@@ -0,0 +1,146 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threadCount)
+    : m_running(0)
+    , m_stop(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    m_workers.reserve(threadCount);
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_taskReady.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::defaultThreadCount()
+{
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 1 ? hw - 1 : 1;
+}
+
+void ThreadPool::submit(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+    }
+    m_taskReady.notify_one();
+}
+
+void ThreadPool::parallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    minChunk = (std::max)(minChunk, (size_t)1);
+    size_t chunkCount = (std::min)((count + minChunk - 1) / minChunk, (size_t)(m_workers.size() + 1) * 4);
+    size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    chunkCount = (count + chunkSize - 1) / chunkSize;
+
+    if (chunkCount == 1)
+    {
+        func(0, count);
+        return;
+    }
+
+    // Chunks are claimed through a shared counter, so the caller and the workers
+    // drain the same range and nobody waits on a chunk that was never started
+    struct Shared
+    {
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    auto shared = std::make_shared<Shared>();
+
+    auto body = [shared, chunkCount, chunkSize, count, &func]()
+    {
+        size_t chunk;
+        while ((chunk = shared->next.fetch_add(1)) < chunkCount)
+        {
+            size_t begin = chunk * chunkSize;
+            func(begin, (std::min)(begin + chunkSize, count));
+            if (shared->done.fetch_add(1) + 1 == chunkCount)
+            {
+                std::lock_guard<std::mutex> lock(shared->mutex);
+                shared->finished.notify_all();
+            }
+        }
+    };
+
+    size_t helpers = (std::min)(chunkCount - 1, m_workers.size());
+    for (size_t i = 0; i < helpers; i++)
+    {
+        submit(body);
+    }
+    body();
+
+    std::unique_lock<std::mutex> lock(shared->mutex);
+    shared->finished.wait(lock, [&]() { return shared->done.load() == chunkCount; });
+}
+
+void ThreadPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_tasks.empty() && m_running == 0; });
+}
+
+bool ThreadPool::runOne(std::unique_lock<std::mutex>& lock)
+{
+    if (m_tasks.empty())
+    {
+        return false;
+    }
+
+    Task task = std::move(m_tasks.front());
+    m_tasks.pop_front();
+    ++m_running;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    --m_running;
+    if (m_tasks.empty() && m_running == 0)
+    {
+        m_idle.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_taskReady.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+        if (m_stop && m_tasks.empty())
+        {
+            break;
+        }
+        runOne(lock);
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads fed from a shared FIFO of tasks.
+// Portable (std only), so everything built on top of it can run headless.
+class ThreadPool
+{
+public:
+	using Task = std::function<void()>;
+
+	// threadCount == 0 means "hardware concurrency - 1", but at least one worker
+	explicit ThreadPool(unsigned threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	void submit(Task task);
+
+	// Splits [0, count) into chunks of at least minChunk items and runs them on the workers.
+	// The calling thread takes part in the work and returns when every chunk is done.
+	void parallelFor(size_t count, size_t minChunk, const std::function<void(size_t begin, size_t end)>& func);
+
+	// Blocks until the queue is empty and no task is running
+	void wait();
+
+	unsigned size() const { return (unsigned)m_workers.size(); }
+
+	static unsigned defaultThreadCount();
+
+private:
+	void workerLoop();
+	bool runOne(std::unique_lock<std::mutex>& lock);
+
+private:
+	std::vector<std::thread> m_workers;
+	std::deque<Task> m_tasks;
+
+	std::mutex m_mutex;
+	std::condition_variable m_taskReady;
+	std::condition_variable m_idle;
+
+	size_t m_running;
+	bool m_stop;
+};
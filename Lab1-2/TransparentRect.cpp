@@ -5,30 +5,43 @@ struct GeomBuffer
     DirectX::XMMATRIX M;
 };
 
-TransparentRect::TransparentRect(ID3D11Device* device, float offset, int colorRed, int colorGreen, int colorBlue) : m_pDevice(device), m_offset(offset), m_colorRed(colorRed), m_colorGreen(colorGreen), m_colorBlue(colorBlue)
+static const wchar_t* VertexShaderFile = L"resources/shaders/cube_vs.hlsl";
+static const wchar_t* PixelShaderFile = L"resources/shaders/cube_ps.hlsl";
+
+TransparentRect::TransparentRect(ID3D11Device* device, D3DResources* resources, float offset, int colorRed, int colorGreen, int colorBlue)
+    : m_pDevice(device)
+    , m_pResources(resources)
+    , m_offset(offset)
+    , m_colorRed(colorRed)
+    , m_colorGreen(colorGreen)
+    , m_colorBlue(colorBlue)
 {
 	initBuffers();
-	initInputLayout();
+	createShaders(m_vertexShader, m_pixelShader, m_inputLayout);
 }
 
-TransparentRect::~TransparentRect()
+void TransparentRect::queueShaders(ShaderBuildQueue& queue)
 {
-	terminate();
+    queueShader(queue, VertexShaderFile, {}, shader_stage::Vertex);
+    queueShader(queue, PixelShaderFile, {}, shader_stage::Pixel);
 }
 
 void TransparentRect::render(ID3D11DeviceContext* context, ID3D11Buffer* sceneBuffer)
 {
-    context->IASetIndexBuffer(m_pIndexBuffer, DXGI_FORMAT_R16_UINT, 0);
-    ID3D11Buffer* vertexBuffers[] = { m_pVertexBuffer };
+    context->IASetIndexBuffer(m_indexBuffer.get<ID3D11Buffer>(), DXGI_FORMAT_R16_UINT, 0);
+    ID3D11Buffer* vertexBuffers[] = { m_vertexBuffer.get<ID3D11Buffer>() };
     UINT strides[] = { 28 };
     UINT offsets[] = { 0 };
-    context->IASetVertexBuffers(0, 1, &m_pVertexBuffer, strides, offsets);
-    context->IASetInputLayout(m_pInputLayout);
+    context->IASetVertexBuffers(0, 1, vertexBuffers, strides, offsets);
+    context->IASetInputLayout(m_inputLayout.get<ID3D11InputLayout>());
     context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    context->VSSetShader(m_pVertexShader, nullptr, 0);
+    context->VSSetShader(m_vertexShader.get<ID3D11VertexShader>(), nullptr, 0);
     context->VSSetConstantBuffers(0, 1, &sceneBuffer);
-    context->VSSetConstantBuffers(1, 1, &m_pGeomBuffer);
-    context->PSSetShader(m_pPixelShader, nullptr, 0);
+    ID3D11Buffer* geomBuffers[] = { m_geomBuffer.get<ID3D11Buffer>() };
+    context->VSSetConstantBuffers(1, 1, geomBuffers);
+    context->PSSetShader(m_pixelShader.get<ID3D11PixelShader>(), nullptr, 0);
+    // The pixel shader lights the rect, so it reads the scene buffer too
+    context->PSSetConstantBuffers(0, 1, &sceneBuffer);
     context->DrawIndexed(6, 0, 0);
 }
 
@@ -67,12 +80,14 @@ bool TransparentRect::initBuffers()
     D3D11_SUBRESOURCE_DATA vertexData = {};
     vertexData.pSysMem = &Vertices;
     vertexData.SysMemPitch = sizeof(Vertices);
-    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &m_pVertexBuffer);
+    ID3D11Buffer* pVertexBuffer = nullptr;
+    HRESULT result = m_pDevice->CreateBuffer(&vertexBufferrDesc, &vertexData, &pVertexBuffer);
+    m_vertexBuffer = m_pResources->buffer(pVertexBuffer);
 
     if (FAILED(result))
         return false;
 
-    result = SetResourceName(m_pVertexBuffer, "rect vertex buffer");
+    result = SetResourceName(pVertexBuffer, "rect vertex buffer");
 
     D3D11_BUFFER_DESC indexBufferDesc = {};
     indexBufferDesc.ByteWidth = sizeof(Indices);
@@ -85,12 +100,14 @@ bool TransparentRect::initBuffers()
     D3D11_SUBRESOURCE_DATA indexData = {};
     indexData.pSysMem = &Indices;
     indexData.SysMemPitch = sizeof(Indices);
-    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &m_pIndexBuffer);
+    ID3D11Buffer* pIndexBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&indexBufferDesc, &indexData, &pIndexBuffer);
+    m_indexBuffer = m_pResources->buffer(pIndexBuffer);
 
     if (!SUCCEEDED(result))
         return false;
 
-    result = SetResourceName(m_pIndexBuffer, "rect index buffer");
+    result = SetResourceName(pIndexBuffer, "rect index buffer");
 
     D3D11_BUFFER_DESC desc = {};
     desc.ByteWidth = sizeof(GeomBuffer);
@@ -108,17 +125,19 @@ bool TransparentRect::initBuffers()
     data.SysMemPitch = sizeof(geomBuffer);
     data.SysMemSlicePitch = 0;
 
-    result = m_pDevice->CreateBuffer(&desc, &data, &m_pGeomBuffer);
+    ID3D11Buffer* pGeomBuffer = nullptr;
+    result = m_pDevice->CreateBuffer(&desc, &data, &pGeomBuffer);
+    m_geomBuffer = m_pResources->buffer(pGeomBuffer);
     assert(SUCCEEDED(result));
     if (SUCCEEDED(result))
     {
-        result = SetResourceName(m_pGeomBuffer, "rect geom buffer");
+        result = SetResourceName(pGeomBuffer, "rect geom buffer");
     }
 
     return true;
 }
 
-bool TransparentRect::initInputLayout()
+bool TransparentRect::createShaders(ResourcePool::Unique& vertexShader, ResourcePool::Unique& pixelShader, ResourcePool::Unique& inputLayout)
 {
     D3D11_INPUT_ELEMENT_DESC inputDesc[] =
     {
@@ -132,19 +151,25 @@ bool TransparentRect::initInputLayout()
     ID3DBlob* pVertexShaderCode = nullptr;
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/cube_vs.hlsl", {}, shader_stage::Vertex, (ID3D11DeviceChild**)&m_pVertexShader, &pVertexShaderCode);
+        ID3D11VertexShader* pVertexShader = nullptr;
+        result = compileShader(m_pDevice, VertexShaderFile, {}, shader_stage::Vertex, (ID3D11DeviceChild**)&pVertexShader, &pVertexShaderCode);
+        vertexShader = m_pResources->add(D3DResources::Shader, pVertexShader);
     }
     if (SUCCEEDED(result))
     {
-        result = compileShader(m_pDevice, L"resources/shaders/cube_ps.hlsl", {}, shader_stage::Pixel, (ID3D11DeviceChild**)&m_pPixelShader);
+        ID3D11PixelShader* pPixelShader = nullptr;
+        result = compileShader(m_pDevice, PixelShaderFile, {}, shader_stage::Pixel, (ID3D11DeviceChild**)&pPixelShader);
+        pixelShader = m_pResources->add(D3DResources::Shader, pPixelShader);
     }
 
     if (SUCCEEDED(result))
     {
-        result = m_pDevice->CreateInputLayout(inputDesc, 3, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &m_pInputLayout);
+        ID3D11InputLayout* pInputLayout = nullptr;
+        result = m_pDevice->CreateInputLayout(inputDesc, 3, pVertexShaderCode->GetBufferPointer(), pVertexShaderCode->GetBufferSize(), &pInputLayout);
+        inputLayout = m_pResources->add(D3DResources::InputLayout, pInputLayout);
         if (SUCCEEDED(result))
         {
-            result = SetResourceName(m_pInputLayout, "rect input layout");
+            result = SetResourceName(pInputLayout, "rect input layout");
         }
     }
 
@@ -154,44 +179,22 @@ bool TransparentRect::initInputLayout()
         pVertexShaderCode = nullptr;
     }
 
-    return result;
+    return SUCCEEDED(result) && vertexShader && pixelShader && inputLayout;
 }
 
-void TransparentRect::terminate()
+bool TransparentRect::reloadShaders()
 {
-    if (m_pGeomBuffer != nullptr)
+    ResourcePool::Unique vertexShader;
+    ResourcePool::Unique pixelShader;
+    ResourcePool::Unique inputLayout;
+    if (!createShaders(vertexShader, pixelShader, inputLayout))
     {
-        m_pGeomBuffer->Release();
-        m_pGeomBuffer = nullptr;
-    }
-
-    if (m_pInputLayout != nullptr)
-    {
-        m_pInputLayout->Release();
-        m_pInputLayout = nullptr;
-    }
-
-    if (m_pPixelShader != nullptr)
-    {
-        m_pPixelShader->Release();
-        m_pPixelShader = nullptr;
-    }
-
-    if (m_pVertexShader != nullptr)
-    {
-        m_pVertexShader->Release();
-        m_pVertexShader = nullptr;
-    }
-
-    if (m_pIndexBuffer != nullptr)
-    {
-        m_pIndexBuffer->Release();
-        m_pIndexBuffer = nullptr;
+        // The old set stays
+        return false;
     }
 
-    if (m_pVertexBuffer != nullptr)
-    {
-        m_pVertexBuffer->Release();
-        m_pVertexBuffer = nullptr;
-    }
+    m_vertexShader = std::move(vertexShader);
+    m_pixelShader = std::move(pixelShader);
+    m_inputLayout = std::move(inputLayout);
+    return true;
 }
@@ -6,6 +6,9 @@
 #include "Render.h"
 
 #include <windowsx.h>
+#include <timeapi.h>
+
+#pragma comment(lib, "winmm.lib")
 
 extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -26,6 +29,7 @@ UINT                WindowWidth = 1280;
 UINT                WindowHeight = 720;
 
 Render* pRender = nullptr;
+HWND hMainWnd = nullptr;
 
 int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                      _In_opt_ HINSTANCE hPrevInstance,
@@ -50,13 +54,17 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 
     HACCEL hAccelTable = LoadAccelerators(hInstance, MAKEINTRESOURCE(IDC_LAB1));
 
-    MSG msg;
+    MSG msg = {};
+
+    // Without it every sleep of the frame pacer rounds up to the 15.6 ms default tick
+    timeBeginPeriod(1);
 
     bool exit = false;
     // Цикл основного сообщения:
     while (!exit)
     {
-        if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
+        // Everything that arrived since the last frame, input must not queue up behind rendering
+        while (!exit && PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE))
         {
             if (!TranslateAccelerator(msg.hwnd, hAccelTable, &msg))
             {
@@ -69,13 +77,23 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
                 exit = true;
             }
         }
+        if (exit)
+        {
+            break;
+        }
 
-        if (pRender->update())
+        FramePacer& pacer = pRender->framePacer();
+        pacer.setActivity(IsIconic(hMainWnd) != FALSE, GetForegroundWindow() == hMainWnd);
+        if (pacer.shouldRender() && pRender->update())
         {
             pRender->render();
         }
+        pRender->endFrame();
+        pacer.waitForNextFrame();
     }
 
+    timeEndPeriod(1);
+
     delete pRender;
 
     return (int) msg.wParam;
@@ -130,6 +148,7 @@ BOOL InitInstance(HINSTANCE hInstance, int nCmdShow)
    {
       return FALSE;
    }
+   hMainWnd = hWnd;
 
    pRender = new Render();
    if (!pRender->init(hWnd))
@@ -25,6 +25,8 @@
 #include <chrono>
 #include <algorithm>
 #include "thirdparty/DDSTextureLoader11.h"
+#include "ShaderCache.h"
+#include "ShaderBuildQueue.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_dx11.h"
@@ -113,87 +115,156 @@ inline bool readFileContent(LPCTSTR filename, std::vector<char>& data)
     return error == NO_ERROR;
 }
 
+// Shader bytecode survives between launches here, keyed by the preprocessed source
+inline ShaderCache& shaderCache()
+{
+    static ShaderCache cache(L"shader_cache", D3D_COMPILER_VERSION);
+    return cache;
+}
+
+// Includes are read from disk once per run, however many shaders pull them in
+inline ShaderIncludeCache& shaderIncludes()
+{
+    static ShaderIncludeCache includes;
+    return includes;
+}
+
 class D3DInclude : public ID3DInclude
 {
     STDMETHOD(Open)(THIS_ D3D_INCLUDE_TYPE IncludeType, LPCSTR pFileName, LPCVOID pParentData, LPCVOID* ppData, UINT* pBytes)
     {
-        FILE* pFile = nullptr;
-        fopen_s(&pFile, pFileName, "rb");
+        const std::vector<char>* pFile = shaderIncludes().read(pFileName);
         assert(pFile != nullptr);
         if (pFile == nullptr)
         {
             return E_FAIL;
         }
 
-        fseek(pFile, 0, SEEK_END);
-        long long size = _ftelli64(pFile);
-        fseek(pFile, 0, SEEK_SET);
-
-        VOID* pData = malloc(size);
-        if (pData == nullptr)
-        {
-            fclose(pFile);
-            return E_FAIL;
-        }
-
-        size_t rd = fread(pData, 1, size, pFile);
-        assert(rd == (size_t)size);
-
-        if (rd != (size_t)size)
-        {
-            fclose(pFile);
-            free(pData);
-            return E_FAIL;
-        }
-
-        *ppData = pData;
-        *pBytes = (UINT)size;
+        *ppData = pFile->data();
+        *pBytes = (UINT)pFile->size();
 
         return S_OK;
     }
     STDMETHOD(Close)(THIS_ LPCVOID pData)
     {
-        free(const_cast<void*>(pData));
+        // The data belongs to shaderIncludes()
         return S_OK;
     }
 };
 
-inline bool compileShader(ID3D11Device* device, LPCTSTR srcFilename, const std::vector<LPCSTR>& defines, const shader_stage& stage, ID3D11DeviceChild** ppShader, ID3DBlob** ppShaderBinary = nullptr)
+// Source to bytecode through shaderCache(). Touches no device, so any thread may call it
+inline HRESULT compileShaderBytecode(LPCTSTR srcFilename, const std::vector<LPCSTR>& defines, shader_stage stage, std::vector<char>& bytecode)
 {
     D3DInclude includeHandler;
 
     std::vector<char> data;
-    bool res = readFileContent(srcFilename, data);
-    if (res)
+    if (!readFileContent(srcFilename, data))
     {
-        std::vector<D3D_SHADER_MACRO> macros;
-        for (int i = 0; i < defines.size(); i++)
-        {
-            macros.push_back({ defines[i], nullptr });
-        }
-        macros.push_back({ nullptr, nullptr });
+        return E_FAIL;
+    }
+
+    // Defines are either "NAME" or "NAME=value"
+    std::vector<std::string> defineNames;
+    std::vector<std::string> macroNames;
+    std::vector<std::string> macroValues;
+    for (int i = 0; i < defines.size(); i++)
+    {
+        std::string define = defines[i];
+        size_t separator = define.find('=');
+        defineNames.push_back(define);
+        macroNames.push_back(define.substr(0, separator));
+        macroValues.push_back(separator != std::string::npos ? define.substr(separator + 1) : std::string());
+    }
 
-        UINT flags = 0;
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (int i = 0; i < defines.size(); i++)
+    {
+        macros.push_back({ macroNames[i].c_str(), macroValues[i].empty() ? nullptr : macroValues[i].c_str() });
+    }
+    macros.push_back({ nullptr, nullptr });
+
+    UINT flags = 0;
 
 #ifdef _DEBUG
-        flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+    flags |= D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif // _DEBUG
 
-        HRESULT result = S_OK;
+    static const LPCSTR entryPoints[] = { "VS", "PS", "CS" };
+    static const LPCSTR profiles[] = { "vs_5_0", "ps_5_0", "cs_5_0" };
+
+    ID3DBlob* pErrMsg = nullptr;
+
+    // Preprocessing is cheap next to compiling, and its output already contains every include
+    ID3DBlob* pPreprocessed = nullptr;
+    HRESULT result = D3DPreprocess(data.data(), data.size(), "", macros.data(), &includeHandler, &pPreprocessed, &pErrMsg);
+    if (SUCCEEDED(result))
+    {
+        ShaderCache::Key key = shaderCache().makeKey(pPreprocessed->GetBufferPointer(), pPreprocessed->GetBufferSize(),
+            defineNames, entryPoints[stage], profiles[stage], flags);
+        pPreprocessed->Release();
+        pPreprocessed = nullptr;
+        // Preprocessor warnings, the compile reports them again on a miss
+        if (pErrMsg != nullptr)
+        {
+            pErrMsg->Release();
+            pErrMsg = nullptr;
+        }
+
+        shaderCache().getOrCompile(key, [&](std::vector<char>& code)
+        {
+            ID3DBlob* pCode = nullptr;
+            result = D3DCompile(data.data(), data.size(), "", macros.data(), &includeHandler, entryPoints[stage], profiles[stage], flags, 0, &pCode, &pErrMsg);
+            if (FAILED(result))
+            {
+                return false;
+            }
+            const char* pBytes = (const char*)pCode->GetBufferPointer();
+            code.assign(pBytes, pBytes + pCode->GetBufferSize());
+            pCode->Release();
+            return true;
+        }, bytecode);
+    }
+
+    if (pErrMsg != nullptr && !SUCCEEDED(result))
+    {
+        const char* pMsg = (const char*)pErrMsg->GetBufferPointer();
+        OutputDebugStringA(pMsg);
+        OutputDebugString(_T("\n"));
+    }
+
+    if (pErrMsg != nullptr)
+    {
+        pErrMsg->Release();
+        pErrMsg = nullptr;
+    }
+
+    return result;
+}
+
+inline bool compileShader(ID3D11Device* device, LPCTSTR srcFilename, const std::vector<LPCSTR>& defines, const shader_stage& stage, ID3D11DeviceChild** ppShader, ID3DBlob** ppShaderBinary = nullptr)
+{
+    std::vector<char> bytecode;
+    HRESULT result = compileShaderBytecode(srcFilename, defines, stage, bytecode);
+
+    // Callers that need the bytecode, e.g. for input layouts, get it as a blob
+    ID3DBlob* pCode = nullptr;
+    if (SUCCEEDED(result) && ppShaderBinary != nullptr)
+    {
+        result = D3DCreateBlob(bytecode.size(), &pCode);
+        if (SUCCEEDED(result))
+        {
+            memcpy(pCode->GetBufferPointer(), bytecode.data(), bytecode.size());
+        }
+    }
 
-        ID3DBlob* pCode = nullptr;
-        ID3DBlob* pErrMsg = nullptr;
+    if (SUCCEEDED(result))
+    {
         switch (stage)
         {
         case Vertex:
         {
             ID3D11VertexShader* pVertexShader = nullptr;
-            result = D3DCompile(data.data(), data.size(), "", macros.data(), &includeHandler, "VS", "vs_5_0", flags, 0, &pCode, &pErrMsg);
-            if (!SUCCEEDED(result))
-            {
-                break;
-            }
-            result = device->CreateVertexShader(pCode->GetBufferPointer(), pCode->GetBufferSize(), nullptr, &pVertexShader);
+            result = device->CreateVertexShader(bytecode.data(), bytecode.size(), nullptr, &pVertexShader);
             if (SUCCEEDED(result))
             {
                 *ppShader = pVertexShader;
@@ -203,12 +274,7 @@ inline bool compileShader(ID3D11Device* device, LPCTSTR srcFilename, const std::
         case Pixel:
         {
             ID3D11PixelShader* pPixelShader = nullptr;
-            result = D3DCompile(data.data(), data.size(), "", macros.data(), &includeHandler, "PS", "ps_5_0", flags, 0, &pCode, &pErrMsg);
-            if (!SUCCEEDED(result))
-            {
-                break;
-            }
-            result = device->CreatePixelShader(pCode->GetBufferPointer(), pCode->GetBufferSize(), nullptr, &pPixelShader);
+            result = device->CreatePixelShader(bytecode.data(), bytecode.size(), nullptr, &pPixelShader);
             if (SUCCEEDED(result))
             {
                 *ppShader = pPixelShader;
@@ -218,12 +284,7 @@ inline bool compileShader(ID3D11Device* device, LPCTSTR srcFilename, const std::
         case Compute:
         {
             ID3D11ComputeShader* pComputeShader = nullptr;
-            result = D3DCompile(data.data(), data.size(), "", macros.data(), &includeHandler, "CS", "cs_5_0", flags, 0, &pCode, &pErrMsg);
-            if (!SUCCEEDED(result))
-            {
-                break;
-            }
-            result = device->CreateComputeShader(pCode->GetBufferPointer(), pCode->GetBufferSize(), nullptr, &pComputeShader);
+            result = device->CreateComputeShader(bytecode.data(), bytecode.size(), nullptr, &pComputeShader);
             if (SUCCEEDED(result))
             {
                 *ppShader = pComputeShader;
@@ -231,44 +292,114 @@ inline bool compileShader(ID3D11Device* device, LPCTSTR srcFilename, const std::
             break;
         }
         }
-        if (pErrMsg != nullptr && !SUCCEEDED(result))
-        {
-            const char* pMsg = (const char*)pErrMsg->GetBufferPointer();
-            OutputDebugStringA(pMsg);
-            OutputDebugString(_T("\n"));
-        }
-        assert(SUCCEEDED(result));
+    }
+    assert(SUCCEEDED(result));
 
-        if (pErrMsg != nullptr)
-        {
-            pErrMsg->Release();
-            pErrMsg = nullptr;
-        }
+    if (SUCCEEDED(result))
+    {
+        std::wstring name = std::wstring(srcFilename);
+        result = SetResourceName(*ppShader, std::string(name.begin(), name.end()));
+    }
 
-        if (SUCCEEDED(result))
-        {
-            std::wstring name = std::wstring(srcFilename);
-            result = SetResourceName(*ppShader, std::string(name.begin(), name.end()));
-        }
+    if (ppShaderBinary)
+    {
+        *ppShaderBinary = pCode;
+    }
+    return SUCCEEDED(result);
+}
 
-        if (ppShaderBinary)
-        {
-            *ppShaderBinary = pCode;
-        }
-        else
+// Compiles into shaderCache() from the queue, compileShader() with the same arguments then is a cache hit
+inline void queueShader(ShaderBuildQueue& queue, LPCTSTR srcFilename, const std::vector<std::string>& defines, shader_stage stage)
+{
+    std::wstring filename(srcFilename);
+    std::string name(filename.begin(), filename.end());
+    for (const std::string& define : defines)
+    {
+        name += " " + define;
+    }
+    queue.add(name, [filename, defines, stage]()
+    {
+        std::vector<LPCSTR> defineStrings;
+        for (const std::string& define : defines)
         {
-            if (pCode != nullptr)
-            {
-                pCode->Release();
-                pCode = nullptr;
-            }
+            defineStrings.push_back(define.c_str());
         }
-        res = SUCCEEDED(result);
-    }
-    return res;
+        std::vector<char> bytecode;
+        return SUCCEEDED(compileShaderBytecode(filename.c_str(), defineStrings, stage, bytecode));
+    }, std::string(filename.begin(), filename.end()));
 }
 
 inline float randNormf()
 {
     return (float)rand() / RAND_MAX;
-}
\ No newline at end of file
+}
+
+// 1x1 texture of a single color (0xAABBGGRR), bound while the real texture is still loading
+inline HRESULT createPlaceholderTexture(ID3D11Device* device, UINT32 color, UINT arraySize, bool isCube, ID3D11ShaderResourceView** ppSRV)
+{
+    if (isCube)
+    {
+        arraySize = 6;
+    }
+
+    D3D11_TEXTURE2D_DESC desc = {};
+    desc.Width = 1;
+    desc.Height = 1;
+    desc.MipLevels = 1;
+    desc.ArraySize = arraySize;
+    desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+    desc.SampleDesc.Count = 1;
+    desc.SampleDesc.Quality = 0;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = isCube ? D3D11_RESOURCE_MISC_TEXTURECUBE : 0;
+
+    std::vector<D3D11_SUBRESOURCE_DATA> data(arraySize);
+    for (UINT i = 0; i < arraySize; i++)
+    {
+        data[i].pSysMem = &color;
+        data[i].SysMemPitch = sizeof(color);
+        data[i].SysMemSlicePitch = 0;
+    }
+
+    ID3D11Texture2D* texture = nullptr;
+    HRESULT result = device->CreateTexture2D(&desc, data.data(), &texture);
+    if (FAILED(result))
+    {
+        return result;
+    }
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Format = desc.Format;
+    if (isCube)
+    {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURECUBE;
+        srvDesc.TextureCube.MipLevels = 1;
+        srvDesc.TextureCube.MostDetailedMip = 0;
+    }
+    else if (arraySize > 1)
+    {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+        srvDesc.Texture2DArray.ArraySize = arraySize;
+        srvDesc.Texture2DArray.FirstArraySlice = 0;
+        srvDesc.Texture2DArray.MipLevels = 1;
+        srvDesc.Texture2DArray.MostDetailedMip = 0;
+    }
+    else
+    {
+        srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+        srvDesc.Texture2D.MipLevels = 1;
+        srvDesc.Texture2D.MostDetailedMip = 0;
+    }
+
+    result = device->CreateShaderResourceView(texture, &srvDesc, ppSRV);
+    texture->Release();
+
+    if (SUCCEEDED(result))
+    {
+        result = SetResourceName(*ppSRV, "placeholder texture");
+    }
+
+    return result;
+}
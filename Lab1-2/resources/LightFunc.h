@@ -2,7 +2,12 @@
 
 float3 CalcLight(in float3 objectColor, in float3 normal, in float3 pos, in float shininess, in bool trans)
 {
+    // Shaders built as permutations know this at compile time, see ShaderPermutations
+#ifdef SHOW_NORMALS
+    if (SHOW_NORMALS)
+#else
     if (sceneParams.z > 0.0)
+#endif
     {
         return float3(normal * 0.5 + float3(0.5, 0.5, 0.5));
     }
@@ -4,7 +4,8 @@ struct GeomBuffer
 {
     float4x4 model;
     float4x4 modelNormal;
-    float4 params; // x - shininess, y - use normal map, z - texture index, w - is cube visible
+    float4 params; // x - shininess, y - use normal map, z - atlas page, w - is cube visible
+    float4 uvTransform; // xy - atlas uv scale, zw - atlas uv offset
 };
 
 cbuffer GeomBufferInst : register(b1)
@@ -30,10 +31,15 @@ struct VSOutput
 float4 PS(VSOutput input) : SV_Target0
 {
     float4 resultColor = float4(0, 0, 0, 0);
-    float3 objectColor = colorTexture.Sample(colorSampler, float3(input.uv, instances[input.id].params.z)).xyz;
+    float3 objectColor = colorTexture.Sample(colorSampler, float3(input.uv * instances[input.id].uvTransform.xy + instances[input.id].uvTransform.zw, instances[input.id].params.z)).xyz;
     
     float3 normal = normalize(input.normal);
+    // NORMAL_MAP=0 drops normal mapping for every instance, otherwise each instance decides
+#ifdef NORMAL_MAP
+    if (NORMAL_MAP && instances[input.id].params.y > 0.0)
+#else
     if (instances[input.id].params.y > 0.0)
+#endif
     {
         normal = normalTexture.Sample(colorSampler, input.uv).xyz * 2.0 - float3(1.0, 1.0, 1.0);
         float3 binorm = normalize(cross(input.normal, input.tangent));
@@ -4,7 +4,8 @@ struct GeomBuffer
 {
     float4x4 model;
     float4x4 modelNormal;
-    float4 params; // x - shininess, y - use normal map, z - texture index, w - is cube visible
+    float4 params; // x - shininess, y - use normal map, z - atlas page, w - is cube visible
+    float4 uvTransform; // xy - atlas uv scale, zw - atlas uv offset
 };
 
 cbuffer GeomBufferInst : register(b1)
@@ -9,5 +9,6 @@ struct VSOutput
 
 float4 PS(VSOutput pixel) : SV_Target0
 {
-    return float4(colorTexture.Sample(colorSampler, pixel.localPos).xyz, 1.0);
+    // Lower mips may hold the environment prefiltered for rough reflections, the sky itself is mip 0
+    return float4(colorTexture.SampleLevel(colorSampler, pixel.localPos, 0).xyz, 1.0);
 }
\ No newline at end of file
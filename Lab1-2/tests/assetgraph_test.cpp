@@ -0,0 +1,105 @@
+// AssetDependencyGraph: include parsing, transitive dependents, cycles, binary assets, and
+// rescanning a file whose includes changed.
+
+#include "AssetDependencyGraph.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    using Names = std::vector<std::string>;
+
+    void writeFile(const std::string& path, const std::string& contents)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    void testParse()
+    {
+        const std::string text =
+            "#include \"a.h\"\n"
+            "  #  include <b.h>\n"
+            "// #include \"c.h\"\n"
+            "/* \n#include \"d.h\"\n*/ #include \"e.h\"\n"
+            "int x; #include \"f.h\"\n"
+            "#includex \"g.h\"\n"
+            "#include \"h.h\"";
+        check(AssetDependencyGraph::parseIncludes(text.data(), text.size()) == Names{ "a.h", "b.h", "e.h", "h.h" },
+            "parse: directives found, comments and non-directives skipped");
+        check(AssetDependencyGraph::parseIncludes("", 0).empty(), "parse: empty text");
+        check(AssetDependencyGraph::parseIncludes("#include \"open", 14).empty(), "parse: unterminated name");
+    }
+
+    void testGraph()
+    {
+        // Include names are relative to the working directory, as in the app
+        writeFile("resources/SceneBuffer.h", "struct S {};\n");
+        writeFile("resources/LightFunc.h", "#include \"resources/SceneBuffer.h\"\n");
+        writeFile("resources/shaders/a_ps.hlsl", "#include \"resources/LightFunc.h\"\n");
+        writeFile("resources/shaders/b_vs.hlsl", "#include \"resources/SceneBuffer.h\"\n");
+        writeFile("resources/shaders/c_ps.hlsl", "float4 PS() : SV_Target { return 0; }\n");
+        writeFile("resources/shaders/cycle.hlsl", "#include \"resources/shaders/cycle.hlsl\"\n");
+
+        AssetDependencyGraph graph;
+        graph.addAsset("resources/shaders/a_ps.hlsl");
+        graph.addAsset("resources/shaders/b_vs.hlsl");
+        graph.addAsset("./resources/shaders/c_ps.hlsl");
+        graph.addAsset("resources/shaders/cycle.hlsl");
+        graph.addAsset("resources/textures/t.dds", false);
+
+        check(graph.files().size() == 7, "graph: assets and includes watched");
+        check(graph.isAsset("resources/shaders/c_ps.hlsl") && !graph.isAsset("resources/LightFunc.h"), "graph: assets told from includes");
+        check(graph.affectedAssets("resources/SceneBuffer.h") == Names{ "resources/shaders/a_ps.hlsl", "resources/shaders/b_vs.hlsl" },
+            "graph: transitive dependents, sorted");
+        check(graph.affectedAssets("resources/LightFunc.h") == Names{ "resources/shaders/a_ps.hlsl" }, "graph: direct dependent");
+        check(graph.affectedAssets("resources/shaders/c_ps.hlsl") == Names{ "resources/shaders/c_ps.hlsl" }, "graph: an asset affects itself");
+        check(graph.affectedAssets("resources/shaders/cycle.hlsl").size() == 1, "graph: self include terminates");
+        check(graph.affectedAssets("resources/textures/t.dds").size() == 1, "graph: binary asset");
+        check(graph.affectedAssets("nothing.h").empty(), "graph: unknown file affects nothing");
+
+        // An edit adding an include, then one removing it again
+        writeFile("resources/shaders/c_ps.hlsl", "#include \"resources/LightFunc.h\"\n");
+        graph.rescan("resources/shaders/c_ps.hlsl");
+        check(graph.affectedAssets("resources/SceneBuffer.h").size() == 3, "rescan: added include");
+        writeFile("resources/shaders/c_ps.hlsl", "float4 PS() : SV_Target { return 0; }\n");
+        graph.rescan("resources/shaders/c_ps.hlsl");
+        check(graph.affectedAssets("resources/SceneBuffer.h").size() == 2, "rescan: removed include");
+
+        graph.setIncludes("resources/shaders/b_vs.hlsl", {});
+        check(graph.affectedAssets("resources/SceneBuffer.h") == Names{ "resources/shaders/a_ps.hlsl" }, "setIncludes: replaces what was read");
+    }
+}
+
+int main()
+{
+    const std::filesystem::path root = "build/assetgraph_files";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "resources/shaders");
+    std::filesystem::current_path(root);
+
+    testParse();
+    testGraph();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("asset dependency graph ok\n");
+    return 0;
+}
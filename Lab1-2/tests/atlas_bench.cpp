@@ -0,0 +1,107 @@
+// TextureAtlasBuilder packing efficiency and build time on icon and sprite sets: pages used, texels
+// covered overall and on the pages before the last, and the pack, tile and encode phases.
+// Usage: atlas_bench [threads] (default hardware concurrency - 1 pool workers, 0 builds on the calling thread)
+
+#include "TextureAtlasBuilder.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Case
+    {
+        const char* name;
+        size_t count;
+        size_t minSize;
+        size_t maxSize;
+        DXGI_FORMAT format;
+        size_t mipLevels;
+        size_t gutter;
+    };
+
+    void run(const Case& c, ThreadPool* pool)
+    {
+        std::mt19937 rng(7);
+        std::vector<std::unique_ptr<ScratchImage>> images;
+        TextureAtlasBuilder builder;
+        for (size_t i = 0; i < c.count; ++i)
+        {
+            const size_t width = c.minSize + rng() % (c.maxSize - c.minSize + 1);
+            const size_t height = c.minSize + rng() % (c.maxSize - c.minSize + 1);
+            auto image = std::make_unique<ScratchImage>();
+            if (FAILED(image->Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1)))
+                return;
+            uint8_t* pixels = image->GetPixels();
+            for (size_t t = 0; t < image->GetPixelsSize(); ++t)
+                pixels[t] = static_cast<uint8_t>(((t + i * 977) * 2654435761u) >> 24);
+            builder.addSource(image.get(), "image" + std::to_string(i));
+            images.push_back(std::move(image));
+        }
+
+        TextureAtlasBuilder::Options options;
+        options.format = c.format;
+        options.mipLevels = c.mipLevels;
+        options.gutter = c.gutter;
+        options.pool = pool;
+
+        ScratchImage pages;
+        std::vector<TextureAtlasBuilder::Entry> entries;
+        TextureAtlasBuilder::Stats stats;
+        const Clock::time_point start = Clock::now();
+        if (FAILED(builder.build(options, pages, entries, &stats)))
+        {
+            std::printf("%-40s build failed\n", c.name);
+            return;
+        }
+        const double total = msSince(start);
+
+        // The last page takes whatever is left over, so the pages before it show the packer itself
+        size_t fullTexels = 0;
+        for (const TextureAtlasBuilder::Entry& entry : entries)
+        {
+            if (entry.page + 1 < stats.pages)
+                fullTexels += entry.width * entry.height;
+        }
+        const size_t fullPageTexels = (stats.pages - 1) * options.pageWidth * options.pageHeight;
+
+        std::printf("%-40s %3zu pages  %5.1f%% used  %5.1f%% on full pages   pack %7.2f ms  tiles %8.1f ms  encode %8.1f ms  total %8.1f ms\n",
+            c.name, stats.pages, stats.efficiency() * 100.0, fullPageTexels ? 100.0 * double(fullTexels) / double(fullPageTexels) : 0.0,
+            stats.packMs, stats.mipMs, stats.encodeMs, total);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const unsigned threads = (argc > 1) ? unsigned(std::strtoul(argv[1], nullptr, 10)) : ThreadPool::defaultThreadCount();
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 0)
+        pool = std::make_unique<ThreadPool>(threads);
+
+    std::printf("%u pool workers, 1024x1024 pages\n", threads);
+
+    const Case cases[] = {
+        { "icons 16-64, RGBA8, 1 mip, gutter 2", 1500, 16, 64, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 2 },
+        { "icons 16-64, BC1, 3 mips, gutter 4", 1500, 16, 64, DXGI_FORMAT_BC1_UNORM, 3, 4 },
+        { "sprites 32-256, BC1, 4 mips, gutter 4", 300, 32, 256, DXGI_FORMAT_BC1_UNORM, 4, 4 },
+        { "sprites 32-256, BC1, 4 mips, gutter 8", 300, 32, 256, DXGI_FORMAT_BC1_UNORM, 4, 8 },
+        { "sprites 32-256, RGBA8, 4 mips, gutter 4", 300, 32, 256, DXGI_FORMAT_R8G8B8A8_UNORM, 4, 4 },
+    };
+    for (const Case& c : cases)
+        run(c, pool.get());
+    return 0;
+}
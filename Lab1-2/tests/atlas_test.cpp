@@ -0,0 +1,189 @@
+// TextureAtlasBuilder on random sets of images: no two placed rectangles overlap once their padding
+// and gutter are counted, every one sits on the placement grid inside its page, gutters repeat the
+// edge texels and the last mip of an entry holds only that entry. Also the entry table round trip.
+
+#include "TextureAtlasBuilder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    const std::string Dir = "build/atlas_files";
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // Alpha holds the image index, so it survives the box filter as long as nothing else is averaged in
+    uint32_t texel(size_t image, size_t x, size_t y)
+    {
+        return uint32_t(image) << 24 | uint32_t(y & 0xFF) << 8 | uint32_t(x & 0xFF);
+    }
+
+    uint32_t pageTexel(const Image& page, size_t x, size_t y)
+    {
+        return reinterpret_cast<const uint32_t*>(page.pixels + page.rowPitch * y)[x];
+    }
+
+    struct Round
+    {
+        DXGI_FORMAT format;
+        size_t images;
+        size_t maxSize;
+        size_t mipLevels;
+        size_t gutter;
+        size_t pageSize;
+        bool pool;
+    };
+
+    void testRound(const Round& round, std::mt19937& rng, ThreadPool& pool)
+    {
+        std::vector<std::unique_ptr<ScratchImage>> images;
+        TextureAtlasBuilder builder;
+        for (size_t i = 0; i < round.images; ++i)
+        {
+            const size_t width = 1 + rng() % round.maxSize;
+            const size_t height = 1 + rng() % round.maxSize;
+            auto image = std::make_unique<ScratchImage>();
+            image->Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1);
+            const Image& pixels = *image->GetImage(0, 0, 0);
+            for (size_t y = 0; y < height; ++y)
+            {
+                for (size_t x = 0; x < width; ++x)
+                    reinterpret_cast<uint32_t*>(pixels.pixels + pixels.rowPitch * y)[x] = texel(i, x, y);
+            }
+            builder.addSource(image.get(), "image" + std::to_string(i));
+            images.push_back(std::move(image));
+        }
+
+        TextureAtlasBuilder::Options options;
+        options.format = round.format;
+        options.pageWidth = round.pageSize;
+        options.pageHeight = round.pageSize;
+        options.mipLevels = round.mipLevels;
+        options.gutter = round.gutter;
+        options.pool = round.pool ? &pool : nullptr;
+
+        ScratchImage pages;
+        std::vector<TextureAtlasBuilder::Entry> entries;
+        TextureAtlasBuilder::Stats stats;
+        if (FAILED(builder.build(options, pages, entries, &stats)))
+        {
+            check(false, "build succeeds");
+            return;
+        }
+        check(entries.size() == round.images && pages.GetMetadata().arraySize == stats.pages, "one entry per source, one slice per page");
+
+        const size_t grid = (IsCompressed(round.format) ? 4 : 1) << (round.mipLevels - 1);
+        const bool texels = !IsCompressed(round.format);
+        std::vector<int> owner(round.pageSize * round.pageSize * stats.pages, -1);
+        bool inside = true;
+        bool disjoint = true;
+        bool gutters = true;
+        bool mipsSeparate = true;
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            const TextureAtlasBuilder::Entry& entry = entries[i];
+            const size_t width = TextureAtlasBuilder::paddedSize(options, round.format, entry.width);
+            const size_t height = TextureAtlasBuilder::paddedSize(options, round.format, entry.height);
+            const size_t x0 = entry.x - round.gutter;
+            const size_t y0 = entry.y - round.gutter;
+            if (entry.x < round.gutter || entry.y < round.gutter || x0 % grid || y0 % grid
+                || x0 + width > round.pageSize || y0 + height > round.pageSize || entry.page >= stats.pages)
+            {
+                inside = false;
+                continue;
+            }
+
+            // The whole padded rectangle: gutter on every side plus the grid alignment slack
+            for (size_t y = y0; y < y0 + height; ++y)
+            {
+                for (size_t x = x0; x < x0 + width; ++x)
+                {
+                    int& cell = owner[(entry.page * round.pageSize + y) * round.pageSize + x];
+                    disjoint = disjoint && cell == -1;
+                    cell = int(i);
+                }
+            }
+
+            if (!texels)
+                continue;
+
+            const Image& page = *pages.GetImage(0, entry.page, 0);
+            for (size_t y = 0; y < height; ++y)
+            {
+                const size_t sy = size_t(std::min<ptrdiff_t>(std::max<ptrdiff_t>(ptrdiff_t(y) - ptrdiff_t(round.gutter), 0), ptrdiff_t(entry.height) - 1));
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const size_t sx = size_t(std::min<ptrdiff_t>(std::max<ptrdiff_t>(ptrdiff_t(x) - ptrdiff_t(round.gutter), 0), ptrdiff_t(entry.width) - 1));
+                    gutters = gutters && pageTexel(page, x0 + x, y0 + y) == texel(i, sx, sy);
+                }
+            }
+
+            const size_t last = round.mipLevels - 1;
+            const Image& mip = *pages.GetImage(last, entry.page, 0);
+            for (size_t y = y0 >> last; y < (y0 + height) >> last; ++y)
+            {
+                for (size_t x = x0 >> last; x < (x0 + width) >> last; ++x)
+                    mipsSeparate = mipsSeparate && (pageTexel(mip, x, y) >> 24) == uint32_t(i);
+            }
+        }
+
+        check(inside, "rectangles sit on the grid inside their page");
+        check(disjoint, "no two rectangles overlap, padding and gutter included");
+        check(gutters, "gutters repeat the edge texels");
+        check(mipsSeparate, "the last mip of an entry holds only that entry");
+
+        const std::wstring table = std::filesystem::path(Dir + "/table.txt").wstring();
+        std::vector<TextureAtlasBuilder::Entry> loaded;
+        const bool saved = SUCCEEDED(TextureAtlasBuilder::saveTable(table, entries))
+            && SUCCEEDED(TextureAtlasBuilder::loadTable(table, loaded)) && loaded.size() == entries.size();
+        const TextureAtlasBuilder::Entry* found = saved ? TextureAtlasBuilder::findEntry(loaded, entries.back().name) : nullptr;
+        check(found && found->page == entries.back().page && found->x == entries.back().x && found->y == entries.back().y
+            && found->uvTransform.z == entries.back().uvTransform.z, "the entry table round trips");
+    }
+}
+
+int main()
+{
+    std::filesystem::create_directories(Dir);
+
+    std::mt19937 rng(1);
+    ThreadPool pool(2);
+    const Round rounds[] = {
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 150, 120, 1, 0, 512, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 150, 120, 1, 3, 512, true },
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 100, 200, 3, 4, 1024, false },
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 60, 250, 4, 7, 1024, true },
+        { DXGI_FORMAT_R8G8B8A8_UNORM, 200, 20, 2, 1, 256, true },
+        { DXGI_FORMAT_BC1_UNORM, 120, 150, 1, 2, 512, false },
+        { DXGI_FORMAT_BC1_UNORM, 80, 200, 4, 4, 1024, true },
+    };
+    for (const Round& round : rounds)
+        testRound(round, rng, pool);
+
+    std::filesystem::remove_all(Dir);
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("atlas rectangles are disjoint and padded\n");
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Time and peak memory of the band loaders against the whole-file HDR/TGA loaders.
+// Usage: bandloader_bench [size] (default 4096)
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // VmHWM, the peak resident set; writing 5 to clear_refs resets it to the current size
+    long peakKB()
+    {
+        FILE* status = std::fopen("/proc/self/status", "r");
+        if (!status)
+            return 0;
+        char line[256];
+        long kb = 0;
+        while (std::fgets(line, sizeof(line), status))
+        {
+            if (std::sscanf(line, "VmHWM: %ld kB", &kb) == 1)
+                break;
+        }
+        std::fclose(status);
+        return kb;
+    }
+
+    void resetPeak()
+    {
+        if (FILE* refs = std::fopen("/proc/self/clear_refs", "w"))
+        {
+            std::fputs("5", refs);
+            std::fclose(refs);
+        }
+    }
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    bool writeTGA(const std::string& path, size_t size)
+    {
+        // 32bpp RLE, each row a mix of runs and noise
+        std::vector<uint8_t> file(18, 0);
+        file[2] = 10;
+        file[12] = static_cast<uint8_t>(size & 0xFF);
+        file[13] = static_cast<uint8_t>(size >> 8);
+        file[14] = file[12];
+        file[15] = file[13];
+        file[16] = 32;
+        file[17] = 0x28;
+
+        std::mt19937 rng(3);
+        for (size_t y = 0; y < size; ++y)
+        {
+            for (size_t x = 0; x < size; )
+            {
+                const size_t count = std::min<size_t>(128, size - x);
+                if (rng() % 2)
+                {
+                    file.push_back(static_cast<uint8_t>(0x80 | (count - 1)));
+                    for (int c = 0; c < 4; ++c)
+                        file.push_back(static_cast<uint8_t>(rng() | 1));
+                }
+                else
+                {
+                    file.push_back(static_cast<uint8_t>(count - 1));
+                    for (size_t i = 0; i < count * 4; ++i)
+                        file.push_back(static_cast<uint8_t>(rng() | 1));
+                }
+                x += count;
+            }
+        }
+
+        FILE* out = std::fopen(path.c_str(), "wb");
+        if (!out)
+            return false;
+        const bool ok = std::fwrite(file.data(), 1, file.size(), out) == file.size();
+        std::fclose(out);
+        return ok;
+    }
+
+    bool writeHDR(const std::wstring& path, size_t size)
+    {
+        ScratchImage image;
+        if (FAILED(image.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, size, size / 2, 1, 1)))
+            return false;
+
+        const Image& img = *image.GetImage(0, 0, 0);
+        std::mt19937 rng(4);
+        for (size_t y = 0; y < img.height; ++y)
+        {
+            auto row = reinterpret_cast<float*>(img.pixels + img.rowPitch * y);
+            for (size_t x = 0; x < img.width * 4; ++x)
+                row[x] = float(rng() % 65536) / 256.f;
+        }
+        return SUCCEEDED(SaveToHDRFile(img, path.c_str()));
+    }
+
+    template <typename Bands, typename Whole>
+    void run(const char* name, Bands bands, Whole whole)
+    {
+        resetPeak();
+        long base = peakKB();
+
+        size_t rows = 0;
+        auto start = Clock::now();
+        HRESULT hr = bands([&](const Image& band, size_t) -> bool
+            {
+                rows += band.height;
+                return true;
+            });
+        const double bandMs = msSince(start);
+        const long bandKB = peakKB() - base;
+        if (FAILED(hr))
+            std::printf("%s: band loader failed %08x\n", name, static_cast<unsigned>(hr));
+
+        resetPeak();
+        base = peakKB();
+        start = Clock::now();
+        ScratchImage image;
+        hr = whole(image);
+        const double wholeMs = msSince(start);
+        const long wholeKB = peakKB() - base;
+        if (FAILED(hr))
+            std::printf("%s: whole-file loader failed %08x\n", name, static_cast<unsigned>(hr));
+
+        std::printf("%-4s bands(64) %8.1f ms %8ld KB peak   whole %8.1f ms %8ld KB peak   (%zu rows)\n",
+            name, bandMs, bandKB, wholeMs, wholeKB, rows);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4096;
+
+    const std::string tga = "build/bandloader_bench.tga";
+    const std::wstring wtga(tga.begin(), tga.end());
+    const std::wstring whdr = L"build/bandloader_bench.hdr";
+    if (!writeTGA(tga, size) || !writeHDR(whdr, size))
+    {
+        std::printf("could not write the benchmark files\n");
+        return 1;
+    }
+
+    run("tga",
+        [&](std::function<bool(const Image&, size_t)> func) { return LoadFromTGAFileBands(wtga.c_str(), TGA_FLAGS_NONE, 64, nullptr, func); },
+        [&](ScratchImage& image) { return LoadFromTGAFile(wtga.c_str(), TGA_FLAGS_NONE, nullptr, image); });
+    run("hdr",
+        [&](std::function<bool(const Image&, size_t)> func) { return LoadFromHDRFileBands(whdr.c_str(), 64, nullptr, func); },
+        [&](ScratchImage& image) { return LoadFromHDRFile(whdr.c_str(), nullptr, image); });
+    return 0;
+}
@@ -0,0 +1,251 @@
+// Checks LoadFromTGAFileBands / LoadFromHDRFileBands against the whole-file loaders, including
+// RLE TGAs whose packets run across scanlines.
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what, const std::string& name)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s: %s\n", name.c_str(), what);
+            ++g_failures;
+        }
+    }
+
+    bool writeFile(const std::string& path, const std::vector<uint8_t>& data)
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (!file)
+            return false;
+        const bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        std::fclose(file);
+        return ok;
+    }
+
+    std::wstring widen(const std::string& s)
+    {
+        return std::wstring(s.begin(), s.end());
+    }
+
+    // Pixels with runs long enough to be packed, a few of them crossing row ends
+    std::vector<uint8_t> makePixels(size_t width, size_t height, size_t bpp, unsigned seed)
+    {
+        std::mt19937 rng(seed);
+        std::vector<uint8_t> pixels(width * height * bpp);
+        size_t i = 0;
+        while (i < width * height)
+        {
+            const size_t run = (rng() % 3 == 0) ? 1 + rng() % 300 : 1;
+            uint8_t pixel[4];
+            for (size_t c = 0; c < bpp; ++c)
+                pixel[c] = static_cast<uint8_t>(rng());
+            if (bpp == 4)
+                pixel[3] |= 1;
+            for (size_t k = 0; k < run && i < width * height; ++k, ++i)
+                std::memcpy(&pixels[i * bpp], pixel, bpp);
+        }
+        return pixels;
+    }
+
+    // Packs pixels[begin, end) into RLE packets
+    void encodeRLE(const std::vector<uint8_t>& pixels, size_t bpp, size_t begin, size_t end, std::vector<uint8_t>& out)
+    {
+        auto same = [&](size_t a, size_t b) { return std::memcmp(&pixels[a * bpp], &pixels[b * bpp], bpp) == 0; };
+
+        size_t i = begin;
+        while (i < end)
+        {
+            size_t run = 1;
+            while (i + run < end && run < 128 && same(i, i + run))
+                ++run;
+
+            if (run > 1)
+            {
+                out.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+                out.insert(out.end(), &pixels[i * bpp], &pixels[i * bpp] + bpp);
+                i += run;
+                continue;
+            }
+
+            size_t count = 1;
+            while (i + count < end && count < 128 && !(i + count + 1 < end && same(i + count, i + count + 1)))
+                ++count;
+            out.push_back(static_cast<uint8_t>(count - 1));
+            out.insert(out.end(), &pixels[i * bpp], &pixels[(i + count) * bpp]);
+            i += count;
+        }
+    }
+
+    std::vector<uint8_t> makeTGA(size_t width, size_t height, size_t bpp, bool rle, bool topDown, bool packetsCrossRows, unsigned seed)
+    {
+        const std::vector<uint8_t> pixels = makePixels(width, height, bpp, seed);
+
+        std::vector<uint8_t> file(18, 0);
+        file.reserve(18 + pixels.size() * 2);
+        file[2] = rle ? 10 : 2;
+        file[12] = static_cast<uint8_t>(width & 0xFF);
+        file[13] = static_cast<uint8_t>(width >> 8);
+        file[14] = static_cast<uint8_t>(height & 0xFF);
+        file[15] = static_cast<uint8_t>(height >> 8);
+        file[16] = static_cast<uint8_t>(bpp * 8);
+        file[17] = static_cast<uint8_t>((topDown ? 0x20 : 0) | (bpp == 4 ? 8 : 0));
+
+        if (!rle)
+            file.insert(file.end(), pixels.begin(), pixels.end());
+        else if (packetsCrossRows)
+            encodeRLE(pixels, bpp, 0, width * height, file);
+        else
+        {
+            for (size_t y = 0; y < height; ++y)
+                encodeRLE(pixels, bpp, y * width, (y + 1) * width, file);
+        }
+        return file;
+    }
+
+    // Every band must match the same rows of the whole-file image
+    template <typename LoadBands>
+    void compareBands(const std::string& name, const ScratchImage& whole, size_t bandHeight, LoadBands loadBands)
+    {
+        const Image& ref = *whole.GetImage(0, 0, 0);
+        std::vector<bool> seen(ref.height, false);
+        TexMetadata metadata = {};
+        bool rowsMatch = true;
+        bool inBounds = true;
+
+        const HRESULT hr = loadBands(bandHeight, &metadata, [&](const Image& band, size_t y) -> bool
+            {
+                if (band.format != ref.format || band.width != ref.width || y + band.height > ref.height)
+                {
+                    inBounds = false;
+                    return false;
+                }
+                for (size_t row = 0; row < band.height; ++row)
+                {
+                    seen[y + row] = true;
+                    if (std::memcmp(band.pixels + band.rowPitch * row, ref.pixels + ref.rowPitch * (y + row), ref.rowPitch) != 0)
+                        rowsMatch = false;
+                }
+                return true;
+            });
+
+        const std::string label = name + " band " + std::to_string(bandHeight);
+        check(hr == S_OK, "band loader failed", label);
+        check(metadata.width == ref.width && metadata.height == ref.height && metadata.format == ref.format, "metadata differs", label);
+        check(inBounds, "band outside the image", label);
+        check(rowsMatch, "rows differ from the whole-file loader", label);
+        check(std::find(seen.begin(), seen.end(), false) == seen.end(), "rows missing", label);
+    }
+
+    void testTGA(const std::string& name, size_t width, size_t height, size_t bpp, bool rle, bool topDown, bool packetsCrossRows)
+    {
+        // LoadFromTGAFile rejects packets that cross scanlines, so the reference is the same pixels stored raw
+        const unsigned seed = unsigned(width * 31 + height);
+        const std::string path = "build/" + name + ".tga";
+        const std::string rawPath = "build/" + name + "_raw.tga";
+        check(writeFile(path, makeTGA(width, height, bpp, rle, topDown, packetsCrossRows, seed)), "write", name);
+        check(writeFile(rawPath, makeTGA(width, height, bpp, false, topDown, false, seed)), "write", name);
+        const std::wstring wpath = widen(path);
+
+        ScratchImage whole;
+        check(SUCCEEDED(LoadFromTGAFile(widen(rawPath).c_str(), TGA_FLAGS_ALLOW_ALL_ZERO_ALPHA, nullptr, whole)), "whole-file loader failed", name);
+        if (!whole.GetImages())
+            return;
+
+        for (const size_t bandHeight : { size_t(1), size_t(7), size_t(64), height + 10 })
+        {
+            compareBands(name, whole, bandHeight, [&](size_t bh, TexMetadata* metadata, std::function<bool(const Image&, size_t)> func)
+                {
+                    return LoadFromTGAFileBands(wpath.c_str(), TGA_FLAGS_NONE, bh, metadata, func);
+                });
+        }
+    }
+
+    void testHDR()
+    {
+        const std::string path = "build/bandloader.hdr";
+        const std::wstring wpath = widen(path);
+
+        ScratchImage source;
+        check(SUCCEEDED(source.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, 301, 97, 1, 1)), "init", "hdr");
+        const Image& image = *source.GetImage(0, 0, 0);
+        std::mt19937 rng(5);
+        for (size_t y = 0; y < image.height; ++y)
+        {
+            auto row = reinterpret_cast<float*>(image.pixels + image.rowPitch * y);
+            for (size_t x = 0; x < image.width; ++x)
+            {
+                // Flat spans so the writer's run-length encoding gets used
+                const float base = ((x / 23) % 2) ? 0.75f : float(rng() % 4096) / 64.f;
+                row[x * 4 + 0] = base;
+                row[x * 4 + 1] = base * 0.5f;
+                row[x * 4 + 2] = base * 0.25f;
+                row[x * 4 + 3] = 1.f;
+            }
+        }
+        check(SUCCEEDED(SaveToHDRFile(image, wpath.c_str())), "save", "hdr");
+
+        ScratchImage whole;
+        check(SUCCEEDED(LoadFromHDRFile(wpath.c_str(), nullptr, whole)), "whole-file loader failed", "hdr");
+        if (!whole.GetImages())
+            return;
+
+        for (const size_t bandHeight : { size_t(1), size_t(16), size_t(200) })
+        {
+            compareBands("hdr", whole, bandHeight, [&](size_t bh, TexMetadata* metadata, std::function<bool(const Image&, size_t)> func)
+                {
+                    return LoadFromHDRFileBands(wpath.c_str(), bh, metadata, func);
+                });
+        }
+    }
+
+    void testAbortAndTruncation()
+    {
+        std::vector<uint8_t> file = makeTGA(64, 64, 4, true, true, true, 9);
+        const std::string path = "build/bandloader_abort.tga";
+        writeFile(path, file);
+
+        int bands = 0;
+        HRESULT hr = LoadFromTGAFileBands(widen(path).c_str(), TGA_FLAGS_NONE, 8, nullptr,
+            [&](const Image&, size_t) { return ++bands < 3; });
+        check(hr == E_ABORT && bands == 3, "returning false doesn't stop with E_ABORT", "abort");
+
+        file.resize(file.size() / 2);
+        const std::string truncated = "build/bandloader_truncated.tga";
+        writeFile(truncated, file);
+        hr = LoadFromTGAFileBands(widen(truncated).c_str(), TGA_FLAGS_NONE, 8, nullptr,
+            [](const Image&, size_t) { return true; });
+        check(FAILED(hr), "truncated RLE data accepted", "truncated");
+    }
+}
+
+int main()
+{
+    testTGA("tga24_rle_cross", 37, 41, 3, true, true, true);
+    testTGA("tga32_rle_cross", 37, 41, 4, true, true, true);
+    testTGA("tga32_rle_cross_bottomup", 53, 29, 4, true, false, true);
+    testTGA("tga24_rle_rows", 61, 33, 3, true, true, false);
+    testTGA("tga32_raw_bottomup", 45, 19, 4, false, false, false);
+    testHDR();
+    testAbortAndTruncation();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("band loaders match the whole-file loaders\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+// BC7 quality against speed for every encoder tier: PSNR over the RGBA channels and single-thread
+// encoding time, on crops of the repo textures and on synthetic images with alpha and noise.
+// Usage: bc7_pareto_bench [cropSize] (default 64; the default tier takes minutes at 128)
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    struct Source
+    {
+        std::string name;
+        ScratchImage image;     // R8G8B8A8_UNORM
+    };
+
+    // A size x size crop of a repo texture, decoded to RGBA8
+    bool loadCrop(const char* file, size_t x, size_t y, size_t size, Source& source)
+    {
+        const std::string path = std::string("../resources/textures/") + file;
+        const std::wstring wpath(path.begin(), path.end());
+
+        ScratchImage dds, decoded;
+        if (FAILED(LoadFromDDSFile(wpath.c_str(), DDS_FLAGS_NONE, nullptr, dds))
+            || FAILED(Decompress(*dds.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, decoded)))
+            return false;
+
+        const Image& full = *decoded.GetImage(0, 0, 0);
+        if (x + size > full.width || y + size > full.height
+            || FAILED(source.image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1)))
+            return false;
+
+        const Rect rect(x, y, size, size);
+        source.name = path.substr(path.find_last_of('/') + 1, path.find_last_of('.') - path.find_last_of('/') - 1);
+        return SUCCEEDED(CopyRectangle(full, rect, *source.image.GetImage(0, 0, 0), TEX_FILTER_DEFAULT, 0, 0));
+    }
+
+    // Gradients, a hard-edged disc, stripes and a semi-transparent band with noise
+    void synthetic(size_t size, Source& source)
+    {
+        source.name = "synthetic";
+        source.image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+        const Image& image = *source.image.GetImage(0, 0, 0);
+        std::mt19937 rng(5);
+        for (size_t y = 0; y < size; ++y)
+        {
+            uint8_t* p = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < size; ++x, p += 4)
+            {
+                const float fx = float(x) / float(size);
+                const float fy = float(y) / float(size);
+                const bool disc = (fx - 0.5f) * (fx - 0.5f) + (fy - 0.5f) * (fy - 0.5f) < 0.1f;
+                const bool stripe = ((x / 7) + (y / 11)) % 2;
+                p[0] = static_cast<uint8_t>(255.f * fx);
+                p[1] = static_cast<uint8_t>(disc ? 200.f : 40.f + 100.f * fy);
+                p[2] = stripe ? 220 : 30;
+                p[3] = static_cast<uint8_t>(disc ? 255 : (x % 64 < 32 ? 128 + rng() % 16 : 255));
+                if ((x * 13 + y * 7) % 97 < 3)
+                {
+                    p[0] = static_cast<uint8_t>(rng());
+                    p[1] = static_cast<uint8_t>(rng());
+                    p[2] = static_cast<uint8_t>(rng());
+                }
+            }
+        }
+    }
+
+    // Smooth value noise in color and alpha, like a terrain or foliage texture
+    void natural(size_t size, bool opaque, Source& source)
+    {
+        auto hash = [](int i, int j, int seed)
+            {
+                uint32_t v = uint32_t(i) * 374761393u + uint32_t(j) * 668265263u + uint32_t(seed) * 982451653u;
+                v = (v ^ (v >> 13)) * 1274126177u;
+                return float(v ^ (v >> 16)) / 4294967296.f;
+            };
+        auto noise = [&](float x, float y, int seed)
+            {
+                float sum = 0.f;
+                float amplitude = 0.5f;
+                for (int octave = 0; octave < 5; ++octave, x *= 2.f, y *= 2.f, amplitude *= 0.5f)
+                {
+                    const int xi = int(floorf(x));
+                    const int yi = int(floorf(y));
+                    float fx = x - float(xi);
+                    float fy = y - float(yi);
+                    fx = fx * fx * (3.f - 2.f * fx);
+                    fy = fy * fy * (3.f - 2.f * fy);
+                    const float a = hash(xi, yi, seed + octave);
+                    const float b = hash(xi + 1, yi, seed + octave);
+                    const float c = hash(xi, yi + 1, seed + octave);
+                    const float d = hash(xi + 1, yi + 1, seed + octave);
+                    sum += amplitude * (a + (b - a) * fx + (c - a) * fy + (a - b - c + d) * fx * fy);
+                }
+                return sum;
+            };
+        auto unorm = [](float v) { return static_cast<uint8_t>(255.f * std::min(1.f, std::max(0.f, v))); };
+
+        source.name = opaque ? "noise-opaque" : "noise-alpha";
+        source.image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1);
+        const Image& image = *source.image.GetImage(0, 0, 0);
+        for (size_t y = 0; y < size; ++y)
+        {
+            uint8_t* p = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < size; ++x, p += 4)
+            {
+                const float u = float(x) / 16.f;
+                const float v = float(y) / 16.f;
+                const float n1 = noise(u, v, 1);
+                const float n2 = noise(u * 1.7f, v * 1.7f, 7);
+                const float rock = noise(u * 0.5f, v * 0.5f, 13) > 0.5f ? 1.f : 0.f;
+                p[0] = unorm(0.3f + 0.6f * n1 * (rock ? 0.8f : 1.2f));
+                p[1] = unorm(0.25f + 0.5f * n2 + 0.2f * rock);
+                p[2] = unorm(0.15f + 0.4f * n1 * n2 + 0.3f * rock);
+                p[3] = opaque ? 255 : unorm((noise(u, v, 21) - 0.35f) * 4.f);
+            }
+        }
+    }
+
+    double psnr(const Image& a, const Image& b)
+    {
+        double squared = 0.0;
+        for (size_t y = 0; y < a.height; ++y)
+        {
+            const uint8_t* pa = a.pixels + a.rowPitch * y;
+            const uint8_t* pb = b.pixels + b.rowPitch * y;
+            for (size_t x = 0; x < a.width * 4; ++x)
+            {
+                const double d = double(pa[x]) - double(pb[x]);
+                squared += d * d;
+            }
+        }
+        const double mse = squared / double(a.width * a.height * 4);
+        return (mse > 0.0) ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 64;
+
+    std::vector<Source> sources(7);
+    if (!loadCrop("tiles.dds", 256, 256, size, sources[0])
+        || !loadCrop("logo.dds", 384, 448, size, sources[1])
+        || !loadCrop("tiles_normal.dds", 512, 128, size, sources[2])
+        || !loadCrop("cubemap.dds", 256, 512, size, sources[3]))
+    {
+        std::printf("could not load the textures in ../resources/textures\n");
+        return 1;
+    }
+    synthetic(size, sources[4]);
+    natural(size, false, sources[5]);
+    natural(size, true, sources[6]);
+
+    const struct
+    {
+        const char* name;
+        TEX_COMPRESS_FLAGS flags;
+    } tiers[] = {
+        { "default", TEX_COMPRESS_DEFAULT },
+        { "3subsets", TEX_COMPRESS_BC7_USE_3SUBSETS },
+        { "fast", TEX_COMPRESS_BC7_FAST },
+        { "fast+3subsets", TEX_COMPRESS_BC7_FAST | TEX_COMPRESS_BC7_USE_3SUBSETS },
+        { "veryfast", TEX_COMPRESS_BC7_VERYFAST },
+        { "ultrafast", TEX_COMPRESS_BC7_ULTRAFAST },
+        { "quick", TEX_COMPRESS_BC7_QUICK },
+    };
+
+    std::printf("%zux%zu crops, one thread, PSNR in dB\n%-14s", size, size, "");
+    for (const Source& source : sources)
+        std::printf(" %12.12s", source.name.c_str());
+    std::printf(" %10s %12s\n", "seconds", "Mtexel/s");
+
+    for (const auto& tier : tiers)
+    {
+        std::printf("%-14s", tier.name);
+        double seconds = 0.0;
+        for (const Source& source : sources)
+        {
+            const Image& image = *source.image.GetImage(0, 0, 0);
+            ScratchImage compressed, decoded;
+
+            const auto start = std::chrono::steady_clock::now();
+            HRESULT hr = Compress(image, DXGI_FORMAT_BC7_UNORM, tier.flags, TEX_THRESHOLD_DEFAULT, compressed);
+            seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (SUCCEEDED(hr))
+                hr = Decompress(*compressed.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, decoded);
+            if (FAILED(hr))
+            {
+                std::printf("\n%s on %s failed %08x\n", tier.name, source.name.c_str(), static_cast<unsigned>(hr));
+                return 1;
+            }
+
+            std::printf(" %12.2f", psnr(image, *decoded.GetImage(0, 0, 0)));
+        }
+        std::printf(" %10.3f %12.3f\n", seconds, double(sources.size() * size * size) / seconds / 1e6);
+    }
+    return 0;
+}
@@ -0,0 +1,85 @@
+// Throughput of the direct RGBA8 decoders (FastDecodeBC*) against the reference D3DXDecodeBC*
+// decoders followed by an RGBA8 store, on one thread.
+// Usage: bcdecode_bench [blocks] (default 16384)
+
+#include "DirectXTexP.h"
+#include "BC.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int Repeats = 20;
+
+    void decodeBC5(XMVECTOR* pColor, const uint8_t* pBC) noexcept
+    {
+        D3DXDecodeBC5U(pColor, pBC);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            pColor[i] = XMVectorSetW(pColor[i], 1.f);
+    }
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void run(const char* name, DXGI_FORMAT format, void (*reference)(XMVECTOR*, const uint8_t*), size_t count)
+    {
+        size_t blockSize = 0;
+        const BC_DECODE_FAST decode = GetFastDecoder(format, blockSize);
+
+        std::mt19937 rng(1);
+        std::vector<uint8_t> blocks(count * blockSize);
+        for (auto& b : blocks)
+            b = static_cast<uint8_t>(rng());
+
+        const size_t rowPitch = count * 16;
+        std::vector<uint8_t> out(rowPitch * 4);
+
+        auto start = Clock::now();
+        for (int r = 0; r < Repeats; ++r)
+            decode(out.data(), rowPitch, blocks.data(), count);
+        const double fast = seconds(start);
+
+        start = Clock::now();
+        for (int r = 0; r < Repeats; ++r)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                XMVECTOR colors[NUM_PIXELS_PER_BLOCK];
+                reference(colors, &blocks[i * blockSize]);
+                for (size_t t = 0; t < NUM_PIXELS_PER_BLOCK; ++t)
+                {
+                    const uint32_t texel = PackRGBA8(colors[t]);
+                    std::memcpy(&out[(t / 4) * rowPitch + i * 16 + (t % 4) * 4], &texel, sizeof(texel));
+                }
+            }
+        }
+        const double ref = seconds(start);
+
+        const double texels = double(Repeats) * double(count) * NUM_PIXELS_PER_BLOCK;
+        std::printf("%s  fast %8.1f Mtexel/s   reference %8.1f Mtexel/s   %.2fx\n",
+            name, texels / fast / 1e6, texels / ref / 1e6, ref / fast);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 16384;
+
+    run("BC1", DXGI_FORMAT_BC1_UNORM, D3DXDecodeBC1, count);
+    run("BC2", DXGI_FORMAT_BC2_UNORM, D3DXDecodeBC2, count);
+    run("BC3", DXGI_FORMAT_BC3_UNORM, D3DXDecodeBC3, count);
+    run("BC5", DXGI_FORMAT_BC5_UNORM, decodeBC5, count);
+    run("BC7", DXGI_FORMAT_BC7_UNORM, D3DXDecodeBC7, count);
+    return 0;
+}
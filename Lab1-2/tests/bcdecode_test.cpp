@@ -0,0 +1,210 @@
+// The direct RGBA8 decoders (FastDecodeBC*), Decompress to R8G8B8A8, serial and with TEX_COMPRESS_PARALLEL,
+// and BlockTexelCache must be bit-identical to the reference D3DXDecodeBC* decoders stored with XMStoreUByteN4.
+
+#include "DirectXTexP.h"
+#include "BC.h"
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what, const char* name)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s: %s\n", name, what);
+            ++g_failures;
+        }
+    }
+
+    typedef void (*BC_DECODE_REF)(XMVECTOR*, const uint8_t*);
+
+    // The fast BC5 decoder fills alpha with 1 where the reference leaves it 0
+    void decodeBC5(XMVECTOR* pColor, const uint8_t* pBC) noexcept
+    {
+        D3DXDecodeBC5U(pColor, pBC);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            pColor[i] = XMVectorSetW(pColor[i], 1.f);
+    }
+
+    struct Format
+    {
+        const char* name;
+        DXGI_FORMAT format;
+        BC_DECODE_REF reference;
+    };
+
+    const Format Formats[] = {
+        { "BC1", DXGI_FORMAT_BC1_UNORM, D3DXDecodeBC1 },
+        { "BC2", DXGI_FORMAT_BC2_UNORM, D3DXDecodeBC2 },
+        { "BC3", DXGI_FORMAT_BC3_UNORM, D3DXDecodeBC3 },
+        { "BC5", DXGI_FORMAT_BC5_UNORM, decodeBC5 },
+        { "BC7", DXGI_FORMAT_BC7_UNORM, D3DXDecodeBC7 },
+    };
+
+    // Random blocks; with tweakEndpoints the color endpoints are made equal or swapped so both
+    // BC1-style palette orders and the degenerate case come up often
+    std::vector<uint8_t> makeBlocks(size_t count, size_t blockSize, bool tweakEndpoints, std::mt19937& rng)
+    {
+        std::vector<uint8_t> blocks(count * blockSize);
+        for (auto& b : blocks)
+            b = static_cast<uint8_t>(rng());
+
+        if (tweakEndpoints)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint8_t* color = &blocks[i * blockSize + blockSize - 8];
+                if (i % 3 == 0)
+                {
+                    color[2] = color[0];
+                    color[3] = color[1];
+                }
+                else if (i % 3 == 1)
+                {
+                    std::swap(color[0], color[2]);
+                    std::swap(color[1], color[3]);
+                }
+            }
+        }
+        return blocks;
+    }
+
+    void referenceBlock(const Format& format, const uint8_t* pBC, uint32_t* texels)
+    {
+        XMVECTOR colors[NUM_PIXELS_PER_BLOCK];
+        format.reference(colors, pBC);
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            texels[i] = PackRGBA8(colors[i]);
+    }
+
+    void testDecoder(const Format& format, bool tweakEndpoints, std::mt19937& rng)
+    {
+        size_t blockSize = 0;
+        const BC_DECODE_FAST decode = GetFastDecoder(format.format, blockSize);
+        check(decode != nullptr, "no fast decoder", format.name);
+        if (!decode)
+            return;
+
+        const size_t count = 4096;
+        const std::vector<uint8_t> blocks = makeBlocks(count, blockSize, tweakEndpoints, rng);
+
+        // One band of every block side by side, then each block on its own with a 16 byte pitch
+        const size_t rowPitch = count * 16;
+        std::vector<uint8_t> band(rowPitch * 4);
+        decode(band.data(), rowPitch, blocks.data(), count);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t expected[NUM_PIXELS_PER_BLOCK];
+            referenceBlock(format, &blocks[i * blockSize], expected);
+
+            uint32_t single[NUM_PIXELS_PER_BLOCK];
+            decode(reinterpret_cast<uint8_t*>(single), 16, &blocks[i * blockSize], 1);
+
+            for (size_t t = 0; t < NUM_PIXELS_PER_BLOCK; ++t)
+            {
+                uint32_t texel;
+                std::memcpy(&texel, &band[(t / 4) * rowPitch + i * 16 + (t % 4) * 4], sizeof(texel));
+                if (texel != expected[t] || single[t] != expected[t])
+                {
+                    if (!mismatches)
+                        std::printf("  %s block %zu texel %zu: %08x, reference %08x\n", format.name, i, t, texel, expected[t]);
+                    ++mismatches;
+                }
+            }
+        }
+        check(mismatches == 0, "fast decoder differs from the reference", format.name);
+    }
+
+    // Decompress to RGBA8 and BlockTexelCache on an image with partial edge blocks
+    void testImage(const Format& format, size_t width, size_t height, std::mt19937& rng)
+    {
+        size_t blockSize = 0;
+        GetFastDecoder(format.format, blockSize);
+        const size_t blocksAcross = (width + 3) / 4;
+        const size_t blocksDown = (height + 3) / 4;
+        std::vector<uint8_t> blocks = makeBlocks(blocksAcross * blocksDown, blockSize, true, rng);
+        const Image image = { width, height, format.format, blocksAcross * blockSize, blocksAcross * blocksDown * blockSize, blocks.data() };
+
+        ScratchImage decoded;
+        check(SUCCEEDED(Decompress(image, DXGI_FORMAT_R8G8B8A8_UNORM, decoded)), "Decompress failed", format.name);
+        ScratchImage parallel;
+        check(SUCCEEDED(Decompress(image, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_COMPRESS_PARALLEL, parallel)),
+            "Decompress with TEX_COMPRESS_PARALLEL failed", format.name);
+        BlockTexelCache cache;
+        check(SUCCEEDED(cache.Initialize(image, 5)), "BlockTexelCache::Initialize failed", format.name);
+        if (!decoded.GetImages())
+            return;
+
+        const Image& out = *decoded.GetImage(0, 0, 0);
+        bool decompressMatches = true;
+        bool cacheMatches = true;
+        for (size_t by = 0; by < blocksDown; ++by)
+        {
+            for (size_t bx = 0; bx < blocksAcross; ++bx)
+            {
+                uint32_t expected[NUM_PIXELS_PER_BLOCK];
+                referenceBlock(format, &blocks[(by * blocksAcross + bx) * blockSize], expected);
+
+                for (size_t t = 0; t < NUM_PIXELS_PER_BLOCK; ++t)
+                {
+                    const size_t x = bx * 4 + t % 4;
+                    const size_t y = by * 4 + t / 4;
+                    if (x >= width || y >= height)
+                        continue;
+
+                    uint32_t texel;
+                    std::memcpy(&texel, out.pixels + out.rowPitch * y + x * 4, sizeof(texel));
+                    decompressMatches = decompressMatches && texel == expected[t];
+                }
+            }
+        }
+
+        // Random access in an order that keeps evicting the 8 cache slots
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            const size_t x = rng() % width;
+            const size_t y = rng() % height;
+            uint32_t expected[NUM_PIXELS_PER_BLOCK];
+            referenceBlock(format, &blocks[((y / 4) * blocksAcross + x / 4) * blockSize], expected);
+            cacheMatches = cacheMatches && cache.GetTexel(x, y) == expected[(y % 4) * 4 + x % 4];
+        }
+
+        check(decompressMatches, "Decompress to R8G8B8A8_UNORM differs from the reference", format.name);
+        check(parallel.GetPixels() && std::memcmp(parallel.GetPixels(), decoded.GetPixels(), decoded.GetPixelsSize()) == 0,
+            "Decompress with TEX_COMPRESS_PARALLEL differs from the serial decode", format.name);
+        check(cacheMatches, "BlockTexelCache::GetTexel differs from the reference", format.name);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    for (const Format& format : Formats)
+    {
+        testDecoder(format, false, rng);
+        testDecoder(format, true, rng);
+        testImage(format, 13, 7, rng);
+        testImage(format, 37, 50, rng);
+        testImage(format, 64, 64, rng);
+        // Enough block rows to split over several threads with TEX_COMPRESS_PARALLEL
+        testImage(format, 1030, 262, rng);
+    }
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("fast BC decoders are bit-identical to the reference\n");
+    return 0;
+}
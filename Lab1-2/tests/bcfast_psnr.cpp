@@ -0,0 +1,212 @@
+// PSNR of the integer BC1/BC3 encoders (BCFast.cpp) against the reference
+// float encoders in BC.cpp, all decoded with the reference decoders.
+// Fails when a fast tier falls further behind the reference than allowed.
+
+#include "DirectXTexP.h"
+#include "BC.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    const size_t Size = 256;
+    const size_t Blocks = (Size / 4) * (Size / 4);
+
+    using Clock = std::chrono::steady_clock;
+
+    // Texels grouped by 4x4 block, RGBA8 little endian
+    std::vector<uint32_t> makeImage(int kind)
+    {
+        std::vector<uint32_t> image(Size * Size);
+        std::mt19937 rng(7 + kind);
+        for (size_t y = 0; y < Size; y++)
+        {
+            for (size_t x = 0; x < Size; x++)
+            {
+                float fx = float(x) / Size;
+                float fy = float(y) / Size;
+                int r = 0, g = 0, b = 0, a = 255;
+                switch (kind)
+                {
+                case 0: // smooth gradients
+                    r = int(255 * fx);
+                    g = int(255 * fy);
+                    b = int(255 * (1.0f - fx * fy));
+                    a = int(255 * (0.5f + 0.5f * sinf(fx * 6.0f)));
+                    break;
+                case 1: // photo-like: low frequency color plus grain
+                    r = int(128 + 100 * sinf(fx * 9 + fy * 3)) + int(rng() % 31) - 15;
+                    g = int(128 + 90 * cosf(fx * 4 - fy * 8)) + int(rng() % 31) - 15;
+                    b = int(128 + 80 * sinf(fx * 2 + fy * 11)) + int(rng() % 31) - 15;
+                    a = int(255 * fy) + int(rng() % 61) - 30;
+                    break;
+                default: // hard edged tiles, two colors per block at most
+                    r = ((x / 3 + y / 5) & 1) ? 230 : 20;
+                    g = ((x / 6) & 1) ? 40 : 200;
+                    b = ((y / 4) & 1) ? 180 : 60;
+                    a = ((x + y) & 4) ? 255 : 0;
+                    break;
+                }
+                r = std::min(255, std::max(0, r));
+                g = std::min(255, std::max(0, g));
+                b = std::min(255, std::max(0, b));
+                a = std::min(255, std::max(0, a));
+
+                size_t block = (y / 4) * (Size / 4) + x / 4;
+                image[block * 16 + (y % 4) * 4 + x % 4] = uint32_t(r) | (uint32_t(g) << 8) | (uint32_t(b) << 16) | (uint32_t(a) << 24);
+            }
+        }
+        return image;
+    }
+
+    void toVectors(const uint32_t* texels, XMVECTOR* colors)
+    {
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++)
+        {
+            colors[i] = XMVectorSet(float(texels[i] & 0xFF) / 255.0f, float((texels[i] >> 8) & 0xFF) / 255.0f,
+                float((texels[i] >> 16) & 0xFF) / 255.0f, float(texels[i] >> 24) / 255.0f);
+        }
+    }
+
+    struct Error
+    {
+        double rgb = 0;
+        double alpha = 0;
+    };
+
+    void accumulate(const uint32_t* texels, const XMVECTOR* decoded, Error& error)
+    {
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++)
+        {
+            XMFLOAT4 d;
+            XMStoreFloat4(&d, decoded[i]);
+            float channels[4] = { d.x, d.y, d.z, d.w };
+            for (int c = 0; c < 4; c++)
+            {
+                double v = double((texels[i] >> (8 * c)) & 0xFF) - std::round(channels[c] * 255.0);
+                (c < 3 ? error.rgb : error.alpha) += v * v;
+            }
+        }
+    }
+
+    double psnr(double squaredError, double samples)
+    {
+        double mse = squaredError / samples;
+        return mse == 0 ? 99.0 : 10.0 * log10(255.0 * 255.0 / mse);
+    }
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    struct Result
+    {
+        double rgb;
+        double alpha;
+        double ms;
+    };
+
+    // Opaque input, so punch-through alpha doesn't enter the comparison
+    Result encodeBC1(std::vector<uint32_t> image, int tier)
+    {
+        for (uint32_t& texel : image)
+        {
+            texel |= 0xFF000000u;
+        }
+
+        std::vector<uint8_t> out(Blocks * 8);
+        Clock::time_point start = Clock::now();
+        if (tier < 0)
+        {
+            XMVECTOR colors[NUM_PIXELS_PER_BLOCK];
+            for (size_t b = 0; b < Blocks; b++)
+            {
+                toVectors(&image[b * 16], colors);
+                D3DXEncodeBC1(&out[b * 8], colors, 0.5f, BC_FLAGS_NONE);
+            }
+        }
+        else
+        {
+            FastEncodeBC1(out.data(), image.data(), Blocks, 128, BC_FAST_QUALITY(tier));
+        }
+        double ms = msSince(start);
+
+        Error error;
+        XMVECTOR decoded[NUM_PIXELS_PER_BLOCK];
+        for (size_t b = 0; b < Blocks; b++)
+        {
+            D3DXDecodeBC1(decoded, &out[b * 8]);
+            accumulate(&image[b * 16], decoded, error);
+        }
+        return { psnr(error.rgb, Size * Size * 3.0), 0.0, ms };
+    }
+
+    Result encodeBC3(const std::vector<uint32_t>& image, int tier)
+    {
+        std::vector<uint8_t> out(Blocks * 16);
+        Clock::time_point start = Clock::now();
+        if (tier < 0)
+        {
+            XMVECTOR colors[NUM_PIXELS_PER_BLOCK];
+            for (size_t b = 0; b < Blocks; b++)
+            {
+                toVectors(&image[b * 16], colors);
+                D3DXEncodeBC3(&out[b * 16], colors, BC_FLAGS_NONE);
+            }
+        }
+        else
+        {
+            FastEncodeBC3(out.data(), image.data(), Blocks, BC_FAST_QUALITY(tier));
+        }
+        double ms = msSince(start);
+
+        Error error;
+        XMVECTOR decoded[NUM_PIXELS_PER_BLOCK];
+        for (size_t b = 0; b < Blocks; b++)
+        {
+            D3DXDecodeBC3(decoded, &out[b * 16]);
+            accumulate(&image[b * 16], decoded, error);
+        }
+        return { psnr(error.rgb, Size * Size * 3.0), psnr(error.alpha, Size * Size), ms };
+    }
+}
+
+int main()
+{
+    static const char* Images[] = { "gradient", "photo", "tiles" };
+    static const char* Tiers[] = { "reference", "fast", "normal" };
+    // Largest RGB PSNR loss against the reference that each fast tier may have
+    static const double MaxLoss[] = { 0.0, 2.5, 0.5 };
+
+    int failures = 0;
+    for (int kind = 0; kind < 3; kind++)
+    {
+        std::vector<uint32_t> image = makeImage(kind);
+        Result bc1[3];
+        Result bc3[3];
+        for (int tier = -1; tier < 2; tier++)
+        {
+            bc1[tier + 1] = encodeBC1(image, tier);
+            bc3[tier + 1] = encodeBC3(image, tier);
+        }
+
+        for (int t = 0; t < 3; t++)
+        {
+            printf("%-8s %-9s BC1 %6.2f dB %8.2f ms | BC3 rgb %6.2f dB alpha %6.2f dB %8.2f ms\n", Images[kind], Tiers[t],
+                bc1[t].rgb, bc1[t].ms, bc3[t].rgb, bc3[t].alpha, bc3[t].ms);
+            if (t > 0 && (bc1[0].rgb - bc1[t].rgb > MaxLoss[t] || bc3[0].rgb - bc3[t].rgb > MaxLoss[t]))
+            {
+                printf("FAIL: %s tier loses more than %.1f dB on %s\n", Tiers[t], MaxLoss[t], Images[kind]);
+                failures++;
+            }
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
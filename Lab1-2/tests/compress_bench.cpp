@@ -0,0 +1,107 @@
+// BC compression throughput per format: Compress on the calling thread against TEX_COMPRESS_PARALLEL
+// on all hardware threads, for a single image and for its whole mip chain, where the small levels
+// run inline instead of paying for threads.
+// Usage: compress_bench [size] (default 512, an eighth of that for the much slower BC6H and BC7)
+
+#include "DirectXTex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Smooth gradients with noise on top, so the encoders don't take their single-color shortcuts
+    bool makeSource(size_t size, DXGI_FORMAT format, ScratchImage& result)
+    {
+        ScratchImage image;
+        if (FAILED(image.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, size, size, 1, 1)))
+            return false;
+
+        std::mt19937 rng(1);
+        const Image& img = *image.GetImage(0, 0, 0);
+        for (size_t y = 0; y < size; ++y)
+        {
+            auto row = reinterpret_cast<XMFLOAT4*>(img.pixels + img.rowPitch * y);
+            for (size_t x = 0; x < size; ++x)
+            {
+                const float noise = float(rng() % 64) / 1024.f;
+                row[x] = XMFLOAT4(float(x) / float(size) + noise, float(y) / float(size), 0.5f + noise, 1.f - noise);
+            }
+        }
+
+        ScratchImage converted;
+        if (FAILED(Convert(img, format, TEX_FILTER_DEFAULT, TEX_THRESHOLD_DEFAULT, converted)))
+            return false;
+        return SUCCEEDED(GenerateMipMaps(*converted.GetImage(0, 0, 0), TEX_FILTER_BOX, 0, result));
+    }
+
+    double compress(const ScratchImage& source, bool chain, DXGI_FORMAT format, TEX_COMPRESS_FLAGS flags, size_t& pixels)
+    {
+        const size_t imageCount = chain ? source.GetImageCount() : 1;
+        TexMetadata metadata = source.GetMetadata();
+        metadata.mipLevels = imageCount;
+
+        pixels = 0;
+        for (size_t i = 0; i < imageCount; ++i)
+            pixels += source.GetImages()[i].width * source.GetImages()[i].height;
+
+        ScratchImage result;
+        const Clock::time_point start = Clock::now();
+        if (FAILED(Compress(source.GetImages(), imageCount, metadata, format, flags, TEX_THRESHOLD_DEFAULT, result)))
+            return 0.0;
+        return seconds(start);
+    }
+
+    void run(const char* name, DXGI_FORMAT format, DXGI_FORMAT sourceFormat, TEX_COMPRESS_FLAGS flags, size_t size)
+    {
+        ScratchImage source;
+        if (!makeSource(size, sourceFormat, source))
+        {
+            std::printf("%-10s can't make the source image\n", name);
+            return;
+        }
+
+        for (const bool chain : { false, true })
+        {
+            size_t pixels = 0;
+            const double serial = compress(source, chain, format, flags, pixels);
+            const double parallel = compress(source, chain, format, flags | TEX_COMPRESS_PARALLEL, pixels);
+            if (serial <= 0.0 || parallel <= 0.0)
+            {
+                std::printf("%-10s compression failed\n", name);
+                return;
+            }
+
+            const double mpixels = double(pixels) / 1e6;
+            std::printf("%-10s %5zu %-6s serial %8.3f Mpixel/s   parallel %8.3f Mpixel/s   %.2fx\n",
+                name, size, chain ? "chain" : "top", mpixels / serial, mpixels / parallel, serial / parallel);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 512;
+
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+    run("BC1", DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_COMPRESS_DEFAULT, size);
+    run("BC3", DXGI_FORMAT_BC3_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_COMPRESS_DEFAULT, size);
+    run("BC4", DXGI_FORMAT_BC4_UNORM, DXGI_FORMAT_R8_UNORM, TEX_COMPRESS_DEFAULT, size);
+    run("BC5", DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_R8G8_UNORM, TEX_COMPRESS_DEFAULT, size);
+    run("BC6H", DXGI_FORMAT_BC6H_UF16, DXGI_FORMAT_R16G16B16A16_FLOAT, TEX_COMPRESS_DEFAULT, size / 8);
+    run("BC7 quick", DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_COMPRESS_BC7_QUICK, size / 8);
+    run("BC7", DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_COMPRESS_DEFAULT, size / 8);
+    return 0;
+}
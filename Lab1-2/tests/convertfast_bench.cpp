@@ -0,0 +1,111 @@
+// Convert throughput per format pair: the fast kernels against the LoadScanline/ConvertScanline/
+// StoreScanline path they replace, run one row at a time as ConvertCustom does.
+// Usage: convertfast_bench [size] (default 2048)
+
+#include "DirectXTexP.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double convertFast(const Image& src, DXGI_FORMAT format, TEX_FILTER_FLAGS filter)
+    {
+        ScratchImage result;
+        const Clock::time_point start = Clock::now();
+        if (FAILED(Convert(src, format, filter, TEX_THRESHOLD_DEFAULT, result)))
+            return -1.0;
+        return seconds(start);
+    }
+
+    double convertScanline(const Image& src, DXGI_FORMAT format, TEX_FILTER_FLAGS filter)
+    {
+        ScratchImage result;
+        const Clock::time_point start = Clock::now();
+        if (FAILED(result.Initialize2D(format, src.width, src.height, 1, 1)))
+            return -1.0;
+
+        const Image& dst = *result.GetImage(0, 0, 0);
+        auto scanline = make_AlignedArrayXMVECTOR(src.width);
+        if (!scanline)
+            return -1.0;
+
+        for (size_t y = 0; y < src.height; ++y)
+        {
+            if (!Internal::LoadScanline(scanline.get(), src.width, src.pixels + src.rowPitch * y, src.rowPitch, src.format))
+                return -1.0;
+
+            Internal::ConvertScanline(scanline.get(), src.width, format, src.format, filter);
+
+            if (!Internal::StoreScanline(dst.pixels + dst.rowPitch * y, dst.rowPitch, format, scanline.get(), src.width, TEX_THRESHOLD_DEFAULT))
+                return -1.0;
+        }
+        return seconds(start);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2048;
+
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+    const struct
+    {
+        const char* name;
+        DXGI_FORMAT inFormat;
+        DXGI_FORMAT outFormat;
+        TEX_FILTER_FLAGS filter;
+    } pairs[] = {
+        { "RGBA8 -> BGRA8", DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM, TEX_FILTER_DEFAULT },
+        { "BGRA8 -> RGBA8", DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT },
+        { "BGRX8 -> RGBA8", DXGI_FORMAT_B8G8R8X8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT },
+        { "RGBA8 -> RGBA8 sRGB", DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, TEX_FILTER_DEFAULT },
+        { "RGBA8 sRGB -> BGRA8", DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_B8G8R8A8_UNORM, TEX_FILTER_DEFAULT },
+        { "RGBA8 -> RGBA16F", DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R16G16B16A16_FLOAT, TEX_FILTER_DEFAULT },
+        { "RGBA8 sRGB -> RGBA16F", DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, DXGI_FORMAT_R16G16B16A16_FLOAT, TEX_FILTER_DEFAULT },
+        { "BGRA8 -> RGBA32F", DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_R32G32B32A32_FLOAT, TEX_FILTER_DEFAULT },
+        { "R32F -> R16F", DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R16_FLOAT, TEX_FILTER_DEFAULT },
+        { "RGBA32F -> RGBA16F", DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, TEX_FILTER_DEFAULT },
+    };
+
+    for (const auto& pair : pairs)
+    {
+        ScratchImage source;
+        if (FAILED(source.Initialize2D(pair.inFormat, size, size, 1, 1)))
+            return 1;
+
+        // Bytes for the 8-bit formats, floats between -2 and 2 for the others
+        uint8_t* pixels = source.GetPixels();
+        if (BitsPerColor(pair.inFormat) == 8)
+        {
+            for (size_t i = 0; i < source.GetPixelsSize(); ++i)
+                pixels[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        }
+        else
+        {
+            auto values = reinterpret_cast<float*>(pixels);
+            for (size_t i = 0; i < source.GetPixelsSize() / sizeof(float); ++i)
+                values[i] = float((i * 2654435761u) >> 16 & 0xFFFF) / 16384.f - 2.f;
+        }
+
+        const Image& image = *source.GetImage(0, 0, 0);
+        const double mpixels = double(size * size) / 1e6;
+        const double fast = convertFast(image, pair.outFormat, pair.filter);
+        const double scanline = convertScanline(image, pair.outFormat, pair.filter);
+        std::printf("%-22s fast %8.1f Mpixel/s   scanline %8.1f Mpixel/s   %.2fx\n",
+            pair.name, mpixels / fast, mpixels / scanline, scanline / fast);
+    }
+    return 0;
+}
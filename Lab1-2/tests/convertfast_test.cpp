@@ -0,0 +1,240 @@
+// Convert's fast kernels against the LoadScanline/ConvertScanline/StoreScanline path they replace:
+// byte equality for every table-driven 8-bit pair with each color space flag, and for the float to
+// half pairs including values out of half range. Also which requests stay off the fast kernels,
+// and progress reporting and cancelling through the status callback.
+
+#include "DirectXTexP.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    const DXGI_FORMAT Formats8[] = {
+        DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+        DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,
+        DXGI_FORMAT_B8G8R8X8_UNORM, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,
+    };
+
+    const TEX_FILTER_FLAGS Filters[] = {
+        TEX_FILTER_DEFAULT, TEX_FILTER_SRGB_IN, TEX_FILTER_SRGB_OUT, TEX_FILTER_SRGB, TEX_FILTER_FLOAT_X2BIAS,
+    };
+
+    // The scanline path one row at a time, as ConvertCustom runs it without dithering
+    bool convertReference(const Image& src, DXGI_FORMAT format, TEX_FILTER_FLAGS filter, ScratchImage& result)
+    {
+        if (FAILED(result.Initialize2D(format, src.width, src.height, 1, 1)))
+            return false;
+
+        const Image& dst = *result.GetImage(0, 0, 0);
+        auto scanline = make_AlignedArrayXMVECTOR(src.width);
+        if (!scanline)
+            return false;
+
+        for (size_t y = 0; y < src.height; ++y)
+        {
+            if (!Internal::LoadScanline(scanline.get(), src.width, src.pixels + src.rowPitch * y, src.rowPitch, src.format))
+                return false;
+
+            Internal::ConvertScanline(scanline.get(), src.width, format, src.format, filter);
+
+            if (!Internal::StoreScanline(dst.pixels + dst.rowPitch * y, dst.rowPitch, format, scanline.get(), src.width, TEX_THRESHOLD_DEFAULT))
+                return false;
+        }
+        return true;
+    }
+
+    bool sameRows(const Image& a, const Image& b)
+    {
+        const size_t rowBytes = a.width * BitsPerPixel(a.format) / 8;
+        for (size_t y = 0; y < a.height; ++y)
+        {
+            if (memcmp(a.pixels + a.rowPitch * y, b.pixels + b.rowPitch * y, rowBytes) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    bool matchesReference(const Image& src, DXGI_FORMAT format, TEX_FILTER_FLAGS filter)
+    {
+        ScratchImage fast;
+        ScratchImage reference;
+        return SUCCEEDED(Convert(src, format, filter, TEX_THRESHOLD_DEFAULT, fast))
+            && convertReference(src, format, filter, reference)
+            && sameRows(*fast.GetImage(0, 0, 0), *reference.GetImage(0, 0, 0));
+    }
+
+    // Every byte value in every channel, and tall enough for the rows to split over several chunks
+    void testTablePairs()
+    {
+        const DXGI_FORMAT outFormats[] = {
+            DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+            DXGI_FORMAT_B8G8R8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB,
+            DXGI_FORMAT_B8G8R8X8_UNORM, DXGI_FORMAT_B8G8R8X8_UNORM_SRGB,
+            DXGI_FORMAT_R16G16B16A16_FLOAT, DXGI_FORMAT_R32G32B32A32_FLOAT,
+        };
+
+        std::mt19937 rng(11);
+        for (const DXGI_FORMAT inFormat : Formats8)
+        {
+            ScratchImage source;
+            source.Initialize2D(inFormat, 300, 700, 1, 1);
+            const Image& image = *source.GetImage(0, 0, 0);
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                uint8_t* row = image.pixels + image.rowPitch * y;
+                for (size_t x = 0; x < image.width * 4; ++x)
+                    row[x] = (y < 2) ? static_cast<uint8_t>(x + y * 3) : static_cast<uint8_t>(rng());
+            }
+
+            for (const DXGI_FORMAT outFormat : outFormats)
+            {
+                if (outFormat == inFormat)
+                    continue;
+
+                for (const TEX_FILTER_FLAGS filter : Filters)
+                {
+                    if (!Internal::CanConvertFast(inFormat, outFormat, filter))
+                    {
+                        std::printf("  no fast kernel for %d -> %d, filter %#x\n", int(inFormat), int(outFormat), unsigned(filter));
+                        check(false, "8-bit pairs: every pair has a fast kernel");
+                        continue;
+                    }
+
+                    if (!matchesReference(image, outFormat, filter))
+                    {
+                        std::printf("  %d -> %d, filter %#x\n", int(inFormat), int(outFormat), unsigned(filter));
+                        check(false, "8-bit pairs: byte-equal to the scanline path");
+                    }
+                }
+            }
+        }
+    }
+
+    float floatValue(std::mt19937& rng)
+    {
+        static const float special[] = {
+            0.f, -0.f, 1.f, -1.f, 65504.f, -65504.f, 65520.f, 1e6f, -1e6f, 6.1e-5f, 5.9e-8f, 1e-10f,
+            std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+        };
+        const uint32_t pick = rng() % 64;
+        if (pick < std::size(special))
+            return special[pick];
+        if (pick < 40)
+            return std::ldexp(float(rng() % 2048) / 1024.f - 1.f, int(rng() % 40) - 24);
+        return (float(rng() % 200001) - 100000.f) * 0.5f;
+    }
+
+    void testFloatPairs()
+    {
+        const struct
+        {
+            DXGI_FORMAT inFormat;
+            DXGI_FORMAT outFormat;
+            size_t channels;
+            const char* what;
+        } pairs[] = {
+            { DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R16_FLOAT, 1, "R32_FLOAT -> R16_FLOAT: byte-equal to the scanline path" },
+            { DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, 4, "R32G32B32A32_FLOAT -> R16G16B16A16_FLOAT: byte-equal to the scanline path" },
+        };
+
+        std::mt19937 rng(13);
+        for (const auto& pair : pairs)
+        {
+            ScratchImage source;
+            source.Initialize2D(pair.inFormat, 257, 600, 1, 1);
+            const Image& image = *source.GetImage(0, 0, 0);
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                auto row = reinterpret_cast<float*>(image.pixels + image.rowPitch * y);
+                for (size_t x = 0; x < image.width * pair.channels; ++x)
+                    row[x] = floatValue(rng);
+            }
+
+            check(Internal::CanConvertFast(pair.inFormat, pair.outFormat, TEX_FILTER_DEFAULT)
+                && matchesReference(image, pair.outFormat, TEX_FILTER_DEFAULT), pair.what);
+        }
+    }
+
+    void testNotFast()
+    {
+        const DXGI_FORMAT in = DXGI_FORMAT_R8G8B8A8_UNORM;
+        const DXGI_FORMAT out = DXGI_FORMAT_B8G8R8A8_UNORM;
+        check(Internal::CanConvertFast(in, out, TEX_FILTER_FORCE_NON_WIC), "FORCE_NON_WIC: fast kernel");
+        check(!Internal::CanConvertFast(in, out, TEX_FILTER_FORCE_WIC), "FORCE_WIC: no fast kernel");
+        check(!Internal::CanConvertFast(in, out, TEX_FILTER_DITHER), "DITHER: no fast kernel");
+        check(!Internal::CanConvertFast(in, out, TEX_FILTER_DITHER_DIFFUSION), "DITHER_DIFFUSION: no fast kernel");
+        check(!Internal::CanConvertFast(DXGI_FORMAT_R32G32B32A32_FLOAT, DXGI_FORMAT_R16G16B16A16_FLOAT, TEX_FILTER_SRGB),
+            "float to half with a color space change: no fast kernel");
+        check(!Internal::CanConvertFast(in, DXGI_FORMAT_R10G10B10A2_UNORM, TEX_FILTER_DEFAULT), "unlisted pair: no fast kernel");
+    }
+
+    void testStatusCallback()
+    {
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 64, 4096, 1, 1);
+        memset(source.GetPixels(), 0x5A, source.GetPixelsSize());
+        const Image& image = *source.GetImage(0, 0, 0);
+
+        ConvertOptions options = {};
+        options.filter = TEX_FILTER_DEFAULT;
+        options.threshold = TEX_THRESHOLD_DEFAULT;
+
+        std::vector<size_t> progress;
+        ScratchImage result;
+        const HRESULT hr = ConvertEx(image, DXGI_FORMAT_R16G16B16A16_FLOAT, options, result,
+            [&](size_t done, size_t total) -> bool
+            {
+                progress.push_back((total == image.height) ? done : SIZE_MAX);
+                return true;
+            });
+
+        bool ordered = progress.size() > 2;
+        for (size_t i = 1; ordered && i < progress.size(); ++i)
+            ordered = progress[i - 1] <= progress[i] && progress[i] <= image.height;
+        check(SUCCEEDED(hr), "status callback: converts");
+        check(ordered && progress.back() == image.height, "status callback: rows reported in bands, in order");
+
+        size_t calls = 0;
+        const HRESULT aborted = ConvertEx(image, DXGI_FORMAT_R16G16B16A16_FLOAT, options, result,
+            [&](size_t done, size_t) -> bool
+            {
+                ++calls;
+                return done == 0;
+            });
+        check(aborted == E_ABORT && calls > 1 && !result.GetPixels(), "status callback: returning false aborts");
+    }
+}
+
+int main()
+{
+    testTablePairs();
+    testFloatPairs();
+    testNotFast();
+    testStatusCallback();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("fast conversions match the scanline path\n");
+    return 0;
+}
@@ -0,0 +1,148 @@
+// Valid DDS files of random shape for the DDSParse fuzzer and benchmark: legacy RGBA8 and
+// DX10 headers, 1D/2D/3D, arrays, cubemaps and partial mip chains, with the exact payload size.
+
+#pragma once
+
+#include "DirectXTex.h"
+#include "DDSParse.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <vector>
+
+namespace DDSFiles
+{
+    using namespace DirectX;
+
+    inline void put(std::vector<uint8_t>& file, size_t offset, uint32_t value)
+    {
+        std::memcpy(file.data() + offset, &value, sizeof(value));
+    }
+
+    // Format for the layout: the DX10 one, or a rough legacy mapping (DXTn FourCCs and the RGB bit
+    // count) that is enough to size the payload of the files made here and of the repo textures
+    inline DXGI_FORMAT layoutFormat(const DDSParse::HeaderView& view)
+    {
+        if (view.dx10)
+            return view.format;
+
+        const uint32_t pfFlags = DDSParse::ReadU32(view.header, DDSParse::Field::pfFlags);
+        if (pfFlags & DDSParse::DDPF_FOURCC)
+        {
+            switch (DDSParse::ReadU32(view.header, DDSParse::Field::pfFourCC))
+            {
+            case 0x31545844: return DXGI_FORMAT_BC1_UNORM;  // "DXT1"
+            case 0x32545844:                                // "DXT2"
+            case 0x33545844: return DXGI_FORMAT_BC2_UNORM;  // "DXT3"
+            case 0x34545844:                                // "DXT4"
+            case 0x35545844: return DXGI_FORMAT_BC3_UNORM;  // "DXT5"
+            default:         return DXGI_FORMAT_UNKNOWN;
+            }
+        }
+
+        switch (DDSParse::ReadU32(view.header, DDSParse::Field::pfFourCC + 4))
+        {
+        case 8:  return DXGI_FORMAT_R8_UNORM;
+        case 16: return DXGI_FORMAT_R8G8_UNORM;
+        case 32: return DXGI_FORMAT_R8G8B8A8_UNORM;
+        case 64: return DXGI_FORMAT_R16G16B16A16_UNORM;
+        default: return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    inline std::vector<uint8_t> make(std::mt19937& rng, bool dx10)
+    {
+        static const DXGI_FORMAT formats[] = {
+            DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC7_UNORM, DXGI_FORMAT_R32G32B32A32_FLOAT,
+            DXGI_FORMAT_NV12, DXGI_FORMAT_YUY2, DXGI_FORMAT_NV11, DXGI_FORMAT_R1_UNORM, DXGI_FORMAT_BC5_UNORM, DXGI_FORMAT_R16_FLOAT,
+        };
+
+        uint32_t width = 1 + rng() % 64;
+        uint32_t height = 1 + rng() % 64;
+        uint32_t depth = 1;
+        uint32_t mipCount = rng() % 8;          // 0 means one level
+        uint32_t arraySize = dx10 ? 1 + rng() % 4 : 1;
+        DXGI_FORMAT format = dx10 ? formats[rng() % std::size(formats)] : DXGI_FORMAT_R8G8B8A8_UNORM;
+        uint32_t dimension = DDSParse::DIMENSION_TEXTURE2D;
+        uint32_t flags = 0x1007;                // DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT
+        bool cube = false;
+
+        switch (rng() % 4)
+        {
+        case 1:
+            dimension = DDSParse::DIMENSION_TEXTURE3D;
+            depth = 1 + rng() % 8;
+            flags |= DDSParse::DDSD_DEPTH;
+            arraySize = 1;
+            break;
+        case 2:
+            if (dx10)
+            {
+                dimension = DDSParse::DIMENSION_TEXTURE1D;
+                height = 1;
+            }
+            break;
+        case 3:
+            cube = true;
+            height = width;
+            break;
+        }
+
+        // Planar formats: 2D only, even sizes, no mips
+        if (format == DXGI_FORMAT_NV12 && (dimension != DDSParse::DIMENSION_TEXTURE2D || cube))
+            format = DXGI_FORMAT_R8G8B8A8_UNORM;
+        if (format == DXGI_FORMAT_NV12)
+        {
+            width = std::max<uint32_t>(2, width & ~1u);
+            height = std::max<uint32_t>(2, height & ~1u);
+            mipCount = 1;
+        }
+
+        // Sizes only: a payload too big to exist never fails the bounds checks
+        static const uint8_t anything = 0;
+        DDSParse::SubresourceLayout layout = {};
+        DDSParse::ComputeLayout(format, width, height, depth, std::max<uint32_t>(1, mipCount),
+            cube ? arraySize * 6 : arraySize, &anything, SIZE_MAX / 2, layout);
+
+        const size_t headerSize = dx10 ? DDSParse::DX10_FILE_SIZE : DDSParse::MIN_FILE_SIZE;
+        std::vector<uint8_t> file(headerSize + layout.totalSize);
+        for (size_t i = headerSize; i < file.size(); ++i)
+            file[i] = static_cast<uint8_t>(rng());
+
+        const size_t header = sizeof(uint32_t);
+        put(file, 0, DDSParse::MAGIC);
+        put(file, header + DDSParse::Field::size, DDSParse::HEADER_SIZE);
+        put(file, header + DDSParse::Field::flags, flags);
+        put(file, header + DDSParse::Field::height, height);
+        put(file, header + DDSParse::Field::width, width);
+        put(file, header + DDSParse::Field::depth, depth);
+        put(file, header + DDSParse::Field::mipMapCount, mipCount);
+        put(file, header + DDSParse::Field::pfSize, DDSParse::PIXELFORMAT_SIZE);
+
+        if (dx10)
+        {
+            put(file, header + DDSParse::Field::pfFlags, DDSParse::DDPF_FOURCC);
+            put(file, header + DDSParse::Field::pfFourCC, DDSParse::FOURCC_DX10);
+            put(file, DDSParse::MIN_FILE_SIZE + DDSParse::Field::dxgiFormat, format);
+            put(file, DDSParse::MIN_FILE_SIZE + DDSParse::Field::resourceDimension, dimension);
+            put(file, DDSParse::MIN_FILE_SIZE + DDSParse::Field::miscFlag, cube ? DDSParse::RESOURCE_MISC_TEXTURECUBE : 0);
+            put(file, DDSParse::MIN_FILE_SIZE + DDSParse::Field::arraySize, arraySize);
+        }
+        else
+        {
+            // DDPF_RGB | DDPF_ALPHAPIXELS, 32 bits, A8B8G8R8 masks
+            put(file, header + DDSParse::Field::pfFlags, 0x41);
+            put(file, header + 84, 32);
+            put(file, header + 88, 0x000000FF);
+            put(file, header + 92, 0x0000FF00);
+            put(file, header + 96, 0x00FF0000);
+            put(file, header + 100, 0xFF000000);
+            if (cube)
+                put(file, header + DDSParse::Field::caps2, DDSParse::DDSCAPS2_CUBEMAP | DDSParse::DDSCAPS2_CUBEMAP_ALLFACES);
+        }
+        return file;
+    }
+}
@@ -0,0 +1,81 @@
+// Header parsing throughput: DDSParse ParseHeader, with and without ComputeLayout, against
+// GetMetadataFromDDSMemory on the same generated files.
+// Usage: ddsparse_bench [files] (default 5000, each parsed 20 times)
+
+#include "ddsfiles.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int Repeats = 20;
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 5000;
+
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> files(count);
+    for (size_t i = 0; i < count; ++i)
+        files[i] = DDSFiles::make(rng, i & 1);
+
+    size_t headers = 0;
+    auto start = Clock::now();
+    for (int r = 0; r < Repeats; ++r)
+    {
+        for (const auto& file : files)
+        {
+            DDSParse::HeaderView view;
+            if (SUCCEEDED(DDSParse::ParseHeader(file.data(), file.size(), DDSParse::PARSE_NONE, view)))
+                ++headers;
+        }
+    }
+    const double headerSeconds = seconds(start);
+
+    size_t parsed = 0;
+    start = Clock::now();
+    for (int r = 0; r < Repeats; ++r)
+    {
+        for (const auto& file : files)
+        {
+            DDSParse::HeaderView view;
+            DDSParse::SubresourceLayout layout;
+            if (SUCCEEDED(DDSParse::ParseHeader(file.data(), file.size(), DDSParse::PARSE_NONE, view))
+                && SUCCEEDED(DDSParse::ComputeLayout(view, DDSFiles::layoutFormat(view), file.data() + view.dataOffset,
+                    file.size() - view.dataOffset, layout)))
+                ++parsed;
+        }
+    }
+    const double parseSeconds = seconds(start);
+
+    size_t metadataParsed = 0;
+    start = Clock::now();
+    for (int r = 0; r < Repeats; ++r)
+    {
+        for (const auto& file : files)
+        {
+            TexMetadata metadata;
+            if (SUCCEEDED(GetMetadataFromDDSMemory(file.data(), file.size(), DDS_FLAGS_NONE, metadata)))
+                ++metadataParsed;
+        }
+    }
+    const double metadataSeconds = seconds(start);
+
+    const double total = double(Repeats) * double(count);
+    std::printf("ParseHeader                  %10.0f files/s  (%zu of %.0f accepted)\n", total / headerSeconds, headers, total);
+    std::printf("ParseHeader + ComputeLayout  %10.0f files/s  (%zu of %.0f accepted)\n", total / parseSeconds, parsed, total);
+    std::printf("GetMetadataFromDDSMemory     %10.0f files/s  (%zu of %.0f accepted)\n", total / metadataSeconds, metadataParsed, total);
+    return (parsed == size_t(total)) ? 0 : 1;
+}
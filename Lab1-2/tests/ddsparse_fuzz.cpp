@@ -0,0 +1,174 @@
+// Fuzz target for DDSParse.h: any input either fails ParseHeader/ComputeLayout or yields a layout
+// whose every subresource lies inside the input. Built with -DDDSPARSE_LIBFUZZER it is a plain
+// libFuzzer target; otherwise main() mutates generated files and replays any files given on the
+// command line, which under AddressSanitizer catches reads past the end of the input.
+// Usage: ddsparse_fuzz [iterations | file...] (default 20000 iterations)
+
+#include "ddsfiles.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+using namespace DirectX;
+
+namespace
+{
+    // True when the input parses to a layout; aborts if that layout reaches outside the input
+    bool parseAndWalk(const uint8_t* data, size_t size)
+    {
+        uint32_t flags = DDSParse::PARSE_NONE;
+        if (size & 1)
+            flags |= DDSParse::PARSE_PERMISSIVE;
+        if (size & 2)
+            flags |= DDSParse::PARSE_IGNORE_MIPS;
+
+        DDSParse::HeaderView view;
+        if (FAILED(DDSParse::ParseHeader(data, size, flags, view)))
+            return false;
+
+        if (view.dataOffset > size)
+            std::abort();
+
+        DDSParse::SubresourceLayout layout;
+        if (FAILED(DDSParse::ComputeLayout(view, DDSFiles::layoutFormat(view), data + view.dataOffset, size - view.dataOffset, layout)))
+            return false;
+
+        if (layout.totalSize > size - view.dataOffset || layout.mipLevels > DDSParse::MAX_MIP_LEVELS)
+            std::abort();
+
+        // Touch the first and last byte of every subresource
+        volatile uint8_t sink = 0;
+        for (size_t item = 0; item < layout.arraySize; ++item)
+        {
+            for (size_t level = 0; level < layout.mipLevels; ++level)
+            {
+                const DDSParse::MipLayout& mip = layout.mips[level];
+                const size_t bytes = mip.slicePitch * mip.depth;
+                const uint8_t* pixels = layout.GetPixels(item, level);
+                if (pixels < data + view.dataOffset || size_t(pixels - data) + bytes > size)
+                    std::abort();
+                if (bytes)
+                    sink = sink + pixels[0] + pixels[bytes - 1];
+            }
+        }
+        return true;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    parseAndWalk(data, size);
+    return 0;
+}
+
+#ifndef DDSPARSE_LIBFUZZER
+
+namespace
+{
+    // Each input gets its own exact-size allocation so a read past the end is a heap overflow
+    bool runOne(const std::vector<uint8_t>& input)
+    {
+        auto copy = static_cast<uint8_t*>(std::malloc(input.empty() ? 1 : input.size()));
+        if (!copy)
+            return false;
+        std::memcpy(copy, input.data(), input.size());
+
+        const bool parsed = parseAndWalk(copy, input.size());
+        std::free(copy);
+        return parsed;
+    }
+
+    void mutate(std::vector<uint8_t>& file, std::mt19937& rng)
+    {
+        const int count = 1 + rng() % 8;
+        for (int i = 0; i < count; ++i)
+        {
+            switch (rng() % 4)
+            {
+            case 0:
+                // Flip a bit anywhere
+                file[rng() % file.size()] ^= static_cast<uint8_t>(1u << (rng() % 8));
+                break;
+            case 1:
+                {
+                    // Overwrite a header field, often with an extreme value
+                    const size_t offset = (rng() % 37) * 4;
+                    if (offset + 4 <= file.size())
+                        DDSFiles::put(file, offset, (rng() % 3) ? uint32_t(rng()) : 0xFFFFFFFFu);
+                }
+                break;
+            case 2:
+                // Truncate
+                file.resize(rng() % (file.size() + 1));
+                if (file.empty())
+                    file.push_back(0);
+                break;
+            case 3:
+                {
+                    // Small values in the DX10 header: format, dimension, misc flags, array size
+                    const size_t offset = DDSParse::MIN_FILE_SIZE + (rng() % 5) * 4;
+                    if (offset + 4 <= file.size())
+                        DDSFiles::put(file, offset, rng() % 200);
+                }
+                break;
+            }
+        }
+    }
+
+    bool readFile(const char* path, std::vector<uint8_t>& data)
+    {
+        FILE* file = std::fopen(path, "rb");
+        if (!file)
+            return false;
+        uint8_t buffer[65536];
+        size_t read;
+        while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+            data.insert(data.end(), buffer, buffer + read);
+        std::fclose(file);
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    char* end = nullptr;
+    const long iterations = (argc > 1) ? std::strtol(argv[1], &end, 10) : 20000;
+
+    // Replay mode for crash reproducers and corpus files
+    if (argc > 1 && *end)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::vector<uint8_t> data;
+            if (!readFile(argv[i], data))
+            {
+                std::printf("could not read %s\n", argv[i]);
+                return 1;
+            }
+            std::printf("%s: %s\n", argv[i], runOne(data) ? "parsed" : "rejected");
+        }
+        return 0;
+    }
+
+    std::mt19937 rng(1234);
+    long accepted = 0;
+    for (long i = 0; i < iterations; ++i)
+    {
+        std::vector<uint8_t> file = DDSFiles::make(rng, rng() & 1);
+
+        // Generated files are well formed (a permissive parse included), so they must be accepted
+        if (!runOne(file))
+        {
+            std::printf("FAIL valid file rejected at iteration %ld\n", i);
+            return 1;
+        }
+
+        mutate(file, rng);
+        accepted += runOne(file);
+    }
+
+    std::printf("%ld mutated files, %ld parsed, no read outside the input\n", iterations, accepted);
+    return 0;
+}
+
+#endif
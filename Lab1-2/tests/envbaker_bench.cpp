@@ -0,0 +1,59 @@
+// Baking time of EnvironmentBaker for 512-2048 faces on all hardware threads.
+// Usage: envbaker_bench [faceSize...] (default 512 1024 2048)
+
+#include "EnvironmentBaker.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+int main(int argc, char** argv)
+{
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i)
+        sizes.push_back(std::strtoul(argv[i], nullptr, 10));
+    if (sizes.empty())
+        sizes = { 512, 1024, 2048 };
+
+    ThreadPool pool;
+    std::printf("%u threads, 64 samples per texel\n", std::thread::hardware_concurrency());
+
+    for (const size_t faceSize : sizes)
+    {
+        // Panorama at the resolution a face of this size resolves
+        const size_t width = faceSize * 4;
+        const size_t height = faceSize * 2;
+        std::vector<XMFLOAT4> pixels(width * height);
+        std::mt19937 rng(1);
+        for (auto& p : pixels)
+        {
+            const float v = float(rng() % 1024) / 256.0f;
+            p = XMFLOAT4(v, v * 0.8f, v * 0.6f, 1.0f);
+        }
+        const Image panorama = { width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, width * sizeof(XMFLOAT4),
+            width * height * sizeof(XMFLOAT4), reinterpret_cast<uint8_t*>(pixels.data()) };
+
+        EnvironmentBaker::Options options;
+        options.faceSize = faceSize;
+        options.pool = &pool;
+
+        ScratchImage cube;
+        EnvironmentBaker::SH9 sh;
+        const auto start = std::chrono::steady_clock::now();
+        const HRESULT hr = EnvironmentBaker::bake(panorama, options, cube, &sh);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (FAILED(hr))
+        {
+            std::printf("%4zu: bake failed %08x\n", faceSize, static_cast<unsigned>(hr));
+            return 1;
+        }
+
+        std::printf("%4zu face, %zu mips: %9.1f ms\n", faceSize, cube.GetMetadata().mipLevels, ms);
+    }
+    return 0;
+}
@@ -0,0 +1,222 @@
+// EnvironmentBaker: a constant environment bakes to itself, the prefiltered mips keep the
+// environment's energy, SH irradiance matches the analytic values and threading doesn't change the result.
+
+#include "EnvironmentBaker.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct Panorama
+    {
+        std::vector<XMFLOAT4> pixels;
+        Image image;
+
+        Panorama(size_t width, size_t height) : pixels(width * height)
+        {
+            image = { width, height, DXGI_FORMAT_R32G32B32A32_FLOAT, width * sizeof(XMFLOAT4), width * height * sizeof(XMFLOAT4),
+                reinterpret_cast<uint8_t*>(pixels.data()) };
+        }
+
+        XMFLOAT4& at(size_t x, size_t y) { return pixels[y * image.width + x]; }
+    };
+
+    float areaElement(float x, float y)
+    {
+        return atan2f(x * y, sqrtf(x * x + y * y + 1.0f));
+    }
+
+    // Radiance of one channel integrated over the sphere, texels weighted by their solid angle
+    double integrate(const ScratchImage& cube, size_t mip, size_t channel)
+    {
+        double sum = 0.0;
+        for (size_t face = 0; face < 6; ++face)
+        {
+            const Image* image = cube.GetImage(mip, face, 0);
+            const float texel = 2.0f / float(image->width);
+            for (size_t y = 0; y < image->height; ++y)
+            {
+                const float* row = reinterpret_cast<const float*>(image->pixels + image->rowPitch * y);
+                const float v0 = -1.0f + texel * float(y);
+                for (size_t x = 0; x < image->width; ++x)
+                {
+                    const float u0 = -1.0f + texel * float(x);
+                    const float solidAngle = areaElement(u0, v0) - areaElement(u0, v0 + texel)
+                        - areaElement(u0 + texel, v0) + areaElement(u0 + texel, v0 + texel);
+                    sum += double(row[x * 4 + channel]) * solidAngle;
+                }
+            }
+        }
+        return sum;
+    }
+
+    float irradiance(const EnvironmentBaker::SH9& sh, float x, float y, float z, size_t channel = 0)
+    {
+        XMFLOAT4 e;
+        XMStoreFloat4(&e, sh.irradiance(XMVectorSet(x, y, z, 0.0f)));
+        return (&e.x)[channel];
+    }
+
+    EnvironmentBaker::Options options(size_t faceSize, ThreadPool* pool)
+    {
+        EnvironmentBaker::Options o;
+        o.faceSize = faceSize;
+        o.sampleCount = 64;
+        o.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        o.pool = pool;
+        return o;
+    }
+
+    void testConstant(ThreadPool& pool)
+    {
+        Panorama pano(128, 64);
+        for (auto& p : pano.pixels)
+            p = XMFLOAT4(0.7f, 1.3f, 2.0f, 1.0f);
+
+        ScratchImage cube;
+        EnvironmentBaker::SH9 sh;
+        check(SUCCEEDED(EnvironmentBaker::bake(pano.image, options(32, &pool), cube, &sh)), "constant: bake");
+        check(cube.GetMetadata().mipLevels == 6 && cube.GetMetadata().IsCubemap(), "constant: full cubemap mip chain");
+
+        float maxError = 0.0f;
+        for (size_t i = 0; i < cube.GetImageCount(); ++i)
+        {
+            const Image& image = cube.GetImages()[i];
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                const float* row = reinterpret_cast<const float*>(image.pixels + image.rowPitch * y);
+                for (size_t x = 0; x < image.width; ++x)
+                {
+                    maxError = std::max({ maxError, fabsf(row[x * 4] - 0.7f), fabsf(row[x * 4 + 1] - 1.3f), fabsf(row[x * 4 + 2] - 2.0f) });
+                }
+            }
+        }
+        check(maxError < 1e-4f, "constant: every mip keeps the constant radiance");
+
+        // E = pi * L for a constant environment, whatever the normal
+        check(fabsf(irradiance(sh, 0.3f, 0.5f, -0.8f, 1) - XM_PI * 1.3f) < 1e-2f, "constant: SH irradiance is pi * L");
+    }
+
+    void testHemisphere(ThreadPool& pool)
+    {
+        // Upper hemisphere 1, lower 0
+        Panorama pano(256, 128);
+        for (size_t y = 0; y < 128; ++y)
+        {
+            for (size_t x = 0; x < 256; ++x)
+            {
+                const float v = y < 64 ? 1.0f : 0.0f;
+                pano.at(x, y) = XMFLOAT4(v, v, v, 1.0f);
+            }
+        }
+
+        ScratchImage cube;
+        EnvironmentBaker::SH9 sh;
+        check(SUCCEEDED(EnvironmentBaker::bake(pano.image, options(64, &pool), cube, &sh)), "hemisphere: bake");
+
+        // Prefiltering only moves energy around: every mip integrates to 2 pi
+        const size_t mips = cube.GetMetadata().mipLevels;
+        for (size_t mip = 0; mip < mips; ++mip)
+        {
+            const double energy = integrate(cube, mip, 0);
+            if (fabs(energy / (2.0 * XM_PI) - 1.0) > 0.02)
+            {
+                std::printf("  mip %zu: %.4f of the environment's energy\n", mip, energy / (2.0 * XM_PI));
+                check(false, "hemisphere: prefiltered mip conserves energy");
+            }
+        }
+
+        // Analytic irradiance: pi facing up, 0 facing down, pi / 2 at the horizon (SH9 rings a little)
+        check(fabsf(irradiance(sh, 1, 0, 0) / XM_PI - 0.5f) < 0.02f, "hemisphere: horizon irradiance");
+        check(irradiance(sh, 0, 1, 0) / XM_PI > 0.9f, "hemisphere: upward irradiance");
+        check(irradiance(sh, 0, -1, 0) / XM_PI < 0.1f, "hemisphere: downward irradiance");
+
+        // Face order: +Y (2) looks at the bright half, -Y (3) at the dark one
+        const Image* up = cube.GetImage(0, 2, 0);
+        const Image* down = cube.GetImage(0, 3, 0);
+        check(reinterpret_cast<const float*>(up->pixels + up->rowPitch * 32)[32 * 4] == 1.0f, "hemisphere: +Y face");
+        check(reinterpret_cast<const float*>(down->pixels + down->rowPitch * 32)[32 * 4] == 0.0f, "hemisphere: -Y face");
+    }
+
+    void testSun(ThreadPool& pool)
+    {
+        // A small bright patch on a dim sky: the case where a lossy prefilter shows up most
+        Panorama pano(256, 128);
+        for (size_t y = 0; y < 128; ++y)
+        {
+            for (size_t x = 0; x < 256; ++x)
+            {
+                const bool sun = x >= 100 && x < 106 && y >= 30 && y < 36;
+                const float v = sun ? 500.0f : 0.05f;
+                pano.at(x, y) = XMFLOAT4(v, v, v, 1.0f);
+            }
+        }
+
+        ScratchImage cube;
+        check(SUCCEEDED(EnvironmentBaker::bake(pano.image, options(128, &pool), cube, nullptr)), "sun: bake");
+
+        // Down to 8x8: on coarser mips a texel sum no longer integrates the blurred sun accurately
+        const double base = integrate(cube, 0, 0);
+        for (size_t mip = 1; cube.GetMetadata().width >> mip >= 8; ++mip)
+        {
+            const double ratio = integrate(cube, mip, 0) / base;
+            if (fabs(ratio - 1.0) > 0.05)
+            {
+                std::printf("  mip %zu: %.4f of mip 0's energy\n", mip, ratio);
+                check(false, "sun: prefiltered mip conserves energy");
+            }
+        }
+    }
+
+    void testThreadingIsDeterministic(ThreadPool& pool)
+    {
+        Panorama pano(128, 64);
+        for (size_t y = 0; y < 64; ++y)
+        {
+            for (size_t x = 0; x < 128; ++x)
+                pano.at(x, y) = XMFLOAT4(float(x % 7), float(y % 5) * 0.5f, float((x * y) % 11) * 0.1f, 1.0f);
+        }
+
+        ScratchImage threaded, serial;
+        EnvironmentBaker::SH9 shThreaded, shSerial;
+        EnvironmentBaker::bake(pano.image, options(32, &pool), threaded, &shThreaded);
+        EnvironmentBaker::bake(pano.image, options(32, nullptr), serial, &shSerial);
+        check(threaded.GetPixelsSize() == serial.GetPixelsSize()
+            && std::memcmp(threaded.GetPixels(), serial.GetPixels(), serial.GetPixelsSize()) == 0, "threading: cubemaps match");
+        check(std::memcmp(shThreaded.coeffs, shSerial.coeffs, sizeof(shSerial.coeffs)) == 0, "threading: SH matches");
+    }
+}
+
+int main()
+{
+    ThreadPool pool(3);
+
+    testConstant(pool);
+    testHemisphere(pool);
+    testSun(pool);
+    testThreadingIsDeterministic(pool);
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("environment baking conserves energy\n");
+    return 0;
+}
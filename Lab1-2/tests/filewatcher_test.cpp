@@ -0,0 +1,162 @@
+// FileWatcher: changes found by scan(), creation of a missing file, saving through a rename,
+// a burst of writes settling into one report, and edits made while the inotify queue overflowed.
+
+#include "FileWatcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    const std::string Dir = "build/filewatcher_files";
+
+    void writeFile(const std::string& path, const std::string& contents)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    void sleepMs(int ms)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    std::vector<std::string> scanAndPoll(FileWatcher& watcher)
+    {
+        std::vector<std::string> changed;
+        watcher.scan();
+        watcher.poll(changed);
+        return changed;
+    }
+
+    void testScan()
+    {
+        const std::string a = Dir + "/a.h";
+        const std::string missing = Dir + "/missing.h";
+        writeFile(a, "struct S {};\n");
+
+        FileWatcher watcher(std::chrono::milliseconds(20), std::chrono::milliseconds(0));
+        std::printf("native events: %s\n", watcher.usesNativeEvents() ? "inotify" : "no, polling");
+        watcher.watch(a);
+        watcher.watch(a);
+        watcher.watch(missing);
+        check(watcher.watchedCount() == 2, "scan: watching twice is a no-op");
+        check(scanAndPoll(watcher).empty(), "scan: nothing changed yet");
+
+        // Past the file clock's resolution for the polling fallback
+        sleepMs(20);
+        writeFile(a, "struct S { int x; };\n");
+        check(scanAndPoll(watcher) == std::vector<std::string>{ a }, "scan: write reported with the path as given");
+        check(scanAndPoll(watcher).empty(), "scan: reported once");
+
+        writeFile(missing, "x");
+        check(scanAndPoll(watcher) == std::vector<std::string>{ missing }, "scan: creating a missing file");
+
+        // Editors that save to a temporary and rename it over the original
+        writeFile(Dir + "/a.h.swp", "new contents\n");
+        scanAndPoll(watcher);
+        std::filesystem::rename(Dir + "/a.h.swp", a);
+        check(scanAndPoll(watcher) == std::vector<std::string>{ a }, "scan: rename over the file");
+    }
+
+    void testSettle()
+    {
+        const std::string b = Dir + "/b.h";
+        writeFile(b, "//\n");
+
+        FileWatcher watcher(std::chrono::milliseconds(10), std::chrono::milliseconds(80));
+        watcher.watch(b);
+        watcher.start();
+        for (int i = 0; i < 5; ++i)
+        {
+            writeFile(b, "// " + std::to_string(i) + "\n");
+            sleepMs(15);
+        }
+
+        std::vector<std::string> changed;
+        for (int i = 0; i < 300 && changed.empty(); ++i)
+        {
+            sleepMs(10);
+            watcher.poll(changed);
+        }
+        sleepMs(200);
+        watcher.poll(changed);
+        check(changed.size() == 1, "settle: a burst of writes is one change");
+
+        watcher.stop();
+        watcher.stop();
+    }
+
+    size_t maxQueuedEvents()
+    {
+        size_t value = 16384;
+        std::ifstream("/proc/sys/fs/inotify/max_queued_events") >> value;
+        return value;
+    }
+
+    void testOverflow()
+    {
+        const std::string c = Dir + "/c.h";
+        const std::string d = Dir + "/d.h";
+        writeFile(c, "//\n");
+        writeFile(d, "//\n");
+
+        FileWatcher watcher(std::chrono::milliseconds(20), std::chrono::milliseconds(0));
+        if (!watcher.usesNativeEvents())
+        {
+            std::printf("overflow: skipped, no inotify\n");
+            return;
+        }
+        watcher.watch(c);
+        watcher.watch(d);
+
+        // Fill the queue with events of other files (create, close, delete), then edit c.h: its events are dropped
+        const size_t files = maxQueuedEvents() / 3 + 100;
+        for (size_t i = 0; i < files; ++i)
+        {
+            const std::string junk = Dir + "/junk" + std::to_string(i % 16);
+            writeFile(junk, "");
+            std::filesystem::remove(junk);
+        }
+        writeFile(c, "// edited while the queue was full\n");
+
+        check(scanAndPoll(watcher) == std::vector<std::string>{ c }, "overflow: the lost edit is found, untouched files aren't");
+        check(scanAndPoll(watcher).empty(), "overflow: reported once");
+
+        writeFile(d, "// edited after\n");
+        check(scanAndPoll(watcher) == std::vector<std::string>{ d }, "overflow: events arrive again afterwards");
+    }
+}
+
+int main()
+{
+    std::filesystem::remove_all(Dir);
+    std::filesystem::create_directories(Dir);
+
+    testScan();
+    testSettle();
+    testOverflow();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("file watcher ok\n");
+    return 0;
+}
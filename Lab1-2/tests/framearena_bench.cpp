@@ -0,0 +1,198 @@
+// Heap allocations per frame of the frame's transient data, std::vector against FrameArena, with
+// the simulation on a FramePipeline worker as in Render; counted by replacing operator new. Also
+// the cost of FrameArenas::local().
+// Usage: framearena_bench [frames] (default 20000)
+
+#include "FrameArena.h"
+#include "FramePipeline.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    std::atomic<uint64_t> g_allocations{ 0 };
+}
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const int Warmup = 100;
+    const int Instances = 20;
+
+    struct Float3
+    {
+        float x, y, z;
+    };
+
+    struct Float4
+    {
+        float x, y, z, w;
+    };
+
+    struct alignas(16) Instance
+    {
+        float model[16];
+        float normal[16];
+        Float4 params;
+        Float4 uv;
+    };
+
+    struct Input
+    {
+        int frame = 0;
+    };
+
+    struct Snapshot
+    {
+        std::vector<Float4> frustum;
+        std::vector<Instance> instances;
+    };
+
+    // Like Render::calcFrustum: scratch corner vectors, planes into the snapshot
+    template <typename Vector>
+    void calcFrustum(std::vector<Float4>& frustum, Vector near, Vector far, int frame)
+    {
+        near.resize(4);
+        far.resize(4);
+        for (int i = 0; i < 4; ++i)
+        {
+            near[i] = { (float)i, (float)frame, 1.0f };
+            far[i] = { (float)-i, 2.0f, (float)frame };
+        }
+        frustum.resize(6);
+        for (int i = 0; i < 6; ++i)
+            frustum[i] = { near[i % 4].x, far[i % 4].y, 0.0f, 1.0f };
+    }
+
+    template <bool UseArena>
+    void run(const char* name, int frames)
+    {
+        FrameArenas arenas;
+        FramePipeline<Input, Snapshot> pipeline([&](const Input& input, Snapshot& snapshot)
+            {
+                if (UseArena)
+                {
+                    FrameArena& arena = arenas.local();
+                    calcFrustum(snapshot.frustum, ArenaVector<Float3>(arena), ArenaVector<Float3>(arena), input.frame);
+                    arena.reset();
+                }
+                else
+                {
+                    calcFrustum(snapshot.frustum, std::vector<Float3>(), std::vector<Float3>(), input.frame);
+                }
+                snapshot.instances.resize(Instances);
+                for (int i = 0; i < Instances; ++i)
+                    snapshot.instances[i].params.w = (float)((i + input.frame) % 3 != 0);
+            });
+
+        uint64_t sink = 0;
+        uint64_t allocations = 0;
+        Clock::time_point start;
+        Input input;
+        for (int frame = 0; frame < Warmup + frames; ++frame)
+        {
+            if (frame == Warmup)
+            {
+                allocations = g_allocations.load();
+                start = Clock::now();
+            }
+            if (pipeline.pending() == 0)
+            {
+                pipeline.submit(input);
+                ++input.frame;
+            }
+            const Snapshot& snapshot = pipeline.acquire();
+            pipeline.submit(input);
+            ++input.frame;
+
+            // Render thread: the visible instances compacted for the upload
+            if (UseArena)
+            {
+                FrameArena& arena = arenas.local();
+                ArenaVector<Instance> visible(arena);
+                for (const Instance& instance : snapshot.instances)
+                {
+                    if (instance.params.w != 0.0f)
+                        visible.push_back(instance);
+                }
+                sink += visible.size() + snapshot.frustum.size();
+                arena.reset();
+            }
+            else
+            {
+                std::vector<Instance> visible;
+                for (const Instance& instance : snapshot.instances)
+                {
+                    if (instance.params.w != 0.0f)
+                        visible.push_back(instance);
+                }
+                sink += visible.size() + snapshot.frustum.size();
+            }
+        }
+        allocations = g_allocations.load() - allocations;
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / frames;
+
+        std::printf("%-12s %5.2f allocations/frame, %.2f us/frame", name, (double)allocations / frames, us);
+        if (UseArena)
+        {
+            const FrameArenas::Stats stats = arenas.stats();
+            std::printf(", %zu arenas, peak %zu B, %llu blocks", stats.threads, stats.peak, (unsigned long long)stats.heapAllocations);
+        }
+        std::printf("  (%llu)\n", (unsigned long long)(sink & 1));
+    }
+
+    void lookups()
+    {
+        const int count = 10000000;
+        FrameArenas arenas;
+        FrameArenas other;
+        size_t sink = 0;
+
+        auto start = Clock::now();
+        for (int i = 0; i < count; ++i)
+            sink += reinterpret_cast<uintptr_t>(&arenas.local()) & 1;
+        const double cachedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+        // Alternating defeats the per-thread cache, every call takes the lock
+        start = Clock::now();
+        for (int i = 0; i < count; ++i)
+            sink += reinterpret_cast<uintptr_t>(&((i & 1) ? other : arenas).local()) & 1;
+        const double lockedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+
+        std::printf("local(): %.2f ns cached, %.2f ns alternating between two FrameArenas  (%zu)\n", cachedNs, lockedNs, sink & 1);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int frames = (argc > 1) ? std::atoi(argv[1]) : 20000;
+    run<false>("std::vector", frames);
+    run<true>("FrameArena", frames);
+    lookups();
+    return 0;
+}
@@ -0,0 +1,175 @@
+// FrameArena and FrameArenas: alignment, growing past a block and merging on reset, a steady
+// frame no longer touching the heap, arena-backed containers, and one arena per thread,
+// looked up again from each thread and from several FrameArenas. Meant to run under TSan.
+
+#include "FrameArena.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct alignas(16) Matrix
+    {
+        float m[16];
+    };
+
+    bool aligned(const void* p, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+    }
+
+    void testArena()
+    {
+        FrameArena arena(1024);
+        void* a = arena.allocate(10, 1);
+        void* b = arena.allocate(16, 16);
+        void* c = arena.allocate(64, 64);
+        check(aligned(b, 16) && aligned(c, 64) && static_cast<char*>(b) >= static_cast<char*>(a) + 10, "arena: aligned, no overlap");
+        check(arena.heapAllocations() == 1, "arena: one block");
+
+        // Past the block into a second one, merged into one on reset
+        std::memset(arena.allocate(5000, 8), 1, 5000);
+        check(arena.heapAllocations() == 2, "arena: grows by a block");
+        const size_t used = arena.used();
+        arena.reset();
+        check(arena.used() == 0 && arena.peak() == used, "reset: used cleared, peak kept");
+        check(arena.heapAllocations() == 3 && arena.capacity() >= 1024 + 5000, "reset: blocks merged");
+
+        // The same frame fits from now on
+        const size_t capacity = arena.capacity();
+        for (int frame = 0; frame < 100; ++frame)
+        {
+            arena.allocate(10, 1);
+            arena.allocate(16, 16);
+            arena.allocate(64, 64);
+            std::memset(arena.allocate(5000, 8), 2, 5000);
+            arena.reset();
+        }
+        check(arena.heapAllocations() == 3 && arena.capacity() == capacity, "steady frames: no heap");
+    }
+
+    void testContainers()
+    {
+        FrameArena arena(256);
+        ArenaVector<Matrix> matrices(arena);
+        for (int i = 0; i < 100; ++i)
+        {
+            Matrix m;
+            m.m[0] = (float)i;
+            matrices.push_back(m);
+        }
+        bool ok = true;
+        for (int i = 0; i < 100; ++i)
+            ok = ok && matrices[i].m[0] == i && aligned(&matrices[i], 16);
+        check(ok, "containers: contents kept and over-aligned type aligned while growing");
+
+        ArenaVector<int> values(arena);
+        values.assign(1000, 7);
+        ArenaVector<int> copy(values);
+        check(copy.get_allocator() == values.get_allocator() && copy[999] == 7, "containers: copies share the arena");
+
+        std::pair<ArenaVector<float>, ArenaVector<float>> pair(arena, arena);
+        pair.first.resize(4);
+        pair.second.resize(4);
+        check(pair.first.get_allocator().arena() == &arena, "containers: taken implicitly");
+    }
+
+    void testPerThread()
+    {
+        FrameArenas arenas(4096);
+        std::atomic<bool> go{ false };
+        std::atomic<int> bad{ 0 };
+        FrameArena* seen[4] = {};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&, t]()
+                {
+                    while (!go)
+                        std::this_thread::yield();
+                    FrameArena& arena = arenas.local();
+                    seen[t] = &arena;
+                    for (int frame = 0; frame < 2000; ++frame)
+                    {
+                        if (&arenas.local() != &arena)
+                            ++bad;
+                        ArenaVector<int> values(arena);
+                        values.resize(100 + t * 50, t);
+                        for (int value : values)
+                        {
+                            if (value != t)
+                                ++bad;
+                        }
+                        arena.reset();
+                        if (frame % 100 == 0)
+                            arenas.stats();
+                    }
+                });
+        }
+        go = true;
+        for (std::thread& thread : threads)
+            thread.join();
+
+        bool distinct = true;
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int j = i + 1; j < 4; ++j)
+                distinct = distinct && seen[i] != seen[j];
+        }
+        const FrameArenas::Stats s = arenas.stats();
+        check(bad == 0, "per thread: the same arena every time, contents intact");
+        check(distinct && s.threads == 4 && s.heapAllocations == 4, "per thread: one arena and one block each");
+    }
+
+    void testSeveralInstances()
+    {
+        // The per-thread cache must not hand out another instance's arena, also at a reused address
+        FrameArenas first;
+        FrameArenas second;
+        FrameArena& a = first.local();
+        FrameArena& b = second.local();
+        check(&a != &b && &first.local() == &a && &second.local() == &b, "instances: each has its own arena");
+
+        for (int i = 0; i < 10; ++i)
+        {
+            auto pArenas = std::make_unique<FrameArenas>();
+            FrameArena& arena = pArenas->local();
+            arena.allocate(16, 16);
+            check(&pArenas->local() == &arena && pArenas->stats().threads == 1, "instances: a new one at an old address starts empty");
+        }
+    }
+}
+
+int main()
+{
+    testArena();
+    testContainers();
+    testPerThread();
+    testSeveralInstances();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("frame arena ok\n");
+    return 0;
+}
@@ -0,0 +1,223 @@
+// FramePacer on a virtual clock: frame rate and jitter with a noisy or coarse OS timer, the sleep
+// slack adapting, idle throttling, hitches, an unlimited rate and overload. Ends with a short run
+// on the real clock.
+
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    const double Period60 = 1000.0 / 60.0;
+
+    // sleep() overshoots like an OS timer, optionally rounded up to a timer quantum; a spin step costs 1 us
+    class VirtualTime : public FramePacer::TimeSource
+    {
+    public:
+        double now() override { return t; }
+
+        void sleep(double seconds) override
+        {
+            double wake = t + seconds;
+            if (quantum > 0.0)
+                wake = std::ceil(wake / quantum) * quantum;
+            std::normal_distribution<double> oversleep(oversleepMean, oversleepJitter);
+            t = wake + std::max(0.0, oversleep(rng));
+        }
+
+        void spin() override
+        {
+            t += 1e-6;
+            spun += 1e-6;
+        }
+
+        double t = 100.0;
+        double quantum = 0.0;
+        double oversleepMean = 0.001;
+        double oversleepJitter = 0.0005;
+        double spun = 0.0;
+        std::mt19937 rng{ 1 };
+    };
+
+    struct Result
+    {
+        double averageMs;
+        double jitterMs;
+        double spunMsPerFrame;
+        double slackMs;
+        uint64_t missed;
+    };
+
+    // frames frames of work seconds each
+    Result run(VirtualTime& time, FramePacer& pacer, int frames, double work)
+    {
+        const double spun = time.spun;
+        for (int i = 0; i < frames; ++i)
+        {
+            time.t += work;
+            pacer.waitForNextFrame();
+        }
+        const FramePacer::Stats& s = pacer.stats();
+        return { s.averageMs, s.jitterMs, (time.spun - spun) * 1000.0 / frames, s.sleepSlackMs, s.missedFrames };
+    }
+
+    void print(const char* name, const Result& r)
+    {
+        std::printf("%-22s avg %7.3f ms, jitter %.4f ms, spin %.3f ms/frame, slack %.3f ms, missed %llu\n",
+            name, r.averageMs, r.jitterMs, r.spunMsPerFrame, r.slackMs, (unsigned long long)r.missed);
+    }
+
+    void testSteady()
+    {
+        // 60 fps, 5 ms of work, 1 +- 0.5 ms oversleep
+        VirtualTime time;
+        FramePacer pacer(FramePacer::Options(), &time);
+        run(time, pacer, 300, 0.005);
+        const Result r = run(time, pacer, 600, 0.005);
+        print("60 fps", r);
+        check(std::fabs(r.averageMs - Period60) < 0.01 && r.jitterMs < 0.01, "steady: on rate, no jitter");
+        check(r.spunMsPerFrame < 3.0 && r.missed == 0, "steady: little spinning, no missed frames");
+        std::printf("CPU share of the frame: %.1f%% (a busy loop: 100%%)\n", (5.0 + r.spunMsPerFrame) / r.averageMs * 100.0);
+    }
+
+    void testCoarseTimer()
+    {
+        // Sleeps rounded up to 15.625 ms, the default Windows timer resolution
+        VirtualTime time;
+        time.quantum = 0.015625;
+        time.oversleepMean = 0.0002;
+        time.oversleepJitter = 0.0001;
+        FramePacer pacer(FramePacer::Options(), &time);
+        run(time, pacer, 300, 0.004);
+        const Result r = run(time, pacer, 600, 0.004);
+        print("coarse timer", r);
+        check(std::fabs(r.averageMs - Period60) < 0.05, "coarse timer: on rate");
+    }
+
+    void testPreciseTimer()
+    {
+        VirtualTime time;
+        time.oversleepMean = 0.0001;
+        time.oversleepJitter = 0.00002;
+        FramePacer pacer(FramePacer::Options(), &time);
+        const Result r = run(time, pacer, 600, 0.005);
+        print("precise timer", r);
+        check(r.slackMs < 0.3 && r.spunMsPerFrame < 0.3, "precise timer: slack adapts down");
+    }
+
+    void testIdle()
+    {
+        VirtualTime time;
+        FramePacer pacer(FramePacer::Options(), &time);
+        run(time, pacer, 60, 0.002);
+
+        pacer.setActivity(false, false);
+        check(pacer.shouldRender(), "idle: unfocused still renders");
+        const double start = time.t;
+        run(time, pacer, 20, 0.002);
+        const double msPerFrame = (time.t - start) / 20 * 1000.0;
+        std::printf("unfocused              %.2f ms/frame\n", msPerFrame);
+        check(std::fabs(msPerFrame - 100.0) < 6.0 && pacer.stats().idle, "idle: unfocused runs at the idle rate");
+
+        pacer.setActivity(true, false);
+        check(!pacer.shouldRender(), "idle: minimized doesn't render");
+
+        pacer.setThrottleWhenUnfocused(false);
+        pacer.setActivity(false, false);
+        run(time, pacer, 60, 0.002);
+        run(time, pacer, 60, 0.002);
+        check(std::fabs(pacer.stats().averageMs - Period60) < 0.05 && !pacer.stats().idle, "idle: throttling can be turned off");
+    }
+
+    void testHitch()
+    {
+        // A 200 ms stall doesn't cause a burst of catch-up frames
+        VirtualTime time;
+        FramePacer pacer(FramePacer::Options(), &time);
+        run(time, pacer, 60, 0.002);
+        time.t += 0.2;
+        pacer.waitForNextFrame();
+        check(pacer.stats().missedFrames == 1, "hitch: one missed frame");
+
+        double previous = time.t;
+        double minGap = 1.0;
+        for (int i = 0; i < 10; ++i)
+        {
+            time.t += 0.002;
+            pacer.waitForNextFrame();
+            minGap = std::min(minGap, time.t - previous);
+            previous = time.t;
+        }
+        check(minGap > 0.016, "hitch: the schedule restarts, no catch-up");
+    }
+
+    void testUnlimited()
+    {
+        VirtualTime time;
+        FramePacer::Options options;
+        options.targetFps = 0.0;
+        FramePacer pacer(options, &time);
+        const Result r = run(time, pacer, 100, 0.003);
+        check(std::fabs(r.averageMs - 3.0) < 1e-6 && r.spunMsPerFrame == 0.0, "unlimited: never waits");
+
+        pacer.setActivity(false, false);
+        run(time, pacer, 5, 0.003);
+        run(time, pacer, 5, 0.003);
+        check(pacer.stats().maxMs > 90.0, "unlimited: still idles when unfocused");
+    }
+
+    void testOverload()
+    {
+        // Work longer than the period: flat out, every frame missed
+        VirtualTime time;
+        FramePacer pacer(FramePacer::Options(), &time);
+        const Result r = run(time, pacer, 100, 0.025);
+        print("overloaded", r);
+        check(std::fabs(r.averageMs - 25.0) < 0.01 && r.missed >= 99, "overload: runs flat out, frames counted as missed");
+    }
+
+    void reportRealClock()
+    {
+        FramePacer pacer;
+        const double start = FramePacer::systemTime().now();
+        for (int i = 0; i < 30; ++i)
+            pacer.waitForNextFrame();
+        const FramePacer::Stats& s = pacer.stats();
+        std::printf("real clock: 30 frames in %.1f ms, avg %.3f ms, jitter %.3f ms, slack %.3f ms\n",
+            (FramePacer::systemTime().now() - start) * 1000.0, s.averageMs, s.jitterMs, s.sleepSlackMs);
+    }
+}
+
+int main()
+{
+    testSteady();
+    testCoarseTimer();
+    testPreciseTimer();
+    testIdle();
+    testHitch();
+    testUnlimited();
+    testOverload();
+    reportRealClock();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("frame pacer ok\n");
+    return 0;
+}
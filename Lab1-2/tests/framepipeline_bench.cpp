@@ -0,0 +1,88 @@
+// FramePipeline throughput: the cost of the handoff alone, and frame time with a busy simulation
+// step and a render thread that blocks (Present, the GPU wait), serial against pipelined.
+// Usage: framepipeline_bench [handoff frames] (default 200000)
+
+#include "FramePipeline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Input
+    {
+        int frame = 0;
+    };
+
+    struct Snapshot
+    {
+        int frame = 0;
+        std::vector<float> data;
+    };
+
+    void busy(double ms)
+    {
+        const auto end = Clock::now() + std::chrono::duration<double, std::milli>(ms);
+        while (Clock::now() < end)
+        {
+        }
+    }
+
+    // Seconds for frames frames, driven the way Render::update drives it
+    double run(bool pipelined, double simulateMs, double renderMs, int frames)
+    {
+        FramePipeline<Input, Snapshot> pipeline([simulateMs](const Input& input, Snapshot& snapshot)
+            {
+                snapshot.frame = input.frame;
+                snapshot.data.resize(1024);
+                if (simulateMs > 0.0)
+                    busy(simulateMs);
+            });
+
+        const auto start = Clock::now();
+        Input input;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            if (pipeline.pending() == 0)
+            {
+                pipeline.submit(input);
+                ++input.frame;
+            }
+            pipeline.acquire();
+            if (pipelined)
+            {
+                pipeline.submit(input);
+                ++input.frame;
+            }
+            if (renderMs > 0.0)
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(renderMs));
+        }
+        if (pipeline.pending() > 0)
+            pipeline.acquire();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int handoffFrames = (argc > 1) ? std::atoi(argv[1]) : 200000;
+    const int frames = 300;
+
+    for (const bool pipelined : { true, false })
+    {
+        const double seconds = run(pipelined, 0.0, 0.0, handoffFrames);
+        std::printf("handoff only, %-9s  %9.0f frames/s (%.2f us/frame)\n", pipelined ? "pipelined" : "serial",
+            handoffFrames / seconds, seconds / handoffFrames * 1e6);
+    }
+    for (const bool pipelined : { false, true })
+    {
+        const double seconds = run(pipelined, 2.0, 3.0, frames);
+        std::printf("simulate 2 ms + render 3 ms, %-9s  %.2f ms/frame\n", pipelined ? "pipelined" : "serial", seconds / frames * 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// HotReload with stub compile jobs: only the shaders an edit affects are rebuilt, swaps happen
+// inside update(), failed builds keep the old shaders, and the watcher picks up edits end to end,
+// includes added by an edit included.
+
+#include "HotReload.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    void writeFile(const std::string& path, const std::string& contents)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << contents;
+    }
+
+    // Runs frames until done() or about four seconds passed
+    template <typename Done>
+    bool runFrames(HotReload& hotReload, Done done)
+    {
+        for (int i = 0; i < 400 && !done(); ++i)
+        {
+            hotReload.update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return done();
+    }
+}
+
+int main()
+{
+    // Include names are relative to the working directory, as in the app
+    const std::filesystem::path root = "build/hotreload_files";
+    std::filesystem::remove_all(root);
+    std::filesystem::create_directories(root / "resources/shaders");
+    std::filesystem::current_path(root);
+
+    writeFile("resources/SceneBuffer.h", "struct S {};\n");
+    writeFile("resources/LightFunc.h", "#include \"resources/SceneBuffer.h\"\n");
+    writeFile("resources/shaders/a_ps.hlsl", "#include \"resources/LightFunc.h\"\n");
+    writeFile("resources/shaders/b_vs.hlsl", "#include \"resources/SceneBuffer.h\"\n");
+    writeFile("resources/shaders/c_ps.hlsl", "float4 PS() : SV_Target { return 0; }\n");
+
+    ThreadPool pool(2);
+    ShaderIncludeCache includes;
+    HotReload hotReload(&pool, &includes);
+
+    // Owner A: two permutations of a_ps and c_ps; owner B: b_vs; and a texture
+    std::atomic<int> compilesA{ 0 };
+    std::atomic<int> compilesB{ 0 };
+    std::atomic<bool> failA{ false };
+    int swapsA = 0;
+    int swapsB = 0;
+    int textures = 0;
+    hotReload.addShaders([&](ShaderBuildQueue& queue)
+        {
+            queue.add("a_ps.hlsl V=0", [&]() { ++compilesA; return !failA; }, "resources/shaders/a_ps.hlsl");
+            queue.add("a_ps.hlsl V=1", [&]() { ++compilesA; return !failA; }, "resources/shaders/a_ps.hlsl");
+            queue.add("c_ps.hlsl", [&]() { ++compilesA; return true; }, "resources/shaders/c_ps.hlsl");
+        }, [&]() { ++swapsA; return true; });
+    hotReload.addShaders([&](ShaderBuildQueue& queue)
+        {
+            queue.add("b_vs.hlsl", [&]() { ++compilesB; return true; }, "resources/shaders/b_vs.hlsl");
+        }, [&]() { ++swapsB; return true; });
+    hotReload.addTexture("resources/textures/t.dds", [&]() { ++textures; });
+
+    const std::vector<char>* pOldContents = includes.read("resources/SceneBuffer.h");
+    const std::string oldContents(pOldContents->begin(), pOldContents->end());
+
+    // The build runs in the background, the swap waits for the next update()
+    hotReload.notifyChanged("resources/LightFunc.h");
+    hotReload.update();
+    hotReload.flush();
+    check(swapsA == 0, "swap waits for update()");
+    hotReload.update();
+    check(compilesA == 2 && swapsA == 1 && compilesB == 0 && swapsB == 0, "only the affected jobs are rebuilt");
+
+    writeFile("resources/SceneBuffer.h", "struct S { float y; };\n");
+    hotReload.notifyChanged("resources/SceneBuffer.h");
+    hotReload.update();
+    hotReload.flush();
+    hotReload.update();
+    check(compilesA == 4 && swapsA == 2 && compilesB == 1 && swapsB == 1, "a shared include rebuilds both owners");
+    check(std::string(pOldContents->begin(), pOldContents->end()) == oldContents, "old include contents stay valid");
+    const std::vector<char>* pNewContents = includes.read("resources/SceneBuffer.h");
+    check(pNewContents != pOldContents && std::string(pNewContents->begin(), pNewContents->end()) == "struct S { float y; };\n",
+        "edited include is read again");
+
+    failA = true;
+    hotReload.notifyChanged("resources/shaders/a_ps.hlsl");
+    hotReload.update();
+    hotReload.flush();
+    hotReload.update();
+    check(swapsA == 2 && hotReload.stats().failures == 1 && !hotReload.stats().lastError.empty(), "failed build keeps the old shaders");
+
+    hotReload.notifyChanged("resources/textures/t.dds");
+    hotReload.update();
+    check(textures == 1 && compilesA == 6, "texture re-requested without compiling");
+
+    // End to end through the watcher
+    failA = false;
+    hotReload.start();
+    check(hotReload.stats().watchedFiles == 6, "start: assets and includes watched");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    writeFile("resources/shaders/b_vs.hlsl", "// edited\n");
+    check(runFrames(hotReload, [&]() { return swapsB == 2; }) && swapsA == 2, "watcher: edited shader swapped");
+
+    writeFile("resources/new.h", "// x\n");
+    writeFile("resources/shaders/b_vs.hlsl", "#include \"resources/new.h\"\n");
+    check(runFrames(hotReload, [&]() { return swapsB == 3; }) && hotReload.stats().watchedFiles == 7, "watcher: added include watched");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    writeFile("resources/new.h", "// y\n");
+    check(runFrames(hotReload, [&]() { return swapsB == 4; }) && swapsA == 2, "watcher: edit of the added include");
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("hot reload ok\n");
+    return 0;
+}
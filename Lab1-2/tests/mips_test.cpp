@@ -0,0 +1,263 @@
+// GenerateMipMaps fast path against the float filters: box in linear and sRGB within 1 LSB of the
+// chain computed in double precision, and TEX_FILTER_KAISER keeping constants exact, following smooth gradients and the
+// 16-bit path, including sizes that are not powers of two.
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    // Largest per-channel difference between two images of the same 8-bit RGBA format
+    int maxDifference(const Image& a, const Image& b, size_t margin = 0)
+    {
+        int worst = 0;
+        for (size_t y = margin; y + margin < a.height; ++y)
+        {
+            const uint8_t* pa = a.pixels + a.rowPitch * y;
+            const uint8_t* pb = b.pixels + b.rowPitch * y;
+            for (size_t x = margin * 4; x + margin * 4 < a.width * 4; ++x)
+                worst = std::max(worst, std::abs(int(pa[x]) - int(pb[x])));
+        }
+        return worst;
+    }
+
+    void fillRandom(const Image& image, std::mt19937& rng)
+    {
+        for (size_t y = 0; y < image.height; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < image.width * 4; ++x)
+                row[x] = static_cast<uint8_t>(rng());
+        }
+    }
+
+    double toLinear(uint8_t value, bool srgb)
+    {
+        const double v = value / 255.0;
+        if (!srgb)
+            return v;
+        return (v <= 0.04045) ? v / 12.92 : std::pow((v + 0.055) / 1.055, 2.4);
+    }
+
+    int toByte(double v, bool srgb)
+    {
+        v = std::min(std::max(v, 0.0), 1.0);
+        if (srgb)
+            v = (v <= 0.0031308) ? v * 12.92 : 1.055 * std::pow(v, 1.0 / 2.4) - 0.055;
+        return int(std::lround(v * 255.0));
+    }
+
+    // The box chain in double precision, never rounded to 8 bits between levels, against every
+    // fast level within 1 LSB. Then every level against the float scanline filter run on the same
+    // 8-bit level above it, also within 1 LSB.
+    // SEPARATE_ALPHA only matters to WIC, which this build doesn't have, and keeps GenerateMipMaps
+    // on the scanline filter
+    void testBox(DXGI_FORMAT format, TEX_FILTER_FLAGS flags, size_t width, size_t height, const char* what)
+    {
+        ScratchImage base;
+        if (FAILED(base.Initialize2D(format, width, height, 1, 1)))
+        {
+            check(false, what);
+            return;
+        }
+        std::mt19937 rng(uint32_t(width * 31 + height));
+        fillRandom(*base.GetImage(0, 0, 0), rng);
+
+        ScratchImage fast;
+        if (FAILED(GenerateMipMaps(*base.GetImage(0, 0, 0), TEX_FILTER_BOX | flags, 0, fast)))
+        {
+            check(false, what);
+            return;
+        }
+
+        const bool srgb = IsSRGB(format) || (flags & TEX_FILTER_SRGB) == TEX_FILTER_SRGB;
+        const bool opaque = !HasAlpha(format);
+        const Image& top = *base.GetImage(0, 0, 0);
+        std::vector<double> reference(width * height * 4);
+        for (size_t y = 0; y < height; ++y)
+        {
+            for (size_t x = 0; x < width * 4; ++x)
+            {
+                const uint8_t value = top.pixels[top.rowPitch * y + x];
+                reference[y * width * 4 + x] = (x % 4 == 3) ? (opaque ? 1.0 : value / 255.0) : toLinear(value, srgb);
+            }
+        }
+
+        int worstExact = 0;
+        int worstScanline = 0;
+        size_t w = width;
+        size_t h = height;
+        for (size_t level = 1; level < fast.GetMetadata().mipLevels; ++level)
+        {
+            const size_t nw = std::max<size_t>(w / 2, 1);
+            const size_t nh = std::max<size_t>(h / 2, 1);
+            std::vector<double> next(nw * nh * 4);
+            for (size_t y = 0; y < nh; ++y)
+            {
+                const size_t y0 = std::min(y * 2, h - 1) * w * 4;
+                const size_t y1 = std::min(y * 2 + 1, h - 1) * w * 4;
+                for (size_t x = 0; x < nw; ++x)
+                {
+                    const size_t x0 = std::min(x * 2, w - 1) * 4;
+                    const size_t x1 = std::min(x * 2 + 1, w - 1) * 4;
+                    for (size_t c = 0; c < 4; ++c)
+                    {
+                        next[(y * nw + x) * 4 + c] = (reference[y0 + x0 + c] + reference[y0 + x1 + c]
+                            + reference[y1 + x0 + c] + reference[y1 + x1 + c]) / 4.0;
+                    }
+                }
+            }
+            reference.swap(next);
+            w = nw;
+            h = nh;
+
+            const Image& mip = *fast.GetImage(level, 0, 0);
+            for (size_t y = 0; y < h; ++y)
+            {
+                for (size_t x = 0; x < w * 4; ++x)
+                {
+                    const double v = reference[y * w * 4 + x];
+                    const int expected = (x % 4 == 3) ? toByte(v, false) : toByte(v, srgb);
+                    worstExact = std::max(worstExact, std::abs(expected - int(mip.pixels[mip.rowPitch * y + x])));
+                }
+            }
+
+            ScratchImage scanline;
+            if (FAILED(GenerateMipMaps(*fast.GetImage(level - 1, 0, 0), TEX_FILTER_BOX | TEX_FILTER_SEPARATE_ALPHA | flags, 2, scanline)))
+            {
+                check(false, what);
+                return;
+            }
+            worstScanline = std::max(worstScanline, maxDifference(mip, *scanline.GetImage(1, 0, 0)));
+        }
+        if (worstExact > 1 || worstScanline > 1)
+            std::printf("  %s: %d LSB from exact, %d LSB from the scanline filter\n", what, worstExact, worstScanline);
+        check(worstExact <= 1 && worstScanline <= 1, what);
+    }
+
+    void testKaiserConstant(DXGI_FORMAT format, size_t width, size_t height)
+    {
+        ScratchImage base;
+        base.Initialize2D(format, width, height, 1, 1);
+        const Image& image = *base.GetImage(0, 0, 0);
+        for (size_t y = 0; y < height; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < image.rowPitch; ++x)
+                row[x] = static_cast<uint8_t>(0x40 + (x % 4) * 0x30);
+        }
+
+        ScratchImage mips;
+        bool constant = SUCCEEDED(GenerateMipMaps(image, TEX_FILTER_KAISER, 0, mips));
+        for (size_t level = 1; constant && level < mips.GetMetadata().mipLevels; ++level)
+        {
+            const Image& mip = *mips.GetImage(level, 0, 0);
+            const size_t rowBytes = mip.width * BitsPerPixel(format) / 8;
+            for (size_t y = 0; y < mip.height; ++y)
+            {
+                const uint8_t* row = mip.pixels + mip.rowPitch * y;
+                for (size_t x = 0; x < rowBytes; ++x)
+                    constant = constant && row[x] == image.pixels[x];
+            }
+        }
+        check(constant, format == DXGI_FORMAT_R16G16B16A16_UNORM ? "kaiser: 16-bit constant image stays exact"
+            : "kaiser: constant image stays exact on every level");
+    }
+
+    // The windowed sinc reproduces a linear ramp; away from the borders it matches the box filter
+    void testKaiserGradient(DXGI_FORMAT format, size_t size)
+    {
+        ScratchImage base;
+        base.Initialize2D(format, size, size, 1, 1);
+        const Image& image = *base.GetImage(0, 0, 0);
+        for (size_t y = 0; y < size; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < size; ++x)
+            {
+                row[x * 4 + 0] = static_cast<uint8_t>(x * 255 / (size - 1));
+                row[x * 4 + 1] = static_cast<uint8_t>(y * 255 / (size - 1));
+                row[x * 4 + 2] = static_cast<uint8_t>((x + y) * 127 / (size - 1));
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        ScratchImage kaiser;
+        ScratchImage box;
+        if (FAILED(GenerateMipMaps(image, TEX_FILTER_KAISER, 3, kaiser))
+            || FAILED(GenerateMipMaps(image, TEX_FILTER_BOX | TEX_FILTER_SEPARATE_ALPHA, 3, box)))
+        {
+            check(false, "kaiser: gradient generated");
+            return;
+        }
+        const int worst = std::max(maxDifference(*kaiser.GetImage(1, 0, 0), *box.GetImage(1, 0, 0), 4),
+            maxDifference(*kaiser.GetImage(2, 0, 0), *box.GetImage(2, 0, 0), 4));
+        if (worst > 2)
+            std::printf("  kaiser gradient: %d LSB\n", worst);
+        check(worst <= 2, IsSRGB(format) ? "kaiser: sRGB gradient within 2 LSB of box inside the borders"
+            : "kaiser: gradient within 2 LSB of box inside the borders");
+    }
+
+    void testKaiserOddSizes()
+    {
+        // Any size: every level halves, rounding down, to 1x1
+        ScratchImage base;
+        base.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 300, 37, 1, 1);
+        std::mt19937 rng(7);
+        fillRandom(*base.GetImage(0, 0, 0), rng);
+
+        ScratchImage mips;
+        const bool generated = SUCCEEDED(GenerateMipMaps(*base.GetImage(0, 0, 0), TEX_FILTER_KAISER, 0, mips));
+        check(generated && mips.GetMetadata().mipLevels == 9, "kaiser: full chain of a 300x37 image");
+        if (generated)
+        {
+            const Image& last = *mips.GetImage(8, 0, 0);
+            check(last.width == 1 && last.height == 1, "kaiser: chain ends at 1x1");
+            check(mips.GetImage(1, 0, 0)->width == 150 && mips.GetImage(1, 0, 0)->height == 18, "kaiser: odd sizes round down");
+        }
+    }
+}
+
+int main()
+{
+    testBox(DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_DEFAULT, 256, 256, "box: RGBA8 256x256 within 1 LSB");
+    testBox(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, TEX_FILTER_DEFAULT, 256, 256, "box: sRGB 256x256 within 1 LSB");
+    testBox(DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, TEX_FILTER_DEFAULT, 512, 32, "box: BGRA8 sRGB 512x32 within 1 LSB");
+    testBox(DXGI_FORMAT_R8G8B8A8_UNORM, TEX_FILTER_SRGB, 4, 1024, "box: TEX_FILTER_SRGB 4x1024 within 1 LSB");
+    testBox(DXGI_FORMAT_B8G8R8X8_UNORM, TEX_FILTER_DEFAULT, 128, 1, "box: BGRX8 128x1 within 1 LSB");
+    // Larger than a tile, so several fused passes run
+    testBox(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, TEX_FILTER_DEFAULT, 2048, 1024, "box: sRGB 2048x1024 within 1 LSB");
+
+    testKaiserConstant(DXGI_FORMAT_R8G8B8A8_UNORM, 96, 80);
+    testKaiserConstant(DXGI_FORMAT_R16G16B16A16_UNORM, 64, 40);
+    testKaiserGradient(DXGI_FORMAT_R8G8B8A8_UNORM, 256);
+    testKaiserGradient(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 256);
+    testKaiserOddSizes();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("mip chains match the float filters\n");
+    return 0;
+}
@@ -0,0 +1,65 @@
+// ComputeNormalMap and GenerateNormalMapMipMaps on an 8K heightmap on all hardware threads.
+// Usage: normalmap_bench [size] (default 8192)
+
+#include "DirectXTex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 8192;
+
+    ScratchImage heightmap;
+    if (FAILED(heightmap.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, 1, 1)))
+    {
+        std::printf("could not allocate a %zux%zu heightmap\n", size, size);
+        return 1;
+    }
+
+    std::mt19937 rng(1);
+    uint8_t* pixels = heightmap.GetPixels();
+    for (size_t i = 0; i < heightmap.GetPixelsSize(); ++i)
+        pixels[i] = static_cast<uint8_t>(rng());
+
+    std::printf("%zux%zu, %u threads\n", size, size, std::thread::hardware_concurrency());
+
+    ScratchImage normalMap;
+    auto start = Clock::now();
+    HRESULT hr = ComputeNormalMap(*heightmap.GetImage(0, 0, 0), CNMAP_CHANNEL_RED | CNMAP_COMPUTE_OCCLUSION, 2.f,
+        DXGI_FORMAT_R8G8B8A8_UNORM, normalMap);
+    const double computeMs = msSince(start);
+    if (FAILED(hr))
+    {
+        std::printf("ComputeNormalMap failed %08x\n", static_cast<unsigned>(hr));
+        return 1;
+    }
+    std::printf("ComputeNormalMap         %9.1f ms\n", computeMs);
+
+    ScratchImage mips, roughness;
+    start = Clock::now();
+    hr = GenerateNormalMapMipMaps(*normalMap.GetImage(0, 0, 0), 0, mips, &roughness, 0.5f);
+    const double mipMs = msSince(start);
+    if (FAILED(hr))
+    {
+        std::printf("GenerateNormalMapMipMaps failed %08x\n", static_cast<unsigned>(hr));
+        return 1;
+    }
+    std::printf("GenerateNormalMapMipMaps %9.1f ms (%zu levels)\n", mipMs, mips.GetMetadata().mipLevels);
+    return 0;
+}
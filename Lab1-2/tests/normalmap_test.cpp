@@ -0,0 +1,340 @@
+// ComputeNormalMap against a scalar reference on heightmaps tall enough to split into several row bands,
+// and GenerateNormalMapMipMaps: renormalized levels, Toksvig roughness and argument checks.
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    // HRESULT_FROM_WIN32(ERROR_NOT_SUPPORTED), as DirectXTexP.h defines it
+    constexpr HRESULT NotSupported = static_cast<HRESULT>(0x80070032L);
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    uint8_t unorm8(float v)
+    {
+        return static_cast<uint8_t>(std::min(std::max(v, 0.f), 1.f) * 255.f + 0.5f);
+    }
+
+    // Height in the red channel of an R32G32B32A32_FLOAT image
+    float height(const Image& image, ptrdiff_t x, ptrdiff_t y, CNMAP_FLAGS flags)
+    {
+        const auto w = static_cast<ptrdiff_t>(image.width);
+        const auto h = static_cast<ptrdiff_t>(image.height);
+        if (x < 0)
+            x = (flags & CNMAP_MIRROR_U) ? 0 : w - 1;
+        else if (x >= w)
+            x = (flags & CNMAP_MIRROR_U) ? w - 1 : 0;
+        if (y < 0)
+            y = (flags & CNMAP_MIRROR_V) ? 0 : h - 1;
+        else if (y >= h)
+            y = (flags & CNMAP_MIRROR_V) ? h - 1 : 0;
+        return reinterpret_cast<const float*>(image.pixels + image.rowPitch * size_t(y))[x * 4];
+    }
+
+    // Central differences over the 3x3 neighborhood, one texel at a time
+    XMFLOAT4 referenceNormal(const Image& image, ptrdiff_t x, ptrdiff_t y, CNMAP_FLAGS flags, float amplitude)
+    {
+        float v[3][3];
+        for (int j = 0; j < 3; ++j)
+        {
+            for (int i = 0; i < 3; ++i)
+                v[j][i] = height(image, x + i - 1, y + j - 1, flags);
+        }
+
+        const float dzx = ((v[0][0] - v[0][2]) + (v[1][0] - v[1][2]) + (v[2][0] - v[2][2])) * amplitude / 6.f;
+        const float dzy = ((v[0][0] - v[2][0]) + (v[0][1] - v[2][1]) + (v[0][2] - v[2][2])) * amplitude / 6.f;
+        const float length = sqrtf(dzx * dzx + dzy * dzy + 1.f);
+        const float sign = (flags & CNMAP_INVERT_SIGN) ? -1.f : 1.f;
+
+        float alpha = 1.f;
+        if (flags & CNMAP_COMPUTE_OCCLUSION)
+        {
+            float delta = 0.f;
+            for (int j = 0; j < 3; ++j)
+            {
+                for (int i = 0; i < 3; ++i)
+                    delta += std::max(0.f, v[j][i] - v[1][1]);
+            }
+            delta *= 0.125f * amplitude;
+            if (delta > 0.f)
+            {
+                const float r = sqrtf(1.f + delta * delta);
+                alpha = (r - delta) / r;
+            }
+        }
+
+        return XMFLOAT4(sign * dzx / length, sign * dzy / length, sign / length, alpha);
+    }
+
+    void testComputeNormalMap(size_t width, size_t height, unsigned seed)
+    {
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, width, height, 1, 1);
+        const Image& image = *source.GetImage(0, 0, 0);
+        std::mt19937 rng(seed);
+        for (size_t y = 0; y < height; ++y)
+        {
+            auto row = reinterpret_cast<float*>(image.pixels + image.rowPitch * y);
+            for (size_t x = 0; x < width * 4; ++x)
+                row[x] = float(rng() % 1000) / 1000.f;
+        }
+
+        const CNMAP_FLAGS variants[] = {
+            CNMAP_CHANNEL_RED,
+            CNMAP_CHANNEL_RED | CNMAP_MIRROR,
+            CNMAP_CHANNEL_RED | CNMAP_MIRROR_U | CNMAP_INVERT_SIGN,
+            CNMAP_CHANNEL_RED | CNMAP_MIRROR_V | CNMAP_COMPUTE_OCCLUSION,
+        };
+        for (const CNMAP_FLAGS flags : variants)
+        {
+            ScratchImage floatMap, unormMap;
+            const HRESULT hrFloat = ComputeNormalMap(image, flags, 2.f, DXGI_FORMAT_R32G32B32A32_FLOAT, floatMap);
+            const HRESULT hrUnorm = ComputeNormalMap(image, flags, 2.f, DXGI_FORMAT_R8G8B8A8_UNORM, unormMap);
+            check(SUCCEEDED(hrFloat) && SUCCEEDED(hrUnorm), "compute: ComputeNormalMap failed");
+            if (FAILED(hrFloat) || FAILED(hrUnorm))
+                continue;
+
+            const Image& f = *floatMap.GetImage(0, 0, 0);
+            const Image& u = *unormMap.GetImage(0, 0, 0);
+            float maxError = 0.f;
+            int maxUnormError = 0;
+            for (size_t y = 0; y < height; ++y)
+            {
+                const float* frow = reinterpret_cast<const float*>(f.pixels + f.rowPitch * y);
+                const uint8_t* urow = u.pixels + u.rowPitch * y;
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const XMFLOAT4 n = referenceNormal(image, ptrdiff_t(x), ptrdiff_t(y), flags, 2.f);
+                    const float* expected = &n.x;
+                    for (size_t c = 0; c < 4; ++c)
+                    {
+                        maxError = std::max(maxError, fabsf(frow[x * 4 + c] - expected[c]));
+                        const float encoded = (c < 3) ? expected[c] * 0.5f + 0.5f : expected[c];
+                        maxUnormError = std::max(maxUnormError, std::abs(int(urow[x * 4 + c]) - int(unorm8(encoded))));
+                    }
+                }
+            }
+
+            if (maxError > 1e-5f || maxUnormError > 1)
+            {
+                std::printf("  %zux%zu flags %lx: float error %g, unorm error %d\n", width, height,
+                    static_cast<unsigned long>(flags), maxError, maxUnormError);
+                check(false, "compute: banded result matches the scalar reference");
+            }
+        }
+    }
+
+    void testConstantNormal()
+    {
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R32G32B32A32_FLOAT, 64, 32, 1, 1);
+        const Image& image = *source.GetImage(0, 0, 0);
+        for (size_t y = 0; y < image.height; ++y)
+        {
+            auto row = reinterpret_cast<float*>(image.pixels + image.rowPitch * y);
+            for (size_t x = 0; x < image.width; ++x)
+            {
+                row[x * 4 + 0] = 0.6f;
+                row[x * 4 + 1] = 0.f;
+                row[x * 4 + 2] = 0.8f;
+                row[x * 4 + 3] = 0.25f;
+            }
+        }
+
+        ScratchImage mips, roughness;
+        check(SUCCEEDED(GenerateNormalMapMipMaps(image, 0, mips, &roughness, 0.5f)), "constant: GenerateNormalMapMipMaps");
+        check(mips.GetMetadata().mipLevels == 7 && roughness.GetMetadata().mipLevels == 7, "constant: full mip chain");
+        if (mips.GetMetadata().mipLevels != 7 || roughness.GetMetadata().mipLevels != 7)
+            return;
+
+        // Identical normals average to themselves and leave the roughness at the base value
+        float maxError = 0.f;
+        bool baseRoughness = true;
+        for (size_t level = 0; level < 7; ++level)
+        {
+            const Image& mip = *mips.GetImage(level, 0, 0);
+            const Image& r = *roughness.GetImage(level, 0, 0);
+            for (size_t y = 0; y < mip.height; ++y)
+            {
+                const float* row = reinterpret_cast<const float*>(mip.pixels + mip.rowPitch * y);
+                for (size_t x = 0; x < mip.width; ++x)
+                {
+                    maxError = std::max({ maxError, fabsf(row[x * 4] - 0.6f), fabsf(row[x * 4 + 1]),
+                        fabsf(row[x * 4 + 2] - 0.8f), fabsf(row[x * 4 + 3] - 0.25f) });
+                    baseRoughness = baseRoughness && r.pixels[r.rowPitch * y + x] == 128;
+                }
+            }
+        }
+        check(maxError < 1e-6f, "constant: every level keeps the normal and alpha");
+        check(baseRoughness, "constant: roughness stays at the base value");
+    }
+
+    void testChecker()
+    {
+        // Alternating normals tilted +-0.6 in X average to (0, 0, 0.8)
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 16, 16, 1, 1);
+        const Image& image = *source.GetImage(0, 0, 0);
+        for (size_t y = 0; y < 16; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < 16; ++x)
+            {
+                const float nx = ((x + y) & 1) ? 0.6f : -0.6f;
+                row[x * 4 + 0] = unorm8(nx * 0.5f + 0.5f);
+                row[x * 4 + 1] = 128;
+                row[x * 4 + 2] = unorm8(0.8f * 0.5f + 0.5f);
+                row[x * 4 + 3] = 255;
+            }
+        }
+
+        ScratchImage mips, roughness;
+        check(SUCCEEDED(GenerateNormalMapMipMaps(image, 3, mips, &roughness, 0.3f)), "checker: GenerateNormalMapMipMaps");
+        if (mips.GetMetadata().mipLevels != 3)
+        {
+            check(false, "checker: three levels");
+            return;
+        }
+
+        const uint8_t* texel = mips.GetImage(1, 0, 0)->pixels;
+        check(std::abs(int(texel[0]) - 128) <= 1 && texel[2] == 255, "checker: level 1 renormalized to +Z");
+
+        // |N| = 0.8 at base roughness 0.3: s = 2 / 0.09^2 - 2, ft = 0.8 / (0.8 + 0.2 s), roughness' = (2 / (s ft + 2))^(1/4)
+        check(roughness.GetImage(0, 0, 0)->pixels[0] == unorm8(0.3f), "checker: level 0 keeps the base roughness");
+        check(std::abs(int(roughness.GetImage(1, 0, 0)->pixels[0]) - 194) <= 1, "checker: Toksvig roughness on level 1");
+    }
+
+    void testTwoChannel()
+    {
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R8G8_UNORM, 8, 8, 1, 1);
+        const Image& image = *source.GetImage(0, 0, 0);
+        for (size_t y = 0; y < 8; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < 8; ++x)
+            {
+                row[x * 2 + 0] = unorm8(((x % 2) ? 0.6f : -0.6f) * 0.5f + 0.5f);
+                row[x * 2 + 1] = 128;
+            }
+        }
+
+        ScratchImage mips;
+        check(SUCCEEDED(GenerateNormalMapMipMaps(image, 0, mips)), "two-channel: GenerateNormalMapMipMaps");
+        check(mips.GetMetadata().mipLevels == 4, "two-channel: full mip chain");
+        if (mips.GetMetadata().mipLevels > 1)
+            check(std::abs(int(mips.GetImage(1, 0, 0)->pixels[0]) - 128) <= 1, "two-channel: reconstructed Z averages out X");
+
+        check(GenerateNormalMapMipMaps(image, 9, mips) == E_INVALIDARG, "two-channel: too many levels rejected");
+
+        ScratchImage compressed;
+        compressed.Initialize2D(DXGI_FORMAT_BC1_UNORM, 8, 8, 1, 1);
+        check(GenerateNormalMapMipMaps(*compressed.GetImage(0, 0, 0), 0, mips) == NotSupported, "compressed input rejected");
+    }
+
+    void testRandomArray()
+    {
+        // Non-power-of-two array slices: every level of every slice comes out unit length
+        TexMetadata metadata = {};
+        metadata.width = 37;
+        metadata.height = 23;
+        metadata.depth = 1;
+        metadata.arraySize = 3;
+        metadata.mipLevels = 1;
+        metadata.format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+        metadata.dimension = TEX_DIMENSION_TEXTURE2D;
+
+        ScratchImage source;
+        source.Initialize(metadata);
+        std::mt19937 rng(7);
+        std::normal_distribution<float> tilt(0.f, 0.3f);
+        for (size_t item = 0; item < 3; ++item)
+        {
+            const Image& image = *source.GetImage(0, item, 0);
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                auto row = reinterpret_cast<float*>(image.pixels + image.rowPitch * y);
+                for (size_t x = 0; x < image.width; ++x)
+                {
+                    const float nx = tilt(rng);
+                    const float ny = tilt(rng);
+                    const float length = sqrtf(nx * nx + ny * ny + 1.f);
+                    row[x * 4 + 0] = nx / length;
+                    row[x * 4 + 1] = ny / length;
+                    row[x * 4 + 2] = 1.f / length;
+                    row[x * 4 + 3] = 1.f;
+                }
+            }
+        }
+
+        ScratchImage mips, roughness;
+        check(SUCCEEDED(GenerateNormalMapMipMaps(source.GetImages(), source.GetImageCount(), metadata, 0, mips, &roughness, 0.2f)),
+            "array: GenerateNormalMapMipMaps");
+        check(mips.GetMetadata().mipLevels == 6 && mips.GetMetadata().arraySize == 3, "array: full mip chain per slice");
+
+        float lengthError = 0.f;
+        bool rougher = true;
+        for (size_t i = 0; i < mips.GetImageCount(); ++i)
+        {
+            const Image& image = mips.GetImages()[i];
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                const float* row = reinterpret_cast<const float*>(image.pixels + image.rowPitch * y);
+                for (size_t x = 0; x < image.width; ++x)
+                {
+                    const float* n = row + x * 4;
+                    lengthError = std::max(lengthError, fabsf(sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) - 1.f));
+                }
+            }
+
+            const Image& r = roughness.GetImages()[i];
+            for (size_t y = 0; y < r.height; ++y)
+            {
+                for (size_t x = 0; x < r.width; ++x)
+                    rougher = rougher && r.pixels[r.rowPitch * y + x] >= unorm8(0.2f);
+            }
+        }
+        check(lengthError < 1e-5f, "array: renormalized to unit length");
+        check(rougher, "array: roughness never drops below the base value");
+    }
+}
+
+int main()
+{
+    // 16 and 300 texels wide split into 3 and 4 row bands however many threads there are
+    testComputeNormalMap(16, 3000, 1);
+    testComputeNormalMap(300, 200, 2);
+    testComputeNormalMap(1, 5, 3);
+    testComputeNormalMap(64, 1, 4);
+
+    testConstantNormal();
+    testChecker();
+    testTwoChannel();
+    testRandomArray();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("normal maps match the reference\n");
+    return 0;
+}
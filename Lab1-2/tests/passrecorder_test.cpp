@@ -0,0 +1,208 @@
+// PassRecorder with a recording mock backend: passes recorded in parallel execute in pass order
+// on the calling thread and give the same command stream as recording serially; the passes use
+// several threads at once; and a busy pool still finishes the frame. Meant to run under TSan.
+
+#include "PassRecorder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct MockContext
+    {
+        std::vector<std::string> commands;
+
+        void draw(const std::string& what) { commands.push_back(what); }
+    };
+
+    using Recorder = PassRecorder<MockContext>;
+
+    // A context per pass like deferred contexts, whose commands become a list executed into the immediate one
+    class MockBackend : public Recorder::Backend
+    {
+    public:
+        MockBackend(MockContext* immediate, size_t passes)
+            : m_pImmediate(immediate)
+            , m_contexts(passes)
+            , m_lists(passes)
+            , m_threads(passes)
+        {
+        }
+
+        MockContext* beginPass(size_t pass) override
+        {
+            if (!m_contexts[pass].commands.empty())
+                m_misused = true;
+            m_threads[pass] = std::this_thread::get_id();
+
+            const int now = ++m_active;
+            int previous = m_maxActive.load();
+            while (now > previous && !m_maxActive.compare_exchange_weak(previous, now))
+            {
+            }
+            return &m_contexts[pass];
+        }
+
+        void finishPass(size_t pass) override
+        {
+            if (m_threads[pass] != std::this_thread::get_id())
+                m_misused = true;
+            --m_active;
+            m_lists[pass].swap(m_contexts[pass].commands);
+            m_contexts[pass].commands.clear();
+        }
+
+        void executePass(size_t pass) override
+        {
+            if (pass != m_nextExecute || std::this_thread::get_id() != m_caller)
+                m_misused = true;
+            m_nextExecute = pass + 1;
+            m_pImmediate->commands.insert(m_pImmediate->commands.end(), m_lists[pass].begin(), m_lists[pass].end());
+            m_lists[pass].clear();
+        }
+
+        // Contexts recorded on their own thread, lists executed in order on the caller
+        bool usedCorrectly() const { return !m_misused && m_nextExecute == m_lists.size(); }
+        size_t threadsUsed() const { return std::set<std::thread::id>(m_threads.begin(), m_threads.end()).size(); }
+        int maxActive() const { return m_maxActive.load(); }
+
+    private:
+        MockContext* m_pImmediate;
+        std::vector<MockContext> m_contexts;
+        std::vector<std::vector<std::string>> m_lists;
+        std::vector<std::thread::id> m_threads;
+        std::atomic<int> m_active{ 0 };
+        std::atomic<int> m_maxActive{ 0 };
+        std::atomic<bool> m_misused{ false };
+        std::thread::id m_caller = std::this_thread::get_id();
+        size_t m_nextExecute = 0;
+    };
+
+    // The scene's five passes; the longest first, so it can't finish first by chance
+    void addPasses(Recorder& recorder, double sleepMs)
+    {
+        const char* names[] = { "Opaque", "Skybox", "Light proxies", "Transparent", "Postprocess" };
+        for (int pass = 0; pass < 5; ++pass)
+        {
+            const std::string name = names[pass];
+            recorder.addPass(name, [name, sleepMs, pass](MockContext* context)
+                {
+                    context->draw(name + ":state");
+                    if (sleepMs > 0.0)
+                        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sleepMs * (5 - pass)));
+                    for (int i = 0; i < 3 + pass; ++i)
+                        context->draw(name + ":draw" + std::to_string(i));
+                });
+        }
+    }
+
+    void testParallel(ThreadPool& pool)
+    {
+        Recorder recorder(&pool);
+        addPasses(recorder, 2.0);
+        check(recorder.passCount() == 5 && recorder.passName(3) == "Transparent", "passes added");
+
+        MockContext serial;
+        recorder.run(nullptr, &serial);
+        check(!recorder.stats().parallel, "serial: recorded on the caller");
+        const double serialMs = recorder.stats().wallMs;
+
+        bool same = true;
+        bool correct = true;
+        bool overlapped = true;
+        for (int frame = 0; frame < 50; ++frame)
+        {
+            MockContext immediate;
+            MockBackend backend(&immediate, 5);
+            recorder.run(&backend, &immediate);
+            same = same && immediate.commands == serial.commands;
+            correct = correct && backend.usedCorrectly();
+            overlapped = overlapped && backend.threadsUsed() > 1 && backend.maxActive() > 1 && recorder.stats().wallMs < serialMs;
+            if (frame == 0)
+            {
+                const Recorder::Stats& s = recorder.stats();
+                std::printf("serial %.2f ms, parallel %.2f ms wall (%.2f ms over the passes, execute %.3f ms), %zu threads, %d passes at once\n",
+                    serialMs, s.wallMs, s.recordMs, s.executeMs, backend.threadsUsed(), backend.maxActive());
+            }
+        }
+        check(recorder.stats().parallel, "parallel: recorded on the backend");
+        check(same, "parallel: same command stream as serial");
+        check(correct, "parallel: each pass on its own context, executed in order on the caller");
+        check(overlapped, "parallel: passes overlap and beat serial");
+    }
+
+    void testManyFrames(ThreadPool& pool)
+    {
+        // Quick passes over many frames, for TSan
+        Recorder recorder(&pool);
+        addPasses(recorder, 0.0);
+        MockContext reference;
+        recorder.run(nullptr, &reference);
+
+        bool same = true;
+        for (int frame = 0; frame < 5000; ++frame)
+        {
+            MockContext immediate;
+            MockBackend backend(&immediate, 5);
+            recorder.run(&backend, &immediate);
+            same = same && immediate.commands == reference.commands && backend.usedCorrectly();
+        }
+        check(same, "many frames: same command stream every frame");
+    }
+
+    void testBusyPool()
+    {
+        // The only worker is stuck in a long task, the caller records every pass itself
+        ThreadPool pool(1);
+        std::atomic<bool> release{ false };
+        pool.submit([&]()
+            {
+                while (!release)
+                    std::this_thread::yield();
+            });
+
+        Recorder recorder(&pool);
+        addPasses(recorder, 0.0);
+        MockContext reference;
+        recorder.run(nullptr, &reference);
+
+        MockContext immediate;
+        MockBackend backend(&immediate, 5);
+        recorder.run(&backend, &immediate);
+        check(immediate.commands == reference.commands && backend.usedCorrectly(), "busy pool: frame finished on the caller");
+        release = true;
+    }
+}
+
+int main()
+{
+    ThreadPool pool(4);
+    testParallel(pool);
+    testManyFrames(pool);
+    testBusyPool();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("pass recorder ok\n");
+    return 0;
+}
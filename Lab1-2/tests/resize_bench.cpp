@@ -0,0 +1,86 @@
+// Resize throughput of the fast path against the float scanline filters, per filter, on an sRGB
+// downscale and upscale. Kaiser has no scanline counterpart.
+// Usage: resize_bench [size] (default 2048: size^2 -> (size/2 - 24)^2 and (size/2)^2 -> (size*3/4)^2)
+
+#include "DirectXTex.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double seconds(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    double resize(const Image& source, size_t width, size_t height, TEX_FILTER_FLAGS filter)
+    {
+        ScratchImage result;
+        const Clock::time_point start = Clock::now();
+        if (FAILED(Resize(source, width, height, filter, result)))
+            return -1.0;
+        return seconds(start);
+    }
+
+    void run(const char* name, TEX_FILTER_FLAGS filter, const Image& source, size_t width, size_t height)
+    {
+        const double mpixels = double(width * height) / 1e6;
+        const double fast = resize(source, width, height, filter);
+        std::printf("%-9s %5zu -> %5zu  fast %8.1f Mpixel/s", name, source.width, width, mpixels / fast);
+        if (filter != TEX_FILTER_KAISER)
+        {
+            // SEPARATE_ALPHA keeps Resize on the scanline filters without WIC
+            const double scanline = resize(source, width, height, filter | TEX_FILTER_SEPARATE_ALPHA);
+            std::printf("   scanline %8.1f Mpixel/s   %.2fx", mpixels / scanline, scanline / fast);
+        }
+        std::printf("\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t size = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2048;
+
+    std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+    const struct
+    {
+        size_t srcSize;
+        size_t dstSize;
+    } cases[] = {
+        { size, size / 2 - 24 },
+        { size / 2, size * 3 / 4 },
+    };
+    const struct
+    {
+        const char* name;
+        TEX_FILTER_FLAGS filter;
+    } filters[] = {
+        { "point", TEX_FILTER_POINT },
+        { "linear", TEX_FILTER_LINEAR },
+        { "cubic", TEX_FILTER_CUBIC },
+        { "triangle", TEX_FILTER_TRIANGLE },
+        { "kaiser", TEX_FILTER_KAISER },
+    };
+
+    for (const auto& c : cases)
+    {
+        ScratchImage source;
+        if (FAILED(source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, c.srcSize, c.srcSize, 1, 1)))
+            return 1;
+        uint8_t* pixels = source.GetPixels();
+        for (size_t i = 0; i < source.GetPixelsSize(); ++i)
+            pixels[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+
+        for (const auto& f : filters)
+            run(f.name, f.filter, *source.GetImage(0, 0, 0), c.dstSize, c.dstSize);
+    }
+    return 0;
+}
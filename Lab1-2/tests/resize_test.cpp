@@ -0,0 +1,215 @@
+// Resize fast path against the float scanline filters, per filter, on RGBA8, sRGB and RGBA16
+// up- and downscales with a max-error bound in 8-bit LSB; TEX_FILTER_KAISER, which has no float
+// counterpart, keeping constants exact and staying near CUBIC on smooth content.
+
+#include "DirectXTex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct Size
+    {
+        size_t srcWidth;
+        size_t srcHeight;
+        size_t width;
+        size_t height;
+    };
+
+    const Size Sizes[] = {
+        { 256, 256, 100, 100 },     // downscale
+        { 64, 48, 192, 108 },       // upscale
+        { 1000, 37, 333, 74 },      // down in x, up in y
+        { 3, 5, 17, 2 },            // tiny
+    };
+
+    // Smooth content with a little noise, so CUBIC's overshoot and the clamping it needs stay rare
+    void fillSmooth(const Image& image, std::mt19937& rng)
+    {
+        const bool wide = BitsPerPixel(image.format) == 64;
+        for (size_t y = 0; y < image.height; ++y)
+        {
+            uint8_t* row = image.pixels + image.rowPitch * y;
+            for (size_t x = 0; x < image.width; ++x)
+            {
+                for (size_t c = 0; c < 4; ++c)
+                {
+                    const double noise = (double(rng() % 256) / 255.0 - 0.5) * 0.1;
+                    const double v = 0.5 + 0.4 * std::sin(double(x) * 0.05 * double(c + 1) + double(y) * 0.03) + noise;
+                    if (wide)
+                        reinterpret_cast<uint16_t*>(row)[x * 4 + c] = static_cast<uint16_t>(std::lround(v * 65535.0));
+                    else
+                        row[x * 4 + c] = static_cast<uint8_t>(std::lround(v * 255.0));
+                }
+            }
+        }
+    }
+
+    // Largest per-channel difference in 8-bit LSB, skipping the first 'margin' rows and columns
+    double maxError(const Image& a, const Image& b, size_t margin = 0)
+    {
+        const bool wide = BitsPerPixel(a.format) == 64;
+        double worst = 0.0;
+        for (size_t y = std::min(margin, a.height - 1); y < a.height; ++y)
+        {
+            const uint8_t* pa = a.pixels + a.rowPitch * y;
+            const uint8_t* pb = b.pixels + b.rowPitch * y;
+            for (size_t i = std::min(margin, a.width - 1) * 4; i < a.width * 4; ++i)
+            {
+                const double e = wide
+                    ? std::abs(double(reinterpret_cast<const uint16_t*>(pa)[i]) - double(reinterpret_cast<const uint16_t*>(pb)[i])) / 257.0
+                    : std::abs(double(pa[i]) - double(pb[i]));
+                worst = std::max(worst, e);
+            }
+        }
+        return worst;
+    }
+
+    // SEPARATE_ALPHA only matters to WIC, which this build doesn't have, and keeps Resize on the
+    // float scanline filters. Bounds per filter:
+    //  - POINT: exact, both pick the same texels
+    //  - LINEAR: 1 LSB, the weights are summed in a different order and values on a rounding
+    //    boundary can go either way
+    //  - CUBIC: the same, except in the leading rows and columns whose sample lands before the first
+    //    source texel, 3 at the 5.7x upscale here; the scanline filter truncates that position
+    //    toward zero and extrapolates, the fast path clamps
+    //  - TRIANGLE: 4 LSB, the scanline filter scatters each source texel over its destinations,
+    //    the fast path gathers from normalized per-destination tables
+    void testFilter(TEX_FILTER_FLAGS filter, double bound, size_t margin, const char* name)
+    {
+        const DXGI_FORMAT formats[] = { DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB, DXGI_FORMAT_R16G16B16A16_UNORM };
+        std::mt19937 rng(3);
+        double worst = 0.0;
+        bool resized = true;
+        for (const DXGI_FORMAT format : formats)
+        {
+            for (const Size& size : Sizes)
+            {
+                ScratchImage source;
+                source.Initialize2D(format, size.srcWidth, size.srcHeight, 1, 1);
+                fillSmooth(*source.GetImage(0, 0, 0), rng);
+
+                ScratchImage fast;
+                ScratchImage reference;
+                if (FAILED(Resize(*source.GetImage(0, 0, 0), size.width, size.height, filter, fast))
+                    || FAILED(Resize(*source.GetImage(0, 0, 0), size.width, size.height, filter | TEX_FILTER_SEPARATE_ALPHA, reference)))
+                {
+                    resized = false;
+                    continue;
+                }
+                worst = std::max(worst, maxError(*fast.GetImage(0, 0, 0), *reference.GetImage(0, 0, 0), margin));
+            }
+        }
+        if (!resized || worst > bound)
+            std::printf("  %s: %.2f LSB, bound %.2f\n", name, worst, bound);
+        check(resized && worst <= bound, name);
+    }
+
+    // BOX only differs from LINEAR on exact halvings
+    void testBoxHalving()
+    {
+        std::mt19937 rng(5);
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 128, 64, 1, 1);
+        fillSmooth(*source.GetImage(0, 0, 0), rng);
+
+        ScratchImage fast;
+        ScratchImage reference;
+        const bool resized = SUCCEEDED(Resize(*source.GetImage(0, 0, 0), 64, 32, TEX_FILTER_BOX, fast))
+            && SUCCEEDED(Resize(*source.GetImage(0, 0, 0), 64, 32, TEX_FILTER_BOX | TEX_FILTER_SEPARATE_ALPHA, reference));
+        check(resized && maxError(*fast.GetImage(0, 0, 0), *reference.GetImage(0, 0, 0)) <= 1.0, "box: sRGB halving within 1 LSB");
+    }
+
+    void testKaiserConstant()
+    {
+        const TEX_FILTER_FLAGS filters[] = { TEX_FILTER_KAISER, TEX_FILTER_KAISER | TEX_FILTER_WRAP_U | TEX_FILTER_MIRROR_V, TEX_FILTER_TRIANGLE };
+        bool constant = true;
+        for (const TEX_FILTER_FLAGS filter : filters)
+        {
+            ScratchImage source;
+            source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, 517, 300, 1, 1);
+            const Image& image = *source.GetImage(0, 0, 0);
+            const uint8_t texel[4] = { 77, 200, 3, 128 };
+            for (size_t y = 0; y < image.height; ++y)
+            {
+                for (size_t x = 0; x < image.width; ++x)
+                    std::memcpy(image.pixels + image.rowPitch * y + x * 4, texel, 4);
+            }
+
+            ScratchImage result;
+            constant = constant && SUCCEEDED(Resize(image, 129, 301, filter, result));
+            const Image& out = *result.GetImage(0, 0, 0);
+            for (size_t y = 0; constant && y < out.height; ++y)
+            {
+                for (size_t x = 0; x < out.width * 4; ++x)
+                    constant = constant && out.pixels[out.rowPitch * y + x] == texel[x % 4];
+            }
+        }
+        check(constant, "kaiser, triangle: constant image stays exact with clamp, wrap and mirror");
+    }
+
+    // A 3-lobe windowed sinc and a cubic agree closely on content that is smooth at the output rate
+    void testKaiserSmooth()
+    {
+        ScratchImage source;
+        source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1);
+        const Image& image = *source.GetImage(0, 0, 0);
+        for (size_t y = 0; y < image.height; ++y)
+        {
+            for (size_t x = 0; x < image.width; ++x)
+            {
+                uint8_t* p = image.pixels + image.rowPitch * y + x * 4;
+                p[0] = static_cast<uint8_t>(std::lround(127.5 + 100.0 * std::sin(double(x) * 0.02)));
+                p[1] = static_cast<uint8_t>(std::lround(127.5 + 100.0 * std::cos(double(y) * 0.03)));
+                p[2] = static_cast<uint8_t>((x + y) / 2);
+                p[3] = 255;
+            }
+        }
+
+        ScratchImage kaiser;
+        ScratchImage cubic;
+        const bool resized = SUCCEEDED(Resize(image, 200, 300, TEX_FILTER_KAISER, kaiser))
+            && SUCCEEDED(Resize(image, 200, 300, TEX_FILTER_CUBIC | TEX_FILTER_SEPARATE_ALPHA, cubic));
+        const double worst = resized ? maxError(*kaiser.GetImage(0, 0, 0), *cubic.GetImage(0, 0, 0)) : 255.0;
+        if (worst > 2.0)
+            std::printf("  kaiser smooth: %.2f LSB\n", worst);
+        check(worst <= 2.0, "kaiser: within 2 LSB of cubic on smooth content");
+    }
+}
+
+int main()
+{
+    testFilter(TEX_FILTER_POINT, 0.0, 0, "point: byte-equal");
+    testFilter(TEX_FILTER_LINEAR, 1.0, 0, "linear: within 1 LSB");
+    testFilter(TEX_FILTER_CUBIC, 1.0, 3, "cubic: within 1 LSB past the leading border");
+    testFilter(TEX_FILTER_TRIANGLE, 4.0, 0, "triangle: within 4 LSB");
+    testBoxHalving();
+    testKaiserConstant();
+    testKaiserSmooth();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("resizes match the float filters\n");
+    return 0;
+}
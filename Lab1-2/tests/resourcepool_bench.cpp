@@ -0,0 +1,71 @@
+// ResourcePool costs: create, get() as every pass does per bound object, and a frame that destroys
+// and recreates every object and collects what the GPU is done with two frames later.
+// Usage: resourcepool_bench [objects] (default 10000)
+
+#include "ResourcePool.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    void releaseNothing(void*)
+    {
+    }
+
+    double nsPer(Clock::duration duration, double count)
+    {
+        return std::chrono::duration<double, std::nano>(duration).count() / count;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int count = (argc > 1) ? std::atoi(argv[1]) : 10000;
+    const int lookupRounds = 1000;
+    const int frames = 100;
+
+    ResourcePool pool;
+    const ResourcePool::TypeId type = pool.registerType("Objects", releaseNothing);
+    std::vector<int> objects(count);
+    std::vector<ResourcePool::Handle> handles;
+    handles.reserve(count);
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; i++)
+        handles.push_back(pool.create(type, &objects[i], 64));
+    const double createNs = nsPer(Clock::now() - start, count);
+
+    uintptr_t sink = 0;
+    start = Clock::now();
+    for (int round = 0; round < lookupRounds; round++)
+    {
+        for (ResourcePool::Handle handle : handles)
+            sink += reinterpret_cast<uintptr_t>(pool.get(handle));
+    }
+    const double getNs = nsPer(Clock::now() - start, (double)count * lookupRounds);
+
+    uint64_t fence = 0;
+    start = Clock::now();
+    for (int frame = 0; frame < frames; frame++)
+    {
+        pool.setFrameFence(++fence);
+        for (ResourcePool::Handle& handle : handles)
+        {
+            pool.destroy(handle);
+            handle = pool.create(type, &objects[0], 64);
+        }
+        if (fence > 2)
+            pool.collect(fence - 2);
+    }
+    const double churnNs = nsPer(Clock::now() - start, (double)count * frames);
+
+    std::printf("%d objects: create %.1f ns, get %.2f ns, destroy + create + collect %.1f ns, %zu slots  (%zu)\n",
+        count, createNs, getNs, churnNs, pool.stats().slots, (size_t)(sink & 1));
+    return 0;
+}
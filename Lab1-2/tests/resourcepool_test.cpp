@@ -0,0 +1,173 @@
+// ResourcePool with counted mock objects: handles and generations, release deferred to the frame
+// fence and in fence order, per-type accounting, Unique ownership and the swap a shader reload
+// does, generation wraparound, and get() from several threads. Meant to run under TSan.
+
+#include "ResourcePool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+    int g_released = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    void releaseInt(void* object)
+    {
+        ++g_released;
+        delete static_cast<int*>(object);
+    }
+
+    void testHandles()
+    {
+        g_released = 0;
+        ResourcePool pool;
+        const ResourcePool::TypeId textures = pool.registerType("Textures", releaseInt);
+        const ResourcePool::TypeId buffers = pool.registerType("Buffers", releaseInt);
+
+        const ResourcePool::Handle texture = pool.create(textures, new int(5), 100);
+        check(!texture.isNull() && *pool.get<int>(texture) == 5, "handles: created object looked up");
+        check(pool.create(textures, nullptr, 10).isNull() && pool.get(ResourcePool::Handle()) == nullptr, "handles: nullptr gives a null handle");
+        check(pool.typeStats()[textures].live == 1 && pool.typeStats()[textures].liveBytes == 100, "handles: accounted to its type");
+
+        pool.setFrameFence(1);
+        pool.destroy(texture);
+        pool.destroy(texture);
+        check(!pool.isValid(texture), "destroy: the handle is dead at once");
+        check(g_released == 0 && pool.typeStats()[textures].pendingBytes == 100 && pool.typeStats()[textures].liveBytes == 0,
+            "destroy: the object waits for the fence, a second destroy is ignored");
+
+        // The slot is reused under a new generation, the old handle stays dead
+        const ResourcePool::Handle buffer = pool.create(buffers, new int(7), 50);
+        check(buffer.index == texture.index && buffer.generation != texture.generation, "reuse: same slot, new generation");
+        check(pool.get(texture) == nullptr && *pool.get<int>(buffer) == 7, "reuse: the stale handle doesn't see the new object");
+
+        pool.collect(0);
+        check(g_released == 0, "collect: nothing before the fence");
+        pool.collect(1);
+        check(g_released == 1 && pool.typeStats()[textures].pending == 0 && pool.stats().released == 1, "collect: released at the fence");
+
+        pool.setFrameFence(2);
+        pool.destroy(buffer);
+        const ResourcePool::Handle later = pool.create(buffers, new int(8), 1);
+        pool.setFrameFence(3);
+        pool.destroy(later);
+        pool.collect(2);
+        check(g_released == 2 && pool.stats().pending == 1, "collect: in fence order, later frames wait");
+
+        // Whatever is left, live or pending, goes with the pool
+        pool.create(textures, new int(1), 1);
+    }
+
+    void testUnique()
+    {
+        g_released = 0;
+        {
+            ResourcePool pool;
+            const ResourcePool::TypeId shaders = pool.registerType("Shaders", releaseInt);
+            pool.setFrameFence(1);
+            {
+                ResourcePool::Unique first = pool.createUnique(shaders, new int(9), 4);
+                ResourcePool::Unique moved = std::move(first);
+                check(!first && moved && *moved.get<int>() == 9, "unique: moved out");
+                ResourcePool::Unique assigned;
+                assigned = std::move(moved);
+                check(pool.stats().live == 1 && first.get<int>() == nullptr, "unique: one owner after moves");
+            }
+            check(pool.stats().live == 0 && pool.stats().pending == 1, "unique: destroyed going out of scope");
+
+            // A reload: the new set built aside, moved over the old one, which the GPU may still be drawing with
+            ResourcePool::Unique shader = pool.createUnique(shaders, new int(1), 0);
+            const ResourcePool::Handle old = shader.handle();
+            ResourcePool::Unique reloaded = pool.createUnique(shaders, new int(2), 0);
+            shader = std::move(reloaded);
+            check(!pool.isValid(old) && *shader.get<int>() == 2 && g_released == 0, "reload: the old shader pending, the new one bound");
+            pool.setFrameFence(2);
+            pool.collect(1);
+            check(g_released == 2, "reload: released once its frame is done");
+
+            // Handles reset before the pool, as Render::terminate() does
+            shader.reset();
+            check(!shader && pool.stats().live == 0, "unique: reset");
+        }
+        check(g_released == 3, "unique: pending released with the pool");
+    }
+
+    void testGenerationWrap()
+    {
+        ResourcePool pool;
+        const ResourcePool::TypeId type = pool.registerType("Objects", releaseInt);
+        const ResourcePool::Handle first = pool.create(type, new int(0), 0);
+        ResourcePool::Handle handle = first;
+        bool ok = true;
+        for (uint32_t i = 0; i < 70000; i++)
+        {
+            pool.destroy(handle);
+            handle = pool.create(type, new int(0), 0);
+            ok = ok && handle.generation != 0 && handle.index == 0 && (!pool.isValid(first) || handle == first);
+        }
+        check(ok, "wrap: generations skip 0 and old handles stay dead");
+        pool.collect(UINT64_MAX);
+    }
+
+    void testConcurrentGet()
+    {
+        // Passes recording in parallel look up handles while nothing creates or destroys
+        ResourcePool pool;
+        const ResourcePool::TypeId type = pool.registerType("Objects", releaseInt);
+        std::vector<ResourcePool::Handle> handles;
+        for (int i = 0; i < 1000; i++)
+        {
+            handles.push_back(pool.create(type, new int(i), 4));
+        }
+
+        std::atomic<long> sum{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&]()
+                {
+                    long local = 0;
+                    for (int round = 0; round < 100; round++)
+                    {
+                        for (ResourcePool::Handle handle : handles)
+                            local += *pool.get<int>(handle);
+                    }
+                    sum += local;
+                });
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+        check(sum == 4L * 100 * 999 * 1000 / 2, "threads: every lookup saw its object");
+    }
+}
+
+int main()
+{
+    testHandles();
+    check(g_released == 4, "handles: the rest released with the pool");
+    testUnique();
+    testGenerationWrap();
+    testConcurrentGet();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("resource pool ok\n");
+    return 0;
+}
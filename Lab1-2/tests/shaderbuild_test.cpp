@@ -0,0 +1,120 @@
+// ShaderBuildQueue with a stub compiler that sleeps like a cold D3DCompile: every job runs once,
+// jobs overlap on the pool, failures are reported, and the stats add up.
+
+#include "ShaderBuildQueue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    struct Result
+    {
+        bool ok;
+        ShaderBuildQueue::Stats stats;
+        int peak;
+        int ran;
+    };
+
+    // Job i sleeps latencies[i] ms; the jobs listed in failing report a compile error
+    Result build(const char* name, const std::vector<int>& latencies, unsigned threads, const std::vector<size_t>& failing = {})
+    {
+        std::atomic<int> running{ 0 };
+        std::atomic<int> peak{ 0 };
+        std::atomic<int> ran{ 0 };
+
+        ShaderBuildQueue queue;
+        for (size_t i = 0; i < latencies.size(); ++i)
+        {
+            const int ms = latencies[i];
+            const bool fails = std::find(failing.begin(), failing.end(), i) != failing.end();
+            queue.add("job" + std::to_string(i), [&, ms, fails]()
+                {
+                    const int now = ++running;
+                    int previous = peak.load();
+                    while (now > previous && !peak.compare_exchange_weak(previous, now))
+                    {
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+                    --running;
+                    ++ran;
+                    return !fails;
+                }, "shader" + std::to_string(i % 3) + ".hlsl");
+        }
+
+        std::unique_ptr<ThreadPool> pool;
+        if (threads)
+            pool = std::make_unique<ThreadPool>(threads);
+        const bool ok = queue.run(pool.get());
+
+        const ShaderBuildQueue::Stats& s = queue.stats();
+        std::printf("%-28s %3zu jobs, %u threads: wall %6.1f ms, serial %6.1f ms, %.2fx, peak %d, slowest %s %.1f ms\n",
+            name, s.jobs, s.threads, s.wallMs, s.compileMs, s.wallMs > 0.0 ? s.compileMs / s.wallMs : 0.0,
+            peak.load(), s.longestJob.c_str(), s.longestMs);
+
+        bool jobsRecorded = queue.jobs().size() == latencies.size();
+        for (size_t i = 0; jobsRecorded && i < latencies.size(); ++i)
+        {
+            const ShaderBuildQueue::Job& job = queue.jobs()[i];
+            const bool fails = std::find(failing.begin(), failing.end(), i) != failing.end();
+            jobsRecorded = job.succeeded == !fails && job.ms >= latencies[i] * 0.9 && job.source == "shader" + std::to_string(i % 3) + ".hlsl";
+        }
+        check(jobsRecorded, "every job records its result, time and source");
+
+        return { ok, s, peak.load(), ran.load() };
+    }
+}
+
+int main()
+{
+    // The eleven scene shaders, 40-120 ms each
+    const std::vector<int> scene = { 120, 90, 60, 40, 50, 45, 40, 70, 65, 40, 40 };
+
+    const Result serial = build("scene, no pool", scene, 0);
+    check(serial.ok && serial.ran == 11 && serial.peak == 1 && serial.stats.threads == 1, "serial: every job once, one at a time");
+
+    for (const unsigned threads : { 1u, 3u, 7u })
+    {
+        const Result pooled = build("scene, pool", scene, threads);
+        check(pooled.ok && pooled.ran == 11, "pool: every job once");
+        check(pooled.stats.threads == threads + 1, "pool: the calling thread takes part");
+        check(pooled.peak > 1 && pooled.peak <= int(threads + 1), "pool: jobs overlap, no more than the threads");
+        check(pooled.stats.longestJob == "job0", "pool: slowest job reported");
+        check(pooled.stats.wallMs < serial.stats.wallMs, "pool: faster than serial");
+        check(pooled.stats.compileMs >= pooled.stats.wallMs, "pool: summed compile time covers the wall time");
+    }
+
+    const Result failed = build("two failing jobs", { 5, 5, 5, 5, 5 }, 3, { 1, 3 });
+    check(!failed.ok && failed.stats.failed == 2 && failed.ran == 5, "failures: reported, the other jobs still run");
+
+    const Result many = build("100 x 2 ms", std::vector<int>(100, 2), 3);
+    check(many.ok && many.ran == 100 && many.stats.jobs == 100, "more jobs than threads");
+
+    const Result empty = build("empty", {}, 3);
+    check(empty.ok && empty.stats.jobs == 0, "empty queue succeeds");
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("shader build queue ok\n");
+    return 0;
+}
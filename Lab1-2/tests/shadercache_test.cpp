@@ -0,0 +1,231 @@
+// ShaderCache with a stub compiler: key sensitivity, hits and misses, entries surviving a restart,
+// damaged entries treated as misses, concurrent writers, and the include cache.
+
+#include "ShaderCache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    const std::wstring CacheDir = L"build/shadercache_entries";
+    const std::string Source = "float4 PS() : SV_Target { return 1; }";
+
+    std::atomic<int> g_compiles{ 0 };
+
+    // "Bytecode" is the reversed source plus a marker; sources containing "error" fail to compile
+    ShaderCache::CompileFn stubCompiler(const std::string& source, int sleepMs = 0)
+    {
+        return [source, sleepMs](std::vector<char>& bytecode)
+            {
+                ++g_compiles;
+                if (source.find("error") != std::string::npos)
+                    return false;
+                std::this_thread::sleep_for(std::chrono::milliseconds(sleepMs));
+                bytecode.assign(source.rbegin(), source.rend());
+                bytecode.push_back('!');
+                return true;
+            };
+    }
+
+    ShaderCache::Key keyOf(const ShaderCache& cache, const std::string& source)
+    {
+        return cache.makeKey(source.data(), source.size(), {}, "PS", "ps_5_0", 0);
+    }
+
+    void forEachEntry(const std::function<void(const std::filesystem::path&)>& func)
+    {
+        for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::path(CacheDir)))
+            func(entry.path());
+    }
+
+    void testKeys()
+    {
+        ShaderCache cache(CacheDir, 47);
+        const auto key = keyOf(cache, Source);
+        const std::string longer = Source + " ";
+
+        check(key == keyOf(cache, Source), "keys: deterministic");
+        check(key != cache.makeKey(Source.data(), Source.size(), { "X" }, "PS", "ps_5_0", 0), "keys: defines");
+        check(cache.makeKey(Source.data(), Source.size(), { "AB", "C" }, "PS", "ps_5_0", 0)
+            != cache.makeKey(Source.data(), Source.size(), { "A", "BC" }, "PS", "ps_5_0", 0), "keys: define boundaries");
+        check(key != cache.makeKey(Source.data(), Source.size(), {}, "VS", "ps_5_0", 0), "keys: entry point");
+        check(key != cache.makeKey(Source.data(), Source.size(), {}, "PS", "ps_5_1", 0), "keys: profile");
+        check(key != cache.makeKey(Source.data(), Source.size(), {}, "PS", "ps_5_0", 1), "keys: flags");
+        check(key != keyOf(ShaderCache(L"", 48), Source), "keys: salt");
+        check(key != keyOf(cache, longer), "keys: source");
+    }
+
+    void testHitsAndMisses()
+    {
+        ShaderCache cache(CacheDir, 47);
+        const auto key = keyOf(cache, Source);
+        std::vector<char> bytecode;
+
+        g_compiles = 0;
+        check(cache.getOrCompile(key, stubCompiler(Source), bytecode) && g_compiles == 1, "miss compiles");
+        check(cache.getOrCompile(key, stubCompiler(Source), bytecode) && g_compiles == 1 && bytecode.back() == '!', "hit skips the compiler");
+        check(cache.stats().hits == 1 && cache.stats().misses == 1, "hit and miss counted");
+
+        const std::string broken = "error";
+        const auto brokenKey = keyOf(cache, broken);
+        check(!cache.getOrCompile(brokenKey, stubCompiler(broken), bytecode)
+            && !cache.getOrCompile(brokenKey, stubCompiler(broken), bytecode) && g_compiles == 3, "compile errors are not cached");
+    }
+
+    void testRestartAndDamage()
+    {
+        // A new instance, as after a restart, finds the entry on disk
+        ShaderCache cache(CacheDir, 47);
+        const auto key = keyOf(cache, Source);
+        std::vector<char> bytecode;
+        check(cache.load(key, bytecode) && std::string(bytecode.begin(), bytecode.end() - 1) == std::string(Source.rbegin(), Source.rend()),
+            "restart: entry loaded from disk");
+
+        // Truncated entries are misses; the instance that loaded the entry still has it in memory
+        forEachEntry([](const std::filesystem::path& path) { std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3); });
+        check(!ShaderCache(CacheDir, 47).load(key, bytecode) && bytecode.empty(), "truncated entry is a miss");
+        check(cache.load(key, bytecode) && cache.stats().memoryHits == 1, "memory copy survives the damage");
+
+        // A corrupted payload is a miss too, and the recompiled entry replaces it
+        forEachEntry([](const std::filesystem::path& path)
+            {
+                std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+                file.seekp(-1, std::ios::end);
+                file.put('x');
+            });
+        g_compiles = 0;
+        ShaderCache fresh(CacheDir, 47);
+        check(fresh.getOrCompile(key, stubCompiler(Source), bytecode) && g_compiles == 1, "corrupted entry recompiled");
+        check(ShaderCache(CacheDir, 47).load(key, bytecode), "recompiled entry written back");
+
+        ShaderCache resalted(CacheDir, 48);
+        check(!resalted.load(keyOf(resalted, Source), bytecode), "a new salt misses");
+
+        ShaderCache memoryOnly(L"");
+        check(!memoryOnly.load(key, bytecode) && !memoryOnly.store(key, { 'a' }) && memoryOnly.load(key, bytecode) && bytecode.size() == 1,
+            "without a directory only memory is used");
+    }
+
+    void testConcurrentWriters()
+    {
+        // Eight threads compiling the same ten shaders race on the same entries
+        ShaderCache cache(CacheDir, 1);
+        std::atomic<int> bad{ 0 };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 8; ++t)
+        {
+            threads.emplace_back([&]()
+                {
+                    for (int i = 0; i < 50; ++i)
+                    {
+                        const std::string source = "shader" + std::to_string(i % 10);
+                        std::vector<char> bytecode;
+                        if (!cache.getOrCompile(keyOf(cache, source), stubCompiler(source), bytecode) || bytecode.back() != '!')
+                            ++bad;
+                    }
+                });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        check(bad == 0, "concurrent: every compile got its bytecode");
+
+        int temporaries = 0;
+        forEachEntry([&](const std::filesystem::path& path) { temporaries += path.extension() == ".tmp"; });
+        check(temporaries == 0, "concurrent: no temporary files left");
+
+        int readable = 0;
+        ShaderCache reader(CacheDir, 1);
+        for (int i = 0; i < 10; ++i)
+        {
+            std::vector<char> bytecode;
+            readable += reader.load(keyOf(reader, "shader" + std::to_string(i)), bytecode);
+        }
+        check(readable == 10, "concurrent: every entry intact on disk");
+    }
+
+    void testIncludes()
+    {
+        const std::string dir = "build/shadercache_includes";
+        std::filesystem::create_directories(dir);
+        std::ofstream(dir + "/a.h") << "#define A 1\n";
+        std::ofstream(dir + "/empty.h").close();
+
+        ShaderIncludeCache includes;
+        const std::vector<char>* contents = includes.read(dir + "/a.h");
+        check(contents && contents->size() == 12, "includes: read");
+
+        std::ofstream(dir + "/a.h") << "#define A 22\n";
+        check(includes.read(dir + "/a.h") == contents && contents->size() == 12, "includes: read once per run");
+        check(includes.read(dir + "/empty.h") && includes.read(dir + "/empty.h")->empty(), "includes: empty file");
+        check(includes.read(dir + "/missing.h") == nullptr, "includes: missing file");
+
+        includes.invalidate(dir + "/a.h");
+        check(contents->size() == 12, "includes: invalidated contents stay valid");
+        check(includes.read(dir + "/a.h")->size() == 13, "includes: invalidate rereads");
+
+        includes.clear();
+        check(includes.read(dir + "/a.h")->size() == 13, "includes: clear rereads");
+    }
+
+    void reportTiming()
+    {
+        // Cold and warm start of ten shaders with a 30 ms stub compile
+        std::filesystem::remove_all(std::filesystem::path(CacheDir));
+        auto run = []()
+            {
+                ShaderCache cache(CacheDir, 47);
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < 10; ++i)
+                {
+                    const std::string source(4000, char('a' + i));
+                    std::vector<char> bytecode;
+                    cache.getOrCompile(cache.makeKey(source.data(), source.size(), { "FOO" }, "PS", "ps_5_0", 0),
+                        stubCompiler(source, 30), bytecode);
+                }
+                return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            };
+        const double cold = run();
+        const double warm = run();
+        std::printf("10 shaders, 30 ms stub compile: cold %.1f ms, warm %.2f ms\n", cold, warm);
+        check(warm < cold / 10, "warm start skips the compiler");
+    }
+}
+
+int main()
+{
+    std::filesystem::remove_all(std::filesystem::path(CacheDir));
+
+    testKeys();
+    testHitsAndMisses();
+    testRestartAndDamage();
+    testConcurrentWriters();
+    testIncludes();
+    reportTiming();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("shader cache ok\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+// ShaderPermutations over three axes, one of them with three values: keys dense and round tripping
+// through value() and defines(), define sets mapped to the same key whatever their order and repeats,
+// select() falling back to a built variant when one is missing, and variantCount/totalSize.
+
+#include "ShaderPermutations.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    using Key = ShaderPermutations::Key;
+    using Values = std::vector<uint32_t>;
+    using Defines = std::vector<std::string>;
+
+    ShaderPermutations permutations()
+    {
+        ShaderPermutations result;
+        result.addAxis("NORMAL_MAP");
+        result.addAxis("LIGHTS", 3);
+        result.addAxis("SHOW_NORMALS");
+        return result;
+    }
+
+    void testKeys()
+    {
+        const ShaderPermutations p = permutations();
+        check(p.axisCount() == 3 && p.variantCount() == 12, "keys: 2 * 3 * 2 variants");
+
+        std::vector<bool> seen(p.variantCount(), false);
+        bool roundTrip = true;
+        bool definesMatch = true;
+        for (uint32_t normalMap = 0; normalMap < 2; ++normalMap)
+        {
+            for (uint32_t lights = 0; lights < 3; ++lights)
+            {
+                for (uint32_t showNormals = 0; showNormals < 2; ++showNormals)
+                {
+                    const Key key = p.key(Values{ normalMap, lights, showNormals });
+                    if (key >= seen.size() || seen[key])
+                    {
+                        roundTrip = false;
+                        continue;
+                    }
+                    seen[key] = true;
+                    roundTrip = roundTrip && p.value(key, 0) == normalMap && p.value(key, 1) == lights && p.value(key, 2) == showNormals;
+
+                    const Defines defines = { "NORMAL_MAP=" + std::to_string(normalMap), "LIGHTS=" + std::to_string(lights),
+                        "SHOW_NORMALS=" + std::to_string(showNormals) };
+                    definesMatch = definesMatch && p.defines(key) == defines && p.key(defines) == key;
+                }
+            }
+        }
+        check(roundTrip, "keys: dense, unique and round trip through value()");
+        check(definesMatch, "keys: defines() and key(defines) invert each other");
+        check(p.key(Values{ 5, 9, 7 }) == p.key(Values{ 1, 2, 1 }), "keys: out of range values clamp");
+    }
+
+    void testDefineSets()
+    {
+        const ShaderPermutations p = permutations();
+        const Key expected = p.key(Values{ 1, 2, 0 });
+
+        Defines defines = { "NORMAL_MAP", "LIGHTS=2" };
+        std::sort(defines.begin(), defines.end());
+        bool orderFree = true;
+        do
+        {
+            orderFree = orderFree && p.key(defines) == expected;
+        } while (std::next_permutation(defines.begin(), defines.end()));
+        check(orderFree, "define sets: order does not matter");
+
+        check(p.key(Defines{ "LIGHTS=2", "NORMAL_MAP", "LIGHTS=2", "NORMAL_MAP=1" }) == expected, "define sets: repeats do not matter");
+        check(p.key(Defines{ "NORMAL_MAP", "FOG=1", "LIGHTS=2", "SHADOWS" }) == expected, "define sets: unknown names are ignored");
+        check(p.key(Defines{}) == 0 && p.key(Defines{ "SHOW_NORMALS=0" }) == 0, "define sets: axes left out are 0");
+        check(p.key(Defines{ "SHOW_NORMALS" }) == p.key(Values{ 0, 0, 1 }), "define sets: a bare name is 1");
+    }
+
+    void testFallback()
+    {
+        ShaderPermutations p = permutations();
+        check(!p.hasVariant(0) && p.select(p.key(Values{ 1, 1, 1 })) == 0, "fallback: nothing built selects 0");
+
+        // Everything but SHOW_NORMALS=1 and the two-light variants with a normal map
+        for (Key key = 0; key < (Key)p.variantCount(); ++key)
+        {
+            if (p.value(key, 2) == 0 && !(p.value(key, 0) == 1 && p.value(key, 1) == 2))
+                p.setVariantSize(key, 100 + key);
+        }
+
+        bool exact = true;
+        for (Key key = 0; key < (Key)p.variantCount(); ++key)
+            exact = exact && (!p.hasVariant(key) || p.select(key) == key);
+        check(exact, "fallback: a built variant selects itself");
+
+        check(p.select(p.key(Values{ 0, 2, 1 })) == p.key(Values{ 0, 2, 0 }), "fallback: the last axis is switched off first");
+        check(p.select(p.key(Values{ 1, 2, 1 })) == p.key(Values{ 1, 0, 0 }), "fallback: then the ones before it");
+        check(p.select(p.key(Values{ 1, 2, 0 })) == p.key(Values{ 1, 0, 0 }), "fallback: keeps the axes before the missing one");
+        check(p.select(Key(p.variantCount() + 3)) == 0, "fallback: a key out of range selects 0");
+        check(p.report("test").find("missing") != std::string::npos, "fallback: report() lists missing variants");
+    }
+
+    void testSizes()
+    {
+        ShaderPermutations p = permutations();
+        check(p.totalSize() == 0, "sizes: nothing built is 0 bytes");
+
+        size_t expected = 0;
+        for (Key key = 0; key < (Key)p.variantCount(); ++key)
+        {
+            p.setVariantSize(key, 1000 + key * 10);
+            expected += 1000 + key * 10;
+        }
+        check(p.totalSize() == expected, "sizes: totalSize sums every variant");
+
+        p.setVariantSize(3, 1);
+        expected += 1 - (1000 + 3 * 10);
+        p.setVariantSize(Key(p.variantCount()), 1 << 20);
+        check(p.totalSize() == expected, "sizes: a rebuilt variant replaces its size, out of range keys are ignored");
+
+        const std::string report = p.report("lighted_cube_ps");
+        check(report.find("lighted_cube_ps: 12 variants, " + std::to_string(expected) + " bytes") == 0
+            && std::count(report.begin(), report.end(), '\n') == 13, "sizes: report() has a summary and a line per variant");
+
+        p.addAxis("FOG");
+        check(p.variantCount() == 24 && p.totalSize() == 0, "sizes: a new axis drops the old sizes");
+    }
+}
+
+int main()
+{
+    testKeys();
+    testDefineSets();
+    testFallback();
+    testSizes();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("shader permutations ok\n");
+    return 0;
+}
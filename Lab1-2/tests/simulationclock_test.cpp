@@ -0,0 +1,223 @@
+// SimulationClock on injected time: whole steps and alpha, simulated time tracking real time,
+// clamped hitches, time scale and pause, and record / save / load / replay giving the same
+// timeline whatever the real clock and the live settings are.
+
+#include "SimulationClock.h"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    bool near(double a, double b)
+    {
+        return std::fabs(a - b) < 1e-9;
+    }
+
+    class VirtualTime : public FramePacer::TimeSource
+    {
+    public:
+        double now() override { return t; }
+        void sleep(double seconds) override { t += seconds; }
+        void spin() override {}
+
+        double t = 100.0;
+    };
+
+    SimulationClock::Options stepOf(double step)
+    {
+        SimulationClock::Options options;
+        options.step = step;
+        return options;
+    }
+
+    void testSteps()
+    {
+        VirtualTime time;
+        SimulationClock clock(stepOf(0.01), &time);
+        check(clock.advance() == 0, "steps: the first frame has no length");
+        time.t += 0.025;
+        check(clock.advance() == 2 && near(clock.alpha(), 0.5), "steps: two steps, half of one left");
+        time.t += 0.007;
+        check(clock.advance() == 1 && near(clock.alpha(), 0.2), "steps: the remainder carries over");
+        check(clock.stats().steps == 3 && near(clock.simulatedTime(), 0.03), "steps: counted");
+    }
+
+    void testTracksRealTime()
+    {
+        // Over many irregular frames the simulated time stays on the real one
+        VirtualTime time;
+        SimulationClock clock(&time);
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> frameTime(0.001, 0.05);
+        clock.advance();
+
+        double real = 0.0;
+        bool alphaInRange = true;
+        for (int i = 0; i < 100000; ++i)
+        {
+            const double dt = frameTime(rng);
+            time.t += dt;
+            real += dt;
+            clock.advance();
+            alphaInRange = alphaInRange && clock.alpha() >= 0.0 && clock.alpha() < 1.0;
+        }
+        const double simulated = clock.simulatedTime() + clock.alpha() * clock.step();
+        check(alphaInRange, "real time: alpha within [0, 1)");
+        check(std::fabs(simulated - real) < 1e-6 * real, "real time: no drift");
+    }
+
+    void testHitch()
+    {
+        VirtualTime time;
+        SimulationClock::Options options = stepOf(0.01);
+        options.maxFrameTime = 0.25;
+        options.maxStepsPerFrame = 8;
+        SimulationClock clock(options, &time);
+        clock.advance();
+        time.t += 3.0;
+        check(clock.advance() == 8 && near(clock.stats().droppedTime, 3.0 - 0.08), "hitch: clamped and capped");
+        time.t += 0.01;
+        check(clock.advance() == 1, "hitch: no burst afterwards");
+    }
+
+    void testScaleAndPause()
+    {
+        VirtualTime time;
+        SimulationClock clock(stepOf(0.01), &time);
+        clock.advance();
+        clock.setTimeScale(0.5);
+        time.t += 0.04;
+        check(clock.advance() == 2, "scale: half speed");
+        clock.setPaused(true);
+        time.t += 0.04;
+        check(clock.advance() == 0, "pause: no steps");
+        clock.setPaused(false);
+        clock.setTimeScale(2.0);
+        time.t += 0.04;
+        check(clock.advance() == 8, "scale: double speed");
+
+        time.t += 0.013;
+        clock.advance();
+        const double alpha = clock.alpha();
+        clock.setStep(1.0 / 60.0);
+        check(near(clock.alpha(), alpha), "setStep keeps alpha");
+    }
+
+    struct Timeline
+    {
+        std::vector<int> steps;
+        std::vector<double> alphas;
+
+        bool operator==(const Timeline& other) const { return steps == other.steps && alphas == other.alphas; }
+    };
+
+    // Replays frameTimes on a fresh clock whose real time and live settings are anything
+    Timeline replay(const std::vector<double>& frameTimes, double realFrame, double timeScale, bool paused)
+    {
+        VirtualTime time;
+        time.t = 5.0;
+        SimulationClock clock(&time);
+        clock.setTimeScale(timeScale);
+        clock.setPaused(paused);
+        clock.advance();
+        clock.startReplay(frameTimes);
+
+        Timeline timeline;
+        for (size_t i = 0; i < frameTimes.size(); ++i)
+        {
+            time.t += realFrame;
+            timeline.steps.push_back(clock.advance());
+            timeline.alphas.push_back(clock.alpha());
+        }
+
+        check(clock.mode() == SimulationClock::Mode::Live && clock.replayRemaining() == 0, "replay: back to live after the last frame");
+        check(clock.timeScale() == timeScale && clock.paused() == paused, "replay: live settings restored");
+        time.t += 0.01;
+        check(clock.advance() <= (paused ? 0 : 2 * timeScale + 1), "replay: no jump going back to live");
+        return timeline;
+    }
+
+    void testRecordAndReplay()
+    {
+        const std::string file = "build/simulationclock_times.txt";
+
+        VirtualTime time;
+        SimulationClock clock(&time);
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<double> frameTime(0.002, 0.04);
+        clock.advance();
+        clock.startRecording();
+        for (int i = 0; i < 5000; ++i)
+        {
+            time.t += frameTime(rng);
+            clock.advance();
+        }
+        clock.stopRecording();
+        check(clock.recording().size() == 5000, "record: every frame time kept");
+
+        std::vector<double> loaded;
+        check(clock.saveRecording(file) && SimulationClock::loadRecording(file, loaded) && loaded == clock.recording(),
+            "record: saved and loaded exactly");
+
+        // Neither the real clock nor the time scale and pause in effect change the timeline
+        const Timeline first = replay(loaded, 1.0, 1.0, false);
+        check(replay(loaded, 2.0, 1.0, false) == first, "replay: real time is irrelevant");
+        check(replay(loaded, 1.0, 0.25, false) == first, "replay: time scale is irrelevant");
+        check(replay(loaded, 1.0, 3.0, true) == first, "replay: pause is irrelevant");
+
+        // Settings changed during a replay wait for its end
+        VirtualTime other;
+        SimulationClock changed(&other);
+        changed.advance();
+        changed.startReplay(loaded);
+        changed.setPaused(true);
+        changed.setTimeScale(0.5);
+        Timeline timeline;
+        for (size_t i = 0; i < loaded.size(); ++i)
+        {
+            other.t += 1.0;
+            timeline.steps.push_back(changed.advance());
+            timeline.alphas.push_back(changed.alpha());
+        }
+        check(timeline == first, "replay: settings changed during it are deferred");
+        check(changed.paused() && changed.timeScale() == 0.5, "replay: deferred settings applied at the end");
+
+        std::vector<double> none;
+        check(!SimulationClock::loadRecording("build/simulationclock_missing.txt", none), "load: missing file fails");
+        std::filesystem::remove(file);
+    }
+}
+
+int main()
+{
+    std::filesystem::create_directories("build");
+
+    testSteps();
+    testTracksRealTime();
+    testHitch();
+    testScaleAndPause();
+    testRecordAndReplay();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("simulation clock ok\n");
+    return 0;
+}
@@ -0,0 +1,147 @@
+// AsyncTextureLoader throughput on many small and a few large DDS files: loadDDS on the calling
+// thread against the loader on 1..N pool threads, with the callbacks pumped as the frame loop does.
+// Usage: textureloader_bench [small] [large] (default 400 64x64 RGBA8 and 8 2048x2048 BC1, full mip chains)
+
+#include "AsyncTextureLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    const std::string Dir = "build/textureloader_files";
+
+    double msSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Random payload is enough: the loader parses and validates, it doesn't look at the texels
+    bool writeDDS(const std::wstring& path, size_t size, DXGI_FORMAT format, std::mt19937& rng)
+    {
+        ScratchImage image;
+        if (FAILED(image.Initialize2D(format, size, size, 1, 0)))
+            return false;
+        uint8_t* pixels = image.GetPixels();
+        for (size_t i = 0; i < image.GetPixelsSize(); ++i)
+            pixels[i] = uint8_t(rng());
+        return SUCCEEDED(SaveToDDSFile(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DDS_FLAGS_NONE, path.c_str()));
+    }
+
+    struct Result
+    {
+        double ms = 0.0;
+        size_t loaded = 0;
+        size_t bytes = 0;
+    };
+
+    Result loadAll(const std::vector<std::wstring>& files, unsigned threads)
+    {
+        Result result;
+        const Clock::time_point start = Clock::now();
+        if (threads == 0)
+        {
+            for (const std::wstring& file : files)
+            {
+                TextureLoadResult texture;
+                if (SUCCEEDED(AsyncTextureLoader::loadDDS(file, DDS_FLAGS_NONE, texture)))
+                {
+                    ++result.loaded;
+                    result.bytes += texture.image.GetPixelsSize();
+                }
+            }
+        }
+        else
+        {
+            ThreadPool pool(threads);
+            AsyncTextureLoader loader(&pool);
+            for (const std::wstring& file : files)
+            {
+                loader.load(file, DDS_FLAGS_NONE, [&result](TextureLoadResult& texture)
+                    {
+                        if (SUCCEEDED(texture.result))
+                        {
+                            ++result.loaded;
+                            result.bytes += texture.image.GetPixelsSize();
+                        }
+                    });
+            }
+            // The frame loop pumps a few completions per frame until everything has landed
+            while (loader.pending() > 0)
+            {
+                if (loader.pump(8) == 0)
+                    std::this_thread::yield();
+            }
+        }
+        result.ms = msSince(start);
+        return result;
+    }
+
+    void run(const char* name, const std::vector<std::wstring>& files)
+    {
+        const unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<unsigned> threadCounts = { 0 };
+        for (unsigned threads = 1; threads < maxThreads; threads *= 2)
+            threadCounts.push_back(threads);
+        threadCounts.push_back(maxThreads);
+
+        for (const unsigned threads : threadCounts)
+        {
+            const Result result = loadAll(files, threads);
+            const double mb = double(result.bytes) / (1024.0 * 1024.0);
+            std::printf("%-6s %4zu files  %-12s %8.2f ms  %7.0f MB/s  %s\n", name, files.size(),
+                threads ? (std::to_string(threads) + " threads").c_str() : "loadDDS",
+                result.ms, mb / (result.ms / 1000.0), result.loaded == files.size() ? "" : "LOAD FAILED");
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t smallCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 400;
+    const size_t largeCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 8;
+
+    std::filesystem::remove_all(Dir);
+    std::filesystem::create_directories(Dir);
+
+    std::mt19937 rng(1);
+    std::vector<std::wstring> small;
+    std::vector<std::wstring> large;
+    for (size_t i = 0; i < smallCount; ++i)
+    {
+        const std::string path = Dir + "/small" + std::to_string(i) + ".dds";
+        small.emplace_back(path.begin(), path.end());
+        if (!writeDDS(small.back(), 64, DXGI_FORMAT_R8G8B8A8_UNORM, rng))
+        {
+            std::printf("can't write %s\n", path.c_str());
+            return 1;
+        }
+    }
+    for (size_t i = 0; i < largeCount; ++i)
+    {
+        const std::string path = Dir + "/large" + std::to_string(i) + ".dds";
+        large.emplace_back(path.begin(), path.end());
+        if (!writeDDS(large.back(), 2048, DXGI_FORMAT_BC1_UNORM, rng))
+        {
+            std::printf("can't write %s\n", path.c_str());
+            return 1;
+        }
+    }
+
+    run("small", small);
+    run("large", large);
+
+    std::filesystem::remove_all(Dir);
+    return 0;
+}
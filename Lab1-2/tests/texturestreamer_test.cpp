@@ -0,0 +1,181 @@
+// TextureStreamer against a simulated budget: eviction in LRU order, the pinned mip tail never
+// evicted, a budget lowered at runtime evicted down to, loads refused over budget counted in
+// deniedLoads, and replaceTexture byte accounting with and without a load in flight.
+
+#include "TextureStreamer.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    using Commands = std::vector<TextureStreamer::Command>;
+
+    // 100 + 50 + 10 bytes, the 10-byte mip 2 is the tail
+    const std::vector<size_t> MipBytes = { 100, 50, 10 };
+    const uint32_t Tail = 2;
+
+    // One frame: culling requests the top mip of every visible texture, then every load completes at once
+    Commands frame(TextureStreamer& streamer, const std::vector<TextureStreamer::TextureId>& visible)
+    {
+        for (TextureStreamer::TextureId texture : visible)
+            streamer.requestMip(texture, 0);
+
+        Commands commands;
+        streamer.update(commands);
+        for (const TextureStreamer::Command& command : commands)
+        {
+            if (command.type == TextureStreamer::CommandType::Load)
+                streamer.completeLoad(command.texture, command.mip);
+        }
+        return commands;
+    }
+
+    bool evicts(const Commands& commands, TextureStreamer::TextureId texture)
+    {
+        for (const TextureStreamer::Command& command : commands)
+        {
+            if (command.type == TextureStreamer::CommandType::Evict && command.texture == texture)
+                return true;
+        }
+        return false;
+    }
+
+    void testLruEviction()
+    {
+        // Room for the three tails and two full textures
+        TextureStreamer streamer(330);
+        const TextureStreamer::TextureId a = streamer.registerTexture(MipBytes, Tail);
+        const TextureStreamer::TextureId b = streamer.registerTexture(MipBytes, Tail);
+        const TextureStreamer::TextureId c = streamer.registerTexture(MipBytes, Tail);
+        check(streamer.stats().residentBytes == 30, "register: the tails are resident from the start");
+
+        frame(streamer, { a });
+        frame(streamer, { a });
+        frame(streamer, { b });
+        frame(streamer, { b });
+        check(streamer.residentMip(a) == 0 && streamer.residentMip(b) == 0 && streamer.stats().residentBytes == 330,
+            "stream: a and b fully resident, budget reached");
+
+        // c needs room: a was used longest ago, so it goes before b
+        Commands commands = frame(streamer, { c });
+        check(evicts(commands, a) && !evicts(commands, b), "lru: the least recently used texture evicted first");
+        check(streamer.residentMip(c) == 1 && streamer.stats().residentBytes <= 330, "lru: the load fits after eviction");
+
+        // With b and c both visible, a is the only victim and goes down to its tail
+        commands = frame(streamer, { b, c });
+        check(!evicts(commands, b) && !evicts(commands, c), "lru: textures used this frame at their level are kept");
+        check(streamer.residentMip(c) == 0 && streamer.residentMip(a) == Tail, "lru: a dropped to its tail for c");
+        check(streamer.stats().residentBytes == 330 && streamer.stats().deniedLoads == 0, "lru: nothing denied");
+    }
+
+    void testPinnedTailAndBudget()
+    {
+        TextureStreamer streamer(10000, 4);
+        std::vector<TextureStreamer::TextureId> textures;
+        for (int i = 0; i < 4; i++)
+            textures.push_back(streamer.registerTexture(MipBytes, Tail));
+        frame(streamer, textures);
+        frame(streamer, textures);
+        check(streamer.stats().residentBytes == 4 * 160, "budget: everything resident");
+
+        // Lowered at runtime: evicted down to it on the next update, least recently used first
+        frame(streamer, { textures[2], textures[3] });
+        streamer.setBudget(400);
+        Commands commands = frame(streamer, {});
+        check(streamer.stats().residentBytes <= 400, "budget: lowered budget reached");
+        check(evicts(commands, textures[0]) || evicts(commands, textures[1]), "budget: the textures not seen lately go first");
+
+        // Below the tails: everything not on screen drops to its tail, which stays
+        streamer.setBudget(0);
+        commands = frame(streamer, {});
+        bool tails = true;
+        for (TextureStreamer::TextureId texture : textures)
+            tails = tails && streamer.residentMip(texture) == Tail;
+        check(tails && streamer.stats().residentBytes == 4 * 10, "tail: never evicted, even with no budget");
+        bool pastTail = false;
+        for (const TextureStreamer::Command& command : commands)
+            pastTail = pastTail || (command.type == TextureStreamer::CommandType::Evict && command.mip > Tail);
+        check(!pastTail, "tail: no eviction past it");
+    }
+
+    void testDeniedLoads()
+    {
+        // Exactly the two tails: no load ever fits and there is nothing to evict
+        TextureStreamer streamer(20);
+        const TextureStreamer::TextureId a = streamer.registerTexture(MipBytes, Tail);
+        const TextureStreamer::TextureId b = streamer.registerTexture(MipBytes, Tail);
+
+        Commands commands = frame(streamer, { a, b });
+        check(commands.empty() && streamer.stats().deniedLoads == 2, "denied: both loads refused over budget");
+        frame(streamer, { a });
+        check(streamer.stats().deniedLoads == 3 && streamer.stats().loadsIssued == 0, "denied: counted every frame it is refused");
+
+        // Room for one mip: the first load goes, the second is denied
+        streamer.setBudget(70);
+        commands = frame(streamer, { a, b });
+        check(commands.size() == 1 && streamer.stats().loadsIssued == 1 && streamer.stats().deniedLoads == 4,
+            "denied: only what fits is issued");
+    }
+
+    void testReplaceTexture()
+    {
+        TextureStreamer streamer(10000, 1);
+        const TextureStreamer::TextureId a = streamer.registerTexture(MipBytes, Tail);
+        const TextureStreamer::TextureId b = streamer.registerTexture(MipBytes, Tail);
+        frame(streamer, { a });
+        frame(streamer, { a });
+        check(streamer.stats().residentBytes == 160 + 10, "replace: a resident before the reload");
+
+        // Reloaded bigger: back to its new tail, the old mips no longer counted
+        streamer.replaceTexture(a, { 400, 100, 25, 5 }, 2);
+        check(streamer.residentMip(a) == 2 && streamer.tailMip(a) == 2, "replace: back to the tail");
+        check(streamer.stats().residentBytes == 30 + 10, "replace: resident bytes of the new tail");
+
+        // Replaced with a load in flight: the in-flight bytes go, a late completion is ignored
+        streamer.requestMip(b, 0);
+        Commands commands;
+        streamer.update(commands);
+        check(commands.size() == 1 && streamer.stats().inFlightBytes == 50, "replace: b's load in flight");
+        streamer.replaceTexture(b, { 8, 2 }, 5);
+        check(streamer.tailMip(b) == 1 && streamer.stats().inFlightBytes == 0, "replace: tail clamped, in-flight bytes dropped");
+        streamer.completeLoad(b, commands[0].mip);
+        check(streamer.residentMip(b) == 1 && streamer.stats().residentBytes == 30 + 2, "replace: stale completion ignored");
+    }
+
+    void testMipForFootprint()
+    {
+        check(TextureStreamer::mipForFootprint(1024, 1024, 11) == 0, "footprint: one texel per pixel");
+        check(TextureStreamer::mipForFootprint(1024, 256, 11) == 2, "footprint: four texels per pixel");
+        check(TextureStreamer::mipForFootprint(1024, 0, 11) == 10, "footprint: off screen");
+        check(TextureStreamer::mipForFootprint(1 << 20, 1, 4) == 3, "footprint: clamped to the chain");
+    }
+}
+
+int main()
+{
+    testLruEviction();
+    testPinnedTailAndBudget();
+    testDeniedLoads();
+    testReplaceTexture();
+    testMipForFootprint();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("texture streamer ok\n");
+    return 0;
+}
@@ -0,0 +1,169 @@
+// ThreadPool and CompletionQueue: every submitted task runs once and wait() sees them all, parallelFor
+// covers its range exactly once, and the Vyukov MPSC queue handed items by several producers loses,
+// duplicates and reorders none of them per producer. Meant to run under TSan.
+
+#include "ThreadPool.h"
+#include "CompletionQueue.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    int g_failures = 0;
+
+    void check(bool condition, const char* what)
+    {
+        if (!condition)
+        {
+            std::printf("FAIL %s\n", what);
+            ++g_failures;
+        }
+    }
+
+    void testSubmit()
+    {
+        ThreadPool pool(4);
+        check(pool.size() == 4, "pool: worker count");
+
+        std::atomic<int> runs{ 0 };
+        for (int i = 0; i < 1000; i++)
+        {
+            pool.submit([&runs]() { ++runs; });
+        }
+        pool.wait();
+        check(runs == 1000, "submit: every task ran before wait() returned");
+
+        // Tasks that submit more tasks are waited for as well
+        for (int i = 0; i < 100; i++)
+        {
+            pool.submit([&pool, &runs]() { pool.submit([&runs]() { ++runs; }); });
+        }
+        pool.wait();
+        check(runs == 1100, "submit: nested tasks waited for");
+    }
+
+    void testParallelFor()
+    {
+        ThreadPool pool(3);
+        std::vector<std::atomic<int>> hits(10007);
+        pool.parallelFor(hits.size(), 16, [&hits](size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                    ++hits[i];
+            });
+        bool once = true;
+        for (const auto& hit : hits)
+            once = once && hit == 1;
+        check(once, "parallelFor: every index exactly once");
+
+        int calls = 0;
+        pool.parallelFor(10, 100, [&calls](size_t begin, size_t end) { calls += (begin == 0 && end == 10); });
+        check(calls == 1, "parallelFor: a single chunk runs inline");
+
+        pool.parallelFor(0, 1, [&calls](size_t, size_t) { ++calls; });
+        check(calls == 1, "parallelFor: empty range does nothing");
+
+        // Called from inside a task while other tasks hold the workers
+        std::atomic<size_t> sum{ 0 };
+        for (int t = 0; t < 4; t++)
+        {
+            pool.submit([&pool, &sum]()
+                {
+                    pool.parallelFor(1000, 10, [&sum](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; i++)
+                                sum += i;
+                        });
+                });
+        }
+        pool.wait();
+        check(sum == 4 * (999 * 1000 / 2), "parallelFor: nested in tasks on a busy pool");
+    }
+
+    void testQueueProducers()
+    {
+        const int producers = 4;
+        const int perProducer = 20000;
+
+        CompletionQueue<int> queue;
+        check(queue.empty(), "queue: starts empty");
+
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; p++)
+        {
+            threads.emplace_back([&queue, p]()
+                {
+                    for (int i = 0; i < perProducer; i++)
+                        queue.push(p * perProducer + i);
+                });
+        }
+
+        // The consumer drains while the producers push; pop() may miss an item mid-push, so keep going until all are seen
+        std::vector<int> last(producers, -1);
+        std::vector<char> seen(producers * perProducer, 0);
+        bool ordered = true;
+        bool unique = true;
+        int received = 0;
+        while (received < producers * perProducer)
+        {
+            int item;
+            if (!queue.pop(item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            const int p = item / perProducer;
+            const int i = item % perProducer;
+            ordered = ordered && i > last[p];
+            last[p] = i;
+            unique = unique && !seen[item];
+            seen[item] = 1;
+            ++received;
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        int item;
+        check(!queue.pop(item) && queue.empty(), "queue: nothing left after every item");
+        check(unique, "queue: no item twice");
+        check(ordered, "queue: each producer's items in push order");
+    }
+
+    void testQueueOwnership()
+    {
+        // Items the consumer never pops go with the queue
+        std::weak_ptr<int> left;
+        {
+            CompletionQueue<std::shared_ptr<int>> queue;
+            queue.push(std::make_shared<int>(1));
+            auto value = std::make_shared<int>(2);
+            left = value;
+            queue.push(std::move(value));
+
+            std::shared_ptr<int> popped;
+            check(queue.pop(popped) && *popped == 1 && popped.use_count() == 1, "ownership: popped item moved out");
+            check(!left.expired(), "ownership: the unpopped item still queued");
+        }
+        check(left.expired(), "ownership: queue destroyed with no leak");
+    }
+}
+
+int main()
+{
+    testSubmit();
+    testParallelFor();
+    testQueueProducers();
+    testQueueOwnership();
+
+    if (g_failures)
+    {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("thread pool ok\n");
+    return 0;
+}
@@ -315,12 +315,12 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    inline void DecodeBC1(
-        _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor,
+    inline void DecodeBC1Palette(
+        _Out_writes_(4) XMVECTOR *pPalette,
         _In_ const D3DX_BC1 *pBC,
         bool isbc1) noexcept
     {
-        assert(pColor && pBC);
+        assert(pPalette && pBC);
         static_assert(sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes");
 
         static XMVECTORF32 s_Scale = { { { 1.f / 31.f, 1.f / 63.f, 1.f / 31.f, 1.f } } };
@@ -349,19 +349,82 @@ namespace
             clr3 = XMVectorLerp(clr0, clr1, 2.f / 3.f);
         }
 
+        pPalette[0] = clr0;
+        pPalette[1] = clr1;
+        pPalette[2] = clr2;
+        pPalette[3] = clr3;
+    }
+
+    inline void DecodeBC1(
+        _Out_writes_(NUM_PIXELS_PER_BLOCK) XMVECTOR *pColor,
+        _In_ const D3DX_BC1 *pBC,
+        bool isbc1) noexcept
+    {
+        assert(pColor && pBC);
+
+        XMVECTOR palette[4];
+        DecodeBC1Palette(palette, pBC, isbc1);
+
         uint32_t dw = pBC->bitmap;
 
         for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i, dw >>= 2)
         {
-            switch (dw & 3)
+            pColor[i] = palette[dw & 3];
+        }
+    }
+
+    // Packed R8G8B8A8 palette for the fast decoders. Runs of blocks sharing their endpoints
+    // (flat areas) reuse the previous palette.
+    class BC1PaletteRGBA8
+    {
+    public:
+        BC1PaletteRGBA8() noexcept : m_endpoints(0), m_valid(false), m_palette{} {}
+
+        const uint32_t* Get(_In_ const D3DX_BC1 *pBC, bool isbc1) noexcept
+        {
+            uint32_t endpoints;
+            memcpy(&endpoints, pBC->rgb, sizeof(endpoints));
+
+            if (!m_valid || endpoints != m_endpoints)
             {
-            case 0: pColor[i] = clr0; break;
-            case 1: pColor[i] = clr1; break;
-            case 2: pColor[i] = clr2; break;
+                XMVECTOR palette[4];
+                DecodeBC1Palette(palette, pBC, isbc1);
+                for (size_t i = 0; i < 4; ++i)
+                    m_palette[i] = PackRGBA8(palette[i]);
 
-            case 3:
-            default: pColor[i] = clr3; break;
+                m_endpoints = endpoints;
+                m_valid = true;
             }
+
+            return m_palette;
+        }
+
+    private:
+        uint32_t m_endpoints;
+        bool m_valid;
+        uint32_t m_palette[4];
+    };
+
+    //-------------------------------------------------------------------------------------
+    inline void DecodeBC3Alpha(
+        _Out_writes_(8) float *pAlpha,
+        _In_ const D3DX_BC3 *pBC3) noexcept
+    {
+        pAlpha[0] = static_cast<float>(pBC3->alpha[0]) * (1.0f / 255.0f);
+        pAlpha[1] = static_cast<float>(pBC3->alpha[1]) * (1.0f / 255.0f);
+
+        if (pBC3->alpha[0] > pBC3->alpha[1])
+        {
+            for (size_t i = 1; i < 7; ++i)
+                pAlpha[i + 1] = (pAlpha[0] * float(7u - i) + pAlpha[1] * float(i)) * (1.0f / 7.0f);
+        }
+        else
+        {
+            for (size_t i = 1; i < 5; ++i)
+                pAlpha[i + 1] = (pAlpha[0] * float(5u - i) + pAlpha[1] * float(i)) * (1.0f / 5.0f);
+
+            pAlpha[6] = 0.0f;
+            pAlpha[7] = 1.0f;
         }
     }
 
@@ -911,23 +974,7 @@ void DirectX::D3DXDecodeBC3(XMVECTOR *pColor, const uint8_t *pBC) noexcept
 
     // Adaptive 3-bit alpha part
     float fAlpha[8];
-
-    fAlpha[0] = static_cast<float>(pBC3->alpha[0]) * (1.0f / 255.0f);
-    fAlpha[1] = static_cast<float>(pBC3->alpha[1]) * (1.0f / 255.0f);
-
-    if (pBC3->alpha[0] > pBC3->alpha[1])
-    {
-        for (size_t i = 1; i < 7; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * float(7u - i) + fAlpha[1] * float(i)) * (1.0f / 7.0f);
-    }
-    else
-    {
-        for (size_t i = 1; i < 5; ++i)
-            fAlpha[i + 1] = (fAlpha[0] * float(5u - i) + fAlpha[1] * float(i)) * (1.0f / 5.0f);
-
-        fAlpha[6] = 0.0f;
-        fAlpha[7] = 1.0f;
-    }
+    DecodeBC3Alpha(fAlpha, pBC3);
 
     uint32_t dw = uint32_t(pBC3->bitmap[0]) | uint32_t(pBC3->bitmap[1] << 8) | uint32_t(pBC3->bitmap[2] << 16);
 
@@ -1139,3 +1186,109 @@ void DirectX::D3DXEncodeBC3(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags
         pBC3->bitmap[2 + iSet * 3] = reinterpret_cast<uint8_t *>(&dw)[2];
     }
 }
+
+
+//-------------------------------------------------------------------------------------
+// Fast decoders to R8G8B8A8
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::FastDecodeBC1(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount) noexcept
+{
+    assert(pDest && pBC);
+
+    BC1PaletteRGBA8 palette;
+    for (size_t i = 0; i < blockCount; ++i, pBC += 8, pDest += 16)
+    {
+        auto pBC1 = reinterpret_cast<const D3DX_BC1 *>(pBC);
+        WriteBlock2BitIndices(pDest, rowPitch, palette.Get(pBC1, true), pBC1->bitmap);
+    }
+}
+
+_Use_decl_annotations_
+void DirectX::FastDecodeBC2(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount) noexcept
+{
+    assert(pDest && pBC);
+
+    // 4-bit alpha, scaled the same way D3DXDecodeBC2 does
+    struct AlphaTable { uint8_t value[16]; };
+    static const AlphaTable s_alpha = []() noexcept
+    {
+        AlphaTable table = {};
+        for (size_t i = 0; i < 16; ++i)
+            table.value[i] = static_cast<uint8_t>(PackRGBA8(XMVectorReplicate(static_cast<float>(i) * (1.0f / 15.0f))) >> 24);
+        return table;
+    }();
+
+    BC1PaletteRGBA8 palette;
+    for (size_t i = 0; i < blockCount; ++i, pBC += 16, pDest += 16)
+    {
+        auto pBC2 = reinterpret_cast<const D3DX_BC2 *>(pBC);
+        WriteBlock2BitIndices(pDest, rowPitch, palette.Get(&pBC2->bc1, false), pBC2->bc1.bitmap);
+
+        for (size_t row = 0; row < 4; ++row)
+        {
+            const uint32_t dw = pBC2->bitmap[row >> 1] >> ((row & 1) * 16);
+            uint8_t* dptr = pDest + rowPitch * row + 3;
+            for (size_t x = 0; x < 4; ++x)
+                dptr[x * 4] = s_alpha.value[(dw >> (x * 4)) & 0xf];
+        }
+    }
+}
+
+_Use_decl_annotations_
+void DirectX::FastDecodeBC3(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount) noexcept
+{
+    assert(pDest && pBC);
+
+    BC1PaletteRGBA8 palette;
+    for (size_t i = 0; i < blockCount; ++i, pBC += 16, pDest += 16)
+    {
+        auto pBC3 = reinterpret_cast<const D3DX_BC3 *>(pBC);
+        WriteBlock2BitIndices(pDest, rowPitch, palette.Get(&pBC3->bc1, false), pBC3->bc1.bitmap);
+
+        float fAlpha[8];
+        DecodeBC3Alpha(fAlpha, pBC3);
+
+        uint32_t alpha[8];
+        const uint32_t lo = PackRGBA8(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(fAlpha)));
+        const uint32_t hi = PackRGBA8(XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(fAlpha + 4)));
+        for (size_t j = 0; j < 4; ++j)
+        {
+            alpha[j] = (lo >> (j * 8)) & 0xFF;
+            alpha[j + 4] = (hi >> (j * 8)) & 0xFF;
+        }
+
+        uint64_t dw = 0;
+        memcpy(&dw, pBC3->bitmap, sizeof(pBC3->bitmap));
+
+        for (size_t row = 0; row < 4; ++row)
+        {
+            auto dptr = reinterpret_cast<uint32_t*>(pDest + rowPitch * row);
+            for (size_t x = 0; x < 4; ++x, dw >>= 3)
+                dptr[x] = (dptr[x] & 0x00FFFFFF) | (alpha[dw & 0x7] << 24);
+        }
+    }
+}
+
+_Use_decl_annotations_
+BC_DECODE_FAST DirectX::GetFastDecoder(DXGI_FORMAT format, size_t& blockSize) noexcept
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_BC1_TYPELESS:
+    case DXGI_FORMAT_BC1_UNORM:
+    case DXGI_FORMAT_BC1_UNORM_SRGB:    blockSize = 8;  return FastDecodeBC1;
+    case DXGI_FORMAT_BC2_TYPELESS:
+    case DXGI_FORMAT_BC2_UNORM:
+    case DXGI_FORMAT_BC2_UNORM_SRGB:    blockSize = 16; return FastDecodeBC2;
+    case DXGI_FORMAT_BC3_TYPELESS:
+    case DXGI_FORMAT_BC3_UNORM:
+    case DXGI_FORMAT_BC3_UNORM_SRGB:    blockSize = 16; return FastDecodeBC3;
+    case DXGI_FORMAT_BC5_TYPELESS:
+    case DXGI_FORMAT_BC5_UNORM:         blockSize = 16; return FastDecodeBC5U;
+    case DXGI_FORMAT_BC7_TYPELESS:
+    case DXGI_FORMAT_BC7_UNORM:
+    case DXGI_FORMAT_BC7_UNORM_SRGB:    blockSize = 16; return FastDecodeBC7;
+    default:                            blockSize = 0;  return nullptr;
+    }
+}
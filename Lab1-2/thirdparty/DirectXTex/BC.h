@@ -45,6 +45,27 @@ namespace DirectX
 
         BC_FLAGS_FORCE_BC7_MODE6 = 0x100000,
         // BC7 should only use mode 6; skip other modes
+
+        BC_FLAGS_FAST = 0x200000,
+        // BC1 & BC3 from 8-bit RGBA sources use the integer encoder in BCFast.cpp
+
+        BC_FLAGS_FAST_REFINE = 0x400000,
+        // The fast encoder fits endpoints to the colors instead of using the bounding box
+
+        BC_FLAGS_BC7_FAST = 0x4000000,
+        BC_FLAGS_BC7_VERYFAST = 0x8000000,
+        BC_FLAGS_BC7_ULTRAFAST = 0xC000000,
+        BC_FLAGS_BC7_TIER_MASK = 0xC000000,
+        // BC7 encoder tiers trading quality for speed; none of them set is the full search
+    };
+
+    enum BC_FAST_QUALITY : uint32_t
+    {
+        BC_FAST_QUALITY_FAST = 0,
+        // Inset bounding box endpoints, indices by projection on the box diagonal
+
+        BC_FAST_QUALITY_NORMAL,
+        // Box diagonal picked from the color covariance, plus one least-squares endpoint refit
     };
 
     //-------------------------------------------------------------------------------------
@@ -342,4 +363,66 @@ namespace DirectX
     void D3DXEncodeBC6HS(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
     void D3DXEncodeBC7(_Out_writes_(16) uint8_t *pBC, _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR *pColor, _In_ uint32_t flags) noexcept;
 
+    // Fast encoders: pPixels holds blockCount blocks of 16 R8G8B8A8 texels each, in row order.
+    // BC1 texels with alpha below alphaRef become transparent (alphaRef = 0 keeps every texel opaque)
+    void FastEncodeBC1(_Out_writes_(blockCount * 8) uint8_t *pBC, _In_reads_(blockCount * NUM_PIXELS_PER_BLOCK) const uint32_t *pPixels, _In_ size_t blockCount, _In_ uint32_t alphaRef, _In_ BC_FAST_QUALITY quality) noexcept;
+    void FastEncodeBC3(_Out_writes_(blockCount * 16) uint8_t *pBC, _In_reads_(blockCount * NUM_PIXELS_PER_BLOCK) const uint32_t *pPixels, _In_ size_t blockCount, _In_ BC_FAST_QUALITY quality) noexcept;
+
+    // Fast decoders: blockCount blocks side by side become 4 rows of R8G8B8A8 texels at pDest, rowPitch bytes apart.
+    // The texels are bit-identical to D3DXDecodeBC* followed by a store to DXGI_FORMAT_R8G8B8A8_UNORM
+    typedef void (*BC_DECODE_FAST)(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount);
+
+    void FastDecodeBC1(_Out_writes_bytes_(rowPitch * 4) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(blockCount * 8) const uint8_t *pBC, _In_ size_t blockCount) noexcept;
+    void FastDecodeBC2(_Out_writes_bytes_(rowPitch * 4) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(blockCount * 16) const uint8_t *pBC, _In_ size_t blockCount) noexcept;
+    void FastDecodeBC3(_Out_writes_bytes_(rowPitch * 4) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(blockCount * 16) const uint8_t *pBC, _In_ size_t blockCount) noexcept;
+    void FastDecodeBC5U(_Out_writes_bytes_(rowPitch * 4) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(blockCount * 16) const uint8_t *pBC, _In_ size_t blockCount) noexcept;
+    void FastDecodeBC7(_Out_writes_bytes_(rowPitch * 4) uint8_t *pDest, _In_ size_t rowPitch, _In_reads_(blockCount * 16) const uint8_t *pBC, _In_ size_t blockCount) noexcept;
+
+    // Fast decoder for a BC format (typeless formats decode as UNORM), or nullptr if there is none
+    BC_DECODE_FAST GetFastDecoder(_In_ DXGI_FORMAT format, _Out_ size_t& blockSize) noexcept;
+
+    // Decoded color as StoreScanline writes it to DXGI_FORMAT_R8G8B8A8_UNORM
+    inline uint32_t PackRGBA8(FXMVECTOR color) noexcept
+    {
+        PackedVector::XMUBYTEN4 packed;
+        PackedVector::XMStoreUByteN4(&packed, color);
+        return packed.v;
+    }
+
+    // Writes a 4x4 block of texels picked from a 4-entry palette by 2-bit indices (texel 0 in the low bits)
+    inline void WriteBlock2BitIndices(
+        _Out_writes_bytes_(rowPitch * 4) uint8_t *pDest,
+        size_t rowPitch,
+        _In_reads_(4) const uint32_t *pPalette,
+        uint32_t indices) noexcept
+    {
+    #if defined(_XM_SSE_INTRINSICS_)
+        const __m128i p0 = _mm_set1_epi32(static_cast<int>(pPalette[0]));
+        const __m128i p1 = _mm_set1_epi32(static_cast<int>(pPalette[1]));
+        const __m128i p2 = _mm_set1_epi32(static_cast<int>(pPalette[2]));
+        const __m128i p3 = _mm_set1_epi32(static_cast<int>(pPalette[3]));
+        const __m128i three = _mm_set1_epi32(3);
+
+        // Lane x holds the indices of column x; each row shifts them down by 8 bits
+        __m128i column = _mm_set_epi32(static_cast<int>(indices >> 6), static_cast<int>(indices >> 4),
+            static_cast<int>(indices >> 2), static_cast<int>(indices));
+        for (size_t row = 0; row < 4; ++row, column = _mm_srli_epi32(column, 8))
+        {
+            const __m128i index = _mm_and_si128(column, three);
+            __m128i texels = _mm_and_si128(_mm_cmpeq_epi32(index, _mm_setzero_si128()), p0);
+            texels = _mm_or_si128(texels, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(1)), p1));
+            texels = _mm_or_si128(texels, _mm_and_si128(_mm_cmpeq_epi32(index, _mm_set1_epi32(2)), p2));
+            texels = _mm_or_si128(texels, _mm_and_si128(_mm_cmpeq_epi32(index, three), p3));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pDest + rowPitch * row), texels);
+        }
+    #else
+        for (size_t row = 0; row < 4; ++row, indices >>= 8)
+        {
+            auto dptr = reinterpret_cast<uint32_t*>(pDest + rowPitch * row);
+            for (size_t x = 0; x < 4; ++x)
+                dptr[x] = pPalette[(indices >> (x * 2)) & 3];
+        }
+    #endif
+    }
+
 } // namespace
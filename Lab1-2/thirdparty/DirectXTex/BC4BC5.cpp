@@ -375,6 +375,20 @@ namespace
             pBC->SetIndex(i, uBestIndex);
         }
     }
+
+    // The 8 palette values of a block as UNORM8, one per byte
+    inline uint64_t DecodePaletteUNORM8(_In_ const BC4_UNORM* pBC) noexcept
+    {
+        float fPalette[8];
+        for (size_t i = 0; i < 8; ++i)
+        {
+            fPalette[i] = pBC->DecodeFromIndex(i);
+        }
+
+        const uint32_t lo = PackRGBA8(XMVectorSet(fPalette[0], fPalette[1], fPalette[2], fPalette[3]));
+        const uint32_t hi = PackRGBA8(XMVectorSet(fPalette[4], fPalette[5], fPalette[6], fPalette[7]));
+        return uint64_t(lo) | (uint64_t(hi) << 32);
+    }
 }
 
 
@@ -560,3 +574,38 @@ void DirectX::D3DXEncodeBC5S(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flag
     FindClosestSNORM(pBCR, theTexelsU);
     FindClosestSNORM(pBCG, theTexelsV);
 }
+
+
+//-------------------------------------------------------------------------------------
+// Fast decoder to R8G8B8A8
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::FastDecodeBC5U(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(BC4_UNORM) == 8, "BC4_UNORM should be 8 bytes");
+
+    for (size_t i = 0; i < blockCount; ++i, pBC += 16, pDest += 16)
+    {
+        auto pBCR = reinterpret_cast<const BC4_UNORM*>(pBC);
+        auto pBCG = reinterpret_cast<const BC4_UNORM*>(pBC + sizeof(BC4_UNORM));
+
+        const uint64_t red = DecodePaletteUNORM8(pBCR);
+        const uint64_t green = DecodePaletteUNORM8(pBCG);
+
+        uint64_t r = pBCR->data >> 16;
+        uint64_t g = pBCG->data >> 16;
+
+        for (size_t row = 0; row < 4; ++row)
+        {
+            auto dptr = reinterpret_cast<uint32_t*>(pDest + rowPitch * row);
+            for (size_t x = 0; x < 4; ++x, r >>= 3, g >>= 3)
+            {
+                // Blue is 0 and alpha 1, as D3DXDecodeBC5U returns them
+                dptr[x] = 0xFF000000
+                    | static_cast<uint32_t>((red >> ((r & 0x7) * 8)) & 0xFF)
+                    | (static_cast<uint32_t>((green >> ((g & 0x7) * 8)) & 0xFF) << 8);
+            }
+        }
+    }
+}
@@ -774,6 +774,7 @@ namespace
     {
     public:
         void Decode(_Out_writes_(NUM_PIXELS_PER_BLOCK) HDRColorA* pOut) const noexcept;
+        void DecodeLDR(_Out_writes_(NUM_PIXELS_PER_BLOCK) LDRColorA* pOut) const noexcept;
         void Encode(uint32_t flags, _In_reads_(NUM_PIXELS_PER_BLOCK) const HDRColorA* const pIn) noexcept;
 
     private:
@@ -863,6 +864,10 @@ namespace
             _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndex2[]) noexcept;
         void FixEndpointPBits(_In_ const EncodeParams* pEP, _In_reads_(BC7_MAX_REGIONS) const LDREndPntPair *pOrigEndpoints, _Out_writes_(BC7_MAX_REGIONS) LDREndPntPair *pFixedEndpoints) noexcept;
         float Refine(_In_ const EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uRotation, _In_ size_t uIndexMode) noexcept;
+        void FitEndPoints(_In_ const EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uIndexMode,
+            _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndices[], _In_reads_(NUM_PIXELS_PER_BLOCK) const size_t aIndices2[],
+            _Out_writes_(BC7_MAX_REGIONS) LDREndPntPair aEndPts[]) const noexcept;
+        float RefineLeastSquares(_In_ const EncodeParams* pEP, _In_ size_t uShape, _In_ size_t uRotation, _In_ size_t uIndexMode) noexcept;
 
         float MapColors(_In_ const EncodeParams* pEP, _In_reads_(np) const LDRColorA aColors[], _In_ size_t np, _In_ size_t uIndexMode,
             _In_ const LDREndPntPair& endPts, _In_ float fMinErr) const noexcept;
@@ -1648,6 +1653,170 @@ namespace
         #endif
         }
     }
+
+    void FillWithErrorColors(_Out_writes_(NUM_PIXELS_PER_BLOCK) LDRColorA* pOut) noexcept
+    {
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+        #ifdef _DEBUG
+            pOut[i] = LDRColorA(255, 0, 255, 255);
+        #else
+            pOut[i] = LDRColorA(0, 0, 0, 255);
+        #endif
+        }
+    }
+
+
+    //-------------------------------------------------------------------------------------
+    // BC7 encoder tiers (BC_FLAGS_BC7_TIER_MASK). Errors are sums over the block of squared
+    // 8-bit channel differences, as ComputeError returns them.
+    //-------------------------------------------------------------------------------------
+    struct BC7Profile
+    {
+        uint8_t modeOrder[8];
+        size_t shapes;          // partitions refined per mode and index mode; 0 is a quarter of them
+        bool preselect;         // partitions ranked once per block by line fit, not by RoughMSE per mode
+        bool prune;             // skip modes that cannot win on the block content
+        bool rotations;         // modes 4 and 5 try every rotation and index mode
+        bool opaqueScalar;      // modes 4 and 5 are tried on opaque blocks
+        bool leastSquares;      // endpoints refit by least squares instead of the perturbation search
+        bool polish;            // the best least squares candidate also gets the perturbation search
+        float flatVariance;     // blocks with less total variance than this skip the multi-subset modes
+        float earlyOut;         // the search stops once a mode gets within this
+    };
+
+    const BC7Profile& GetBC7Profile(uint32_t flags) noexcept
+    {
+        static const BC7Profile s_profiles[] =
+        {
+            // Full search
+            { { 0, 1, 2, 3, 4, 5, 6, 7 }, 0, false, false, true, true, false, false, 0.f, 0.f },
+            // BC_FLAGS_BC7_FAST
+            { { 6, 1, 3, 7, 5, 4, 0, 2 }, 8, true, true, true, true, true, true, 0.f, 0.f },
+            // BC_FLAGS_BC7_VERYFAST
+            { { 6, 1, 3, 7, 5, 4, 0, 2 }, 2, true, true, true, false, true, false, 0.f, 0.f },
+            // BC_FLAGS_BC7_ULTRAFAST
+            { { 6, 1, 3, 7, 5, 4, 0, 2 }, 1, true, true, false, false, true, false, 16.f, 4.f },
+        };
+        static_assert(BC_FLAGS_BC7_TIER_MASK >> 26 == std::size(s_profiles) - 1, "One profile per tier");
+
+        return s_profiles[(flags & BC_FLAGS_BC7_TIER_MASK) >> 26];
+    }
+
+    inline XMVECTOR XM_CALLCONV TransformSymmetric(_In_reads_(4) const XMVECTOR aRows[], FXMVECTOR v) noexcept
+    {
+        XMVECTOR result = XMVectorMultiply(aRows[0], XMVectorSplatX(v));
+        result = XMVectorMultiplyAdd(aRows[1], XMVectorSplatY(v), result);
+        result = XMVectorMultiplyAdd(aRows[2], XMVectorSplatZ(v), result);
+        return XMVectorMultiplyAdd(aRows[3], XMVectorSplatW(v), result);
+    }
+
+    // Squared distance of the subset's pixels from their best-fit line: the total variance
+    // less the largest eigenvalue of the covariance, found by power iteration
+    float LineFitError(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR aPixels[],
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint8_t aPartition[],
+        uint8_t uSubset,
+        _Out_opt_ float* pVariance = nullptr) noexcept
+    {
+        if (pVariance)
+            *pVariance = 0.f;
+
+        XMVECTOR sum = XMVectorZero();
+        size_t np = 0;
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (aPartition[i] == uSubset)
+            {
+                sum = XMVectorAdd(sum, aPixels[i]);
+                ++np;
+            }
+        }
+
+        // Any two colors lie on a line
+        if (np < 3)
+            return 0.f;
+
+        const XMVECTOR mean = XMVectorScale(sum, 1.f / float(np));
+
+        XMVECTOR aCov[4] = { XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (aPartition[i] == uSubset)
+            {
+                const XMVECTOR d = XMVectorSubtract(aPixels[i], mean);
+                aCov[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), aCov[0]);
+                aCov[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), aCov[1]);
+                aCov[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), aCov[2]);
+                aCov[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), aCov[3]);
+            }
+        }
+
+        const float fTrace = XMVectorGetX(aCov[0]) + XMVectorGetY(aCov[1]) + XMVectorGetZ(aCov[2]) + XMVectorGetW(aCov[3]);
+        if (pVariance)
+            *pVariance = fTrace;
+        if (fTrace <= 0.f)
+            return 0.f;
+
+        // Start from the longest row so the axis can't begin orthogonal to the principal one
+        XMVECTOR axis = aCov[0];
+        float fBest = XMVectorGetX(XMVector4LengthSq(axis));
+        for (size_t k = 1; k < 4; ++k)
+        {
+            const float fLen = XMVectorGetX(XMVector4LengthSq(aCov[k]));
+            if (fLen > fBest)
+            {
+                fBest = fLen;
+                axis = aCov[k];
+            }
+        }
+
+        for (size_t iter = 0; iter < 4; ++iter)
+            axis = XMVector4Normalize(TransformSymmetric(aCov, axis));
+
+        const float fLambda = XMVectorGetX(XMVector4Dot(axis, TransformSymmetric(aCov, axis)));
+        return std::max(0.f, fTrace - fLambda);
+    }
+
+    // Orders all 64 partitions of the 2 (uPartitions = 1) or 3 subset modes by line fit error
+    void RankPartitions(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const XMVECTOR aPixels[],
+        size_t uPartitions,
+        _Out_writes_(BC7_MAX_SHAPES) size_t auShape[]) noexcept
+    {
+        float afErr[BC7_MAX_SHAPES];
+        for (size_t s = 0; s < BC7_MAX_SHAPES; ++s)
+        {
+            afErr[s] = 0.f;
+            for (size_t p = 0; p <= uPartitions; ++p)
+                afErr[s] += LineFitError(aPixels, g_aPartitionTable[uPartitions][s], uint8_t(p));
+            auShape[s] = s;
+        }
+
+        std::stable_sort(auShape, auShape + BC7_MAX_SHAPES, [&](size_t a, size_t b) noexcept { return afErr[a] < afErr[b]; });
+    }
+
+    // Swaps a color channel with alpha for the mode 4 and 5 rotations; applying it twice undoes it
+    inline void SwapRotation(_Inout_updates_all_(NUM_PIXELS_PER_BLOCK) LDRColorA aPixels[], size_t uRotation) noexcept
+    {
+        switch (uRotation)
+        {
+        case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(aPixels[i].r, aPixels[i].a); break;
+        case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(aPixels[i].g, aPixels[i].a); break;
+        case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(aPixels[i].b, aPixels[i].a); break;
+        default: break;
+        }
+    }
+
+    inline const int* GetIndexWeights(size_t uIndexPrec) noexcept
+    {
+        switch (uIndexPrec)
+        {
+        case 2: return g_aWeights2;
+        case 3: return g_aWeights3;
+        default: assert(uIndexPrec == 4); return g_aWeights4;
+        }
+    }
 }
 
 
@@ -2567,6 +2736,20 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
 {
     assert(pOut);
 
+    LDRColorA aLDR[NUM_PIXELS_PER_BLOCK];
+    DecodeLDR(aLDR);
+
+    for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+    {
+        pOut[i] = HDRColorA(aLDR[i]);
+    }
+}
+
+_Use_decl_annotations_
+void D3DX_BC7::DecodeLDR(LDRColorA* pOut) const noexcept
+{
+    assert(pOut);
+
     size_t uFirst = 0;
     while (uFirst < 128 && !GetBit(uFirst)) {}
     const uint8_t uMode = uint8_t(uFirst - 1);
@@ -2766,7 +2949,7 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
             default: break;
             }
 
-            pOut[i] = HDRColorA(outPixel);
+            pOut[i] = outPixel;
         }
     }
     else
@@ -2775,7 +2958,7 @@ void D3DX_BC7::Decode(HDRColorA* pOut) const noexcept
         OutputDebugStringA("BC7: Reserved mode 8 encountered during decoding\n");
     #endif
         // Per the BC7 format spec, we must return transparent black
-        memset(pOut, 0, sizeof(HDRColorA) * NUM_PIXELS_PER_BLOCK);
+        memset(pOut, 0, sizeof(LDRColorA) * NUM_PIXELS_PER_BLOCK);
     }
 }
 
@@ -2784,6 +2967,8 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 {
     assert(pIn);
 
+    const BC7Profile& profile = GetBC7Profile(flags);
+
     D3DX_BC7 final = *this;
     EncodeParams EP(pIn);
     float fMSEBest = FLT_MAX;
@@ -2800,8 +2985,47 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
 
     const bool bHasAlpha = (alphaMask != 0xFF);
 
-    for (EP.uMode = 0; EP.uMode < 8 && fMSEBest > 0; ++EP.uMode)
+    // Partitions of the 2 and 3 subset modes, best first, when the tier preselects them
+    size_t auRanked[2][BC7_MAX_SHAPES];
+    bool bMultiSubset = true;
+    float fVariance = 0.f;
+    if (profile.prune || profile.preselect)
+    {
+        XMVECTOR aPixels[NUM_PIXELS_PER_BLOCK];
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            aPixels[i] = XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(&EP.aLDRPixels[i]));
+
+        if (profile.prune)
+        {
+            LineFitError(aPixels, g_aPartitionTable[0][0], 0, &fVariance);
+            bMultiSubset = fVariance > profile.flatVariance;
+        }
+
+        if (profile.preselect && bMultiSubset)
+        {
+            RankPartitions(aPixels, 1, auRanked[0]);
+            if (flags & BC_FLAGS_USE_3SUBSETS)
+                RankPartitions(aPixels, 2, auRanked[1]);
+        }
+    }
+
+    uint8_t aModeOrder[c_NumModes];
+    memcpy(aModeOrder, profile.modeOrder, sizeof(aModeOrder));
+    if (profile.prune && fVariance <= 0.f)
     {
+        // Mode 5 usually represents a solid color exactly, so try it first
+        uint8_t* pMode5 = std::find(aModeOrder, aModeOrder + c_NumModes, uint8_t(5));
+        std::rotate(aModeOrder, pMode5, pMode5 + 1);
+    }
+
+    // Where the least squares search found its best block, for the polish
+    uint8_t uBestMode = 0;
+    size_t uBestShape = 0, uBestRotation = 0, uBestIndexMode = 0;
+
+    for (size_t uModeIndex = 0; uModeIndex < c_NumModes && fMSEBest > 0; ++uModeIndex)
+    {
+        EP.uMode = aModeOrder[uModeIndex];
+
         if (!(flags & BC_FLAGS_USE_3SUBSETS) && (EP.uMode == 0 || EP.uMode == 2))
         {
             // 3 subset modes tend to be used rarely and add significant compression time
@@ -2820,69 +3044,110 @@ void D3DX_BC7::Encode(uint32_t flags, const HDRColorA* const pIn) noexcept
             continue;
         }
 
+        if (profile.prune)
+        {
+            if (ms_aInfo[EP.uMode].uPartitions > 0 && !bMultiSubset)
+                continue;
+
+            // Modes 0 to 3 have no alpha channel
+            if (bHasAlpha && !ms_aInfo[EP.uMode].RGBAPrec.a)
+                continue;
+
+            // Solid color blocks keep modes 4 and 5, which represent them exactly
+            if (!bHasAlpha && ms_aInfo[EP.uMode].uRotationBits && !profile.opaqueScalar && fVariance > 0.f)
+                continue;
+        }
+
         const size_t uShapes = size_t(1) << ms_aInfo[EP.uMode].uPartitionBits;
         assert(uShapes <= BC7_MAX_SHAPES);
         _Analysis_assume_(uShapes <= BC7_MAX_SHAPES);
 
-        const size_t uNumRots = size_t(1) << ms_aInfo[EP.uMode].uRotationBits;
-        const size_t uNumIdxMode = size_t(1) << ms_aInfo[EP.uMode].uIndexModeBits;
+        const size_t uNumRots = profile.rotations ? (size_t(1) << ms_aInfo[EP.uMode].uRotationBits) : 1;
+        const size_t uNumIdxMode = profile.rotations ? (size_t(1) << ms_aInfo[EP.uMode].uIndexModeBits) : 1;
         // Number of rough cases to look at. reasonable values of this are 1, uShapes/4, and uShapes
         // uShapes/4 gets nearly all the cases; you can increase that a bit (say by 3 or 4) if you really want to squeeze the last bit out
-        const size_t uItems = std::max<size_t>(1, uShapes >> 2);
+        const size_t uItems = profile.shapes ? std::min(profile.shapes, uShapes) : std::max<size_t>(1, uShapes >> 2);
         float afRoughMSE[BC7_MAX_SHAPES];
         size_t auShape[BC7_MAX_SHAPES];
 
         for (size_t r = 0; r < uNumRots && fMSEBest > 0; ++r)
         {
-            switch (r)
-            {
-            case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].r, EP.aLDRPixels[i].a); break;
-            case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].g, EP.aLDRPixels[i].a); break;
-            case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].b, EP.aLDRPixels[i].a); break;
-            default: break;
-            }
+            SwapRotation(EP.aLDRPixels, r);
 
             for (size_t im = 0; im < uNumIdxMode && fMSEBest > 0; ++im)
             {
-                // pick the best uItems shapes and refine these.
-                for (size_t s = 0; s < uShapes; s++)
+                if (profile.preselect && uShapes > 1)
                 {
-                    afRoughMSE[s] = RoughMSE(&EP, s, im);
-                    auShape[s] = s;
+                    // Take the best ranked partitions this mode has; RoughMSE still sets up their endpoints
+                    const size_t* pRanked = auRanked[ms_aInfo[EP.uMode].uPartitions - 1];
+                    for (size_t i = 0, n = 0; n < uItems; ++i)
+                    {
+                        assert(i < BC7_MAX_SHAPES);
+                        if (pRanked[i] < uShapes)
+                        {
+                            auShape[n++] = pRanked[i];
+                            RoughMSE(&EP, pRanked[i], im);
+                        }
+                    }
                 }
-
-                // Bubble up the first uItems items
-                for (size_t i = 0; i < uItems; i++)
+                else
                 {
-                    for (size_t j = i + 1; j < uShapes; j++)
+                    // pick the best uItems shapes and refine these.
+                    for (size_t s = 0; s < uShapes; s++)
+                    {
+                        afRoughMSE[s] = RoughMSE(&EP, s, im);
+                        auShape[s] = s;
+                    }
+
+                    // Bubble up the first uItems items
+                    for (size_t i = 0; i < uItems; i++)
                     {
-                        if (afRoughMSE[i] > afRoughMSE[j])
+                        for (size_t j = i + 1; j < uShapes; j++)
                         {
-                            std::swap(afRoughMSE[i], afRoughMSE[j]);
-                            std::swap(auShape[i], auShape[j]);
+                            if (afRoughMSE[i] > afRoughMSE[j])
+                            {
+                                std::swap(afRoughMSE[i], afRoughMSE[j]);
+                                std::swap(auShape[i], auShape[j]);
+                            }
                         }
                     }
                 }
 
                 for (size_t i = 0; i < uItems && fMSEBest > 0; i++)
                 {
-                    const float fMSE = Refine(&EP, auShape[i], r, im);
+                    const float fMSE = profile.leastSquares
+                        ? RefineLeastSquares(&EP, auShape[i], r, im)
+                        : Refine(&EP, auShape[i], r, im);
                     if (fMSE < fMSEBest)
                     {
                         final = *this;
                         fMSEBest = fMSE;
+                        uBestMode = EP.uMode;
+                        uBestShape = auShape[i];
+                        uBestRotation = r;
+                        uBestIndexMode = im;
                     }
                 }
             }
 
-            switch (r)
-            {
-            case 1: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].r, EP.aLDRPixels[i].a); break;
-            case 2: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].g, EP.aLDRPixels[i].a); break;
-            case 3: for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; i++) std::swap(EP.aLDRPixels[i].b, EP.aLDRPixels[i].a); break;
-            default: break;
-            }
+            SwapRotation(EP.aLDRPixels, r);
         }
+
+        if (fMSEBest <= profile.earlyOut)
+            break;
+    }
+
+    if (profile.leastSquares && profile.polish && fMSEBest > 0 && fMSEBest < FLT_MAX)
+    {
+        EP.uMode = uBestMode;
+        SwapRotation(EP.aLDRPixels, uBestRotation);
+
+        RoughMSE(&EP, uBestShape, uBestIndexMode);
+        const float fMSE = Refine(&EP, uBestShape, uBestRotation, uBestIndexMode);
+        if (fMSE < fMSEBest)
+            final = *this;
+
+        SwapRotation(EP.aLDRPixels, uBestRotation);
     }
 
     *this = final;
@@ -3462,6 +3727,141 @@ float D3DX_BC7::Refine(const EncodeParams* pEP, size_t uShape, size_t uRotation,
     }
 }
 
+_Use_decl_annotations_
+void D3DX_BC7::FitEndPoints(const EncodeParams* pEP, size_t uShape, size_t uIndexMode, const size_t aIndices[], const size_t aIndices2[],
+    LDREndPntPair aEndPts[]) const noexcept
+{
+    assert(pEP);
+    assert(uShape < BC7_MAX_SHAPES);
+    _Analysis_assume_(uShape < BC7_MAX_SHAPES);
+    assert(pEP->uMode < c_NumModes);
+    _Analysis_assume_(pEP->uMode < c_NumModes);
+
+    const uint8_t uPartitions = ms_aInfo[pEP->uMode].uPartitions;
+    assert(uPartitions < BC7_MAX_REGIONS);
+    _Analysis_assume_(uPartitions < BC7_MAX_REGIONS);
+
+    const uint8_t uIndexPrec = uIndexMode ? ms_aInfo[pEP->uMode].uIndexPrec2 : ms_aInfo[pEP->uMode].uIndexPrec;
+    const uint8_t uIndexPrec2 = uIndexMode ? ms_aInfo[pEP->uMode].uIndexPrec : ms_aInfo[pEP->uMode].uIndexPrec2;
+    const int* aWeights = GetIndexWeights(uIndexPrec);
+    const int* aWeights2 = uIndexPrec2 ? GetIndexWeights(uIndexPrec2) : aWeights;
+
+    // Solves for the endpoints minimizing the squared error of the interpolated colors,
+    // all four channels at once (alpha may follow the second index set)
+    for (size_t p = 0; p <= uPartitions; ++p)
+    {
+        XMVECTOR aa = XMVectorZero();
+        XMVECTOR ab = XMVectorZero();
+        XMVECTOR bb = XMVectorZero();
+        XMVECTOR ax = XMVectorZero();
+        XMVECTOR bx = XMVectorZero();
+        float fCount = 0.f;
+
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (g_aPartitionTable[uPartitions][uShape][i] != p)
+                continue;
+
+            const float wc = float(aWeights[aIndices[i]]) * (1.f / float(BC67_WEIGHT_MAX));
+            const float wa = float(aWeights2[uIndexPrec2 ? aIndices2[i] : aIndices[i]]) * (1.f / float(BC67_WEIGHT_MAX));
+            const XMVECTOR w = XMVectorSet(wc, wc, wc, wa);
+            const XMVECTOR iw = XMVectorSubtract(g_XMOne, w);
+            const XMVECTOR x = XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(&pEP->aLDRPixels[i]));
+
+            aa = XMVectorMultiplyAdd(iw, iw, aa);
+            ab = XMVectorMultiplyAdd(iw, w, ab);
+            bb = XMVectorMultiplyAdd(w, w, bb);
+            ax = XMVectorMultiplyAdd(iw, x, ax);
+            bx = XMVectorMultiplyAdd(w, x, bx);
+            fCount += 1.f;
+        }
+
+        assert(fCount > 0.f);
+
+        // A channel whose pixels all share one index only pins down the mean
+        const XMVECTOR det = XMVectorNegativeMultiplySubtract(ab, ab, XMVectorMultiply(aa, bb));
+        const XMVECTOR singular = XMVectorLess(XMVectorAbs(det), XMVectorReplicate(1e-4f));
+        const XMVECTOR invDet = XMVectorReciprocal(XMVectorSelect(det, g_XMOne, singular));
+        const XMVECTOR mean = XMVectorScale(XMVectorAdd(ax, bx), 1.f / fCount);
+
+        XMVECTOR a = XMVectorMultiply(XMVectorNegativeMultiplySubtract(ab, bx, XMVectorMultiply(bb, ax)), invDet);
+        XMVECTOR b = XMVectorMultiply(XMVectorNegativeMultiplySubtract(ab, ax, XMVectorMultiply(aa, bx)), invDet);
+        a = XMVectorRound(XMVectorClamp(XMVectorSelect(a, mean, singular), XMVectorZero(), g_UByteMax));
+        b = XMVectorRound(XMVectorClamp(XMVectorSelect(b, mean, singular), XMVectorZero(), g_UByteMax));
+
+        XMStoreUByte4(reinterpret_cast<XMUBYTE4*>(&aEndPts[p].A), a);
+        XMStoreUByte4(reinterpret_cast<XMUBYTE4*>(&aEndPts[p].B), b);
+    }
+}
+
+_Use_decl_annotations_
+float D3DX_BC7::RefineLeastSquares(const EncodeParams* pEP, size_t uShape, size_t uRotation, size_t uIndexMode) noexcept
+{
+    assert(pEP);
+    assert(uShape < BC7_MAX_SHAPES);
+    _Analysis_assume_(uShape < BC7_MAX_SHAPES);
+    assert(pEP->uMode < c_NumModes);
+    _Analysis_assume_(pEP->uMode < c_NumModes);
+
+    const size_t uPartitions = ms_aInfo[pEP->uMode].uPartitions;
+    assert(uPartitions < BC7_MAX_REGIONS);
+    _Analysis_assume_(uPartitions < BC7_MAX_REGIONS);
+
+    LDREndPntPair aQntEndPts[BC7_MAX_REGIONS];
+    LDREndPntPair aBestEndPts[BC7_MAX_REGIONS];
+    size_t aBestIdx[NUM_PIXELS_PER_BLOCK];
+    size_t aBestIdx2[NUM_PIXELS_PER_BLOCK];
+    float aErr[BC7_MAX_REGIONS];
+
+    const LDREndPntPair* aEndPts = &pEP->aEndPts[uShape][0];
+    for (size_t p = 0; p <= uPartitions; p++)
+    {
+        aQntEndPts[p].A = Quantize(aEndPts[p].A, ms_aInfo[pEP->uMode].RGBAPrecWithP);
+        aQntEndPts[p].B = Quantize(aEndPts[p].B, ms_aInfo[pEP->uMode].RGBAPrecWithP);
+    }
+
+    FixEndpointPBits(pEP, aQntEndPts, aBestEndPts);
+    AssignIndices(pEP, uShape, uIndexMode, aBestEndPts, aBestIdx, aBestIdx2, aErr);
+
+    float fBestErr = 0;
+    for (size_t p = 0; p <= uPartitions; p++)
+        fBestErr += aErr[p];
+
+    // Refit to the indices and reassign until the error stops dropping
+    for (size_t iter = 0; iter < 2 && fBestErr > 0; ++iter)
+    {
+        LDREndPntPair aFitEndPts[BC7_MAX_REGIONS] = {};
+        FitEndPoints(pEP, uShape, uIndexMode, aBestIdx, aBestIdx2, aFitEndPts);
+
+        for (size_t p = 0; p <= uPartitions; p++)
+        {
+            aQntEndPts[p].A = Quantize(aFitEndPts[p].A, ms_aInfo[pEP->uMode].RGBAPrecWithP);
+            aQntEndPts[p].B = Quantize(aFitEndPts[p].B, ms_aInfo[pEP->uMode].RGBAPrecWithP);
+        }
+
+        LDREndPntPair aNewEndPts[BC7_MAX_REGIONS];
+        size_t aIdx[NUM_PIXELS_PER_BLOCK];
+        size_t aIdx2[NUM_PIXELS_PER_BLOCK];
+        FixEndpointPBits(pEP, aQntEndPts, aNewEndPts);
+        AssignIndices(pEP, uShape, uIndexMode, aNewEndPts, aIdx, aIdx2, aErr);
+
+        float fErr = 0;
+        for (size_t p = 0; p <= uPartitions; p++)
+            fErr += aErr[p];
+
+        if (fErr >= fBestErr)
+            break;
+
+        fBestErr = fErr;
+        memcpy(aBestEndPts, aNewEndPts, sizeof(aBestEndPts));
+        memcpy(aBestIdx, aIdx, sizeof(aBestIdx));
+        memcpy(aBestIdx2, aIdx2, sizeof(aBestIdx2));
+    }
+
+    EmitBlock(pEP, uShape, uRotation, uIndexMode, aBestEndPts, aBestIdx, aBestIdx2);
+    return fBestErr;
+}
+
 _Use_decl_annotations_
 float D3DX_BC7::MapColors(const EncodeParams* pEP, const LDRColorA aColors[], size_t np, size_t uIndexMode, const LDREndPntPair& endPts, float fMinErr) const noexcept
 {
@@ -3550,7 +3950,7 @@ float D3DX_BC7::RoughMSE(EncodeParams* pEP, size_t uShape, size_t uIndexMode) no
         else
         {
             uint8_t uMinAlpha = 255, uMaxAlpha = 0;
-            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+            for (size_t i = 0; i < np; ++i)
             {
                 uMinAlpha = std::min<uint8_t>(uMinAlpha, pEP->aLDRPixels[auPixIdx[i]].a);
                 uMaxAlpha = std::max<uint8_t>(uMaxAlpha, pEP->aLDRPixels[auPixIdx[i]].a);
@@ -3657,3 +4057,21 @@ void DirectX::D3DXEncodeBC7(uint8_t *pBC, const XMVECTOR *pColor, uint32_t flags
     static_assert(sizeof(D3DX_BC7) == 16, "D3DX_BC7 should be 16 bytes");
     reinterpret_cast<D3DX_BC7*>(pBC)->Encode(flags, reinterpret_cast<const HDRColorA*>(pColor));
 }
+
+_Use_decl_annotations_
+void DirectX::FastDecodeBC7(uint8_t *pDest, size_t rowPitch, const uint8_t *pBC, size_t blockCount) noexcept
+{
+    assert(pDest && pBC);
+    static_assert(sizeof(D3DX_BC7) == 16, "D3DX_BC7 should be 16 bytes");
+    static_assert(sizeof(LDRColorA) == 4, "LDRColorA should be 4 bytes");
+
+    // BC7 decodes to 8-bit values, so the R8G8B8A8 texels come straight from the integer decoder
+    LDRColorA aLDR[NUM_PIXELS_PER_BLOCK];
+    for (size_t i = 0; i < blockCount; ++i, pBC += 16, pDest += 16)
+    {
+        reinterpret_cast<const D3DX_BC7*>(pBC)->DecodeLDR(aLDR);
+
+        for (size_t row = 0; row < 4; ++row)
+            memcpy(pDest + rowPitch * row, &aLDR[row * 4], sizeof(LDRColorA) * 4);
+    }
+}
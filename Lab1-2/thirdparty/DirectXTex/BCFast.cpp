@@ -0,0 +1,402 @@
+//-------------------------------------------------------------------------------------
+// BCFast.cpp
+//
+// Integer BC1 / BC3 encoders working directly on R8G8B8A8 texels. They trade the
+// weighted float search of BC.cpp for a bounding box fit, which is several times
+// faster and good enough for content pipelines that rebuild textures often.
+//-------------------------------------------------------------------------------------
+
+#include "DirectXTexP.h"
+
+#include "BC.h"
+
+using namespace DirectX;
+
+namespace
+{
+    inline int Channel(uint32_t texel, size_t channel) noexcept
+    {
+        return static_cast<int>((texel >> (channel * 8)) & 0xFF);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Per-channel min / max of the block. Texels with alpha below alphaRef are left out
+    // and returned as a bit mask (bit i = texel i)
+    //-------------------------------------------------------------------------------------
+    uint32_t ComputeBounds(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        uint32_t alphaRef,
+        _Out_writes_(4) int* pMin,
+        _Out_writes_(4) int* pMax) noexcept
+    {
+    #if defined(_XM_SSE_INTRINSICS_)
+        const __m128i ref = _mm_set1_epi32(static_cast<int>(alphaRef));
+        __m128i vmin = _mm_set1_epi32(-1);
+        __m128i vmax = _mm_setzero_si128();
+        uint32_t skipped = 0;
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels + i * 4));
+            const __m128i skip = _mm_cmplt_epi32(_mm_srli_epi32(v, 24), ref);
+            vmin = _mm_min_epu8(vmin, _mm_or_si128(v, skip));
+            vmax = _mm_max_epu8(vmax, _mm_andnot_si128(skip, v));
+            skipped |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(skip))) << (i * 4);
+        }
+
+        vmin = _mm_min_epu8(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmin = _mm_min_epu8(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+        vmax = _mm_max_epu8(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+        vmax = _mm_max_epu8(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+
+        const auto mn = static_cast<uint32_t>(_mm_cvtsi128_si32(vmin));
+        const auto mx = static_cast<uint32_t>(_mm_cvtsi128_si32(vmax));
+    #else
+        uint32_t mn = 0xFFFFFFFF;
+        uint32_t mx = 0;
+        uint32_t skipped = 0;
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const uint32_t texel = pPixels[i];
+            if ((texel >> 24) < alphaRef)
+            {
+                skipped |= 1u << i;
+                continue;
+            }
+
+            for (size_t c = 0; c < 4; ++c)
+            {
+                const uint32_t shift = static_cast<uint32_t>(c * 8);
+                const uint32_t lane = 0xFFu << shift;
+                mn = (mn & ~lane) | std::min(mn & lane, texel & lane);
+                mx = (mx & ~lane) | std::max(mx & lane, texel & lane);
+            }
+        }
+    #endif
+
+        for (size_t c = 0; c < 4; ++c)
+        {
+            pMin[c] = Channel(mn, c);
+            pMax[c] = Channel(mx, c);
+        }
+
+        return skipped;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Projects every texel on axis and quantizes the position to [0, maxStep]:
+    // step = clamp(round((dot(texel, axis) - base) * scale), 0, maxStep)
+    //-------------------------------------------------------------------------------------
+    void ComputeSteps(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        _In_reads_(4) const int* axis,
+        int base,
+        float scale,
+        int maxStep,
+        _Out_writes_(NUM_PIXELS_PER_BLOCK) uint8_t* pSteps) noexcept
+    {
+    #if defined(_XM_SSE_INTRINSICS_)
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i axis16 = _mm_set_epi16(
+            static_cast<short>(axis[3]), static_cast<short>(axis[2]), static_cast<short>(axis[1]), static_cast<short>(axis[0]),
+            static_cast<short>(axis[3]), static_cast<short>(axis[2]), static_cast<short>(axis[1]), static_cast<short>(axis[0]));
+        const __m128i vbase = _mm_set1_epi32(base);
+        const __m128 vscale = _mm_set1_ps(scale);
+        const __m128 vmaxStep = _mm_set1_ps(static_cast<float>(maxStep));
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        __m128i steps[4];
+        for (size_t i = 0; i < 4; ++i)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pPixels + i * 4));
+
+            // 16-bit lanes: madd leaves r*ar + g*ag and b*ab + a*aa for each texel
+            const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(v, zero), axis16);
+            const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(v, zero), axis16);
+            const __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+            const __m128i dot = _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+
+            __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(dot, vbase)), vscale);
+            t = _mm_min_ps(_mm_max_ps(t, _mm_setzero_ps()), vmaxStep);
+            steps[i] = _mm_cvttps_epi32(_mm_add_ps(t, half));
+        }
+
+        const __m128i packed = _mm_packus_epi16(_mm_packs_epi32(steps[0], steps[1]), _mm_packs_epi32(steps[2], steps[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pSteps), packed);
+    #else
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            int dot = 0;
+            for (size_t c = 0; c < 4; ++c)
+                dot += Channel(pPixels[i], c) * axis[c];
+
+            float t = static_cast<float>(dot - base) * scale;
+            t = std::min(std::max(t, 0.f), static_cast<float>(maxStep));
+            pSteps[i] = static_cast<uint8_t>(t + 0.5f);
+        }
+    #endif
+    }
+
+    //-------------------------------------------------------------------------------------
+    inline uint16_t Encode565(_In_reads_(3) const int* rgb) noexcept
+    {
+        const int r = (rgb[0] * 31 + 127) / 255;
+        const int g = (rgb[1] * 63 + 127) / 255;
+        const int b = (rgb[2] * 31 + 127) / 255;
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    inline void Decode565(uint16_t color, _Out_writes_(4) int* rgb) noexcept
+    {
+        const int r = (color >> 11) & 31;
+        const int g = (color >> 5) & 63;
+        const int b = color & 31;
+        rgb[0] = (r << 3) | (r >> 2);
+        rgb[1] = (g << 2) | (g >> 4);
+        rgb[2] = (b << 3) | (b >> 2);
+        rgb[3] = 0;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Indices for the endpoints in pBC. Opaque blocks use the 4 color mode (rgb[0] > rgb[1]),
+    // blocks with transparent texels the 3 color mode; the endpoints are swapped as needed
+    //-------------------------------------------------------------------------------------
+    void ComputeColorIndices(
+        _Inout_ D3DX_BC1* pBC,
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        uint32_t transparent) noexcept
+    {
+        static const uint8_t s_opaqueIndex[] = { 1, 3, 2, 0 };
+        static const uint8_t s_keyedIndex[] = { 0, 2, 1 };
+
+        const bool keyed = transparent != 0;
+        if (keyed ? (pBC->rgb[0] > pBC->rgb[1]) : (pBC->rgb[0] < pBC->rgb[1]))
+        {
+            const uint16_t color = pBC->rgb[0];
+            pBC->rgb[0] = pBC->rgb[1];
+            pBC->rgb[1] = color;
+        }
+
+        pBC->bitmap = 0;
+        if (pBC->rgb[0] != pBC->rgb[1])
+        {
+            // Steps run from the base endpoint to the other one
+            int from[4], to[4], axis[4];
+            Decode565(pBC->rgb[keyed ? 0 : 1], from);
+            Decode565(pBC->rgb[keyed ? 1 : 0], to);
+
+            int base = 0;
+            int length = 0;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                axis[c] = to[c] - from[c];
+                base += from[c] * axis[c];
+                length += axis[c] * axis[c];
+            }
+
+            const int maxStep = keyed ? 2 : 3;
+            uint8_t steps[NUM_PIXELS_PER_BLOCK];
+            ComputeSteps(pPixels, axis, base, static_cast<float>(maxStep) / static_cast<float>(length), maxStep, steps);
+
+            const uint8_t* remap = keyed ? s_keyedIndex : s_opaqueIndex;
+            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                pBC->bitmap |= static_cast<uint32_t>(remap[steps[i]]) << (i * 2);
+        }
+
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (transparent & (1u << i))
+                pBC->bitmap |= 3u << (i * 2);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Flips the box diagonal on channels that fall while the widest channel rises
+    //-------------------------------------------------------------------------------------
+    void AlignDiagonal(
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        uint32_t transparent,
+        _Inout_updates_(3) int* pMin,
+        _Inout_updates_(3) int* pMax) noexcept
+    {
+        size_t widest = 0;
+        for (size_t c = 1; c < 3; ++c)
+        {
+            if (pMax[c] - pMin[c] > pMax[widest] - pMin[widest])
+                widest = c;
+        }
+
+        int mean[3] = {};
+        int count = 0;
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (transparent & (1u << i))
+                continue;
+            for (size_t c = 0; c < 3; ++c)
+                mean[c] += Channel(pPixels[i], c);
+            ++count;
+        }
+
+        int covariance[3] = {};
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            if (transparent & (1u << i))
+                continue;
+            const int dw = Channel(pPixels[i], widest) * count - mean[widest];
+            for (size_t c = 0; c < 3; ++c)
+                covariance[c] += (Channel(pPixels[i], c) * count - mean[c]) * dw;
+        }
+
+        for (size_t c = 0; c < 3; ++c)
+        {
+            if (covariance[c] < 0)
+                std::swap(pMin[c], pMax[c]);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // One least-squares refit of opaque endpoints to the current indices
+    //-------------------------------------------------------------------------------------
+    void RefineEndpoints(
+        _Inout_ D3DX_BC1* pBC,
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels) noexcept
+    {
+        // Weight of rgb[0] in thirds for index 0..3
+        static const int s_weight[] = { 3, 0, 2, 1 };
+
+        int aa = 0, bb = 0, ab = 0;
+        int ax[3] = {}, bx[3] = {};
+        for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+        {
+            const int a = s_weight[(pBC->bitmap >> (i * 2)) & 3];
+            const int b = 3 - a;
+            aa += a * a;
+            bb += b * b;
+            ab += a * b;
+            for (size_t c = 0; c < 3; ++c)
+            {
+                const int x = Channel(pPixels[i], c);
+                ax[c] += a * x;
+                bx[c] += b * x;
+            }
+        }
+
+        const int det = aa * bb - ab * ab;
+        if (!det)
+            return;
+
+        const float scale = 3.f / static_cast<float>(det);
+        int c0[3], c1[3];
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const float v0 = static_cast<float>(ax[c] * bb - bx[c] * ab) * scale;
+            const float v1 = static_cast<float>(bx[c] * aa - ax[c] * ab) * scale;
+            c0[c] = static_cast<int>(std::min(std::max(v0, 0.f), 255.f) + 0.5f);
+            c1[c] = static_cast<int>(std::min(std::max(v1, 0.f), 255.f) + 0.5f);
+        }
+
+        pBC->rgb[0] = Encode565(c0);
+        pBC->rgb[1] = Encode565(c1);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // mn / mx are the ComputeBounds results and get clobbered
+    void EncodeColorBlock(
+        _Out_ D3DX_BC1* pBC,
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        uint32_t transparent,
+        _Inout_updates_(4) int* mn,
+        _Inout_updates_(4) int* mx,
+        BC_FAST_QUALITY quality) noexcept
+    {
+        if (transparent == 0xFFFF)
+        {
+            pBC->rgb[0] = pBC->rgb[1] = 0;
+            pBC->bitmap = 0xFFFFFFFF;
+            return;
+        }
+
+        if (quality == BC_FAST_QUALITY_NORMAL)
+            AlignDiagonal(pPixels, transparent, mn, mx);
+
+        // Pull the endpoints in by 1/16 of the range, so the palette covers the block better
+        for (size_t c = 0; c < 3; ++c)
+        {
+            const int inset = (mx[c] - mn[c]) / 16;
+            mn[c] += inset;
+            mx[c] -= inset;
+        }
+
+        pBC->rgb[0] = Encode565(mx);
+        pBC->rgb[1] = Encode565(mn);
+        ComputeColorIndices(pBC, pPixels, transparent);
+
+        if (quality == BC_FAST_QUALITY_NORMAL && !transparent && pBC->rgb[0] != pBC->rgb[1])
+        {
+            RefineEndpoints(pBC, pPixels);
+            ComputeColorIndices(pBC, pPixels, 0);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    void EncodeAlphaBlock(
+        _Out_ D3DX_BC3* pBC,
+        _In_reads_(NUM_PIXELS_PER_BLOCK) const uint32_t* pPixels,
+        int minAlpha,
+        int maxAlpha) noexcept
+    {
+        // Steps from min to max alpha mapped to the 8 alpha interpolation mode
+        static const uint8_t s_alphaIndex[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+        static const int s_alphaAxis[] = { 0, 0, 0, 1 };
+
+        pBC->alpha[0] = static_cast<uint8_t>(maxAlpha);
+        pBC->alpha[1] = static_cast<uint8_t>(minAlpha);
+
+        uint64_t bitmap = 0;
+        if (maxAlpha != minAlpha)
+        {
+            uint8_t steps[NUM_PIXELS_PER_BLOCK];
+            ComputeSteps(pPixels, s_alphaAxis, minAlpha, 7.f / static_cast<float>(maxAlpha - minAlpha), 7, steps);
+
+            for (size_t i = 0; i < NUM_PIXELS_PER_BLOCK; ++i)
+                bitmap |= static_cast<uint64_t>(s_alphaIndex[steps[i]]) << (i * 3);
+        }
+
+        for (size_t i = 0; i < 6; ++i)
+            pBC->bitmap[i] = static_cast<uint8_t>(bitmap >> (i * 8));
+    }
+}
+
+//-------------------------------------------------------------------------------------
+// Entry points
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+void DirectX::FastEncodeBC1(uint8_t *pBC, const uint32_t *pPixels, size_t blockCount, uint32_t alphaRef, BC_FAST_QUALITY quality) noexcept
+{
+    assert(pBC && pPixels);
+    static_assert(sizeof(D3DX_BC1) == 8, "D3DX_BC1 should be 8 bytes");
+
+    auto pBlock = reinterpret_cast<D3DX_BC1*>(pBC);
+    for (size_t i = 0; i < blockCount; ++i, pPixels += NUM_PIXELS_PER_BLOCK)
+    {
+        int mn[4], mx[4];
+        const uint32_t transparent = ComputeBounds(pPixels, alphaRef, mn, mx);
+        EncodeColorBlock(pBlock + i, pPixels, transparent, mn, mx, quality);
+    }
+}
+
+_Use_decl_annotations_
+void DirectX::FastEncodeBC3(uint8_t *pBC, const uint32_t *pPixels, size_t blockCount, BC_FAST_QUALITY quality) noexcept
+{
+    assert(pBC && pPixels);
+    static_assert(sizeof(D3DX_BC3) == 16, "D3DX_BC3 should be 16 bytes");
+
+    auto pBlock = reinterpret_cast<D3DX_BC3*>(pBC);
+    for (size_t i = 0; i < blockCount; ++i, pPixels += NUM_PIXELS_PER_BLOCK)
+    {
+        int mn[4], mx[4];
+        ComputeBounds(pPixels, 0, mn, mx);
+        EncodeAlphaBlock(pBlock + i, pPixels, mn[3], mx[3]);
+        EncodeColorBlock(&pBlock[i].bc1, pPixels, 0, mn, mx, quality);
+    }
+}
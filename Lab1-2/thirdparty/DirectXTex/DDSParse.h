@@ -0,0 +1,690 @@
+//--------------------------------------------------------------------------------------
+// File: DDSParse.h
+//
+// Allocation-free DDS header validation and subresource layout, shared by
+// DDSTextureLoader and DirectXTex. Everything here works on the caller's memory:
+// the parsed view and the layout point into the file image, nothing is copied.
+//
+// Requires DXGI_FORMAT and HRESULT to be declared before inclusion.
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+
+namespace DirectX
+{
+    namespace DDSParse
+    {
+        // A 32-bit width needs at most 32 levels, so the layout never has to grow
+        constexpr size_t MAX_MIP_LEVELS = 32;
+
+        constexpr uint32_t MAGIC = 0x20534444; // "DDS "
+        constexpr size_t HEADER_SIZE = 124;
+        constexpr size_t PIXELFORMAT_SIZE = 32;
+        constexpr size_t DX10_HEADER_SIZE = 20;
+        constexpr size_t MIN_FILE_SIZE = sizeof(uint32_t) + HEADER_SIZE;
+        constexpr size_t DX10_FILE_SIZE = MIN_FILE_SIZE + DX10_HEADER_SIZE;
+
+        constexpr HRESULT E_DDS_INVALID_DATA = static_cast<HRESULT>(0x8007000DL);
+        constexpr HRESULT E_DDS_NOT_SUPPORTED = static_cast<HRESULT>(0x80070032L);
+        constexpr HRESULT E_DDS_HANDLE_EOF = static_cast<HRESULT>(0x80070026L);
+        constexpr HRESULT E_DDS_ARITHMETIC_OVERFLOW = static_cast<HRESULT>(0x80070216L);
+
+        enum PARSE_FLAGS : uint32_t
+        {
+            PARSE_NONE = 0x0,
+
+            PARSE_PERMISSIVE = 0x1,
+            // Accept the known malformed header sizes and clamp oversized mip counts
+
+            PARSE_IGNORE_MIPS = 0x2,
+            // Report a single mip level regardless of the header
+        };
+
+        // Matches D3D11_RESOURCE_DIMENSION and DDS_RESOURCE_DIMENSION
+        enum DIMENSION : uint32_t
+        {
+            DIMENSION_TEXTURE1D = 2,
+            DIMENSION_TEXTURE2D = 3,
+            DIMENSION_TEXTURE3D = 4,
+        };
+
+        struct HeaderView
+        {
+            const uint8_t*  header;         // DDS_HEADER, just past the magic value
+            const uint8_t*  dx10;           // DDS_HEADER_DXT10, or nullptr for legacy files
+            size_t          dataOffset;     // First byte of pixel data (palette for legacy P8)
+            uint32_t        width;
+            uint32_t        height;
+            uint32_t        depth;
+            uint32_t        mipLevels;
+            uint32_t        arraySize;      // Includes the six faces of each cubemap
+            DIMENSION       dimension;
+            DXGI_FORMAT     format;         // DXGI_FORMAT_UNKNOWN when the legacy pixel format must be mapped
+            uint32_t        miscFlags;      // DX10 miscFlag, zero for legacy files
+            uint32_t        miscFlags2;     // DX10 miscFlags2, zero for legacy files
+            bool            isCubeMap;
+        };
+
+        struct MipLayout
+        {
+            size_t      offset;             // From the start of each array item
+            size_t      rowPitch;
+            size_t      slicePitch;
+            uint32_t    width;
+            uint32_t    height;
+            uint32_t    depth;
+        };
+
+        struct SubresourceLayout
+        {
+            const uint8_t*  bits;
+            size_t          mipLevels;
+            size_t          arraySize;
+            size_t          itemStride;
+            size_t          totalSize;
+            MipLayout       mips[MAX_MIP_LEVELS];
+
+            const uint8_t* GetPixels(size_t item, size_t mip) const noexcept
+            {
+                return bits + item * itemStride + mips[mip].offset;
+            }
+        };
+
+        //----------------------------------------------------------------------------------
+        // Header fields are read by byte offset so the view carries no alignment or
+        // packing requirements, and the caller keeps its own DDS_HEADER definition
+        //----------------------------------------------------------------------------------
+        inline uint32_t ReadU32(const uint8_t* p, size_t offset) noexcept
+        {
+            uint32_t value;
+            memcpy(&value, p + offset, sizeof(value));
+            return value;
+        }
+
+        namespace Field
+        {
+            constexpr size_t size = 0;
+            constexpr size_t flags = 4;
+            constexpr size_t height = 8;
+            constexpr size_t width = 12;
+            constexpr size_t depth = 20;
+            constexpr size_t mipMapCount = 24;
+            constexpr size_t pfSize = 72;
+            constexpr size_t pfFlags = 76;
+            constexpr size_t pfFourCC = 80;
+            constexpr size_t caps2 = 108;
+
+            constexpr size_t dxgiFormat = 0;
+            constexpr size_t resourceDimension = 4;
+            constexpr size_t miscFlag = 8;
+            constexpr size_t arraySize = 12;
+            constexpr size_t miscFlags2 = 16;
+        }
+
+        constexpr uint32_t DDPF_FOURCC = 0x00000004;
+        constexpr uint32_t DDSD_HEIGHT = 0x00000002;
+        constexpr uint32_t DDSD_DEPTH = 0x00800000;
+        constexpr uint32_t DDSCAPS2_CUBEMAP = 0x00000200;
+        constexpr uint32_t DDSCAPS2_CUBEMAP_ALLFACES = 0x0000FE00;
+        constexpr uint32_t RESOURCE_MISC_TEXTURECUBE = 0x4;
+        constexpr uint32_t FOURCC_DX10 = 0x30315844; // "DX10"
+
+        inline uint32_t FullMipChain(uint32_t width, uint32_t height, uint32_t depth) noexcept
+        {
+            uint32_t largest = std::max(std::max(width, height), depth);
+            uint32_t levels = 1;
+            while (largest > 1)
+            {
+                largest >>= 1;
+                ++levels;
+            }
+            return levels;
+        }
+
+        //--------------------------------------------------------------------------------------
+        // Return the BPP for a particular format
+        //--------------------------------------------------------------------------------------
+        inline size_t BitsPerPixel(_In_ DXGI_FORMAT fmt) noexcept
+        {
+            switch (fmt)
+            {
+            case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+            case DXGI_FORMAT_R32G32B32A32_UINT:
+            case DXGI_FORMAT_R32G32B32A32_SINT:
+                return 128;
+
+            case DXGI_FORMAT_R32G32B32_TYPELESS:
+            case DXGI_FORMAT_R32G32B32_FLOAT:
+            case DXGI_FORMAT_R32G32B32_UINT:
+            case DXGI_FORMAT_R32G32B32_SINT:
+                return 96;
+
+            case DXGI_FORMAT_R16G16B16A16_TYPELESS:
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            case DXGI_FORMAT_R16G16B16A16_UNORM:
+            case DXGI_FORMAT_R16G16B16A16_UINT:
+            case DXGI_FORMAT_R16G16B16A16_SNORM:
+            case DXGI_FORMAT_R16G16B16A16_SINT:
+            case DXGI_FORMAT_R32G32_TYPELESS:
+            case DXGI_FORMAT_R32G32_FLOAT:
+            case DXGI_FORMAT_R32G32_UINT:
+            case DXGI_FORMAT_R32G32_SINT:
+            case DXGI_FORMAT_R32G8X24_TYPELESS:
+            case DXGI_FORMAT_D32_FLOAT_S8X24_UINT:
+            case DXGI_FORMAT_R32_FLOAT_X8X24_TYPELESS:
+            case DXGI_FORMAT_X32_TYPELESS_G8X24_UINT:
+            case DXGI_FORMAT_Y416:
+            case DXGI_FORMAT_Y210:
+            case DXGI_FORMAT_Y216:
+                return 64;
+
+            case DXGI_FORMAT_R10G10B10A2_TYPELESS:
+            case DXGI_FORMAT_R10G10B10A2_UNORM:
+            case DXGI_FORMAT_R10G10B10A2_UINT:
+            case DXGI_FORMAT_R11G11B10_FLOAT:
+            case DXGI_FORMAT_R8G8B8A8_TYPELESS:
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_R8G8B8A8_UINT:
+            case DXGI_FORMAT_R8G8B8A8_SNORM:
+            case DXGI_FORMAT_R8G8B8A8_SINT:
+            case DXGI_FORMAT_R16G16_TYPELESS:
+            case DXGI_FORMAT_R16G16_FLOAT:
+            case DXGI_FORMAT_R16G16_UNORM:
+            case DXGI_FORMAT_R16G16_UINT:
+            case DXGI_FORMAT_R16G16_SNORM:
+            case DXGI_FORMAT_R16G16_SINT:
+            case DXGI_FORMAT_R32_TYPELESS:
+            case DXGI_FORMAT_D32_FLOAT:
+            case DXGI_FORMAT_R32_FLOAT:
+            case DXGI_FORMAT_R32_UINT:
+            case DXGI_FORMAT_R32_SINT:
+            case DXGI_FORMAT_R24G8_TYPELESS:
+            case DXGI_FORMAT_D24_UNORM_S8_UINT:
+            case DXGI_FORMAT_R24_UNORM_X8_TYPELESS:
+            case DXGI_FORMAT_X24_TYPELESS_G8_UINT:
+            case DXGI_FORMAT_R9G9B9E5_SHAREDEXP:
+            case DXGI_FORMAT_R8G8_B8G8_UNORM:
+            case DXGI_FORMAT_G8R8_G8B8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8X8_UNORM:
+            case DXGI_FORMAT_R10G10B10_XR_BIAS_A2_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_TYPELESS:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_TYPELESS:
+            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            case DXGI_FORMAT_AYUV:
+            case DXGI_FORMAT_Y410:
+            case DXGI_FORMAT_YUY2:
+                return 32;
+
+            case DXGI_FORMAT_P010:
+            case DXGI_FORMAT_P016:
+                return 24;
+
+            case DXGI_FORMAT_R8G8_TYPELESS:
+            case DXGI_FORMAT_R8G8_UNORM:
+            case DXGI_FORMAT_R8G8_UINT:
+            case DXGI_FORMAT_R8G8_SNORM:
+            case DXGI_FORMAT_R8G8_SINT:
+            case DXGI_FORMAT_R16_TYPELESS:
+            case DXGI_FORMAT_R16_FLOAT:
+            case DXGI_FORMAT_D16_UNORM:
+            case DXGI_FORMAT_R16_UNORM:
+            case DXGI_FORMAT_R16_UINT:
+            case DXGI_FORMAT_R16_SNORM:
+            case DXGI_FORMAT_R16_SINT:
+            case DXGI_FORMAT_B5G6R5_UNORM:
+            case DXGI_FORMAT_B5G5R5A1_UNORM:
+            case DXGI_FORMAT_A8P8:
+            case DXGI_FORMAT_B4G4R4A4_UNORM:
+                return 16;
+
+            case DXGI_FORMAT_NV12:
+            case DXGI_FORMAT_420_OPAQUE:
+            case DXGI_FORMAT_NV11:
+                return 12;
+
+            case DXGI_FORMAT_R8_TYPELESS:
+            case DXGI_FORMAT_R8_UNORM:
+            case DXGI_FORMAT_R8_UINT:
+            case DXGI_FORMAT_R8_SNORM:
+            case DXGI_FORMAT_R8_SINT:
+            case DXGI_FORMAT_A8_UNORM:
+            case DXGI_FORMAT_BC2_TYPELESS:
+            case DXGI_FORMAT_BC2_UNORM:
+            case DXGI_FORMAT_BC2_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_TYPELESS:
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+            case DXGI_FORMAT_BC5_TYPELESS:
+            case DXGI_FORMAT_BC5_UNORM:
+            case DXGI_FORMAT_BC5_SNORM:
+            case DXGI_FORMAT_BC6H_TYPELESS:
+            case DXGI_FORMAT_BC6H_UF16:
+            case DXGI_FORMAT_BC6H_SF16:
+            case DXGI_FORMAT_BC7_TYPELESS:
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+            case DXGI_FORMAT_AI44:
+            case DXGI_FORMAT_IA44:
+            case DXGI_FORMAT_P8:
+                return 8;
+
+            case DXGI_FORMAT_R1_UNORM:
+                return 1;
+
+            case DXGI_FORMAT_BC1_TYPELESS:
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC4_TYPELESS:
+            case DXGI_FORMAT_BC4_UNORM:
+            case DXGI_FORMAT_BC4_SNORM:
+                return 4;
+
+            default:
+                return 0;
+            }
+        }
+
+
+        //--------------------------------------------------------------------------------------
+        // Get surface information for a particular format
+        //--------------------------------------------------------------------------------------
+        inline HRESULT GetSurfaceInfo(
+            _In_ size_t width,
+            _In_ size_t height,
+            _In_ DXGI_FORMAT fmt,
+            size_t* outNumBytes,
+            _Out_opt_ size_t* outRowBytes,
+            _Out_opt_ size_t* outNumRows) noexcept
+        {
+            uint64_t numBytes = 0;
+            uint64_t rowBytes = 0;
+            uint64_t numRows = 0;
+
+            bool bc = false;
+            bool packed = false;
+            bool planar = false;
+            size_t bpe = 0;
+            switch (fmt)
+            {
+            case DXGI_FORMAT_BC1_TYPELESS:
+            case DXGI_FORMAT_BC1_UNORM:
+            case DXGI_FORMAT_BC1_UNORM_SRGB:
+            case DXGI_FORMAT_BC4_TYPELESS:
+            case DXGI_FORMAT_BC4_UNORM:
+            case DXGI_FORMAT_BC4_SNORM:
+                bc = true;
+                bpe = 8;
+                break;
+
+            case DXGI_FORMAT_BC2_TYPELESS:
+            case DXGI_FORMAT_BC2_UNORM:
+            case DXGI_FORMAT_BC2_UNORM_SRGB:
+            case DXGI_FORMAT_BC3_TYPELESS:
+            case DXGI_FORMAT_BC3_UNORM:
+            case DXGI_FORMAT_BC3_UNORM_SRGB:
+            case DXGI_FORMAT_BC5_TYPELESS:
+            case DXGI_FORMAT_BC5_UNORM:
+            case DXGI_FORMAT_BC5_SNORM:
+            case DXGI_FORMAT_BC6H_TYPELESS:
+            case DXGI_FORMAT_BC6H_UF16:
+            case DXGI_FORMAT_BC6H_SF16:
+            case DXGI_FORMAT_BC7_TYPELESS:
+            case DXGI_FORMAT_BC7_UNORM:
+            case DXGI_FORMAT_BC7_UNORM_SRGB:
+                bc = true;
+                bpe = 16;
+                break;
+
+            case DXGI_FORMAT_R8G8_B8G8_UNORM:
+            case DXGI_FORMAT_G8R8_G8B8_UNORM:
+            case DXGI_FORMAT_YUY2:
+                packed = true;
+                bpe = 4;
+                break;
+
+            case DXGI_FORMAT_Y210:
+            case DXGI_FORMAT_Y216:
+                packed = true;
+                bpe = 8;
+                break;
+
+            case DXGI_FORMAT_NV12:
+            case DXGI_FORMAT_420_OPAQUE:
+                if ((height % 2) != 0)
+                {
+                    // Requires a height alignment of 2.
+                    return E_INVALIDARG;
+                }
+                planar = true;
+                bpe = 2;
+                break;
+
+            case DXGI_FORMAT_P010:
+            case DXGI_FORMAT_P016:
+                if ((height % 2) != 0)
+                {
+                    // Requires a height alignment of 2.
+                    return E_INVALIDARG;
+                }
+                planar = true;
+                bpe = 4;
+                break;
+
+            default:
+                break;
+            }
+
+            if (bc)
+            {
+                uint64_t numBlocksWide = 0;
+                if (width > 0)
+                {
+                    numBlocksWide = std::max<uint64_t>(1u, (uint64_t(width) + 3u) / 4u);
+                }
+                uint64_t numBlocksHigh = 0;
+                if (height > 0)
+                {
+                    numBlocksHigh = std::max<uint64_t>(1u, (uint64_t(height) + 3u) / 4u);
+                }
+                rowBytes = numBlocksWide * bpe;
+                numRows = numBlocksHigh;
+                numBytes = rowBytes * numBlocksHigh;
+            }
+            else if (packed)
+            {
+                rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
+                numRows = uint64_t(height);
+                numBytes = rowBytes * height;
+            }
+            else if (fmt == DXGI_FORMAT_NV11)
+            {
+                rowBytes = ((uint64_t(width) + 3u) >> 2) * 4u;
+                numRows = uint64_t(height) * 2u; // Direct3D makes this simplifying assumption, although it is larger than the 4:1:1 data
+                numBytes = rowBytes * numRows;
+            }
+            else if (planar)
+            {
+                rowBytes = ((uint64_t(width) + 1u) >> 1) * bpe;
+                numBytes = (rowBytes * uint64_t(height)) + ((rowBytes * uint64_t(height) + 1u) >> 1);
+                numRows = height + ((uint64_t(height) + 1u) >> 1);
+            }
+            else
+            {
+                const size_t bpp = BitsPerPixel(fmt);
+                if (!bpp)
+                    return E_INVALIDARG;
+
+                rowBytes = (uint64_t(width) * bpp + 7u) / 8u; // round up to nearest byte
+                numRows = uint64_t(height);
+                numBytes = rowBytes * height;
+            }
+
+        #if defined(_M_IX86) || defined(_M_ARM) || defined(_M_HYBRID_X86_ARM64)
+            static_assert(sizeof(size_t) == 4, "Not a 32-bit platform!");
+            if (numBytes > UINT32_MAX || rowBytes > UINT32_MAX || numRows > UINT32_MAX)
+                return E_DDS_ARITHMETIC_OVERFLOW;
+        #else
+            static_assert(sizeof(size_t) == 8, "Not a 64-bit platform!");
+        #endif
+
+            if (outNumBytes)
+            {
+                *outNumBytes = static_cast<size_t>(numBytes);
+            }
+            if (outRowBytes)
+            {
+                *outRowBytes = static_cast<size_t>(rowBytes);
+            }
+            if (outNumRows)
+            {
+                *outNumRows = static_cast<size_t>(numRows);
+            }
+
+            return S_OK;
+        }
+
+
+        //----------------------------------------------------------------------------------
+        // Validates the magic value, header, and DX10 extension and resolves the
+        // resource shape. Only the headers need to be present in memory.
+        //----------------------------------------------------------------------------------
+        inline HRESULT ParseHeader(
+            _In_reads_bytes_(size) const void* pSource,
+            size_t size,
+            uint32_t flags,
+            _Out_ HeaderView& view) noexcept
+        {
+            view = {};
+
+            if (!pSource)
+                return E_INVALIDARG;
+
+            if (size < MIN_FILE_SIZE)
+                return E_DDS_INVALID_DATA;
+
+            auto const data = static_cast<const uint8_t*>(pSource);
+            if (ReadU32(data, 0) != MAGIC)
+                return E_FAIL;
+
+            auto const header = data + sizeof(uint32_t);
+            const uint32_t headerSize = ReadU32(header, Field::size);
+            const uint32_t pfSize = ReadU32(header, Field::pfSize);
+
+            if (flags & PARSE_PERMISSIVE)
+            {
+                if (headerSize != 24 /* Known variant */ && headerSize != HEADER_SIZE)
+                    return E_DDS_NOT_SUPPORTED;
+
+                if (pfSize != 0 /* Known variant */ && pfSize != 24 /* Known variant */ && pfSize != PIXELFORMAT_SIZE)
+                    return E_DDS_NOT_SUPPORTED;
+            }
+            else if (headerSize != HEADER_SIZE || pfSize != PIXELFORMAT_SIZE)
+            {
+                return E_DDS_NOT_SUPPORTED;
+            }
+
+            const uint32_t headerFlags = ReadU32(header, Field::flags);
+
+            view.header = header;
+            view.dataOffset = MIN_FILE_SIZE;
+            view.width = ReadU32(header, Field::width);
+            view.height = ReadU32(header, Field::height);
+            view.depth = 1;
+            view.arraySize = 1;
+            view.format = DXGI_FORMAT_UNKNOWN;
+
+            view.mipLevels = ReadU32(header, Field::mipMapCount);
+            if (!view.mipLevels || (flags & PARSE_IGNORE_MIPS))
+                view.mipLevels = 1;
+
+            if ((ReadU32(header, Field::pfFlags) & DDPF_FOURCC) && ReadU32(header, Field::pfFourCC) == FOURCC_DX10)
+            {
+                // We do not accept legacy DX9 'known variants' for modern "DX10" extension header files.
+                if (headerSize != HEADER_SIZE || pfSize != PIXELFORMAT_SIZE)
+                    return E_FAIL;
+
+                if (size < DX10_FILE_SIZE)
+                    return E_FAIL;
+
+                auto const dx10 = data + MIN_FILE_SIZE;
+                view.dx10 = dx10;
+                view.dataOffset = DX10_FILE_SIZE;
+                view.format = static_cast<DXGI_FORMAT>(ReadU32(dx10, Field::dxgiFormat));
+                view.miscFlags = ReadU32(dx10, Field::miscFlag);
+                view.miscFlags2 = ReadU32(dx10, Field::miscFlags2);
+
+                view.arraySize = ReadU32(dx10, Field::arraySize);
+                if (!view.arraySize)
+                    view.arraySize = 1;
+
+                switch (ReadU32(dx10, Field::resourceDimension))
+                {
+                case DIMENSION_TEXTURE1D:
+                    // D3DX writes 1D textures with a fixed Height of 1
+                    if ((headerFlags & DDSD_HEIGHT) && view.height != 1)
+                        return E_DDS_INVALID_DATA;
+
+                    view.height = 1;
+                    view.dimension = DIMENSION_TEXTURE1D;
+                    break;
+
+                case DIMENSION_TEXTURE2D:
+                    if (view.miscFlags & RESOURCE_MISC_TEXTURECUBE)
+                    {
+                        if (view.arraySize > UINT32_MAX / 6)
+                            return E_DDS_NOT_SUPPORTED;
+
+                        view.arraySize *= 6;
+                        view.isCubeMap = true;
+                    }
+                    view.dimension = DIMENSION_TEXTURE2D;
+                    break;
+
+                case DIMENSION_TEXTURE3D:
+                    if (!(headerFlags & DDSD_DEPTH))
+                        return E_DDS_INVALID_DATA;
+
+                    if (view.arraySize > 1)
+                        return E_DDS_NOT_SUPPORTED;
+
+                    view.depth = ReadU32(header, Field::depth);
+                    view.dimension = DIMENSION_TEXTURE3D;
+                    break;
+
+                default:
+                    return E_DDS_INVALID_DATA;
+                }
+            }
+            else if (headerFlags & DDSD_DEPTH)
+            {
+                view.depth = ReadU32(header, Field::depth);
+                view.dimension = DIMENSION_TEXTURE3D;
+            }
+            else
+            {
+                const uint32_t caps2 = ReadU32(header, Field::caps2);
+                if (caps2 & DDSCAPS2_CUBEMAP)
+                {
+                    // We require all six faces to be defined
+                    if ((caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES)
+                        return E_DDS_NOT_SUPPORTED;
+
+                    view.arraySize = 6;
+                    view.isCubeMap = true;
+                }
+
+                // Note there's no way for a legacy Direct3D 9 DDS to express a '1D' texture
+                view.dimension = DIMENSION_TEXTURE2D;
+            }
+
+            if (flags & PARSE_PERMISSIVE)
+            {
+                // Allow cases where mipCount was computed incorrectly
+                view.mipLevels = std::min(view.mipLevels, FullMipChain(view.width, view.height, view.depth));
+            }
+            else if (view.mipLevels > MAX_MIP_LEVELS)
+            {
+                return E_DDS_INVALID_DATA;
+            }
+
+            return S_OK;
+        }
+
+
+        //----------------------------------------------------------------------------------
+        // Computes every mip's pitch and offset and checks that the whole chain for every
+        // array item fits in bitSize. Subresource (item, mip) starts at GetPixels(item, mip).
+        //----------------------------------------------------------------------------------
+        inline HRESULT ComputeLayout(
+            DXGI_FORMAT format,
+            size_t width,
+            size_t height,
+            size_t depth,
+            size_t mipLevels,
+            size_t arraySize,
+            _In_reads_bytes_(bitSize) const uint8_t* bits,
+            size_t bitSize,
+            _Out_ SubresourceLayout& layout) noexcept
+        {
+            layout.bits = bits;
+            layout.mipLevels = layout.arraySize = layout.itemStride = layout.totalSize = 0;
+
+            if (!bits && bitSize)
+                return E_POINTER;
+
+            if (!mipLevels || mipLevels > MAX_MIP_LEVELS || !arraySize)
+                return E_DDS_INVALID_DATA;
+
+            if (width > UINT32_MAX || height > UINT32_MAX || depth > UINT32_MAX)
+                return E_DDS_INVALID_DATA;
+
+            uint64_t itemStride = 0;
+            size_t w = width;
+            size_t h = height;
+            size_t d = depth;
+            for (size_t level = 0; level < mipLevels; ++level)
+            {
+                size_t numBytes = 0;
+                size_t rowBytes = 0;
+                size_t numRows = 0;
+                const HRESULT hr = GetSurfaceInfo(w, h, format, &numBytes, &rowBytes, &numRows);
+                if (FAILED(hr))
+                    return hr;
+
+                // rowBytes * numRows bounds numBytes, so this also rules out wraparound inside GetSurfaceInfo
+                if (rowBytes > UINT32_MAX || numRows > UINT32_MAX
+                    || uint64_t(rowBytes) * numRows > UINT32_MAX || numBytes > UINT32_MAX)
+                    return E_DDS_ARITHMETIC_OVERFLOW;
+
+                MipLayout& mip = layout.mips[level];
+                mip.offset = static_cast<size_t>(itemStride);
+                mip.rowPitch = rowBytes;
+                mip.slicePitch = numBytes;
+                mip.width = static_cast<uint32_t>(w);
+                mip.height = static_cast<uint32_t>(h);
+                mip.depth = static_cast<uint32_t>(d);
+
+                // Each term is below 2^64 since numBytes and d both fit in 32 bits
+                itemStride += uint64_t(numBytes) * d;
+                if (itemStride > bitSize)
+                    return E_DDS_HANDLE_EOF;
+
+                w = std::max<size_t>(1, w >> 1);
+                h = std::max<size_t>(1, h >> 1);
+                d = std::max<size_t>(1, d >> 1);
+            }
+
+            // itemStride <= bitSize here, so this division guards the multiply below
+            if (itemStride && arraySize > bitSize / itemStride)
+                return E_DDS_HANDLE_EOF;
+
+            layout.mipLevels = mipLevels;
+            layout.arraySize = arraySize;
+            layout.itemStride = static_cast<size_t>(itemStride);
+            layout.totalSize = static_cast<size_t>(itemStride) * arraySize;
+
+            return S_OK;
+        }
+
+        inline HRESULT ComputeLayout(
+            const HeaderView& view,
+            DXGI_FORMAT format,
+            _In_reads_bytes_(bitSize) const uint8_t* bits,
+            size_t bitSize,
+            _Out_ SubresourceLayout& layout) noexcept
+        {
+            return ComputeLayout(format, view.width, view.height, view.depth, view.mipLevels, view.arraySize,
+                bits, bitSize, layout);
+        }
+    }
+}
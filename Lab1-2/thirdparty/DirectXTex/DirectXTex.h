@@ -523,6 +523,15 @@ namespace DirectX
         _In_z_ const wchar_t* szFile,
         _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image) noexcept;
 
+    HRESULT __cdecl LoadFromHDRFileBands(
+        _In_z_ const wchar_t* szFile, _In_ size_t bandHeight,
+        _Out_opt_ TexMetadata* metadata,
+        _In_ std::function<bool __cdecl(const Image& band, size_t y)> bandFunc);
+        // Decodes bandHeight rows at a time without holding the whole image: the next band is
+        // decoded on a helper thread while bandFunc works on the current one. y is the image row
+        // of the band's top row; the band's memory is reused once bandFunc returns.
+        // metadata is filled in before the first band. Return false from bandFunc to stop (E_ABORT).
+
     HRESULT __cdecl SaveToHDRMemory(_In_ const Image& image, _Out_ Blob& blob) noexcept;
     HRESULT __cdecl SaveToHDRFile(_In_ const Image& image, _In_z_ const wchar_t* szFile) noexcept;
 
@@ -536,6 +545,15 @@ namespace DirectX
         _In_ TGA_FLAGS flags,
         _Out_opt_ TexMetadata* metadata, _Out_ ScratchImage& image) noexcept;
 
+    HRESULT __cdecl LoadFromTGAFileBands(
+        _In_z_ const wchar_t* szFile,
+        _In_ TGA_FLAGS flags, _In_ size_t bandHeight,
+        _Out_opt_ TexMetadata* metadata,
+        _In_ std::function<bool __cdecl(const Image& band, size_t y)> bandFunc);
+        // As LoadFromHDRFileBands; bands come in file order, so bottom-up TGAs deliver the bottom band first.
+        // The alpha channel is returned as stored (as with TGA_FLAGS_ALLOW_ALL_ZERO_ALPHA) and the
+        // alpha mode only comes from the TGA 2.0 extension area.
+
     HRESULT __cdecl SaveToTGAMemory(_In_ const Image& image,
         _In_ TGA_FLAGS flags,
         _Out_ Blob& blob, _In_opt_ const TexMetadata* metadata = nullptr) noexcept;
@@ -646,6 +664,7 @@ namespace DirectX
         TEX_FILTER_BOX = 0x400000,
         TEX_FILTER_FANT = 0x400000, // Equiv to Box filtering for mipmap generation
         TEX_FILTER_TRIANGLE = 0x500000,
+        TEX_FILTER_KAISER = 0x600000, // Kaiser-windowed sinc; 8-bit RGBA/BGRA and R16G16B16A16_UNORM formats only
         // Filtering mode to use for any required image resizing
 
         TEX_FILTER_SRGB_IN = 0x1000000,
@@ -776,12 +795,29 @@ namespace DirectX
         TEX_COMPRESS_BC7_QUICK = 0x100000,
         // Minimal modes (usually mode 6) for BC7 compression
 
+        TEX_COMPRESS_BC_FAST = 0x200000,
+        // Integer encoder for BC1 & BC3 from R8G8B8A8, B8G8R8A8 or B8G8R8X8 sources; ignored when dithering
+
+        TEX_COMPRESS_BC_FAST_REFINE = 0x400000,
+        // With TEX_COMPRESS_BC_FAST, fits endpoints to the block colors for better quality at about half the speed
+
         TEX_COMPRESS_SRGB_IN = 0x1000000,
         TEX_COMPRESS_SRGB_OUT = 0x2000000,
         TEX_COMPRESS_SRGB = (TEX_COMPRESS_SRGB_IN | TEX_COMPRESS_SRGB_OUT),
         // if the input format type is IsSRGB(), then SRGB_IN is on by default
         // if the output format type is IsSRGB(), then SRGB_OUT is on by default
 
+        TEX_COMPRESS_BC7_FAST = 0x4000000,
+        // BC7 partitions preselected per block, least squares endpoints, full search only on the best candidate
+
+        TEX_COMPRESS_BC7_VERYFAST = 0x8000000,
+        // BC7 as TEX_COMPRESS_BC7_FAST with fewer partitions and no full search
+
+        TEX_COMPRESS_BC7_ULTRAFAST = 0xC000000,
+        // BC7 with one partition per mode, no rotations, and an early out once a mode is close enough
+
+        TEX_COMPRESS_BC7_TIER_MASK = 0xC000000,
+
         TEX_COMPRESS_PARALLEL = 0x10000000,
         // Compress is free to use multithreading to improve performance (by default it does not use multithreading)
     };
@@ -836,6 +872,56 @@ namespace DirectX
     HRESULT __cdecl Decompress(
         _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
         _In_ DXGI_FORMAT format, _Out_ ScratchImage& images) noexcept;
+    HRESULT __cdecl Decompress(
+        _In_ const Image& cImage, _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS flags, _Out_ ScratchImage& image) noexcept;
+    HRESULT __cdecl Decompress(
+        _In_reads_(nimages) const Image* cImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+        _In_ DXGI_FORMAT format, _In_ TEX_COMPRESS_FLAGS flags, _Out_ ScratchImage& images) noexcept;
+        // Only TEX_COMPRESS_PARALLEL is used: the decoders straight to R8G8B8A8 may then use multithreading
+        // (by default, and in the overloads without flags, decompression stays on the calling thread)
+
+    class BlockTexelCache
+    {
+    public:
+        BlockTexelCache() noexcept
+            : m_image{}, m_blockSize(0), m_blocksAcross(0), m_pfDecode(nullptr),
+            m_slotShift(0), m_slotMaskX(0), m_slotMaskY(0), m_tags(nullptr), m_texels(nullptr) {}
+        BlockTexelCache(BlockTexelCache&& moveFrom) noexcept
+            : m_image{}, m_blockSize(0), m_blocksAcross(0), m_pfDecode(nullptr),
+            m_slotShift(0), m_slotMaskX(0), m_slotMaskY(0), m_tags(nullptr), m_texels(nullptr) { *this = std::move(moveFrom); }
+        ~BlockTexelCache() { Release(); }
+
+        BlockTexelCache& __cdecl operator= (BlockTexelCache&& moveFrom) noexcept;
+
+        BlockTexelCache(const BlockTexelCache&) = delete;
+        BlockTexelCache& operator=(const BlockTexelCache&) = delete;
+
+        HRESULT __cdecl Initialize(_In_ const Image& image, _In_ size_t cacheBlocks = 64) noexcept;
+            // Random access to a BC1, BC2, BC3, BC5 (UNORM) or BC7 image; the image's pixels must outlive the cache.
+            // Keeps cacheBlocks decoded blocks (rounded up to a power of 2), placed by block position so
+            // neighboring blocks never evict each other. Not thread-safe: use one cache per thread.
+
+        void __cdecl Release() noexcept;
+
+        const uint32_t* __cdecl GetBlock(_In_ size_t bx, _In_ size_t by) noexcept;
+            // 16 R8G8B8A8 texels of block (bx, by) in row order, valid until the next call
+
+        uint32_t __cdecl GetTexel(_In_ size_t x, _In_ size_t y) noexcept;
+
+        void __cdecl SampleLinear(_In_ float u, _In_ float v, _Out_writes_(4) float* rgba) noexcept;
+            // Bilinear filtering with wrap addressing; channels are returned as stored (no sRGB conversion)
+
+    private:
+        Image       m_image;
+        size_t      m_blockSize;
+        size_t      m_blocksAcross;
+        void        (*m_pfDecode)(uint8_t*, size_t, const uint8_t*, size_t);
+        size_t      m_slotShift;
+        size_t      m_slotMaskX;
+        size_t      m_slotMaskY;
+        size_t*     m_tags;     // block index + 1 held by each slot, 0 if empty
+        uint32_t*   m_texels;   // 16 texels per slot
+    };
 
     //---------------------------------------------------------------------------------
     // Normal map operations
@@ -871,6 +957,19 @@ namespace DirectX
         _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
         _In_ CNMAP_FLAGS flags, _In_ float amplitude, _In_ DXGI_FORMAT format, _Out_ ScratchImage& normalMaps) noexcept;
 
+    HRESULT __cdecl GenerateNormalMapMipMaps(
+        _In_ const Image& baseImage, _In_ size_t levels, _Out_ ScratchImage& mipChain,
+        _Out_opt_ ScratchImage* roughnessChain = nullptr, _In_ float baseRoughness = 0.5f) noexcept;
+    HRESULT __cdecl GenerateNormalMapMipMaps(
+        _In_reads_(nimages) const Image* srcImages, _In_ size_t nimages, _In_ const TexMetadata& metadata,
+        _In_ size_t levels, _Out_ ScratchImage& mipChain,
+        _Out_opt_ ScratchImage* roughnessChain = nullptr, _In_ float baseRoughness = 0.5f) noexcept;
+        // Mip chain for a tangent-space normal map: every level box-averages the vectors of the level above
+        // and stores them renormalized, in the source format (UNORM formats are decoded as 2*c-1, two-channel
+        // formats get Z reconstructed). levels of '0' indicates a full mipchain.
+        // roughnessChain receives an R8_UNORM chain of perceptual roughness: baseRoughness widened by the
+        // Toksvig factor of the averaged (unnormalized) normal's length.
+
     //---------------------------------------------------------------------------------
     // Misc image operations
 
@@ -0,0 +1,175 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexBlockCache.cpp
+//
+// Random access to block-compressed images through a small cache of blocks
+// decoded to R8G8B8A8, for CPU-side sampling
+//-------------------------------------------------------------------------------------
+
+#include "DirectXTexP.h"
+
+#include "BC.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    inline float UNormChannel(uint32_t texel, size_t channel) noexcept
+    {
+        return static_cast<float>((texel >> (channel * 8)) & 0xFF) * (1.0f / 255.0f);
+    }
+
+    // Wraps a texel coordinate into [0, size)
+    inline size_t WrapCoord(ptrdiff_t i, size_t size) noexcept
+    {
+        const auto n = static_cast<ptrdiff_t>(size);
+        i %= n;
+        return static_cast<size_t>((i < 0) ? i + n : i);
+    }
+}
+
+
+//=====================================================================================
+// BlockTexelCache methods
+//=====================================================================================
+
+BlockTexelCache& BlockTexelCache::operator= (BlockTexelCache&& moveFrom) noexcept
+{
+    if (this != &moveFrom)
+    {
+        Release();
+
+        m_image = moveFrom.m_image;
+        m_blockSize = moveFrom.m_blockSize;
+        m_blocksAcross = moveFrom.m_blocksAcross;
+        m_pfDecode = moveFrom.m_pfDecode;
+        m_slotShift = moveFrom.m_slotShift;
+        m_slotMaskX = moveFrom.m_slotMaskX;
+        m_slotMaskY = moveFrom.m_slotMaskY;
+        m_tags = moveFrom.m_tags;
+        m_texels = moveFrom.m_texels;
+
+        moveFrom.m_tags = nullptr;
+        moveFrom.m_texels = nullptr;
+        moveFrom.m_pfDecode = nullptr;
+        moveFrom.m_image = {};
+    }
+    return *this;
+}
+
+_Use_decl_annotations_
+HRESULT BlockTexelCache::Initialize(const Image& image, size_t cacheBlocks) noexcept
+{
+    if (!image.pixels || !image.width || !image.height || !cacheBlocks)
+        return E_INVALIDARG;
+
+    Release();
+
+    size_t blockSize;
+    const BC_DECODE_FAST pfDecode = GetFastDecoder(image.format, blockSize);
+    if (!pfDecode)
+        return HRESULT_E_NOT_SUPPORTED;
+
+    // Slots form a grid of 2^shiftX by 2^shiftY blocks that tiles the image
+    size_t bits = 0;
+    while ((size_t(1) << bits) < cacheBlocks)
+        ++bits;
+
+    if (bits > 20)
+        return E_INVALIDARG;
+
+    const size_t slotShift = (bits + 1) / 2;
+    const size_t slotCount = size_t(1) << bits;
+
+    std::unique_ptr<size_t[]> tags(new (std::nothrow) size_t[slotCount]);
+    std::unique_ptr<uint32_t[]> texels(new (std::nothrow) uint32_t[slotCount * NUM_PIXELS_PER_BLOCK]);
+    if (!tags || !texels)
+        return E_OUTOFMEMORY;
+
+    memset(tags.get(), 0, sizeof(size_t) * slotCount);
+
+    m_image = image;
+    m_blockSize = blockSize;
+    m_blocksAcross = (image.width + 3) / 4;
+    m_pfDecode = pfDecode;
+    m_slotShift = slotShift;
+    m_slotMaskX = (size_t(1) << slotShift) - 1;
+    m_slotMaskY = (size_t(1) << (bits - slotShift)) - 1;
+    m_tags = tags.release();
+    m_texels = texels.release();
+
+    return S_OK;
+}
+
+void BlockTexelCache::Release() noexcept
+{
+    delete[] m_tags;
+    delete[] m_texels;
+
+    m_image = {};
+    m_blockSize = m_blocksAcross = 0;
+    m_pfDecode = nullptr;
+    m_slotShift = m_slotMaskX = m_slotMaskY = 0;
+    m_tags = nullptr;
+    m_texels = nullptr;
+}
+
+_Use_decl_annotations_
+const uint32_t* BlockTexelCache::GetBlock(size_t bx, size_t by) noexcept
+{
+    assert(m_tags && m_texels);
+    assert(bx < m_blocksAcross && by * 4 < m_image.height);
+
+    const size_t slot = ((by & m_slotMaskY) << m_slotShift) | (bx & m_slotMaskX);
+    const size_t tag = by * m_blocksAcross + bx + 1;
+
+    uint32_t* pTexels = m_texels + slot * NUM_PIXELS_PER_BLOCK;
+    if (m_tags[slot] != tag)
+    {
+        m_pfDecode(reinterpret_cast<uint8_t*>(pTexels), sizeof(uint32_t) * 4,
+            m_image.pixels + m_image.rowPitch * by + m_blockSize * bx, 1);
+        m_tags[slot] = tag;
+    }
+
+    return pTexels;
+}
+
+_Use_decl_annotations_
+uint32_t BlockTexelCache::GetTexel(size_t x, size_t y) noexcept
+{
+    assert(x < m_image.width && y < m_image.height);
+
+    return GetBlock(x >> 2, y >> 2)[((y & 3) << 2) | (x & 3)];
+}
+
+_Use_decl_annotations_
+void BlockTexelCache::SampleLinear(float u, float v, float* rgba) noexcept
+{
+    assert(rgba);
+
+    // Texel centers sit at half-integer coordinates
+    const float x = u * static_cast<float>(m_image.width) - 0.5f;
+    const float y = v * static_cast<float>(m_image.height) - 0.5f;
+    const float fx = floorf(x);
+    const float fy = floorf(y);
+    const float tx = x - fx;
+    const float ty = y - fy;
+
+    const size_t x0 = WrapCoord(static_cast<ptrdiff_t>(fx), m_image.width);
+    const size_t y0 = WrapCoord(static_cast<ptrdiff_t>(fy), m_image.height);
+    const size_t x1 = (x0 + 1 < m_image.width) ? x0 + 1 : 0;
+    const size_t y1 = (y0 + 1 < m_image.height) ? y0 + 1 : 0;
+
+    const uint32_t t00 = GetTexel(x0, y0);
+    const uint32_t t10 = GetTexel(x1, y0);
+    const uint32_t t01 = GetTexel(x0, y1);
+    const uint32_t t11 = GetTexel(x1, y1);
+
+    for (size_t c = 0; c < 4; ++c)
+    {
+        const float top = UNormChannel(t00, c) + tx * (UNormChannel(t10, c) - UNormChannel(t00, c));
+        const float bottom = UNormChannel(t01, c) + tx * (UNormChannel(t11, c) - UNormChannel(t01, c));
+        rgba[c] = top + ty * (bottom - top);
+    }
+}
@@ -11,12 +11,11 @@
 
 #include "DirectXTexP.h"
 
-#ifdef _OPENMP
-#include <omp.h>
-#pragma warning(disable : 4616 6993)
-#endif
-
 #include "BC.h"
+#include "threading.h"
+
+#include <cmath>
+#include <mutex>
 
 using namespace DirectX;
 using namespace DirectX::Internal;
@@ -31,7 +30,12 @@ namespace
         static_assert(static_cast<int>(TEX_COMPRESS_UNIFORM) == static_cast<int>(BC_FLAGS_UNIFORM), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_USE_3SUBSETS) == static_cast<int>(BC_FLAGS_USE_3SUBSETS), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
         static_assert(static_cast<int>(TEX_COMPRESS_BC7_QUICK) == static_cast<int>(BC_FLAGS_FORCE_BC7_MODE6), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
-        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6));
+        static_assert(static_cast<int>(TEX_COMPRESS_BC_FAST) == static_cast<int>(BC_FLAGS_FAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC_FAST_REFINE) == static_cast<int>(BC_FLAGS_FAST_REFINE), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_FAST) == static_cast<int>(BC_FLAGS_BC7_FAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_VERYFAST) == static_cast<int>(BC_FLAGS_BC7_VERYFAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        static_assert(static_cast<int>(TEX_COMPRESS_BC7_ULTRAFAST) == static_cast<int>(BC_FLAGS_BC7_ULTRAFAST), "TEX_COMPRESS_* flags should match BC_FLAGS_*");
+        return (compress & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A | BC_FLAGS_UNIFORM | BC_FLAGS_USE_3SUBSETS | BC_FLAGS_FORCE_BC7_MODE6 | BC_FLAGS_FAST | BC_FLAGS_FAST_REFINE | BC_FLAGS_BC7_TIER_MASK));
     }
 
     constexpr TEX_FILTER_FLAGS GetSRGBFlags(_In_ TEX_COMPRESS_FLAGS compress) noexcept
@@ -69,13 +73,77 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    HRESULT CompressBC(
-        const Image& image,
-        const Image& result,
-        uint32_t bcflags,
-        TEX_FILTER_FLAGS srgb,
-        float threshold,
-        const std::function<bool __cdecl(size_t, size_t)>& statusCallback) noexcept
+    struct BCEncodeSetup
+    {
+        DXGI_FORMAT format;
+        size_t sbpp;
+        BC_ENCODE pfEncode;
+        size_t blocksize;
+        TEX_FILTER_FLAGS cflags;
+
+        // Integer BC1 / BC3 path (BC_FLAGS_FAST)
+        bool fast;
+        bool fastSwizzle;       // source is BGRA
+        bool fastOpaque;        // source has no alpha channel
+        BC_FAST_QUALITY fastQuality;
+        uint32_t alphaRef;
+    };
+
+    void SetupFastEncode(const Image& image, const Image& result, uint32_t bcflags, TEX_FILTER_FLAGS srgb, float threshold, BCEncodeSetup& setup) noexcept
+    {
+        setup.fast = false;
+        setup.fastSwizzle = false;
+        setup.fastOpaque = false;
+        setup.fastQuality = (bcflags & BC_FLAGS_FAST_REFINE) ? BC_FAST_QUALITY_NORMAL : BC_FAST_QUALITY_FAST;
+        setup.alphaRef = 0;
+
+        // Dithering needs the float encoder's error diffusion
+        if (!(bcflags & BC_FLAGS_FAST) || (bcflags & (BC_FLAGS_DITHER_RGB | BC_FLAGS_DITHER_A)))
+            return;
+
+        switch (result.format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            setup.alphaRef = static_cast<uint32_t>(std::min(std::max(std::ceil(threshold * 255.f), 0.f), 256.f));
+            break;
+
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            break;
+
+        default:
+            return;
+        }
+
+        switch (image.format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            break;
+
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            setup.fastSwizzle = true;
+            break;
+
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            setup.fastSwizzle = true;
+            setup.fastOpaque = true;
+            break;
+
+        default:
+            return;
+        }
+
+        // Texels go to the encoder unconverted, so both sides must be in the same color space
+        const bool srgbIn = IsSRGB(image.format) || (srgb & TEX_FILTER_SRGB_IN);
+        const bool srgbOut = IsSRGB(result.format) || (srgb & TEX_FILTER_SRGB_OUT);
+        setup.fast = (srgbIn == srgbOut);
+    }
+
+    HRESULT SetupBCEncode(const Image& image, const Image& result, uint32_t bcflags, TEX_FILTER_FLAGS srgb, float threshold, BCEncodeSetup& setup) noexcept
     {
         if (!image.pixels || !result.pixels)
             return E_POINTER;
@@ -83,8 +151,8 @@ namespace
         assert(image.width == result.width);
         assert(image.height == result.height);
 
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
+        setup.format = image.format;
+        size_t sbpp = BitsPerPixel(setup.format);
         if (!sbpp)
             return E_FAIL;
 
@@ -95,31 +163,105 @@ namespace
         }
 
         // Round to bytes
-        sbpp = (sbpp + 7) / 8;
-
-        uint8_t *pDest = result.pixels;
+        setup.sbpp = (sbpp + 7) / 8;
 
         // Determine BC format encoder
-        BC_ENCODE pfEncode;
-        size_t blocksize;
-        TEX_FILTER_FLAGS cflags;
-        if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
+        if (!DetermineEncoderSettings(result.format, setup.pfEncode, setup.blocksize, setup.cflags))
             return HRESULT_E_NOT_SUPPORTED;
 
-        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-        const uint8_t *pSrc = image.pixels;
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
-        const size_t rowPitch = image.rowPitch;
-        for (size_t h = 0; h < image.height; h += 4)
+        SetupFastEncode(image, result, bcflags, srgb, threshold, setup);
+
+        return S_OK;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // CompressBlockRows for the integer encoder: blocks are gathered as R8G8B8A8 a few at a time
+    HRESULT CompressBlockRowsFast(
+        const Image& image,
+        const Image& result,
+        const BCEncodeSetup& setup,
+        size_t rowBegin,
+        size_t rowEnd) noexcept
+    {
+        constexpr size_t BlocksPerBatch = 8;
+        XM_ALIGNED_DATA(16) uint32_t texels[BlocksPerBatch * NUM_PIXELS_PER_BLOCK];
+
+        // Partial blocks replicate edge texels like the float path does
+        auto edge = [](size_t i, size_t count) noexcept -> size_t
         {
-            if (statusCallback)
+            static const size_t uSrc[] = { 0, 0, 0, 1 };
+            while (i >= count)
+                i = uSrc[i];
+            return i;
+        };
+
+        const size_t blocksAcross = (image.width + 3) / 4;
+        for (size_t row = rowBegin; row < rowEnd && row * 4 < image.height; ++row)
+        {
+            const size_t h = row * 4;
+            const size_t ph = std::min<size_t>(4, image.height - h);
+            uint8_t* pDest = result.pixels + result.rowPitch * row;
+
+            for (size_t bx = 0; bx < blocksAcross; bx += BlocksPerBatch)
             {
-                if (!statusCallback(h, image.height))
+                const size_t count = std::min<size_t>(BlocksPerBatch, blocksAcross - bx);
+                for (size_t b = 0; b < count; ++b)
                 {
-                    return E_ABORT;
+                    const size_t w = (bx + b) * 4;
+                    const size_t pw = std::min<size_t>(4, image.width - w);
+                    uint32_t* pBlock = texels + b * NUM_PIXELS_PER_BLOCK;
+
+                    for (size_t t = 0; t < 4; ++t)
+                    {
+                        auto sptr = reinterpret_cast<const uint32_t*>(image.pixels + image.rowPitch * (h + edge(t, ph))) + w;
+                        for (size_t s = 0; s < 4; ++s)
+                        {
+                            uint32_t texel = sptr[edge(s, pw)];
+                            if (setup.fastSwizzle)
+                                texel = (texel & 0xFF00FF00) | ((texel >> 16) & 0xFF) | ((texel & 0xFF) << 16);
+                            if (setup.fastOpaque)
+                                texel |= 0xFF000000;
+                            pBlock[t * 4 + s] = texel;
+                        }
+                    }
                 }
+
+                if (setup.blocksize == 8)
+                    FastEncodeBC1(pDest + bx * 8, texels, count, setup.alphaRef, setup.fastQuality);
+                else
+                    FastEncodeBC3(pDest + bx * 16, texels, count, setup.fastQuality);
             }
+        }
+
+        return S_OK;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Encodes block rows [rowBegin, rowEnd). Block rows touch disjoint source and
+    // destination memory, so any number of them can be encoded concurrently.
+    HRESULT CompressBlockRows(
+        const Image& image,
+        const Image& result,
+        const BCEncodeSetup& setup,
+        uint32_t bcflags,
+        TEX_FILTER_FLAGS srgb,
+        float threshold,
+        size_t rowBegin,
+        size_t rowEnd) noexcept
+    {
+        if (setup.fast)
+            return CompressBlockRowsFast(image, result, setup, rowBegin, rowEnd);
+
+        const DXGI_FORMAT format = setup.format;
+        const size_t blocksize = setup.blocksize;
 
+        XM_ALIGNED_DATA(16) XMVECTOR temp[16];
+        const uint8_t *pSrc = image.pixels + image.rowPitch * 4 * rowBegin;
+        uint8_t *pDest = result.pixels + result.rowPitch * rowBegin;
+        const uint8_t *pEnd = image.pixels + image.slicePitch;
+        const size_t rowPitch = image.rowPitch;
+        for (size_t h = rowBegin * 4; h < image.height && h < rowEnd * 4; h += 4)
+        {
             const uint8_t *sptr = pSrc;
             uint8_t* dptr = pDest;
             const size_t ph = std::min<size_t>(4, image.height - h);
@@ -186,14 +328,14 @@ namespace
                     }
                 }
 
-                ConvertScanline(temp, 16, result.format, format, cflags | srgb);
+                ConvertScanline(temp, 16, result.format, format, setup.cflags | srgb);
 
-                if (pfEncode)
-                    pfEncode(dptr, temp, bcflags);
+                if (setup.pfEncode)
+                    setup.pfEncode(dptr, temp, bcflags);
                 else
                     D3DXEncodeBC1(dptr, temp, threshold, bcflags);
 
-                sptr += sbpp * 4;
+                sptr += setup.sbpp * 4;
                 dptr += blocksize;
             }
 
@@ -204,10 +346,8 @@ namespace
         return S_OK;
     }
 
-
     //-------------------------------------------------------------------------------------
-#ifdef _OPENMP
-    HRESULT CompressBC_Parallel(
+    HRESULT CompressBC(
         const Image& image,
         const Image& result,
         uint32_t bcflags,
@@ -215,162 +355,104 @@ namespace
         float threshold,
         const std::function<bool __cdecl(size_t, size_t)>& statusCallback) noexcept
     {
-        if (!image.pixels || !result.pixels)
-            return E_POINTER;
-
-        assert(image.width == result.width);
-        assert(image.height == result.height);
-
-        const DXGI_FORMAT format = image.format;
-        size_t sbpp = BitsPerPixel(format);
-        if (!sbpp)
-            return E_FAIL;
-
-        if (sbpp < 8)
-        {
-            // We don't support compressing from monochrome (DXGI_FORMAT_R1_UNORM)
-            return HRESULT_E_NOT_SUPPORTED;
-        }
-
-        // Round to bytes
-        sbpp = (sbpp + 7) / 8;
-
-        const uint8_t *pEnd = image.pixels + image.slicePitch;
-
-        // Determine BC format encoder
-        BC_ENCODE pfEncode;
-        size_t blocksize;
-        TEX_FILTER_FLAGS cflags;
-        if (!DetermineEncoderSettings(result.format, pfEncode, blocksize, cflags))
-            return HRESULT_E_NOT_SUPPORTED;
-
-        // Refactored version of loop to support parallel independance
-        const size_t nBlocks = std::max<size_t>(1, (image.width + 3) / 4) * std::max<size_t>(1, (image.height + 3) / 4);
-
-        bool fail = false;
-
-        size_t progress = 0;
-        bool abort = false;
-
-        const size_t progressTotal = std::max<size_t>(1, (image.height + 3) / 4);
+        BCEncodeSetup setup;
+        HRESULT hr = SetupBCEncode(image, result, bcflags, srgb, threshold, setup);
+        if (FAILED(hr))
+            return hr;
 
-#pragma omp parallel for shared(progress)
-        for (int nb = 0; nb < static_cast<int>(nBlocks); ++nb)
+        const size_t blockRows = (image.height + 3) / 4;
+        for (size_t row = 0; row < blockRows; ++row)
         {
-#pragma omp flush (abort)
-            if (abort)
+            if (statusCallback)
             {
-                // Short circuit the loop body if an abort is requested.
-                // OpenMP 2.0 does not support cancellation of a 'parallel for' loop.
-                continue;
+                if (!statusCallback(row * 4, image.height))
+                {
+                    return E_ABORT;
+                }
             }
 
-            const int nbWidth = std::max<int>(1, int((image.width + 3) / 4));
-
-            int y = nb / nbWidth;
-            const int x = (nb - (y*nbWidth)) * 4;
-            y *= 4;
-
-            assert((x >= 0) && (x < int(image.width)));
-            assert((y >= 0) && (y < int(image.height)));
+            hr = CompressBlockRows(image, result, setup, bcflags, srgb, threshold, row, row + 1);
+            if (FAILED(hr))
+                return hr;
+        }
 
-            const size_t rowPitch = image.rowPitch;
-            const uint8_t *pSrc = image.pixels + (size_t(y)*rowPitch) + (size_t(x)*sbpp);
+        return S_OK;
+    }
 
-            uint8_t *pDest = result.pixels + (size_t(nb)*blocksize);
 
-            const size_t ph = std::min<size_t>(4, image.height - size_t(y));
-            const size_t pw = std::min<size_t>(4, image.width - size_t(x));
-            assert(pw > 0 && ph > 0);
+    //-------------------------------------------------------------------------------------
+    // Blocks worth starting a thread for. ParallelFor starts its threads on every call, i.e.
+    // per image and per mip level, which costs tens of microseconds; BC6H/BC7 spend about
+    // that on a handful of blocks, the other encoders need a few hundred.
+    size_t GetParallelGrainBlocks(DXGI_FORMAT format) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_BC6H_TYPELESS:
+        case DXGI_FORMAT_BC6H_UF16:
+        case DXGI_FORMAT_BC6H_SF16:
+        case DXGI_FORMAT_BC7_TYPELESS:
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            return 16;
 
-            const ptrdiff_t bytesLeft = pEnd - pSrc;
-            assert(bytesLeft > 0);
-            size_t bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft));
+        default:
+            return 1024;
+        }
+    }
 
-            XM_ALIGNED_DATA(16) XMVECTOR temp[16];
-            if (!LoadScanline(&temp[0], pw, pSrc, bytesToRead, format))
-                fail = true;
 
-            if (ph > 1)
-            {
-                bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch);
-                if (!LoadScanline(&temp[4], pw, pSrc + rowPitch, bytesToRead, format))
-                    fail = true;
+    //-------------------------------------------------------------------------------------
+    // Splits the image into bands of block rows and encodes them on std::threads.
+    // Images too small to pay for the threads are encoded on the calling thread.
+    HRESULT CompressBC_Parallel(
+        const Image& image,
+        const Image& result,
+        uint32_t bcflags,
+        TEX_FILTER_FLAGS srgb,
+        float threshold,
+        const std::function<bool __cdecl(size_t, size_t)>& statusCallback,
+        size_t maxThreads = 0) noexcept
+    {
+        BCEncodeSetup setup;
+        HRESULT hr = SetupBCEncode(image, result, bcflags, srgb, threshold, setup);
+        if (FAILED(hr))
+            return hr;
 
-                if (ph > 2)
-                {
-                    bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 2);
-                    if (!LoadScanline(&temp[8], pw, pSrc + rowPitch * 2, bytesToRead, format))
-                        fail = true;
+        const size_t blockRows = std::max<size_t>(1, (image.height + 3) / 4);
+        const size_t blocksAcross = std::max<size_t>(1, (image.width + 3) / 4);
+        const size_t grain = std::max<size_t>(1, GetParallelGrainBlocks(result.format) / blocksAcross);
 
-                    if (ph > 3)
-                    {
-                        bytesToRead = std::min<size_t>(rowPitch, size_t(bytesLeft) - rowPitch * 3);
-                        if (!LoadScanline(&temp[12], pw, pSrc + rowPitch * 3, bytesToRead, format))
-                            fail = true;
-                    }
-                }
-            }
+        std::atomic<HRESULT> status(S_OK);
+        std::mutex progressLock;
+        size_t progress = 0;
 
-            if (pw != 4 || ph != 4)
+        ParallelFor(blockRows, grain, [&](size_t begin, size_t end) -> bool
             {
-                // Replicate pixels for partial block
-                static const size_t uSrc[] = { 0, 0, 0, 1 };
-
-                if (pw < 4)
+                const HRESULT chunkResult = CompressBlockRows(image, result, setup, bcflags, srgb, threshold, begin, end);
+                if (FAILED(chunkResult))
                 {
-                    for (size_t t = 0; t < ph && t < 4; ++t)
-                    {
-                        for (size_t s = pw; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(t << 2) | uSrc[s]];
-                        }
-                    }
+                    status = chunkResult;
+                    return false;
                 }
 
-                if (ph < 4)
+                if (statusCallback)
                 {
-                    for (size_t t = ph; t < 4; ++t)
+                    // Serialized so the callback never sees concurrent calls
+                    std::lock_guard<std::mutex> lock(progressLock);
+                    progress += (end - begin) * 4;
+                    if (!statusCallback(std::min<size_t>(progress, image.height), image.height))
                     {
-                        for (size_t s = 0; s < 4; ++s)
-                        {
-                            temp[(t << 2) | s] = temp[(uSrc[t] << 2) | s];
-                        }
+                        status = E_ABORT;
+                        return false;
                     }
                 }
-            }
-
-            ConvertScanline(temp, 16, result.format, format, cflags | srgb);
-
-            if (pfEncode)
-                pfEncode(pDest, temp, bcflags);
-            else
-                D3DXEncodeBC1(pDest, temp, threshold, bcflags);
 
-            // Report progress when a new row is reached.
-            if (x == 0 && statusCallback)
-            {
-#pragma omp atomic
-                progress += 4;
-
-                if (!statusCallback(progress, progressTotal))
-                {
-                    abort = true;
-#pragma omp flush (abort)
-                }
-            }
-        }
+                return true;
+            }, maxThreads);
 
-        if (abort)
-        {
-            return E_ABORT;
-        }
-        else
-        {
-            return (fail) ? E_FAIL : S_OK;
-        }
+        return status;
     }
-#endif // _OPENMP
 
 
     //-------------------------------------------------------------------------------------
@@ -422,7 +504,56 @@ namespace
 
 
     //-------------------------------------------------------------------------------------
-    HRESULT DecompressBC(_In_ const Image& cImage, _In_ const Image& result) noexcept
+    // Decodes straight to R8G8B8A8, on the ParallelFor workers when 'parallel' is set. Whole
+    // blocks are written in place; blocks cut by the right or bottom edge go through a scratch block.
+    HRESULT DecompressBCFast(
+        _In_ const Image& cImage,
+        _In_ const Image& result,
+        _In_ BC_DECODE_FAST pfDecode,
+        size_t blockSize,
+        bool parallel) noexcept
+    {
+        constexpr size_t ChunkTexels = 65536;
+
+        const size_t blocksAcross = (cImage.width + 3) / 4;
+        const size_t blockRows = (cImage.height + 3) / 4;
+        const size_t wholeBlocks = cImage.width / 4;
+        const size_t grain = std::max<size_t>(1, ChunkTexels / (blocksAcross * NUM_PIXELS_PER_BLOCK));
+
+        ParallelFor(blockRows, grain, [&](size_t begin, size_t end) -> bool
+            {
+                uint8_t block[NUM_PIXELS_PER_BLOCK * 4];
+                for (size_t row = begin; row < end; ++row)
+                {
+                    const uint8_t* pSrc = cImage.pixels + cImage.rowPitch * row;
+                    uint8_t* pDest = result.pixels + result.rowPitch * row * 4;
+                    const size_t ph = std::min<size_t>(4, cImage.height - row * 4);
+
+                    size_t bx = 0;
+                    if (ph == 4)
+                    {
+                        pfDecode(pDest, result.rowPitch, pSrc, wholeBlocks);
+                        bx = wholeBlocks;
+                    }
+
+                    for (; bx < blocksAcross; ++bx)
+                    {
+                        pfDecode(block, 16, pSrc + bx * blockSize, 1);
+
+                        const size_t pw = std::min<size_t>(4, cImage.width - bx * 4);
+                        for (size_t y = 0; y < ph; ++y)
+                            memcpy(pDest + result.rowPitch * y + bx * 16, block + y * 16, pw * 4);
+                    }
+                }
+                return true;
+            }, parallel ? 0 : 1);
+
+        return S_OK;
+    }
+
+
+    //-------------------------------------------------------------------------------------
+    HRESULT DecompressBC(_In_ const Image& cImage, _In_ const Image& result, bool parallel) noexcept
     {
         if (!cImage.pixels || !result.pixels)
             return E_POINTER;
@@ -462,6 +593,16 @@ namespace
         default:                        cformat = cImage.format;         break;
         }
 
+        // 8-bit RGBA targets that need no sRGB conversion skip the float pipeline
+        if ((format == DXGI_FORMAT_R8G8B8A8_UNORM || format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB)
+            && IsSRGB(format) == IsSRGB(cformat))
+        {
+            size_t blockSize;
+            const BC_DECODE_FAST pfDecodeFast = GetFastDecoder(cformat, blockSize);
+            if (pfDecodeFast)
+                return DecompressBCFast(cImage, result, pfDecodeFast, blockSize, parallel);
+        }
+
         // Determine BC format decoder
         BC_DECODE pfDecode;
         size_t sbpp;
@@ -699,11 +840,7 @@ HRESULT DirectX::CompressEx(
     // Compress single image
     if (options.flags & TEX_COMPRESS_PARALLEL)
     {
-    #ifndef _OPENMP
-        hr = E_NOTIMPL;
-    #else
         hr = CompressBC_Parallel(srcImage, *img, GetBCFlags(options.flags), GetSRGBFlags(options.flags), options.threshold, statusCallback);
-    #endif // _OPENMP
     }
     else
     {
@@ -805,11 +942,7 @@ HRESULT DirectX::CompressEx(
 
         if (options.flags & TEX_COMPRESS_PARALLEL)
         {
-        #ifndef _OPENMP
-            hr = E_NOTIMPL;
-        #else
             hr = CompressBC_Parallel(src, dest[index], GetBCFlags(options.flags), GetSRGBFlags(options.flags), options.threshold, nullptr);
-        #endif // _OPENMP
         }
         else
         {
@@ -853,6 +986,16 @@ HRESULT DirectX::Decompress(
     const Image& cImage,
     DXGI_FORMAT format,
     ScratchImage& image) noexcept
+{
+    return Decompress(cImage, format, TEX_COMPRESS_DEFAULT, image);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Decompress(
+    const Image& cImage,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS flags,
+    ScratchImage& image) noexcept
 {
     if (!IsCompressed(cImage.format) || IsCompressed(format))
         return E_INVALIDARG;
@@ -889,7 +1032,7 @@ HRESULT DirectX::Decompress(
     }
 
     // Decompress single image
-    hr = DecompressBC(cImage, *img);
+    hr = DecompressBC(cImage, *img, (flags & TEX_COMPRESS_PARALLEL) != 0);
     if (FAILED(hr))
         image.Release();
 
@@ -903,6 +1046,18 @@ HRESULT DirectX::Decompress(
     const TexMetadata& metadata,
     DXGI_FORMAT format,
     ScratchImage& images) noexcept
+{
+    return Decompress(cImages, nimages, metadata, format, TEX_COMPRESS_DEFAULT, images);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Decompress(
+    const Image* cImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    DXGI_FORMAT format,
+    TEX_COMPRESS_FLAGS flags,
+    ScratchImage& images) noexcept
 {
     if (!cImages || !nimages)
         return E_INVALIDARG;
@@ -967,7 +1122,7 @@ HRESULT DirectX::Decompress(
             return E_FAIL;
         }
 
-        hr = DecompressBC(src, dest[index]);
+        hr = DecompressBC(src, dest[index], (flags & TEX_COMPRESS_PARALLEL) != 0);
         if (FAILED(hr))
         {
             images.Release();
@@ -5143,11 +5143,17 @@ HRESULT DirectX::ConvertEx(
         }
     }
 
+    // The fast kernels only replace the scanline path; WIC keeps what it converts unless
+    // TEX_FILTER_FORCE_NON_WIC is given
     WICPixelFormatGUID pfGUID, targetGUID;
     if (UseWICConversion(options.filter, srcImage.format, format, pfGUID, targetGUID))
     {
         hr = ConvertUsingWIC(srcImage, pfGUID, targetGUID, options.filter, options.threshold, *rimage);
     }
+    else if (CanConvertFast(srcImage.format, format, options.filter))
+    {
+        hr = ConvertFast(srcImage, options.filter, options.threshold, *rimage, statusCallback);
+    }
     else
     {
         hr = ConvertCustom(srcImage, options.filter, *rimage, options.threshold, 0, statusCallback);
@@ -5257,6 +5263,7 @@ HRESULT DirectX::ConvertEx(
 
     WICPixelFormatGUID pfGUID, targetGUID;
     const bool usewic = !metadata.IsPMAlpha() && UseWICConversion(options.filter, metadata.format, format, pfGUID, targetGUID);
+    const bool fastconvert = !usewic && CanConvertFast(metadata.format, format, options.filter);
 
     switch (metadata.dimension)
     {
@@ -5286,7 +5293,11 @@ HRESULT DirectX::ConvertEx(
                 return E_FAIL;
             }
 
-            if (usewic)
+            if (fastconvert)
+            {
+                hr = ConvertFast(src, options.filter, options.threshold, dst, nullptr);
+            }
+            else if (usewic)
             {
                 hr = ConvertUsingWIC(src, pfGUID, targetGUID, options.filter, options.threshold, dst);
             }
@@ -5348,7 +5359,11 @@ HRESULT DirectX::ConvertEx(
                         return E_FAIL;
                     }
 
-                    if (usewic)
+                    if (fastconvert)
+                    {
+                        hr = ConvertFast(src, options.filter, options.threshold, dst, nullptr);
+                    }
+                    else if (usewic)
                     {
                         hr = ConvertUsingWIC(src, pfGUID, targetGUID, options.filter, options.threshold, dst);
                     }
@@ -0,0 +1,363 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexConvertFast.cpp
+//
+// Threaded direct conversion kernels for common format pairs. Convert picks them
+// ahead of the LoadScanline/ConvertScanline/StoreScanline path, and they give the
+// same bits as that path. Conversions WIC would handle stay with WIC.
+//-------------------------------------------------------------------------------------
+
+#include "DirectXTexP.h"
+
+#include "threading.h"
+
+using namespace DirectX;
+using namespace DirectX::Internal;
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    // Enough texels per chunk to pay for a thread hand-off
+    constexpr size_t ConvertChunkTexels = 65536;
+
+    // Progress steps reported per image when a status callback is given
+    constexpr size_t ConvertStatusBands = 16;
+
+    //-------------------------------------------------------------------------------------
+    // Byte position of R, G, B and A in a texel of the 8-bit RGBA formats
+    //-------------------------------------------------------------------------------------
+    bool GetByteLayout(DXGI_FORMAT format, _Out_writes_(4) uint8_t* pos) noexcept
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            pos[0] = 0; pos[1] = 1; pos[2] = 2; pos[3] = 3;
+            return true;
+
+        case DXGI_FORMAT_B8G8R8A8_UNORM:
+        case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+        case DXGI_FORMAT_B8G8R8X8_UNORM:
+        case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            pos[0] = 2; pos[1] = 1; pos[2] = 0; pos[3] = 3;
+            return true;
+
+        default:
+            return false;
+        }
+    }
+
+    enum CONVERT_KERNEL : uint32_t
+    {
+        CONVERT_NONE = 0,
+        CONVERT_TABLE,              // 8-bit RGBA -> 8-bit RGBA, R16G16B16A16_FLOAT or R32G32B32A32_FLOAT
+        CONVERT_R32_TO_R16F,
+        CONVERT_RGBA32F_TO_RGBA16F,
+    };
+
+    CONVERT_KERNEL SelectKernel(DXGI_FORMAT inFormat, DXGI_FORMAT outFormat, TEX_FILTER_FLAGS filter) noexcept
+    {
+        // An explicit request for WIC is honored; dithering needs the scanline stores
+        if (filter & (TEX_FILTER_DITHER_MASK | TEX_FILTER_FORCE_WIC))
+            return CONVERT_NONE;
+
+        uint8_t pos[4];
+        if (GetByteLayout(inFormat, pos))
+        {
+            switch (outFormat)
+            {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_UNORM:
+            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                return CONVERT_TABLE;
+
+            default:
+                return CONVERT_NONE;
+            }
+        }
+
+        // Float to float only changes precision unless a color space conversion is requested
+        if (filter & TEX_FILTER_SRGB_MASK)
+            return CONVERT_NONE;
+
+        if (inFormat == DXGI_FORMAT_R32_FLOAT && outFormat == DXGI_FORMAT_R16_FLOAT)
+            return CONVERT_R32_TO_R16F;
+
+        if (inFormat == DXGI_FORMAT_R32G32B32A32_FLOAT && outFormat == DXGI_FORMAT_R16G16B16A16_FLOAT)
+            return CONVERT_RGBA32F_TO_RGBA16F;
+
+        return CONVERT_NONE;
+    }
+
+    //-------------------------------------------------------------------------------------
+    // 8-bit sources have only 256 values per channel, so the generic scanline path is
+    // run once over all of them and its results are replayed from tables
+    //-------------------------------------------------------------------------------------
+    struct ChannelTables
+    {
+        size_t dstElementSize;          // 1, 2 or 4 bytes per channel
+        uint8_t srcByte[4];             // source byte feeding each destination channel
+        bool swizzle;                   // every channel is a plain copy or a constant
+        uint32_t swizzleKeep;           // swizzle: destination bits taken from the source
+        uint32_t swizzleSet;            // swizzle: constant destination bits
+        uint32_t values[4][256];        // destination channel bits for each source byte
+    };
+
+    HRESULT BuildChannelTables(
+        DXGI_FORMAT inFormat,
+        DXGI_FORMAT outFormat,
+        TEX_FILTER_FLAGS filter,
+        float threshold,
+        ChannelTables& tables) noexcept
+    {
+        uint8_t srcPos[4];
+        if (!GetByteLayout(inFormat, srcPos))
+            return E_UNEXPECTED;
+
+        uint8_t dstPos[4] = { 0, 1, 2, 3 };
+        tables.dstElementSize = 1;
+        if (outFormat == DXGI_FORMAT_R16G16B16A16_FLOAT)
+            tables.dstElementSize = 2;
+        else if (outFormat == DXGI_FORMAT_R32G32B32A32_FLOAT)
+            tables.dstElementSize = 4;
+        else if (!GetByteLayout(outFormat, dstPos))
+            return E_UNEXPECTED;
+
+        for (size_t c = 0; c < 4; ++c)
+            tables.srcByte[dstPos[c]] = srcPos[c];
+
+        // Texel i has every byte set to i
+        uint32_t source[256];
+        for (uint32_t i = 0; i < 256; ++i)
+            source[i] = i * 0x01010101u;
+
+        auto scanline = make_AlignedArrayXMVECTOR(256);
+        std::unique_ptr<uint8_t[]> dest(new (std::nothrow) uint8_t[256 * 4 * tables.dstElementSize]);
+        if (!scanline || !dest)
+            return E_OUTOFMEMORY;
+
+        const size_t dstTexelSize = 4 * tables.dstElementSize;
+        if (!LoadScanline(scanline.get(), 256, source, sizeof(source), inFormat))
+            return E_FAIL;
+
+        ConvertScanline(scanline.get(), 256, outFormat, inFormat, filter);
+
+        if (!StoreScanline(dest.get(), 256 * dstTexelSize, outFormat, scanline.get(), 256, threshold))
+            return E_FAIL;
+
+        for (size_t i = 0; i < 256; ++i)
+        {
+            const uint8_t* texel = dest.get() + i * dstTexelSize;
+            for (size_t j = 0; j < 4; ++j)
+            {
+                uint32_t v = 0;
+                memcpy(&v, texel + j * tables.dstElementSize, tables.dstElementSize);
+                tables.values[j][i] = v;
+            }
+        }
+
+        // Most 8-bit to 8-bit pairs only move bytes around
+        tables.swizzle = (tables.dstElementSize == 1);
+        tables.swizzleKeep = 0;
+        tables.swizzleSet = 0;
+        for (size_t j = 0; j < 4 && tables.swizzle; ++j)
+        {
+            bool copy = true;
+            bool constant = true;
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                copy = copy && (tables.values[j][i] == i);
+                constant = constant && (tables.values[j][i] == tables.values[j][0]);
+            }
+
+            if (copy)
+                tables.swizzleKeep |= 0xFFu << (j * 8);
+            else if (constant)
+                tables.swizzleSet |= tables.values[j][0] << (j * 8);
+            else
+                tables.swizzle = false;
+        }
+
+        return S_OK;
+    }
+
+    void SwizzleRow(const ChannelTables& tables, _In_reads_(count) const uint32_t* sptr, size_t count, _Out_writes_(count) uint32_t* dptr) noexcept
+    {
+        // Only the R and B positions can differ between the 8-bit layouts
+        const bool swapRB = (tables.srcByte[0] != 0);
+        const uint32_t keep = tables.swizzleKeep;
+        const uint32_t set = tables.swizzleSet;
+
+        if (swapRB)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint32_t t = sptr[i];
+                const uint32_t s = (t & 0xFF00FF00) | ((t >> 16) & 0xFF) | ((t & 0xFF) << 16);
+                dptr[i] = (s & keep) | set;
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+                dptr[i] = (sptr[i] & keep) | set;
+        }
+    }
+
+    template<typename T>
+    void TableRow(const ChannelTables& tables, _In_reads_(count) const uint32_t* sptr, size_t count, _Out_writes_(count * 4) T* dptr) noexcept
+    {
+        const unsigned s0 = tables.srcByte[0] * 8u;
+        const unsigned s1 = tables.srcByte[1] * 8u;
+        const unsigned s2 = tables.srcByte[2] * 8u;
+        const unsigned s3 = tables.srcByte[3] * 8u;
+
+        for (size_t i = 0; i < count; ++i, dptr += 4)
+        {
+            const uint32_t t = sptr[i];
+            dptr[0] = static_cast<T>(tables.values[0][(t >> s0) & 0xFF]);
+            dptr[1] = static_cast<T>(tables.values[1][(t >> s1) & 0xFF]);
+            dptr[2] = static_cast<T>(tables.values[2][(t >> s2) & 0xFF]);
+            dptr[3] = static_cast<T>(tables.values[3][(t >> s3) & 0xFF]);
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Float to half, clamped the same way StoreScanline does
+    //-------------------------------------------------------------------------------------
+    void ConvertR32ToR16FRow(_In_reads_(count) const float* sptr, size_t count, _Out_writes_(count) HALF* dptr) noexcept
+    {
+        float clamped[256];
+        for (size_t i = 0; i < count; i += std::size(clamped))
+        {
+            const size_t n = std::min(count - i, std::size(clamped));
+            for (size_t j = 0; j < n; ++j)
+                clamped[j] = std::max<float>(std::min<float>(sptr[i + j], 65504.f), -65504.f);
+
+            XMConvertFloatToHalfStream(dptr + i, sizeof(HALF), clamped, sizeof(float), n);
+        }
+    }
+
+    void ConvertRGBA32FToRGBA16FRow(_In_reads_(count) const XMFLOAT4* sptr, size_t count, _Out_writes_(count) XMHALF4* dptr) noexcept
+    {
+        static const XMVECTORF32 s_halfMin = { { { -65504.f, -65504.f, -65504.f, -65504.f } } };
+        static const XMVECTORF32 s_halfMax = { { { 65504.f, 65504.f, 65504.f, 65504.f } } };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const XMVECTOR v = XMVectorClamp(XMLoadFloat4(sptr + i), s_halfMin, s_halfMax);
+            XMStoreHalf4(dptr + i, v);
+        }
+    }
+}
+
+
+//=====================================================================================
+// Entry-points
+//=====================================================================================
+
+_Use_decl_annotations_
+bool DirectX::Internal::CanConvertFast(DXGI_FORMAT inFormat, DXGI_FORMAT outFormat, TEX_FILTER_FLAGS filter) noexcept
+{
+    return SelectKernel(inFormat, outFormat, filter) != CONVERT_NONE;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Internal::ConvertFast(
+    const Image& srcImage,
+    TEX_FILTER_FLAGS filter,
+    float threshold,
+    const Image& destImage,
+    const std::function<bool __cdecl(size_t, size_t)>& statusCallback) noexcept
+{
+    if (!srcImage.pixels || !destImage.pixels)
+        return E_POINTER;
+
+    if (srcImage.width != destImage.width || srcImage.height != destImage.height)
+        return E_FAIL;
+
+    const CONVERT_KERNEL kernel = SelectKernel(srcImage.format, destImage.format, filter);
+    if (kernel == CONVERT_NONE)
+        return HRESULT_E_NOT_SUPPORTED;
+
+    std::unique_ptr<ChannelTables> tables;
+    if (kernel == CONVERT_TABLE)
+    {
+        tables.reset(new (std::nothrow) ChannelTables);
+        if (!tables)
+            return E_OUTOFMEMORY;
+
+        const HRESULT hr = BuildChannelTables(srcImage.format, destImage.format, filter, threshold, *tables);
+        if (FAILED(hr))
+            return hr;
+    }
+
+    const size_t width = srcImage.width;
+    const size_t height = srcImage.height;
+    const size_t grain = std::max<size_t>(1, ConvertChunkTexels / width);
+
+    auto convertRows = [&](size_t begin, size_t end) -> bool
+        {
+            for (size_t y = begin; y < end; ++y)
+            {
+                const uint8_t* pSrc = srcImage.pixels + srcImage.rowPitch * y;
+                uint8_t* pDest = destImage.pixels + destImage.rowPitch * y;
+
+                switch (kernel)
+                {
+                case CONVERT_TABLE:
+                    {
+                        auto sptr = reinterpret_cast<const uint32_t*>(pSrc);
+                        if (tables->swizzle)
+                            SwizzleRow(*tables, sptr, width, reinterpret_cast<uint32_t*>(pDest));
+                        else if (tables->dstElementSize == 1)
+                            TableRow(*tables, sptr, width, pDest);
+                        else if (tables->dstElementSize == 2)
+                            TableRow(*tables, sptr, width, reinterpret_cast<uint16_t*>(pDest));
+                        else
+                            TableRow(*tables, sptr, width, reinterpret_cast<uint32_t*>(pDest));
+                    }
+                    break;
+
+                case CONVERT_R32_TO_R16F:
+                    ConvertR32ToR16FRow(reinterpret_cast<const float*>(pSrc), width, reinterpret_cast<HALF*>(pDest));
+                    break;
+
+                case CONVERT_RGBA32F_TO_RGBA16F:
+                    ConvertRGBA32FToRGBA16FRow(reinterpret_cast<const XMFLOAT4*>(pSrc), width, reinterpret_cast<XMHALF4*>(pDest));
+                    break;
+
+                default:
+                    break;
+                }
+            }
+            return true;
+        };
+
+    if (!statusCallback)
+    {
+        ParallelFor(height, grain, convertRows);
+        return S_OK;
+    }
+
+    // Progress is reported from the calling thread between bands of rows, like ConvertCustom
+    // does between rows, and each band is converted on the worker threads
+    const size_t bandRows = std::max<size_t>(grain, (height + ConvertStatusBands - 1) / ConvertStatusBands);
+    for (size_t y = 0; y < height; y += bandRows)
+    {
+        if (!statusCallback(y, height))
+            return E_ABORT;
+
+        const size_t rows = std::min<size_t>(bandRows, height - y);
+        ParallelFor(rows, grain, [&](size_t begin, size_t end) -> bool
+            {
+                return convertRows(y + begin, y + end);
+            });
+    }
+
+    return S_OK;
+}
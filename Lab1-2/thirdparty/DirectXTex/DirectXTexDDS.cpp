@@ -12,6 +12,7 @@
 #include "DirectXTexP.h"
 
 #include "DDS.h"
+#include "DDSParse.h"
 
 using namespace DirectX;
 using namespace DirectX::Internal;
@@ -335,81 +336,41 @@ namespace
             *ddPixelFormat = {};
         }
 
-        if (size < DDS_MIN_HEADER_SIZE)
-        {
-            return HRESULT_E_INVALID_DATA;
-        }
+        // Structural validation is shared with DDSTextureLoader
+        uint32_t parseFlags = DDSParse::PARSE_NONE;
+        if (flags & DDS_FLAGS_PERMISSIVE)
+            parseFlags |= DDSParse::PARSE_PERMISSIVE;
+        if (flags & DDS_FLAGS_IGNORE_MIPS)
+            parseFlags |= DDSParse::PARSE_IGNORE_MIPS;
 
-        // DDS files always start with the same magic number ("DDS ")
-        auto const dwMagicNumber = *static_cast<const uint32_t*>(pSource);
-        if (dwMagicNumber != DDS_MAGIC)
-        {
-            return E_FAIL;
-        }
+        DDSParse::HeaderView view;
+        const HRESULT hr = DDSParse::ParseHeader(pSource, size, parseFlags, view);
+        if (FAILED(hr))
+            return hr;
 
-        auto pHeader = reinterpret_cast<const DDS_HEADER*>(static_cast<const uint8_t*>(pSource) + sizeof(uint32_t));
+        static_assert(static_cast<int>(TEX_DIMENSION_TEXTURE1D) == static_cast<int>(DDSParse::DIMENSION_TEXTURE1D), "DDS header mismatch");
+        static_assert(static_cast<int>(TEX_DIMENSION_TEXTURE2D) == static_cast<int>(DDSParse::DIMENSION_TEXTURE2D), "DDS header mismatch");
+        static_assert(static_cast<int>(TEX_DIMENSION_TEXTURE3D) == static_cast<int>(DDSParse::DIMENSION_TEXTURE3D), "DDS header mismatch");
 
-        // Verify header to validate DDS file
-        if (flags & DDS_FLAGS_PERMISSIVE)
-        {
-            if (pHeader->size != 24 /* Known variant */
-                && pHeader->size != sizeof(DDS_HEADER))
-            {
-                return HRESULT_E_NOT_SUPPORTED;
-            }
-        }
-        else if (pHeader->size != sizeof(DDS_HEADER))
-        {
-            return HRESULT_E_NOT_SUPPORTED;
-        }
+        auto pHeader = reinterpret_cast<const DDS_HEADER*>(view.header);
 
-        if (flags & DDS_FLAGS_PERMISSIVE)
-        {
-            if (pHeader->ddspf.size != 0 /* Known variant */
-                && pHeader->ddspf.size != 24 /* Known variant */
-                && pHeader->ddspf.size != sizeof(DDS_PIXELFORMAT))
-            {
-                return HRESULT_E_NOT_SUPPORTED;
-            }
-        }
-        else if (pHeader->ddspf.size != sizeof(DDS_PIXELFORMAT))
-        {
-            return HRESULT_E_NOT_SUPPORTED;
-        }
+        metadata.width = view.width;
+        metadata.height = view.height;
+        metadata.depth = view.depth;
+        metadata.arraySize = view.arraySize;
+        metadata.mipLevels = view.mipLevels;
+        metadata.dimension = static_cast<TEX_DIMENSION>(view.dimension);
 
-        metadata.mipLevels = pHeader->mipMapCount;
-        if ((metadata.mipLevels == 0) || (flags & DDS_FLAGS_IGNORE_MIPS))
+        if (view.isCubeMap)
         {
-            metadata.mipLevels = 1;
+            metadata.miscFlags |= TEX_MISC_TEXTURECUBE;
         }
 
-        // Check for DX10 extension
-        if ((pHeader->ddspf.flags & DDS_FOURCC)
-            && (MAKEFOURCC('D', 'X', '1', '0') == pHeader->ddspf.fourCC))
+        if (view.dx10)
         {
-            if (pHeader->size != sizeof(DDS_HEADER)
-                || pHeader->ddspf.size != sizeof(DDS_PIXELFORMAT))
-            {
-                // We do not accept legacy DX9 'known variants' for modern "DX10" extension header files.
-                return E_FAIL;
-            }
-
-            // Buffer must be big enough for both headers and magic value
-            if (size < DDS_DX10_HEADER_SIZE)
-            {
-                return E_FAIL;
-            }
-
-            auto d3d10ext = reinterpret_cast<const DDS_HEADER_DXT10*>(static_cast<const uint8_t*>(pSource) + DDS_MIN_HEADER_SIZE);
             convFlags |= CONV_FLAGS_DX10;
 
-            metadata.arraySize = d3d10ext->arraySize;
-            if (metadata.arraySize == 0)
-            {
-                metadata.arraySize = 1;
-            }
-
-            metadata.format = d3d10ext->dxgiFormat;
+            metadata.format = view.format;
             if (!IsValid(metadata.format) || IsPalettized(metadata.format))
             {
                 return HRESULT_E_NOT_SUPPORTED;
@@ -417,55 +378,7 @@ namespace
 
             static_assert(static_cast<int>(TEX_MISC_TEXTURECUBE) == static_cast<int>(DDS_RESOURCE_MISC_TEXTURECUBE), "DDS header mismatch");
 
-            metadata.miscFlags = d3d10ext->miscFlag & ~static_cast<uint32_t>(TEX_MISC_TEXTURECUBE);
-
-            switch (d3d10ext->resourceDimension)
-            {
-            case DDS_DIMENSION_TEXTURE1D:
-
-                // D3DX writes 1D textures with a fixed Height of 1
-                if ((pHeader->flags & DDS_HEIGHT) && pHeader->height != 1)
-                {
-                    return HRESULT_E_INVALID_DATA;
-                }
-
-                metadata.width = pHeader->width;
-                metadata.height = 1;
-                metadata.depth = 1;
-                metadata.dimension = TEX_DIMENSION_TEXTURE1D;
-                break;
-
-            case DDS_DIMENSION_TEXTURE2D:
-                if (d3d10ext->miscFlag & DDS_RESOURCE_MISC_TEXTURECUBE)
-                {
-                    metadata.miscFlags |= TEX_MISC_TEXTURECUBE;
-                    metadata.arraySize *= 6;
-                }
-
-                metadata.width = pHeader->width;
-                metadata.height = pHeader->height;
-                metadata.depth = 1;
-                metadata.dimension = TEX_DIMENSION_TEXTURE2D;
-                break;
-
-            case DDS_DIMENSION_TEXTURE3D:
-                if (!(pHeader->flags & DDS_HEADER_FLAGS_VOLUME))
-                {
-                    return HRESULT_E_INVALID_DATA;
-                }
-
-                if (metadata.arraySize > 1)
-                    return HRESULT_E_NOT_SUPPORTED;
-
-                metadata.width = pHeader->width;
-                metadata.height = pHeader->height;
-                metadata.depth = pHeader->depth;
-                metadata.dimension = TEX_DIMENSION_TEXTURE3D;
-                break;
-
-            default:
-                return HRESULT_E_INVALID_DATA;
-            }
+            metadata.miscFlags |= view.miscFlags & ~static_cast<uint32_t>(TEX_MISC_TEXTURECUBE);
 
             static_assert(static_cast<int>(TEX_MISC2_ALPHA_MODE_MASK) == static_cast<int>(DDS_MISC_FLAGS2_ALPHA_MODE_MASK), "DDS header mismatch");
 
@@ -475,55 +388,10 @@ namespace
             static_assert(static_cast<int>(TEX_ALPHA_MODE_OPAQUE) == static_cast<int>(DDS_ALPHA_MODE_OPAQUE), "DDS header mismatch");
             static_assert(static_cast<int>(TEX_ALPHA_MODE_CUSTOM) == static_cast<int>(DDS_ALPHA_MODE_CUSTOM), "DDS header mismatch");
 
-            metadata.miscFlags2 = d3d10ext->miscFlags2;
+            metadata.miscFlags2 = view.miscFlags2;
         }
         else
         {
-            metadata.arraySize = 1;
-
-            if (pHeader->flags & DDS_HEADER_FLAGS_VOLUME)
-            {
-                metadata.width = pHeader->width;
-                metadata.height = pHeader->height;
-                metadata.depth = pHeader->depth;
-                metadata.dimension = TEX_DIMENSION_TEXTURE3D;
-
-                if (flags & DDS_FLAGS_PERMISSIVE)
-                {
-                    // Allow cases where mipCount was computed incorrectly
-                    size_t maxMips = 0;
-                    std::ignore = Internal::CalculateMipLevels3D(metadata.width, metadata.height, metadata.depth, maxMips);
-                    metadata.mipLevels = std::min(metadata.mipLevels, maxMips);
-                }
-            }
-            else
-            {
-                if (pHeader->caps2 & DDS_CUBEMAP)
-                {
-                    // We require all six faces to be defined
-                    if ((pHeader->caps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES)
-                        return HRESULT_E_NOT_SUPPORTED;
-
-                    metadata.arraySize = 6;
-                    metadata.miscFlags |= TEX_MISC_TEXTURECUBE;
-                }
-
-                metadata.width = pHeader->width;
-                metadata.height = pHeader->height;
-                metadata.depth = 1;
-                metadata.dimension = TEX_DIMENSION_TEXTURE2D;
-
-                // Note there's no way for a legacy Direct3D 9 DDS to express a '1D' texture
-
-                if (flags & DDS_FLAGS_PERMISSIVE)
-                {
-                    // Allow cases where mipCount was computed incorrectly
-                    size_t maxMips = 0;
-                    std::ignore = Internal::CalculateMipLevels(metadata.width, metadata.height, maxMips);
-                    metadata.mipLevels = std::min(metadata.mipLevels, maxMips);
-                }
-            }
-
             metadata.format = GetDXGIFormat(*pHeader, pHeader->ddspf, flags, convFlags);
 
             if (metadata.format == DXGI_FORMAT_UNKNOWN)
@@ -1770,6 +1638,50 @@ namespace
         return S_OK;
     }
 
+    //-------------------------------------------------------------------------------------
+    // Copies pixels that need no conversion one subresource at a time straight from the
+    // file's layout. Returns S_FALSE if the image's pitches differ from the file's, in
+    // which case the caller falls back to CopyImage.
+    //-------------------------------------------------------------------------------------
+    HRESULT CopySubresources(
+        _In_ const DDSParse::SubresourceLayout& layout,
+        _In_ const TexMetadata& metadata,
+        _In_ const ScratchImage& image) noexcept
+    {
+        if (layout.mipLevels != metadata.mipLevels || layout.arraySize != metadata.arraySize)
+            return E_FAIL;
+
+        for (size_t level = 0; level < metadata.mipLevels; ++level)
+        {
+            const Image* img = image.GetImage(level, 0, 0);
+            if (!img || !img->pixels)
+                return E_POINTER;
+
+            if (img->rowPitch != layout.mips[level].rowPitch || img->slicePitch != layout.mips[level].slicePitch)
+                return S_FALSE;
+        }
+
+        for (size_t item = 0; item < metadata.arraySize; ++item)
+        {
+            for (size_t level = 0; level < metadata.mipLevels; ++level)
+            {
+                const DDSParse::MipLayout& mip = layout.mips[level];
+                const uint8_t* pSrc = layout.GetPixels(item, level);
+
+                for (size_t slice = 0; slice < mip.depth; ++slice, pSrc += mip.slicePitch)
+                {
+                    const Image* img = image.GetImage(level, item, slice);
+                    if (!img || !img->pixels)
+                        return E_POINTER;
+
+                    memcpy(img->pixels, pSrc, mip.slicePitch);
+                }
+            }
+        }
+
+        return S_OK;
+    }
+
     HRESULT CopyImageInPlace(uint32_t convFlags, _In_ const ScratchImage& image) noexcept
     {
         if (!image.GetPixels())
@@ -2002,10 +1914,6 @@ HRESULT DirectX::LoadFromDDSMemoryEx(
             return E_FAIL;
     }
 
-    hr = image.Initialize(mdata);
-    if (FAILED(hr))
-        return hr;
-
     CP_FLAGS cflags = CP_FLAGS_NONE;
     if (flags & DDS_FLAGS_LEGACY_DWORD)
     {
@@ -2018,13 +1926,36 @@ HRESULT DirectX::LoadFromDDSMemoryEx(
 
     const void* pPixels = static_cast<const uint8_t*>(pSource) + offset;
     assert(pPixels);
-    hr = CopyImage(pPixels,
-        size - offset,
-        mdata,
-        cflags,
-        convFlags,
-        pal8,
-        image);
+
+    // When no per-pixel conversion is needed the file is bounds checked before the
+    // image is allocated, and copied without building a temporary Image array
+    DDSParse::SubresourceLayout layout;
+    bool direct = !(convFlags & ~static_cast<uint32_t>(CONV_FLAGS_DX10)) && (cflags == CP_FLAGS_NONE);
+    if (direct)
+    {
+        hr = DDSParse::ComputeLayout(mdata.format, mdata.width, mdata.height, mdata.depth, mdata.mipLevels, mdata.arraySize,
+            static_cast<const uint8_t*>(pPixels), size - offset, layout);
+        if (hr == HRESULT_E_HANDLE_EOF)
+            return hr;
+
+        direct = SUCCEEDED(hr);
+    }
+
+    hr = image.Initialize(mdata);
+    if (FAILED(hr))
+        return hr;
+
+    hr = direct ? CopySubresources(layout, mdata, image) : S_FALSE;
+    if (hr == S_FALSE)
+    {
+        hr = CopyImage(pPixels,
+            size - offset,
+            mdata,
+            cflags,
+            convFlags,
+            pal8,
+            image);
+    }
     if (FAILED(hr))
     {
         image.Release();
@@ -10,6 +10,8 @@
 //-------------------------------------------------------------------------------------
 
 #include "DirectXTexP.h"
+
+#include "bandstream.h"
 //
 // In theory HDR (RGBE) Radiance files can have any of the following data orientations
 //
@@ -33,6 +35,7 @@
 //#define WRITE_OLD_COLORS
 
 using namespace DirectX;
+using namespace DirectX::Internal;
 
 #ifndef _WIN32
 #include <cstdarg>
@@ -589,6 +592,143 @@ namespace
         return encSize;
     #endif
     }
+
+    //-------------------------------------------------------------------------------------
+    // Decodes one scanline from a file stream (same encodings and transform as LoadFromHDRMemory)
+    //-------------------------------------------------------------------------------------
+    HRESULT DecodeScanline(
+        BufferedFileReader& reader,
+        size_t width,
+        float exposure,
+        _Out_writes_(width * 4) float* scanLine) noexcept
+    {
+        uint8_t inColor[4];
+        HRESULT hr = reader.Read(inColor, 4);
+        if (FAILED(hr))
+            return E_FAIL;
+
+        if (inColor[0] == 2 && inColor[1] == 2 && inColor[2] < 128)
+        {
+            // Adaptive Run Length Encoding (RLE)
+            if (size_t((size_t(inColor[2]) << 8) + inColor[3]) != width)
+                return E_FAIL;
+
+            uint8_t literal[128];
+            for (int channel = 0; channel < 4; ++channel)
+            {
+                auto pixelLoc = scanLine + channel;
+                for (size_t pixelCount = 0; pixelCount < width;)
+                {
+                    uint8_t runLen;
+                    if (FAILED(reader.ReadByte(runLen)))
+                        return E_FAIL;
+
+                    if (runLen > 128)
+                    {
+                        runLen &= 127;
+                        if (pixelCount + runLen > width)
+                            return E_FAIL;
+
+                        uint8_t value;
+                        if (FAILED(reader.ReadByte(value)))
+                            return E_FAIL;
+
+                        auto const val = static_cast<float>(value);
+                        for (uint8_t j = 0; j < runLen; ++j)
+                        {
+                            *pixelLoc = val;
+                            pixelLoc += 4;
+                        }
+                        pixelCount += runLen;
+                    }
+                    else if ((pixelCount + size_t(runLen)) > width)
+                    {
+                        return E_FAIL;
+                    }
+                    else
+                    {
+                        if (FAILED(reader.Read(literal, runLen)))
+                            return E_FAIL;
+
+                        for (uint8_t j = 0; j < runLen; ++j)
+                        {
+                            *pixelLoc = static_cast<float>(literal[j]);
+                            pixelLoc += 4;
+                        }
+                        pixelCount += runLen;
+                    }
+                }
+            }
+        }
+        else
+        {
+            auto pixelLoc = scanLine;
+
+            float prevColor[4];
+            prevColor[0] = inColor[0];
+            prevColor[1] = inColor[1];
+            prevColor[2] = inColor[2];
+            prevColor[3] = inColor[3];
+
+            int bitShift = 0;
+            for (size_t pixelCount = 0; pixelCount < width;)
+            {
+                if (inColor[0] == 1 && inColor[1] == 1 && inColor[2] == 1)
+                {
+                    if (bitShift > 24)
+                        return E_FAIL;
+
+                    // "Standard" Run Length Encoding
+                    const size_t spanLen = size_t(inColor[3]) << bitShift;
+                    if (spanLen + pixelCount > width)
+                        return E_FAIL;
+
+                    for (size_t j = 0; j < spanLen; ++j)
+                    {
+                        pixelLoc[0] = prevColor[0];
+                        pixelLoc[1] = prevColor[1];
+                        pixelLoc[2] = prevColor[2];
+                        pixelLoc[3] = prevColor[3];
+                        pixelLoc += 4;
+                    }
+                    pixelCount += spanLen;
+                    bitShift += 8;
+                }
+                else
+                {
+                    // Uncompressed
+                    pixelLoc[0] = prevColor[0] = inColor[0];
+                    pixelLoc[1] = prevColor[1] = inColor[1];
+                    pixelLoc[2] = prevColor[2] = inColor[2];
+                    pixelLoc[3] = prevColor[3] = inColor[3];
+                    bitShift = 0;
+                    ++pixelCount;
+                    pixelLoc += 4;
+                }
+
+                if (pixelCount >= width)
+                    break;
+
+                if (FAILED(reader.Read(inColor, 4)))
+                    return E_FAIL;
+            }
+        }
+
+        // Transform values
+        auto fdata = scanLine;
+        for (size_t j = 0; j < width; ++j)
+        {
+            auto const exponent = static_cast<int>(fdata[3]);
+            fdata[0] = 1.0f / exposure*ldexpf((fdata[0] + 0.5f), exponent - (128 + 8));
+            fdata[1] = 1.0f / exposure*ldexpf((fdata[1] + 0.5f), exponent - (128 + 8));
+            fdata[2] = 1.0f / exposure*ldexpf((fdata[2] + 0.5f), exponent - (128 + 8));
+            fdata[3] = 1.f;
+
+            fdata += 4;
+        }
+
+        return S_OK;
+    }
 }
 
 
@@ -999,6 +1139,70 @@ HRESULT DirectX::LoadFromHDRFile(const wchar_t* szFile, TexMetadata* metadata, S
 }
 
 
+//-------------------------------------------------------------------------------------
+// Load a HDR file from disk a band of scanlines at a time
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadFromHDRFileBands(
+    const wchar_t* szFile,
+    size_t bandHeight,
+    TexMetadata* metadata,
+    std::function<bool __cdecl(const Image&, size_t)> bandFunc)
+{
+    if (!szFile || !bandHeight || !bandFunc)
+        return E_INVALIDARG;
+
+    BufferedFileReader reader;
+    HRESULT hr = reader.Open(szFile);
+    if (FAILED(hr))
+        return hr;
+
+    // Need at least enough data to fill the header to be a valid HDR
+    if (reader.GetSize() < sizeof(g_Signature))
+    {
+        return E_FAIL;
+    }
+
+    // Read the first part of the file to find the header
+    uint8_t header[8192] = {};
+    auto const headerLen = static_cast<size_t>(std::min<uint64_t>(sizeof(header), reader.GetSize()));
+    hr = reader.Read(header, headerLen);
+    if (FAILED(hr))
+        return hr;
+
+    size_t offset;
+    float exposure;
+    TexMetadata mdata;
+    hr = DecodeHDRHeader(header, headerLen, mdata, offset, exposure);
+    if (FAILED(hr))
+        return hr;
+
+    if (offset >= reader.GetSize())
+        return E_FAIL;
+
+    hr = reader.Seek(offset);
+    if (FAILED(hr))
+        return hr;
+
+    if (metadata)
+        memcpy(metadata, &mdata, sizeof(TexMetadata));
+
+    // Scanlines are stored top to bottom
+    const size_t width = mdata.width;
+    return StreamBands(mdata, bandHeight, false, [&](const Image& band) noexcept -> HRESULT
+        {
+            for (size_t y = 0; y < band.height; ++y)
+            {
+                auto scanLine = reinterpret_cast<float*>(band.pixels + band.rowPitch * y);
+                const HRESULT hrScan = DecodeScanline(reader, width, exposure, scanLine);
+                if (FAILED(hrScan))
+                    return hrScan;
+            }
+            return S_OK;
+        }, bandFunc);
+}
+
+
 //-------------------------------------------------------------------------------------
 // Save a HDR file to memory
 //-------------------------------------------------------------------------------------
@@ -1340,6 +1544,15 @@ namespace DirectX
         return LoadFromHDRFile(reinterpret_cast<const unsigned short*>(szFile), metadata, image);
     }
 
+    HRESULT __cdecl LoadFromHDRFileBands(
+        _In_z_ const __wchar_t* szFile,
+        _In_ size_t bandHeight,
+        _Out_opt_ TexMetadata* metadata,
+        _In_ std::function<bool __cdecl(const Image&, size_t)> bandFunc)
+    {
+        return LoadFromHDRFileBands(reinterpret_cast<const unsigned short*>(szFile), bandHeight, metadata, bandFunc);
+    }
+
     HRESULT __cdecl SaveToHDRFile(
         _In_ const Image& image,
         _In_z_ const __wchar_t* szFile) noexcept
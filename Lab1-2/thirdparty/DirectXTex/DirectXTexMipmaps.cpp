@@ -1028,6 +1028,7 @@ namespace
             if (height <= 1)
             {
                 urow1 = urow0;
+                urow3 = urow2;
             }
 
             if (width <= 1)
@@ -1859,7 +1860,9 @@ namespace
             if (height <= 1)
             {
                 urow1 = urow0;
+                urow3 = urow2;
                 vrow1 = vrow0;
+                vrow3 = vrow2;
             }
 
             if (width <= 1)
@@ -2857,8 +2860,10 @@ HRESULT DirectX::GenerateMipMaps(
 
     static_assert(TEX_FILTER_POINT == 0x100000, "TEX_FILTER_ flag values don't match TEX_FILTER_MODE_MASK");
 
+    const bool fastmips = CanGenerateMipsFast(baseImage.format, baseImage.width, baseImage.height, filter);
+
 #ifdef _WIN32
-    bool usewic = UseWICFiltering(baseImage.format, filter);
+    bool usewic = !fastmips && UseWICFiltering(baseImage.format, filter);
 
     WICPixelFormatGUID pfGUID = {};
     const bool wicpf = (usewic) ? DXGIToWIC(baseImage.format, pfGUID, true) : false;
@@ -2955,6 +2960,18 @@ HRESULT DirectX::GenerateMipMaps(
         mdata.mipLevels = levels;
         mdata.format = baseImage.format;
 
+        if (fastmips)
+        {
+            hr = Setup2DMips(&baseImage, 1, mdata, mipChain);
+            if (FAILED(hr))
+                return hr;
+
+            hr = GenerateMipsFast(levels, filter, mipChain, 0);
+            if (FAILED(hr))
+                mipChain.Release();
+            return hr;
+        }
+
         unsigned long filter_select = (filter & TEX_FILTER_MODE_MASK);
         if (!filter_select)
         {
@@ -3072,8 +3089,10 @@ HRESULT DirectX::GenerateMipMaps(
 
     static_assert(TEX_FILTER_POINT == 0x100000, "TEX_FILTER_ flag values don't match TEX_FILTER_MODE_MASK");
 
+    const bool fastmips = CanGenerateMipsFast(metadata.format, metadata.width, metadata.height, filter);
+
 #ifdef _WIN32
-    bool usewic = !metadata.IsPMAlpha() && UseWICFiltering(metadata.format, filter);
+    bool usewic = !fastmips && !metadata.IsPMAlpha() && UseWICFiltering(metadata.format, filter);
 
     WICPixelFormatGUID pfGUID = {};
     const bool wicpf = (usewic) ? DXGIToWIC(metadata.format, pfGUID, true) : false;
@@ -3170,6 +3189,24 @@ HRESULT DirectX::GenerateMipMaps(
         TexMetadata mdata2 = metadata;
         mdata2.mipLevels = levels;
 
+        if (fastmips)
+        {
+            hr = Setup2DMips(&baseImages[0], metadata.arraySize, mdata2, mipChain);
+            if (FAILED(hr))
+                return hr;
+
+            for (size_t item = 0; item < metadata.arraySize; ++item)
+            {
+                hr = GenerateMipsFast(levels, filter, mipChain, item);
+                if (FAILED(hr))
+                {
+                    mipChain.Release();
+                    break;
+                }
+            }
+            return hr;
+        }
+
         unsigned long filter_select = (filter & TEX_FILTER_MODE_MASK);
         if (!filter_select)
         {
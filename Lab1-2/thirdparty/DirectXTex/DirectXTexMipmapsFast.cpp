@@ -0,0 +1,274 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexMipmapsFast.cpp
+//
+// Threaded mip generation for 8-bit RGBA formats (and 16-bit RGBA with Kaiser). GenerateMipMaps
+// picks it ahead of both WIC and the float scanline filters, so the result is the same on
+// every platform.
+//-------------------------------------------------------------------------------------
+
+#include "DirectXTexP.h"
+
+#include "resample.h"
+#include "threading.h"
+
+using namespace DirectX;
+using namespace DirectX::Internal;
+
+namespace
+{
+    constexpr bool ispow2(size_t x) noexcept
+    {
+        return ((x != 0) && !(x & (x - 1)));
+    }
+
+    inline const uint32_t* SourceRow(const Image& image, size_t y) noexcept
+    {
+        return reinterpret_cast<const uint32_t*>(image.pixels + image.rowPitch * y);
+    }
+
+    inline uint32_t* DestRow(const Image& image, size_t y) noexcept
+    {
+        return reinterpret_cast<uint32_t*>(image.pixels + image.rowPitch * y);
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Box filter: the image is cut into tiles and every level a tile fully determines is
+    // made from it while it is in cache, so the source is read once per pass. Only the
+    // last fused level is kept (as linear floats) for the next pass.
+    //-------------------------------------------------------------------------------------
+    constexpr size_t BoxTileSize = 64;
+    constexpr size_t BoxTileLevels = 6;
+    static_assert(BoxTileSize == (size_t(1) << BoxTileLevels), "BoxTileLevels must match BoxTileSize");
+
+    struct BoxPass
+    {
+        size_t level;                   // level the pass reads
+        size_t width;
+        size_t height;
+        const XMVECTOR* pLinear;        // linear copy of that level, nullptr to decode the image
+        size_t tileWidth;
+        size_t tileHeight;
+        size_t fusedLevels;
+        XMVECTOR* pNextLinear;          // receives the last fused level if another pass follows
+    };
+
+    void BoxFilterTile(
+        const ScratchImage& mipChain,
+        size_t item,
+        const TexelCodec& codec,
+        const BoxPass& pass,
+        size_t tx0,
+        size_t ty0,
+        _Inout_updates_(pass.tileWidth * pass.tileHeight) XMVECTOR* tile) noexcept
+    {
+        const size_t stride = pass.tileWidth;
+        size_t pw = pass.tileWidth;
+        size_t ph = pass.tileHeight;
+
+        if (pass.pLinear)
+        {
+            for (size_t y = 0; y < ph; ++y)
+                memcpy(tile + y * stride, pass.pLinear + (ty0 + y) * pass.width + tx0, pw * sizeof(XMVECTOR));
+        }
+        else
+        {
+            const Image* src = mipChain.GetImage(pass.level, item, 0);
+            for (size_t y = 0; y < ph; ++y)
+            {
+                const uint32_t* sptr = SourceRow(*src, ty0 + y) + tx0;
+                for (size_t x = 0; x < pw; ++x)
+                    tile[y * stride + x] = DecodeTexel(sptr[x], codec);
+            }
+        }
+
+        for (size_t l = 1; l <= pass.fusedLevels; ++l)
+        {
+            // Downsampled in place: texel (x, y) only reads texels at or after its own slot
+            const size_t cw = std::max<size_t>(1, pw >> 1);
+            const size_t ch = std::max<size_t>(1, ph >> 1);
+            for (size_t y = 0; y < ch; ++y)
+            {
+                const XMVECTOR* row0 = tile + (y * 2) * stride;
+                const XMVECTOR* row1 = tile + std::min(y * 2 + 1, ph - 1) * stride;
+                XMVECTOR* out = tile + y * stride;
+                for (size_t x = 0; x < cw; ++x)
+                {
+                    const size_t x0 = x * 2;
+                    const size_t x1 = std::min(x0 + 1, pw - 1);
+                    const XMVECTOR sum = XMVectorAdd(XMVectorAdd(row0[x0], row0[x1]), XMVectorAdd(row1[x0], row1[x1]));
+                    out[x] = XMVectorScale(sum, 0.25f);
+                }
+            }
+            pw = cw;
+            ph = ch;
+
+            const Image* dst = mipChain.GetImage(pass.level + l, item, 0);
+            const size_t dx0 = tx0 >> l;
+            const size_t dy0 = ty0 >> l;
+            for (size_t y = 0; y < ph; ++y)
+            {
+                uint32_t* dptr = DestRow(*dst, dy0 + y) + dx0;
+                for (size_t x = 0; x < pw; ++x)
+                    dptr[x] = EncodeTexel(tile[y * stride + x], codec);
+            }
+        }
+
+        if (pass.pNextLinear)
+        {
+            const size_t nextWidth = std::max<size_t>(1, pass.width >> pass.fusedLevels);
+            const size_t dx0 = tx0 >> pass.fusedLevels;
+            const size_t dy0 = ty0 >> pass.fusedLevels;
+            for (size_t y = 0; y < ph; ++y)
+                memcpy(pass.pNextLinear + (dy0 + y) * nextWidth + dx0, tile + y * stride, pw * sizeof(XMVECTOR));
+        }
+    }
+
+    HRESULT GenerateBoxMips(size_t levels, const TexelCodec& codec, const ScratchImage& mipChain, size_t item) noexcept
+    {
+        size_t level = 0;
+        size_t width = mipChain.GetMetadata().width;
+        size_t height = mipChain.GetMetadata().height;
+
+        if (!ispow2(width) || !ispow2(height))
+            return E_FAIL;
+
+        ScopedAlignedArrayXMVECTOR linear;
+        while (level + 1 < levels)
+        {
+            BoxPass pass = {};
+            pass.level = level;
+            pass.width = width;
+            pass.height = height;
+            pass.pLinear = linear.get();
+            pass.tileWidth = std::min(BoxTileSize, width);
+            pass.tileHeight = std::min(BoxTileSize, height);
+
+            // A tile spanning the whole axis keeps determining its levels down to 1 texel
+            pass.fusedLevels = levels - 1 - level;
+            if (pass.tileWidth < width || pass.tileHeight < height)
+                pass.fusedLevels = std::min(pass.fusedLevels, BoxTileLevels);
+
+            const size_t nextWidth = std::max<size_t>(1, width >> pass.fusedLevels);
+            const size_t nextHeight = std::max<size_t>(1, height >> pass.fusedLevels);
+
+            ScopedAlignedArrayXMVECTOR nextLinear;
+            if (level + pass.fusedLevels + 1 < levels)
+            {
+                nextLinear = make_AlignedArrayXMVECTOR(uint64_t(nextWidth) * uint64_t(nextHeight));
+                if (!nextLinear)
+                    return E_OUTOFMEMORY;
+                pass.pNextLinear = nextLinear.get();
+            }
+
+            const size_t tilesAcross = width / pass.tileWidth;
+            const size_t tileCount = tilesAcross * (height / pass.tileHeight);
+
+            const bool succeeded = ParallelFor(tileCount, 1, [&](size_t begin, size_t end) -> bool
+                {
+                    auto tile = make_AlignedArrayXMVECTOR(uint64_t(pass.tileWidth) * uint64_t(pass.tileHeight));
+                    if (!tile)
+                        return false;
+
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        BoxFilterTile(mipChain, item, codec, pass,
+                            (i % tilesAcross) * pass.tileWidth, (i / tilesAcross) * pass.tileHeight, tile.get());
+                    }
+                    return true;
+                });
+            if (!succeeded)
+                return E_OUTOFMEMORY;
+
+            linear = std::move(nextLinear);
+            level += pass.fusedLevels;
+            width = nextWidth;
+            height = nextHeight;
+        }
+
+        return S_OK;
+    }
+}
+
+
+//=====================================================================================
+// Entry-points
+//=====================================================================================
+
+_Use_decl_annotations_
+bool DirectX::Internal::CanGenerateMipsFast(DXGI_FORMAT format, size_t width, size_t height, TEX_FILTER_FLAGS filter) noexcept
+{
+    // Separate alpha filtering is left to the generic paths
+    if (filter & (TEX_FILTER_FORCE_WIC | TEX_FILTER_SEPARATE_ALPHA))
+        return false;
+
+    TexelCodec codec;
+    if (!GetTexelCodec(format, (filter & TEX_FILTER_SRGB_IN) != 0, (filter & TEX_FILTER_SRGB_OUT) != 0, codec))
+        return false;
+
+    switch (filter & TEX_FILTER_MODE_MASK)
+    {
+    case 0:
+    #ifdef _WIN32
+        // The default filter goes to WIC unless the caller opted out, so existing output doesn't change
+        if (!(filter & TEX_FILTER_FORCE_NON_WIC))
+            return false;
+    #endif
+        return codec.bytesPerTexel == 4 && ispow2(width) && ispow2(height);
+
+    case TEX_FILTER_BOX:
+        // Same restriction as the scanline box filter; the default choice is LINEAR otherwise
+        return codec.bytesPerTexel == 4 && ispow2(width) && ispow2(height);
+
+    case TEX_FILTER_KAISER:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Internal::GenerateMipsFast(size_t levels, TEX_FILTER_FLAGS filter, const ScratchImage& mipChain, size_t item) noexcept
+{
+    if (!mipChain.GetImages())
+        return E_INVALIDARG;
+
+    // This assumes that the base image is already placed into the mipChain at the top level... (see Setup2DMips)
+
+    assert(levels > 1 && levels <= mipChain.GetMetadata().mipLevels);
+
+    const DXGI_FORMAT format = mipChain.GetMetadata().format;
+    const bool srgbIn = IsSRGB(format) || (filter & TEX_FILTER_SRGB_IN);
+    const bool srgbOut = IsSRGB(format) || (filter & TEX_FILTER_SRGB_OUT);
+
+    TexelCodec codec;
+    if (!GetTexelCodec(format, srgbIn, srgbOut, codec))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    if ((filter & TEX_FILTER_MODE_MASK) == TEX_FILTER_KAISER)
+    {
+        // Kaiser-windowed sinc, applied separably one level at a time
+        for (size_t level = 1; level < levels; ++level)
+        {
+            const Image* src = mipChain.GetImage(level - 1, item, 0);
+            const Image* dst = mipChain.GetImage(level, item, 0);
+            if (!src || !dst)
+                return E_POINTER;
+
+            FilterTable tx, ty;
+            if (!BuildFilterTable(RESAMPLE_KAISER, src->width, dst->width,
+                (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, tx)
+                || !BuildFilterTable(RESAMPLE_KAISER, src->height, dst->height,
+                    (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, ty))
+                return E_OUTOFMEMORY;
+
+            const HRESULT hr = ResampleImage(*src, *dst, tx, ty, codec);
+            if (FAILED(hr))
+                return hr;
+        }
+
+        return S_OK;
+    }
+
+    return GenerateBoxMips(levels, codec, mipChain, item);
+}
@@ -11,11 +11,15 @@
 
 #include "DirectXTexP.h"
 
+#include "threading.h"
+
 using namespace DirectX;
 using namespace DirectX::Internal;
 
 namespace
 {
+    // Texels per chunk of rows handed to a worker thread
+    constexpr size_t NormalMapChunkTexels = 16384;
 
 #pragma prefast(suppress : 25000, "FXMVECTOR is 16 bytes")
     inline float EvaluateColor(_In_ FXMVECTOR val, _In_ CNMAP_FLAGS flags) noexcept
@@ -74,26 +78,26 @@ namespace
         }
     }
 
-    HRESULT ComputeNMap(_In_ const Image& srcImage, _In_ CNMAP_FLAGS flags, _In_ float amplitude,
-        _In_ DXGI_FORMAT format, _In_ const Image& normalMap) noexcept
+    // Source row y, with y = -1 and y = height mirrored or wrapped per CNMAP_MIRROR_V
+    inline const uint8_t* SourceRow(_In_ const Image& srcImage, ptrdiff_t y, _In_ CNMAP_FLAGS flags) noexcept
     {
-        if (!srcImage.pixels || !normalMap.pixels)
-            return E_INVALIDARG;
-
-        const uint32_t convFlags = GetConvertFlags(format);
-        if (!convFlags)
-            return E_FAIL;
+        const auto height = static_cast<ptrdiff_t>(srcImage.height);
+        if (y < 0)
+            y = (flags & CNMAP_MIRROR_V) ? 0 : height - 1;
+        else if (y >= height)
+            y = (flags & CNMAP_MIRROR_V) ? height - 1 : 0;
 
-        if (!(convFlags & (CONVF_UNORM | CONVF_SNORM | CONVF_FLOAT)))
-            return HRESULT_E_NOT_SUPPORTED;
+        return srcImage.pixels + srcImage.rowPitch * static_cast<size_t>(y);
+    }
 
+    HRESULT ComputeNMapRows(_In_ const Image& srcImage, _In_ CNMAP_FLAGS flags, _In_ float amplitude,
+        _In_ DXGI_FORMAT format, _In_ uint32_t convFlags, _In_ const Image& normalMap,
+        size_t yBegin, size_t yEnd) noexcept
+    {
         const size_t width = srcImage.width;
-        const size_t height = srcImage.height;
-        if (width != normalMap.width || height != normalMap.height)
-            return E_FAIL;
 
-        // Allocate temporary space (4 scanlines and 3 evaluated rows)
-        auto scanline = make_AlignedArrayXMVECTOR(uint64_t(width) * 4);
+        // Allocate temporary space (a source and a target scanline, 3 evaluated rows)
+        auto scanline = make_AlignedArrayXMVECTOR(uint64_t(width) * 2);
         if (!scanline)
             return E_OUTOFMEMORY;
 
@@ -101,71 +105,33 @@ namespace
         if (!buffer)
             return E_OUTOFMEMORY;
 
-        uint8_t* pDest = normalMap.pixels;
-        if (!pDest)
-            return E_POINTER;
-
-        XMVECTOR* row0 = scanline.get();
-        XMVECTOR* row1 = row0 + width;
-        XMVECTOR* row2 = row1 + width;
-        XMVECTOR* target = row2 + width;
+        XMVECTOR* row = scanline.get();
+        XMVECTOR* target = row + width;
 
         float* val0 = buffer.get();
         float* val1 = val0 + width + 2;
         float* val2 = val1 + width + 2;
 
         const size_t rowPitch = srcImage.rowPitch;
-        const uint8_t* pSrc = srcImage.pixels;
 
-        // Read first scanline row into 'row1'
-        if (!LoadScanline(row1, width, pSrc, rowPitch, srcImage.format))
+        // Evaluate the rows above and at the first one
+        if (!LoadScanline(row, width, SourceRow(srcImage, ptrdiff_t(yBegin) - 1, flags), rowPitch, srcImage.format))
             return E_FAIL;
+        EvaluateRow(row, val0, width, flags);
 
-        // Setup 'row0'
-        if (flags & CNMAP_MIRROR_V)
-        {
-            // Mirror first row
-            memcpy(row0, row1, rowPitch);
-        }
-        else
-        {
-            // Read last row (Wrap V)
-            if (!LoadScanline(row0, width, pSrc + (rowPitch * (height - 1)), rowPitch, srcImage.format))
-                return E_FAIL;
-        }
-
-        // Evaluate the initial rows
-        EvaluateRow(row0, val0, width, flags);
-        EvaluateRow(row1, val1, width, flags);
+        if (!LoadScanline(row, width, SourceRow(srcImage, ptrdiff_t(yBegin), flags), rowPitch, srcImage.format))
+            return E_FAIL;
+        EvaluateRow(row, val1, width, flags);
 
-        pSrc += rowPitch;
+        uint8_t* pDest = normalMap.pixels + normalMap.rowPitch * yBegin;
 
-        for (size_t y = 0; y < height; ++y)
+        for (size_t y = yBegin; y < yEnd; ++y)
         {
-            // Load next scanline of source image
-            if (y < (height - 1))
-            {
-                if (!LoadScanline(row2, width, pSrc, rowPitch, srcImage.format))
-                    return E_FAIL;
-            }
-            else
-            {
-                if (flags & CNMAP_MIRROR_V)
-                {
-                    // Use last row of source image
-                    if (!LoadScanline(row2, width, srcImage.pixels + (rowPitch * (height - 1)), rowPitch, srcImage.format))
-                        return E_FAIL;
-                }
-                else
-                {
-                    // Use first row of source image (Wrap V)
-                    if (!LoadScanline(row2, width, srcImage.pixels, rowPitch, srcImage.format))
-                        return E_FAIL;
-                }
-            }
+            // Load and evaluate next scanline of source image
+            if (!LoadScanline(row, width, SourceRow(srcImage, ptrdiff_t(y) + 1, flags), rowPitch, srcImage.format))
+                return E_FAIL;
 
-            // Evaluate row
-            EvaluateRow(row2, val2, width, flags);
+            EvaluateRow(row, val2, width, flags);
 
             // Generate target scanline
             XMVECTOR *dptr = target;
@@ -237,12 +203,286 @@ namespace
             val1 = val2;
             val2 = temp;
 
-            pSrc += rowPitch;
             pDest += normalMap.rowPitch;
         }
 
         return S_OK;
     }
+
+    HRESULT ComputeNMap(_In_ const Image& srcImage, _In_ CNMAP_FLAGS flags, _In_ float amplitude,
+        _In_ DXGI_FORMAT format, _In_ const Image& normalMap) noexcept
+    {
+        if (!srcImage.pixels || !normalMap.pixels)
+            return E_INVALIDARG;
+
+        const uint32_t convFlags = GetConvertFlags(format);
+        if (!convFlags)
+            return E_FAIL;
+
+        if (!(convFlags & (CONVF_UNORM | CONVF_SNORM | CONVF_FLOAT)))
+            return HRESULT_E_NOT_SUPPORTED;
+
+        const size_t width = srcImage.width;
+        const size_t height = srcImage.height;
+        if (width != normalMap.width || height != normalMap.height)
+            return E_FAIL;
+
+        // Every band of rows reads its own neighbor rows, so the bands are independent
+        const size_t grain = std::max<size_t>(1, NormalMapChunkTexels / width);
+
+        std::atomic<HRESULT> result(S_OK);
+        ParallelFor(height, grain, [&](size_t begin, size_t end) -> bool
+            {
+                const HRESULT hr = ComputeNMapRows(srcImage, flags, amplitude, format, convFlags, normalMap, begin, end);
+                if (FAILED(hr))
+                {
+                    result = hr;
+                    return false;
+                }
+                return true;
+            });
+
+        return result;
+    }
+
+    //---------------------------------------------------------------------------------
+    // Normal map mipmaps
+    //---------------------------------------------------------------------------------
+
+    // Loads a scanline of a tangent-space normal map as signed vectors; alpha stays in w
+    bool LoadNormals(
+        _Out_writes_(width) XMVECTOR* pDest,
+        size_t width,
+        _In_ const Image& srcImage,
+        size_t y,
+        uint32_t convFlags) noexcept
+    {
+        if (!LoadScanline(pDest, width, srcImage.pixels + srcImage.rowPitch * y, srcImage.rowPitch, srcImage.format))
+            return false;
+
+        for (size_t x = 0; x < width; ++x)
+        {
+            XMVECTOR v = pDest[x];
+
+            if (convFlags & CONVF_UNORM)
+            {
+                v = XMVectorSelect(v, XMVectorMultiplyAdd(v, g_XMTwo, g_XMNegativeOne), g_XMSelect1110);
+            }
+
+            if (!(convFlags & CONVF_B))
+            {
+                // Two-channel normal map: z = sqrt(1 - x^2 - y^2)
+                const float z = sqrtf(std::max(0.f, 1.f - XMVectorGetX(XMVector2Dot(v, v))));
+                v = XMVectorSetZ(v, z);
+            }
+
+            pDest[x] = v;
+        }
+
+        return true;
+    }
+
+    // Toksvig: the average of diverging normals is shorter than 1, and the shortening widens the
+    // specular lobe. GGX alpha = roughness^2 maps to the Blinn-Phong power s = 2 / alpha^2 - 2,
+    // which the filtered normal scales by ft = |N| / (|N| + s * (1 - |N|)).
+    inline float ToksvigRoughness(float length, float roughness) noexcept
+    {
+        if (length <= 0.f)
+            return 1.f;
+
+        length = std::min(length, 1.f);
+
+        const float alpha = std::max(roughness * roughness, 1e-3f);
+        const float power = 2.f / (alpha * alpha) - 2.f;
+        const float ft = length / (length + power * (1.f - length));
+
+        // alpha'^2 = 2 / (s' + 2), roughness' = sqrt(alpha')
+        return sqrtf(sqrtf(2.f / (power * ft + 2.f)));
+    }
+
+    struct NormalMipLevel
+    {
+        size_t level;
+        size_t width;
+        size_t height;
+        const XMVECTOR* pPrev;  // unnormalized averages of level - 1 (level 2 and up)
+        size_t prevWidth;
+        size_t prevHeight;
+        XMVECTOR* pNext;        // receives this level's unnormalized averages, if another level follows
+    };
+
+    HRESULT NormalMipRows(
+        _In_ const Image& baseImage,
+        uint32_t convFlags,
+        _In_ const NormalMipLevel& mip,
+        _In_ const Image& dest,
+        _In_opt_ const Image* roughness,
+        float baseRoughness,
+        size_t yBegin,
+        size_t yEnd) noexcept
+    {
+        const size_t width = mip.width;
+
+        // Two source scanlines of level 0 (level 1 reads the base image directly) and the output row
+        const size_t srcWidth = (mip.level == 1) ? baseImage.width : 0;
+        auto scanline = make_AlignedArrayXMVECTOR(uint64_t(srcWidth) * 2 + width);
+        if (!scanline)
+            return E_OUTOFMEMORY;
+
+        XMVECTOR* src0 = scanline.get();
+        XMVECTOR* src1 = src0 + srcWidth;
+        XMVECTOR* row = src1 + srcWidth;
+
+        for (size_t y = yBegin; y < yEnd; ++y)
+        {
+            if (!mip.level)
+            {
+                if (!LoadNormals(row, width, baseImage, y, convFlags))
+                    return E_FAIL;
+            }
+            else
+            {
+                const XMVECTOR* r0;
+                const XMVECTOR* r1;
+                size_t rowWidth;
+
+                if (mip.level == 1)
+                {
+                    if (!LoadNormals(src0, srcWidth, baseImage, y * 2, convFlags)
+                        || !LoadNormals(src1, srcWidth, baseImage, std::min(y * 2 + 1, baseImage.height - 1), convFlags))
+                        return E_FAIL;
+
+                    r0 = src0;
+                    r1 = src1;
+                    rowWidth = srcWidth;
+                }
+                else
+                {
+                    r0 = mip.pPrev + mip.prevWidth * (y * 2);
+                    r1 = mip.pPrev + mip.prevWidth * std::min(y * 2 + 1, mip.prevHeight - 1);
+                    rowWidth = mip.prevWidth;
+                }
+
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const size_t x0 = x * 2;
+                    const size_t x1 = std::min(x0 + 1, rowWidth - 1);
+
+                    const XMVECTOR v = XMVectorAdd(XMVectorAdd(r0[x0], r0[x1]), XMVectorAdd(r1[x0], r1[x1]));
+                    row[x] = XMVectorScale(v, 0.25f);
+                }
+            }
+
+            if (mip.pNext)
+            {
+                memcpy(mip.pNext + width * y, row, sizeof(XMVECTOR) * width);
+            }
+
+            if (roughness)
+            {
+                uint8_t* pRoughness = roughness->pixels + roughness->rowPitch * y;
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const float r = ToksvigRoughness(XMVectorGetX(XMVector3Length(row[x])), baseRoughness);
+                    pRoughness[x] = static_cast<uint8_t>(r * 255.f + 0.5f);
+                }
+            }
+
+            uint8_t* pDest = dest.pixels + dest.rowPitch * y;
+            if (!mip.level)
+            {
+                // The top level is the source itself
+                memcpy(pDest, baseImage.pixels + baseImage.rowPitch * y, std::min(dest.rowPitch, baseImage.rowPitch));
+                continue;
+            }
+
+            for (size_t x = 0; x < width; ++x)
+            {
+                const XMVECTOR v = row[x];
+
+                XMVECTOR n = XMVector3Normalize(v);
+                if (XMVector3Less(XMVector3LengthSq(v), g_XMEpsilon))
+                {
+                    // Opposing normals cancelled out
+                    n = g_XMIdentityR2;
+                }
+
+                if (convFlags & CONVF_UNORM)
+                {
+                    n = XMVectorMultiplyAdd(n, g_XMOneHalf, g_XMOneHalf);
+                }
+
+                row[x] = XMVectorSelect(v, n, g_XMSelect1110);
+            }
+
+            if (!StoreScanline(pDest, dest.rowPitch, dest.format, row, width))
+                return E_FAIL;
+        }
+
+        return S_OK;
+    }
+
+    HRESULT GenerateNormalMips(
+        _In_ const Image& baseImage,
+        size_t levels,
+        _In_reads_(levels) const Image* const* dest,
+        _In_reads_opt_(levels) const Image* const* roughness,
+        float baseRoughness) noexcept
+    {
+        const uint32_t convFlags = GetConvertFlags(baseImage.format);
+
+        ScopedAlignedArrayXMVECTOR prev;
+        size_t prevWidth = 0;
+        size_t prevHeight = 0;
+
+        for (size_t level = 0; level < levels; ++level)
+        {
+            const size_t width = dest[level]->width;
+            const size_t height = dest[level]->height;
+
+            NormalMipLevel mip = {};
+            mip.level = level;
+            mip.width = width;
+            mip.height = height;
+            mip.pPrev = prev.get();
+            mip.prevWidth = prevWidth;
+            mip.prevHeight = prevHeight;
+
+            // Level 1 is averaged straight from the source, so level 0 keeps no copy
+            ScopedAlignedArrayXMVECTOR next;
+            if (level > 0 && level + 1 < levels)
+            {
+                next = make_AlignedArrayXMVECTOR(uint64_t(width) * uint64_t(height));
+                if (!next)
+                    return E_OUTOFMEMORY;
+                mip.pNext = next.get();
+            }
+
+            const Image* rimage = roughness ? roughness[level] : nullptr;
+            const size_t grain = std::max<size_t>(1, NormalMapChunkTexels / width);
+
+            std::atomic<HRESULT> result(S_OK);
+            ParallelFor(height, grain, [&](size_t begin, size_t end) -> bool
+                {
+                    const HRESULT hr = NormalMipRows(baseImage, convFlags, mip, *dest[level], rimage, baseRoughness, begin, end);
+                    if (FAILED(hr))
+                    {
+                        result = hr;
+                        return false;
+                    }
+                    return true;
+                });
+
+            if (FAILED(result))
+                return result;
+
+            prev = std::move(next);
+            prevWidth = width;
+            prevHeight = height;
+        }
+
+        return S_OK;
+    }
 }
 
 
@@ -391,3 +631,127 @@ HRESULT DirectX::ComputeNormalMap(
 
     return S_OK;
 }
+
+
+//-------------------------------------------------------------------------------------
+// Generates a renormalized mip chain (and optionally a Toksvig roughness chain) for
+// a tangent-space normal map
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::GenerateNormalMapMipMaps(
+    const Image& baseImage,
+    size_t levels,
+    ScratchImage& mipChain,
+    ScratchImage* roughnessChain,
+    float baseRoughness) noexcept
+{
+    if (!baseImage.pixels)
+        return E_INVALIDARG;
+
+    TexMetadata mdata = {};
+    mdata.width = baseImage.width;
+    mdata.height = baseImage.height;
+    mdata.depth = mdata.arraySize = mdata.mipLevels = 1;
+    mdata.format = baseImage.format;
+    mdata.dimension = TEX_DIMENSION_TEXTURE2D;
+
+    return GenerateNormalMapMipMaps(&baseImage, 1, mdata, levels, mipChain, roughnessChain, baseRoughness);
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::GenerateNormalMapMipMaps(
+    const Image* srcImages,
+    size_t nimages,
+    const TexMetadata& metadata,
+    size_t levels,
+    ScratchImage& mipChain,
+    ScratchImage* roughnessChain,
+    float baseRoughness) noexcept
+{
+    if (!srcImages || !nimages || !IsValid(metadata.format))
+        return E_INVALIDARG;
+
+    if (!(baseRoughness >= 0.f && baseRoughness <= 1.f) || roughnessChain == &mipChain)
+        return E_INVALIDARG;
+
+    if (metadata.IsVolumemap()
+        || IsCompressed(metadata.format) || IsTypeless(metadata.format)
+        || IsPlanar(metadata.format) || IsPalettized(metadata.format))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    // Needs at least X and Y stored as normalized or float values
+    const uint32_t convFlags = GetConvertFlags(metadata.format);
+    if (!(convFlags & (CONVF_UNORM | CONVF_SNORM | CONVF_FLOAT))
+        || (convFlags & (CONVF_SHAREDEXP | CONVF_DEPTH | CONVF_YUV))
+        || !(convFlags & CONVF_G))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    if (!CalculateMipLevels(metadata.width, metadata.height, levels))
+        return E_INVALIDARG;
+
+    mipChain.Release();
+    if (roughnessChain)
+        roughnessChain->Release();
+
+    TexMetadata mdata2 = metadata;
+    mdata2.mipLevels = levels;
+    HRESULT hr = mipChain.Initialize(mdata2);
+    if (FAILED(hr))
+        return hr;
+
+    if (roughnessChain)
+    {
+        mdata2.format = DXGI_FORMAT_R8_UNORM;
+        hr = roughnessChain->Initialize(mdata2);
+        if (FAILED(hr))
+        {
+            mipChain.Release();
+            return hr;
+        }
+    }
+
+    auto fail = [&](HRESULT result) noexcept -> HRESULT
+    {
+        mipChain.Release();
+        if (roughnessChain)
+            roughnessChain->Release();
+        return result;
+    };
+
+    std::unique_ptr<const Image*[]> dest(new (std::nothrow) const Image*[levels * 2]);
+    if (!dest)
+        return fail(E_OUTOFMEMORY);
+
+    const Image** rough = roughnessChain ? dest.get() + levels : nullptr;
+
+    for (size_t item = 0; item < metadata.arraySize; ++item)
+    {
+        const size_t index = metadata.ComputeIndex(0, item, 0);
+        if (index >= nimages)
+            return fail(E_FAIL);
+
+        const Image& src = srcImages[index];
+        if (src.format != metadata.format || src.width != metadata.width || src.height != metadata.height)
+            return fail(E_FAIL);
+
+        for (size_t level = 0; level < levels; ++level)
+        {
+            dest[level] = mipChain.GetImage(level, item, 0);
+            if (!dest[level])
+                return fail(E_POINTER);
+
+            if (rough)
+            {
+                rough[level] = roughnessChain->GetImage(level, item, 0);
+                if (!rough[level])
+                    return fail(E_POINTER);
+            }
+        }
+
+        hr = GenerateNormalMips(src, levels, dest.get(), rough, baseRoughness);
+        if (FAILED(hr))
+            return fail(hr);
+    }
+
+    return S_OK;
+}
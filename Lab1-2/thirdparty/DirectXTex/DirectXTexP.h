@@ -445,6 +445,27 @@ namespace DirectX
         bool __cdecl CalculateMipLevels3D(_In_ size_t width, _In_ size_t height, _In_ size_t depth,
             _Inout_ size_t& mipLevels) noexcept;
 
+        //---------------------------------------------------------------------------------
+        // Threaded mipmap generation for 8-bit RGBA/BGRA and 16-bit RGBA formats (DirectXTexMipmapsFast.cpp)
+        bool __cdecl CanGenerateMipsFast(_In_ DXGI_FORMAT format, _In_ size_t width, _In_ size_t height,
+            _In_ TEX_FILTER_FLAGS filter) noexcept;
+        HRESULT __cdecl GenerateMipsFast(_In_ size_t levels, _In_ TEX_FILTER_FLAGS filter,
+            _In_ const ScratchImage& mipChain, _In_ size_t item) noexcept;
+
+        //---------------------------------------------------------------------------------
+        // Threaded resize for 8-bit RGBA/BGRA and 16-bit RGBA formats (DirectXTexResizeFast.cpp)
+        bool __cdecl CanResizeFast(_In_ DXGI_FORMAT format, _In_ TEX_FILTER_FLAGS filter) noexcept;
+        HRESULT __cdecl ResizeFast(_In_ const Image& srcImage, _In_ TEX_FILTER_FLAGS filter,
+            _In_ const Image& destImage) noexcept;
+
+        //---------------------------------------------------------------------------------
+        // Threaded conversion kernels for common format pairs (DirectXTexConvertFast.cpp)
+        bool __cdecl CanConvertFast(_In_ DXGI_FORMAT inFormat, _In_ DXGI_FORMAT outFormat,
+            _In_ TEX_FILTER_FLAGS filter) noexcept;
+        HRESULT __cdecl ConvertFast(_In_ const Image& srcImage, _In_ TEX_FILTER_FLAGS filter,
+            _In_ float threshold, _In_ const Image& destImage,
+            _In_ const std::function<bool __cdecl(size_t, size_t)>& statusCallback) noexcept;
+
     #ifdef _WIN32
         HRESULT __cdecl ResizeSeparateColorAndAlpha(_In_ IWICImagingFactory* pWIC,
             _In_ bool iswic2,
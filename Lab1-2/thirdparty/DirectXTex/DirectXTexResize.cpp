@@ -876,8 +876,10 @@ HRESULT DirectX::Resize(
         return HRESULT_E_NOT_SUPPORTED;
     }
 
+    const bool fastresize = CanResizeFast(srcImage.format, filter);
+
 #ifdef _WIN32
-    bool usewic = UseWICFiltering(srcImage.format, filter);
+    bool usewic = !fastresize && UseWICFiltering(srcImage.format, filter);
 
     WICPixelFormatGUID pfGUID = {};
     const bool wicpf = (usewic) ? DXGIToWIC(srcImage.format, pfGUID, true) : false;
@@ -921,8 +923,14 @@ HRESULT DirectX::Resize(
     }
     else
     #endif
+    if (fastresize)
+    {
+        // Case 3: resampling the 8-bit/16-bit texels directly
+        hr = ResizeFast(srcImage, filter, *rimage);
+    }
+    else
     {
-        // Case 3: not using WIC resizing
+        // Case 4: not using WIC resizing
         hr = PerformResizeUsingCustomFilters(srcImage, filter, *rimage);
     }
 
@@ -963,8 +971,10 @@ HRESULT DirectX::Resize(
     if (FAILED(hr))
         return hr;
 
+    const bool fastresize = CanResizeFast(metadata.format, filter);
+
 #ifdef _WIN32
-    bool usewic = !metadata.IsPMAlpha() && UseWICFiltering(metadata.format, filter);
+    bool usewic = !fastresize && !metadata.IsPMAlpha() && UseWICFiltering(metadata.format, filter);
 
     WICPixelFormatGUID pfGUID = {};
     const bool wicpf = (usewic) ? DXGIToWIC(metadata.format, pfGUID, true) : false;
@@ -1035,8 +1045,14 @@ HRESULT DirectX::Resize(
             }
             else
             #endif
+            if (fastresize)
             {
-                // Case 3: not using WIC resizing
+                // Case 3: resampling the 8-bit/16-bit texels directly
+                hr = ResizeFast(*srcimg, filter, *destimg);
+            }
+            else
+            {
+                // Case 4: not using WIC resizing
                 hr = PerformResizeUsingCustomFilters(*srcimg, filter, *destimg);
             }
 
@@ -1096,8 +1112,14 @@ HRESULT DirectX::Resize(
             }
             else
             #endif
+            if (fastresize)
+            {
+                // Case 3: resampling the 8-bit/16-bit texels directly
+                hr = ResizeFast(*srcimg, filter, *destimg);
+            }
+            else
             {
-                // Case 3: not using WIC resizing
+                // Case 4: not using WIC resizing
                 hr = PerformResizeUsingCustomFilters(*srcimg, filter, *destimg);
             }
 
@@ -0,0 +1,470 @@
+//-------------------------------------------------------------------------------------
+// DirectXTexResizeFast.cpp
+//
+// Separable, threaded resampler for 8-bit RGBA/BGRA and 16-bit RGBA UNORM images.
+// Resize picks it ahead of both WIC and the float scanline filters, so the result is
+// the same on every platform and no R32G32B32A32 copy of the image is made.
+//-------------------------------------------------------------------------------------
+
+#include "DirectXTexP.h"
+
+#include "resample.h"
+#include "threading.h"
+
+using namespace DirectX;
+using namespace DirectX::Internal;
+
+namespace
+{
+    //-------------------------------------------------------------------------------------
+    // Filter kernels
+    //-------------------------------------------------------------------------------------
+    constexpr float KaiserRadius = 3.f;     // in destination texels when minifying
+    constexpr float KaiserAlpha = 4.f;
+
+    float BesselI0(float x) noexcept
+    {
+        float sum = 1.f;
+        float term = 1.f;
+        const float halfX = x * 0.5f;
+        for (int k = 1; k < 32 && term > sum * 1e-8f; ++k)
+        {
+            term *= (halfX / static_cast<float>(k)) * (halfX / static_cast<float>(k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    float KaiserWeight(float x) noexcept
+    {
+        if (fabsf(x) >= KaiserRadius)
+            return 0.f;
+
+        const float t = x / KaiserRadius;
+        const float sinc = (x == 0.f) ? 1.f : sinf(XM_PI * x) / (XM_PI * x);
+        return sinc * BesselI0(KaiserAlpha * sqrtf(1.f - t * t)) / BesselI0(KaiserAlpha);
+    }
+
+    float KernelRadius(RESAMPLE_KERNEL kernel) noexcept
+    {
+        switch (kernel)
+        {
+        case RESAMPLE_BOX:      return 0.5f;
+        case RESAMPLE_KAISER:   return KaiserRadius;
+        default:                return 1.f;
+        }
+    }
+
+    float KernelWeight(RESAMPLE_KERNEL kernel, float x) noexcept
+    {
+        const float ax = fabsf(x);
+        switch (kernel)
+        {
+        case RESAMPLE_BOX:      return (ax < 0.5f) ? 1.f : ((ax == 0.5f) ? 0.5f : 0.f);
+        case RESAMPLE_KAISER:   return KaiserWeight(x);
+        default:                return std::max(1.f - ax, 0.f);
+        }
+    }
+
+    size_t AddressTexel(ptrdiff_t i, size_t size, bool wrap, bool mirror) noexcept
+    {
+        const auto n = static_cast<ptrdiff_t>(size);
+        if (wrap)
+            return static_cast<size_t>(((i % n) + n) % n);
+
+        if (mirror)
+        {
+            const ptrdiff_t m = ((i % (n * 2)) + n * 2) % (n * 2);
+            return static_cast<size_t>((m < n) ? m : n * 2 - 1 - m);
+        }
+
+        return static_cast<size_t>(std::min(std::max<ptrdiff_t>(i, 0), n - 1));
+    }
+
+    //-------------------------------------------------------------------------------------
+    // Work is split into strips of destination columns, so the cached rows of a strip
+    // stay in L2, and bands of destination rows within a strip
+    //-------------------------------------------------------------------------------------
+    constexpr size_t ResampleStripTexels = 512;
+    constexpr size_t ResampleBandRows = 32;
+
+    //-------------------------------------------------------------------------------------
+    // Point sampling with no color space change picks whole texels, so they are copied
+    // instead of going through the float rows
+    //-------------------------------------------------------------------------------------
+    template<typename Texel>
+    void CopyPointRow(const uint8_t* srcRow, const uint32_t* index, size_t width, uint8_t* dstRow) noexcept
+    {
+        for (size_t x = 0; x < width; ++x)
+        {
+            Texel texel;
+            memcpy(&texel, srcRow + size_t(index[x]) * sizeof(Texel), sizeof(Texel));
+            memcpy(dstRow + x * sizeof(Texel), &texel, sizeof(Texel));
+        }
+    }
+
+    void CopyPointSamples(const Image& src, const Image& dst, const FilterTable& tx, const FilterTable& ty, size_t bpp) noexcept
+    {
+        ParallelFor(dst.height, ResampleBandRows, [&](size_t begin, size_t end) -> bool
+            {
+                for (size_t y = begin; y < end; ++y)
+                {
+                    const uint8_t* srcRow = src.pixels + src.rowPitch * ty.index[y];
+                    uint8_t* dstRow = dst.pixels + dst.rowPitch * y;
+                    if (bpp == 8)
+                        CopyPointRow<uint64_t>(srcRow, tx.index.get(), dst.width, dstRow);
+                    else
+                        CopyPointRow<uint32_t>(srcRow, tx.index.get(), dst.width, dstRow);
+                }
+                return true;
+            });
+    }
+}
+
+
+//=====================================================================================
+// Resampler
+//=====================================================================================
+
+_Use_decl_annotations_
+bool DirectX::Internal::BuildFilterTable(
+    RESAMPLE_KERNEL kernel,
+    size_t srcSize,
+    size_t dstSize,
+    bool wrap,
+    bool mirror,
+    FilterTable& table) noexcept
+{
+    table = {};
+    if (!srcSize || !dstSize || srcSize > UINT32_MAX)
+        return false;
+
+    const float scale = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+
+    // Minifying widens the kernel to cover the source; magnifying keeps it in source texels
+    const float kernelScale = (kernel == RESAMPLE_LINEAR || kernel == RESAMPLE_CUBIC) ? 1.f : std::max(scale, 1.f);
+    const float support = KernelRadius(kernel) * kernelScale;
+
+    switch (kernel)
+    {
+    case RESAMPLE_POINT:    table.taps = 1; break;
+    case RESAMPLE_LINEAR:   table.taps = 2; break;
+    case RESAMPLE_CUBIC:    table.taps = 4; break;
+    default:                table.taps = static_cast<size_t>(ceilf(support * 2.f)) + 1; break;
+    }
+
+    table.index.reset(new (std::nothrow) uint32_t[dstSize * table.taps]);
+    table.weight.reset(new (std::nothrow) float[dstSize * table.taps]);
+    if (!table.index || !table.weight)
+        return false;
+
+    for (size_t d = 0; d < dstSize; ++d)
+    {
+        const float center = (static_cast<float>(d) + 0.5f) * scale;
+        uint32_t* index = table.index.get() + d * table.taps;
+        float* weight = table.weight.get() + d * table.taps;
+
+        auto address = [&](ptrdiff_t i) noexcept
+        {
+            return static_cast<uint32_t>(AddressTexel(i, srcSize, wrap, mirror));
+        };
+
+        switch (kernel)
+        {
+        case RESAMPLE_POINT:
+            // 16.16 fixed point stepping, same texels as the POINT scanline filter
+            index[0] = static_cast<uint32_t>((uint64_t(d) * ((uint64_t(srcSize) << 16) / dstSize)) >> 16);
+            weight[0] = 1.f;
+            break;
+
+        case RESAMPLE_LINEAR:
+        case RESAMPLE_CUBIC:
+            {
+                // Interpolates between texel centers
+                const float pos = center - 0.5f;
+                const float first = floorf(pos);
+                const float x = pos - first;
+                const auto i = static_cast<ptrdiff_t>(first);
+
+                if (kernel == RESAMPLE_LINEAR)
+                {
+                    index[0] = address(i);
+                    index[1] = address(i + 1);
+                    weight[0] = 1.f - x;
+                    weight[1] = x;
+                }
+                else
+                {
+                    // Same polynomial as CUBIC_INTERPOLATE in filters.h, expanded into per-texel weights
+                    const float x2 = x * x;
+                    const float x3 = x2 * x;
+                    const float w0 = -x / 3.f + x2 / 2.f - x3 / 6.f;
+                    const float w2 = x + x2 / 2.f - x3 / 2.f;
+                    const float w3 = -x / 6.f + x3 / 6.f;
+
+                    for (size_t k = 0; k < 4; ++k)
+                        index[k] = address(i - 1 + static_cast<ptrdiff_t>(k));
+                    weight[0] = w0;
+                    weight[1] = 1.f - w0 - w2 - w3;
+                    weight[2] = w2;
+                    weight[3] = w3;
+                }
+            }
+            break;
+
+        default:
+            {
+                const auto first = static_cast<ptrdiff_t>(floorf(center - support));
+                float total = 0.f;
+                for (size_t k = 0; k < table.taps; ++k)
+                {
+                    const ptrdiff_t i = first + static_cast<ptrdiff_t>(k);
+                    index[k] = address(i);
+                    weight[k] = KernelWeight(kernel, (static_cast<float>(i) + 0.5f - center) / kernelScale);
+                    total += weight[k];
+                }
+
+                if (total > 0.f)
+                {
+                    for (size_t k = 0; k < table.taps; ++k)
+                        weight[k] /= total;
+                }
+                else
+                {
+                    for (size_t k = 0; k < table.taps; ++k)
+                        weight[k] = 0.f;
+                    weight[0] = 1.f;
+                    index[0] = address(static_cast<ptrdiff_t>(center));
+                }
+            }
+            break;
+        }
+    }
+
+    return true;
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Internal::ResampleImage(
+    const Image& src,
+    const Image& dst,
+    const FilterTable& tx,
+    const FilterTable& ty,
+    const TexelCodec& codec) noexcept
+{
+    if (!src.pixels || !dst.pixels)
+        return E_POINTER;
+
+    assert(src.format == dst.format);
+    assert(tx.taps > 0 && ty.taps > 0);
+
+    const size_t bpp = codec.bytesPerTexel;
+    const size_t stripCount = (dst.width + ResampleStripTexels - 1) / ResampleStripTexels;
+    const size_t bandCount = (dst.height + ResampleBandRows - 1) / ResampleBandRows;
+    const size_t stripWidth = std::min(dst.width, ResampleStripTexels);
+
+    // Horizontally filtered source rows are cached; neighbouring destination rows share most of them
+    const size_t slots = ty.taps + 2;
+
+    // Units run down a strip first, so a chunk of them keeps its cache between bands
+    const bool succeeded = ParallelFor(stripCount * bandCount, 1, [&](size_t begin, size_t end) -> bool
+        {
+            auto decoded = make_AlignedArrayXMVECTOR(src.width);
+            auto rows = make_AlignedArrayXMVECTOR(uint64_t(stripWidth) * uint64_t(slots));
+            auto sum = make_AlignedArrayXMVECTOR(stripWidth);
+            std::unique_ptr<size_t[]> rowTag(new (std::nothrow) size_t[slots * 2]);
+            if (!decoded || !rows || !sum || !rowTag)
+                return false;
+
+            size_t* rowAge = rowTag.get() + slots;
+            size_t clock = 0;
+            size_t cachedStrip = SIZE_MAX;
+
+            size_t x0 = 0;
+            size_t width = 0;
+            size_t lo = 0;
+            size_t hi = 0;
+
+            auto filteredRow = [&](size_t sy) noexcept -> const XMVECTOR*
+            {
+                size_t slot = 0;
+                for (size_t s = 0; s < slots; ++s)
+                {
+                    if (rowTag[s] == sy)
+                    {
+                        rowAge[s] = ++clock;
+                        return rows.get() + s * stripWidth;
+                    }
+                    if (rowAge[s] < rowAge[slot])
+                        slot = s;
+                }
+
+                DecodeRow(src.pixels + src.rowPitch * sy + lo * bpp, hi - lo + 1, codec, decoded.get());
+
+                XMVECTOR* out = rows.get() + slot * stripWidth;
+                for (size_t x = 0; x < width; ++x)
+                {
+                    const uint32_t* index = tx.index.get() + (x0 + x) * tx.taps;
+                    const float* weight = tx.weight.get() + (x0 + x) * tx.taps;
+                    XMVECTOR acc = XMVectorZero();
+                    for (size_t k = 0; k < tx.taps; ++k)
+                        acc = XMVectorMultiplyAdd(decoded[index[k] - lo], XMVectorReplicate(weight[k]), acc);
+                    out[x] = acc;
+                }
+
+                rowTag[slot] = sy;
+                rowAge[slot] = ++clock;
+                return out;
+            };
+
+            for (size_t unit = begin; unit < end; ++unit)
+            {
+                const size_t strip = unit / bandCount;
+                const size_t band = unit % bandCount;
+
+                if (strip != cachedStrip)
+                {
+                    cachedStrip = strip;
+                    x0 = strip * ResampleStripTexels;
+                    width = std::min(dst.width - x0, ResampleStripTexels);
+
+                    // Only the source columns the strip reads get decoded
+                    lo = SIZE_MAX;
+                    hi = 0;
+                    const uint32_t* index = tx.index.get() + x0 * tx.taps;
+                    for (size_t k = 0; k < width * tx.taps; ++k)
+                    {
+                        lo = std::min<size_t>(lo, index[k]);
+                        hi = std::max<size_t>(hi, index[k]);
+                    }
+
+                    for (size_t s = 0; s < slots; ++s)
+                    {
+                        rowTag[s] = SIZE_MAX;
+                        rowAge[s] = 0;
+                    }
+                }
+
+                const size_t y1 = std::min(dst.height, (band + 1) * ResampleBandRows);
+                for (size_t y = band * ResampleBandRows; y < y1; ++y)
+                {
+                    for (size_t x = 0; x < width; ++x)
+                        sum[x] = XMVectorZero();
+
+                    const uint32_t* index = ty.index.get() + y * ty.taps;
+                    const float* weight = ty.weight.get() + y * ty.taps;
+                    for (size_t k = 0; k < ty.taps; ++k)
+                    {
+                        if (weight[k] == 0.f)
+                            continue;
+
+                        const XMVECTOR* row = filteredRow(index[k]);
+                        const XMVECTOR w = XMVectorReplicate(weight[k]);
+                        for (size_t x = 0; x < width; ++x)
+                            sum[x] = XMVectorMultiplyAdd(row[x], w, sum[x]);
+                    }
+
+                    EncodeRow(sum.get(), width, codec, dst.pixels + dst.rowPitch * y + x0 * bpp);
+                }
+            }
+
+            return true;
+        });
+
+    return succeeded ? S_OK : E_OUTOFMEMORY;
+}
+
+
+//=====================================================================================
+// Entry-points
+//=====================================================================================
+
+_Use_decl_annotations_
+bool DirectX::Internal::CanResizeFast(DXGI_FORMAT format, TEX_FILTER_FLAGS filter) noexcept
+{
+    // Separate alpha filtering is left to the generic paths
+    if (filter & (TEX_FILTER_FORCE_WIC | TEX_FILTER_SEPARATE_ALPHA))
+        return false;
+
+    const bool srgbIn = (filter & TEX_FILTER_SRGB_IN) != 0;
+    const bool srgbOut = (filter & TEX_FILTER_SRGB_OUT) != 0;
+
+    TexelCodec codec;
+    if (!GetTexelCodec(format, srgbIn, srgbOut, codec))
+        return false;
+
+    switch (filter & TEX_FILTER_MODE_MASK)
+    {
+    case 0:
+    #ifdef _WIN32
+        // TEX_FILTER_DEFAULT keeps WIC's output unless the caller asked for the non-WIC filters
+        return (filter & TEX_FILTER_FORCE_NON_WIC) != 0;
+    #else
+        return true;
+    #endif
+
+    case TEX_FILTER_POINT:
+    case TEX_FILTER_BOX:
+    case TEX_FILTER_LINEAR:
+    case TEX_FILTER_CUBIC:
+    case TEX_FILTER_TRIANGLE:
+    case TEX_FILTER_KAISER:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+_Use_decl_annotations_
+HRESULT DirectX::Internal::ResizeFast(const Image& srcImage, TEX_FILTER_FLAGS filter, const Image& destImage) noexcept
+{
+    if (!srcImage.pixels || !destImage.pixels)
+        return E_POINTER;
+
+    if (srcImage.format != destImage.format)
+        return E_FAIL;
+
+    const bool srgbIn = IsSRGB(srcImage.format) || (filter & TEX_FILTER_SRGB_IN);
+    const bool srgbOut = IsSRGB(srcImage.format) || (filter & TEX_FILTER_SRGB_OUT);
+
+    TexelCodec codec;
+    if (!GetTexelCodec(srcImage.format, srgbIn, srgbOut, codec))
+        return HRESULT_E_NOT_SUPPORTED;
+
+    unsigned long filter_select = filter & TEX_FILTER_MODE_MASK;
+    if (!filter_select)
+    {
+        // Default filter choice, same as the custom filters
+        filter_select = (((destImage.width << 1) == srcImage.width) && ((destImage.height << 1) == srcImage.height))
+            ? TEX_FILTER_BOX : TEX_FILTER_LINEAR;
+    }
+
+    RESAMPLE_KERNEL kernel;
+    switch (filter_select)
+    {
+    case TEX_FILTER_POINT:      kernel = RESAMPLE_POINT; break;
+    case TEX_FILTER_BOX:        kernel = RESAMPLE_BOX; break;
+    case TEX_FILTER_LINEAR:     kernel = RESAMPLE_LINEAR; break;
+    case TEX_FILTER_CUBIC:      kernel = RESAMPLE_CUBIC; break;
+    case TEX_FILTER_TRIANGLE:   kernel = RESAMPLE_TRIANGLE; break;
+    case TEX_FILTER_KAISER:     kernel = RESAMPLE_KAISER; break;
+    default:                    return HRESULT_E_NOT_SUPPORTED;
+    }
+
+    FilterTable tx, ty;
+    if (!BuildFilterTable(kernel, srcImage.width, destImage.width,
+        (filter & TEX_FILTER_WRAP_U) != 0, (filter & TEX_FILTER_MIRROR_U) != 0, tx)
+        || !BuildFilterTable(kernel, srcImage.height, destImage.height,
+            (filter & TEX_FILTER_WRAP_V) != 0, (filter & TEX_FILTER_MIRROR_V) != 0, ty))
+        return E_OUTOFMEMORY;
+
+    // The X8 formats still go through the rows, which write their unused channel as opaque
+    if (kernel == RESAMPLE_POINT && srgbIn == srgbOut && HasAlpha(srcImage.format))
+    {
+        CopyPointSamples(srcImage, destImage, tx, ty, codec.bytesPerTexel);
+        return S_OK;
+    }
+
+    return ResampleImage(srcImage, destImage, tx, ty, codec);
+}
@@ -11,6 +11,8 @@
 
 #include "DirectXTexP.h"
 
+#include "bandstream.h"
+
 //
 // The implementation here has the following limitations:
 //      * Does not support files that contain color maps (these are rare in practice)
@@ -1435,6 +1437,76 @@ namespace
 
         return format;
     }
+
+    //-------------------------------------------------------------------------------------
+    // A packet may run on past the end of a scanline; what is left of it goes here
+    //-------------------------------------------------------------------------------------
+    struct RLECarry
+    {
+        size_t count;
+        bool repeat;
+        uint8_t pixel[4];
+    };
+
+    //-------------------------------------------------------------------------------------
+    // Reads the RLE packets of one scanline. A packet crossing the end of the scanline is
+    // split, so the scanline's packets can be uncompressed on their own
+    //-------------------------------------------------------------------------------------
+    HRESULT ReadRLEScanline(
+        BufferedFileReader& reader,
+        size_t width,
+        size_t bytesPerPixel,
+        RLECarry& carry,
+        _Out_writes_bytes_to_(width * (bytesPerPixel + 1), size) uint8_t* pDest,
+        size_t& size) noexcept
+    {
+        assert(bytesPerPixel <= sizeof(carry.pixel));
+
+        size = 0;
+        for (size_t x = 0; x < width; )
+        {
+            if (carry.count == 0)
+            {
+                uint8_t packet;
+                HRESULT hr = reader.ReadByte(packet);
+                if (FAILED(hr))
+                    return E_FAIL;
+
+                carry.count = size_t(packet & 0x7F) + 1;
+                carry.repeat = (packet & 0x80) != 0;
+
+                // Repeat packets carry one pixel, literal packets one per count
+                if (carry.repeat)
+                {
+                    hr = reader.Read(carry.pixel, bytesPerPixel);
+                    if (FAILED(hr))
+                        return E_FAIL;
+                }
+            }
+
+            const size_t count = std::min(carry.count, width - x);
+            pDest[size++] = static_cast<uint8_t>((count - 1) | (carry.repeat ? 0x80 : 0));
+
+            if (carry.repeat)
+            {
+                memcpy(pDest + size, carry.pixel, bytesPerPixel);
+                size += bytesPerPixel;
+            }
+            else
+            {
+                HRESULT hr = reader.Read(pDest + size, count * bytesPerPixel);
+                if (FAILED(hr))
+                    return E_FAIL;
+
+                size += count * bytesPerPixel;
+            }
+
+            carry.count -= count;
+            x += count;
+        }
+
+        return S_OK;
+    }
 }
 
 
@@ -2240,6 +2312,153 @@ HRESULT DirectX::LoadFromTGAFile(
 }
 
 
+//-------------------------------------------------------------------------------------
+// Load a TGA file from disk a band of scanlines at a time
+//-------------------------------------------------------------------------------------
+_Use_decl_annotations_
+HRESULT DirectX::LoadFromTGAFileBands(
+    const wchar_t* szFile,
+    TGA_FLAGS flags,
+    size_t bandHeight,
+    TexMetadata* metadata,
+    std::function<bool __cdecl(const Image&, size_t)> bandFunc)
+{
+    if (!szFile || !bandHeight || !bandFunc)
+        return E_INVALIDARG;
+
+    BufferedFileReader reader;
+    HRESULT hr = reader.Open(szFile);
+    if (FAILED(hr))
+        return hr;
+
+    const uint64_t len = reader.GetSize();
+
+    // Need at least enough data to fill the header to be a valid TGA
+    if (len < TGA_HEADER_LEN)
+    {
+        return E_FAIL;
+    }
+
+    // Read the header
+    uint8_t header[TGA_HEADER_LEN] = {};
+    hr = reader.Read(header, TGA_HEADER_LEN);
+    if (FAILED(hr))
+        return hr;
+
+    size_t offset;
+    uint32_t convFlags = 0;
+    TexMetadata mdata;
+    hr = DecodeTGAHeader(header, TGA_HEADER_LEN, flags, mdata, offset, &convFlags);
+    if (FAILED(hr))
+        return hr;
+
+    if (offset >= len)
+        return E_FAIL;
+
+    // The optional TGA 2.0 footer & extension area is needed before the first band
+    const TGA_EXTENSION* ext = nullptr;
+    TGA_EXTENSION extData = {};
+    if (len >= sizeof(TGA_FOOTER))
+    {
+        TGA_FOOTER footer = {};
+        hr = reader.Seek(len - sizeof(TGA_FOOTER));
+        if (SUCCEEDED(hr))
+            hr = reader.Read(&footer, sizeof(TGA_FOOTER));
+        if (FAILED(hr))
+            return hr;
+
+        if (memcmp(footer.Signature, g_Signature, sizeof(g_Signature)) == 0
+            && footer.dwExtensionOffset != 0
+            && ((footer.dwExtensionOffset + sizeof(TGA_EXTENSION)) <= len)
+            && SUCCEEDED(reader.Seek(footer.dwExtensionOffset))
+            && SUCCEEDED(reader.Read(&extData, sizeof(TGA_EXTENSION))))
+        {
+            ext = &extData;
+        }
+    }
+
+    // Scanlines are decoded in the format the loader uses; only the band format is sRGB
+    const DXGI_FORMAT decodeFormat = mdata.format;
+    if (!(flags & TGA_FLAGS_IGNORE_SRGB))
+    {
+        mdata.format = GetSRGBFromExtension(ext, mdata.format, flags, nullptr);
+    }
+
+    if (ext)
+    {
+        mdata.SetAlphaMode(GetAlphaModeFromExtension(ext));
+    }
+
+    hr = reader.Seek(offset);
+    if (FAILED(hr))
+        return hr;
+
+    uint8_t palette[256 * 4] = {};
+    if (convFlags & CONV_FLAGS_PALETTED)
+    {
+        uint8_t colorMap[256 * 3] = {};
+        auto const colorMapLen = static_cast<size_t>(std::min<uint64_t>(sizeof(colorMap), len - offset));
+        hr = reader.Read(colorMap, colorMapLen);
+        if (FAILED(hr))
+            return hr;
+
+        size_t paletteOffset = 0;
+        hr = ReadPalette(header, colorMap, colorMapLen, flags, palette, paletteOffset);
+        if (FAILED(hr))
+            return hr;
+
+        hr = reader.Seek(offset + paletteOffset);
+        if (FAILED(hr))
+            return hr;
+    }
+
+    if (metadata)
+        memcpy(metadata, &mdata, sizeof(TexMetadata));
+
+    auto pHeader = reinterpret_cast<const TGA_HEADER*>(header);
+    const size_t bytesPerPixel = (size_t(pHeader->bBitsPerPixel) + 7) >> 3;
+    const size_t width = mdata.width;
+
+    std::unique_ptr<uint8_t[]> scanline(new (std::nothrow) uint8_t[width * (bytesPerPixel + 1)]);
+    if (!scanline)
+        return E_OUTOFMEMORY;
+
+    // Whole-image alpha fixups don't apply to a single scanline
+    const auto rowFlags = static_cast<TGA_FLAGS>(flags | TGA_FLAGS_ALLOW_ALL_ZERO_ALPHA);
+    const bool bottomUp = !(convFlags & CONV_FLAGS_INVERTY);
+    RLECarry carry = {};
+
+    return StreamBands(mdata, bandHeight, bottomUp, [&](const Image& band) noexcept -> HRESULT
+        {
+            for (size_t row = 0; row < band.height; ++row)
+            {
+                const size_t y = bottomUp ? (band.height - row - 1) : row;
+                const Image dest = { width, 1, decodeFormat, band.rowPitch, band.rowPitch, band.pixels + band.rowPitch * y };
+
+                HRESULT hrRow;
+                if (convFlags & CONV_FLAGS_RLE)
+                {
+                    size_t size;
+                    hrRow = ReadRLEScanline(reader, width, bytesPerPixel, carry, scanline.get(), size);
+                    if (SUCCEEDED(hrRow))
+                        hrRow = UncompressPixels(scanline.get(), size, rowFlags, &dest, convFlags);
+                }
+                else
+                {
+                    const size_t size = width * bytesPerPixel;
+                    hrRow = reader.Read(scanline.get(), size);
+                    if (SUCCEEDED(hrRow))
+                        hrRow = CopyPixels(scanline.get(), size, rowFlags, &dest, convFlags, palette);
+                }
+
+                if (FAILED(hrRow))
+                    return hrRow;
+            }
+            return S_OK;
+        }, bandFunc);
+}
+
+
 //-------------------------------------------------------------------------------------
 // Save a TGA file to memory
 //-------------------------------------------------------------------------------------
@@ -2559,6 +2778,16 @@ namespace DirectX
         return LoadFromTGAFile(reinterpret_cast<const unsigned short*>(szFile), flags, metadata, image);
     }
 
+    HRESULT __cdecl LoadFromTGAFileBands(
+        _In_z_ const __wchar_t* szFile,
+        _In_ TGA_FLAGS flags,
+        _In_ size_t bandHeight,
+        _Out_opt_ TexMetadata* metadata,
+        _In_ std::function<bool __cdecl(const Image&, size_t)> bandFunc)
+    {
+        return LoadFromTGAFileBands(reinterpret_cast<const unsigned short*>(szFile), flags, bandHeight, metadata, bandFunc);
+    }
+
     HRESULT __cdecl SaveToTGAFile(_In_ const Image& image,
         _In_ TGA_FLAGS flags,
         _In_z_ const __wchar_t* szFile,
@@ -0,0 +1,379 @@
+//-------------------------------------------------------------------------------------
+// bandstream.h
+//
+// Utility header for the band-at-a-time file loaders (LoadFromHDRFileBands,
+// LoadFromTGAFileBands): a buffered sequential file reader, and a two-buffer pipeline
+// that decodes the next band on a helper thread while the caller consumes the current one.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifndef _WIN32
+#include <filesystem>
+#include <fstream>
+#endif
+
+#include "threading.h"
+
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        //---------------------------------------------------------------------------------
+        // Sequential file reads through a fixed-size buffer; files over 4 GB are fine
+        //---------------------------------------------------------------------------------
+        class BufferedFileReader
+        {
+        public:
+            static constexpr size_t BufferSize = 64 * 1024;
+
+            BufferedFileReader() noexcept : m_pos(0), m_end(0), m_size(0), m_bufferOffset(0) {}
+
+            BufferedFileReader(const BufferedFileReader&) = delete;
+            BufferedFileReader& operator=(const BufferedFileReader&) = delete;
+
+            HRESULT Open(_In_z_ const wchar_t* szFile) noexcept
+            {
+                m_buffer.reset(new (std::nothrow) uint8_t[BufferSize]);
+                if (!m_buffer)
+                    return E_OUTOFMEMORY;
+
+            #ifdef _WIN32
+            #if (_WIN32_WINNT >= _WIN32_WINNT_WIN8)
+                CREATEFILE2_EXTENDED_PARAMETERS params = {};
+                params.dwSize = sizeof(CREATEFILE2_EXTENDED_PARAMETERS);
+                params.dwFileAttributes = FILE_ATTRIBUTE_NORMAL;
+                params.dwFileFlags = FILE_FLAG_SEQUENTIAL_SCAN;
+                m_hFile.reset(safe_handle(CreateFile2(szFile, GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &params)));
+            #else
+                m_hFile.reset(safe_handle(CreateFileW(szFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                    FILE_FLAG_SEQUENTIAL_SCAN, nullptr)));
+            #endif
+                if (!m_hFile)
+                    return HRESULT_FROM_WIN32(GetLastError());
+
+                FILE_STANDARD_INFO fileInfo;
+                if (!GetFileInformationByHandleEx(m_hFile.get(), FileStandardInfo, &fileInfo, sizeof(fileInfo)))
+                    return HRESULT_FROM_WIN32(GetLastError());
+
+                m_size = static_cast<uint64_t>(fileInfo.EndOfFile.QuadPart);
+            #else
+                m_file.open(std::filesystem::path(szFile), std::ios::in | std::ios::binary | std::ios::ate);
+                if (!m_file)
+                    return E_FAIL;
+
+                const std::streampos fileLen = m_file.tellg();
+                if (!m_file)
+                    return E_FAIL;
+
+                m_size = static_cast<uint64_t>(fileLen);
+            #endif
+
+                return Seek(0);
+            }
+
+            uint64_t GetSize() const noexcept { return m_size; }
+
+            HRESULT Seek(uint64_t offset) noexcept
+            {
+                if (offset > m_size)
+                    return HRESULT_E_HANDLE_EOF;
+
+            #ifdef _WIN32
+                LARGE_INTEGER filePos;
+                filePos.QuadPart = static_cast<LONGLONG>(offset);
+                if (!SetFilePointerEx(m_hFile.get(), filePos, nullptr, FILE_BEGIN))
+                    return HRESULT_FROM_WIN32(GetLastError());
+            #else
+                m_file.clear();
+                m_file.seekg(static_cast<std::streamoff>(offset), std::ios::beg);
+                if (!m_file)
+                    return E_FAIL;
+            #endif
+
+                m_bufferOffset = offset;
+                m_pos = m_end = 0;
+                return S_OK;
+            }
+
+            HRESULT Read(_Out_writes_bytes_(count) void* pDest, size_t count) noexcept
+            {
+                auto dptr = static_cast<uint8_t*>(pDest);
+
+                const size_t buffered = std::min(count, m_end - m_pos);
+                memcpy(dptr, m_buffer.get() + m_pos, buffered);
+                m_pos += buffered;
+                dptr += buffered;
+                count -= buffered;
+
+                if (!count)
+                    return S_OK;
+
+                if (count >= BufferSize)
+                {
+                    // Large reads skip the buffer
+                    m_bufferOffset += m_end;
+                    m_pos = m_end = 0;
+
+                    HRESULT hr = ReadFromFile(dptr, count);
+                    if (FAILED(hr))
+                        return hr;
+
+                    m_bufferOffset += count;
+                    return S_OK;
+                }
+
+                HRESULT hr = Fill();
+                if (FAILED(hr))
+                    return hr;
+
+                if (m_end < count)
+                    return HRESULT_E_HANDLE_EOF;
+
+                memcpy(dptr, m_buffer.get(), count);
+                m_pos = count;
+                return S_OK;
+            }
+
+            HRESULT ReadByte(uint8_t& value) noexcept
+            {
+                if (m_pos == m_end)
+                {
+                    HRESULT hr = Fill();
+                    if (FAILED(hr))
+                        return hr;
+
+                    if (!m_end)
+                        return HRESULT_E_HANDLE_EOF;
+                }
+
+                value = m_buffer[m_pos++];
+                return S_OK;
+            }
+
+        private:
+            HRESULT Fill() noexcept
+            {
+                m_bufferOffset += m_end;
+                m_pos = m_end = 0;
+
+                const uint64_t remaining = m_size - std::min(m_bufferOffset, m_size);
+                const size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, BufferSize));
+                if (!count)
+                    return S_OK;
+
+                HRESULT hr = ReadFromFile(m_buffer.get(), count);
+                if (FAILED(hr))
+                    return hr;
+
+                m_end = count;
+                return S_OK;
+            }
+
+            HRESULT ReadFromFile(_Out_writes_bytes_(count) uint8_t* pDest, size_t count) noexcept
+            {
+                if (count > m_size - std::min(m_bufferOffset, m_size))
+                    return HRESULT_E_HANDLE_EOF;
+
+            #ifdef _WIN32
+                while (count > 0)
+                {
+                    const auto chunk = static_cast<DWORD>(std::min<size_t>(count, UINT32_MAX));
+                    DWORD bytesRead = 0;
+                    if (!ReadFile(m_hFile.get(), pDest, chunk, &bytesRead, nullptr))
+                        return HRESULT_FROM_WIN32(GetLastError());
+
+                    if (bytesRead != chunk)
+                        return E_FAIL;
+
+                    pDest += chunk;
+                    count -= chunk;
+                }
+            #else
+                m_file.read(reinterpret_cast<char*>(pDest), static_cast<std::streamsize>(count));
+                if (!m_file)
+                    return E_FAIL;
+            #endif
+
+                return S_OK;
+            }
+
+        #ifdef _WIN32
+            ScopedHandle m_hFile;
+        #else
+            std::ifstream m_file;
+        #endif
+            std::unique_ptr<uint8_t[]> m_buffer;
+            size_t m_pos;
+            size_t m_end;
+            uint64_t m_size;
+            uint64_t m_bufferOffset;    // file offset of m_buffer[0]
+        };
+
+        //---------------------------------------------------------------------------------
+        // Decodes an image band by band into two band buffers. decodeBand(band) fills the
+        // rows of the next band in file order, from the bottom row up if bottomUp is set.
+        // It runs on a helper thread one band ahead of bandFunc, which gets each band and
+        // the image row its top row lands on. bandFunc returning false stops with E_ABORT.
+        template<typename Fn>
+        HRESULT StreamBands(
+            const TexMetadata& metadata,
+            size_t bandHeight,
+            bool bottomUp,
+            Fn&& decodeBand,
+            const std::function<bool __cdecl(const Image&, size_t)>& bandFunc)
+        {
+            const size_t height = metadata.height;
+            if (!height || !bandHeight)
+                return E_INVALIDARG;
+
+            bandHeight = std::min(bandHeight, height);
+            const size_t bandCount = (height + bandHeight - 1) / bandHeight;
+
+            ScratchImage buffers[2];
+            for (size_t i = 0; i < std::min<size_t>(bandCount, 2); ++i)
+            {
+                HRESULT hr = buffers[i].Initialize2D(metadata.format, metadata.width, bandHeight, 1, 1, CP_FLAGS_LIMIT_4GB);
+                if (FAILED(hr))
+                    return hr;
+            }
+
+            auto getBand = [&](size_t band, size_t& y) noexcept -> Image
+            {
+                Image img = *buffers[band & 1].GetImage(0, 0, 0);
+                const size_t first = band * bandHeight;
+                img.height = std::min(bandHeight, height - first);
+                img.slicePitch = img.rowPitch * img.height;
+                y = bottomUp ? (height - first - img.height) : first;
+                return img;
+            };
+
+            std::mutex mutex;
+            std::condition_variable cv;
+            size_t decoded = 0;     // bands ready for bandFunc
+            size_t consumed = 0;    // bands whose buffer is free again
+            HRESULT decodeResult = S_OK;
+            bool cancel = false;
+
+            auto producer = [&]() noexcept
+            {
+                for (size_t band = 0; band < bandCount; ++band)
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex);
+                        cv.wait(lock, [&]() { return cancel || band < consumed + 2; });
+                        if (cancel)
+                            return;
+                    }
+
+                    size_t y;
+                    const HRESULT hr = decodeBand(getBand(band, y));
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (FAILED(hr))
+                            decodeResult = hr;
+                        else
+                            decoded = band + 1;
+                    }
+                    cv.notify_all();
+
+                    if (FAILED(hr))
+                        return;
+                }
+            };
+
+            std::thread worker;
+            if (bandCount > 1 && GetWorkerThreadCount() > 1)
+            {
+                try
+                {
+                    worker = std::thread(producer);
+                }
+                catch (...)
+                {
+                    // No thread to spare: decode on the calling thread below
+                }
+            }
+
+            if (!worker.joinable())
+            {
+                for (size_t band = 0; band < bandCount; ++band)
+                {
+                    size_t y;
+                    const Image img = getBand(band, y);
+
+                    HRESULT hr = decodeBand(img);
+                    if (FAILED(hr))
+                        return hr;
+
+                    if (!bandFunc(img, y))
+                        return E_ABORT;
+                }
+
+                return S_OK;
+            }
+
+            auto stop = [&]() noexcept
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    cancel = true;
+                }
+                cv.notify_all();
+                worker.join();
+            };
+
+            for (size_t band = 0; band < bandCount; ++band)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [&]() { return decoded > band || FAILED(decodeResult); });
+                    if (decoded <= band)
+                    {
+                        lock.unlock();
+                        stop();
+                        return decodeResult;
+                    }
+                }
+
+                size_t y;
+                const Image img = getBand(band, y);
+
+                bool keepGoing = false;
+                try
+                {
+                    keepGoing = bandFunc(img, y);
+                }
+                catch (...)
+                {
+                    stop();
+                    throw;
+                }
+
+                if (!keepGoing)
+                {
+                    stop();
+                    return E_ABORT;
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    consumed = band + 1;
+                }
+                cv.notify_all();
+            }
+
+            worker.join();
+            return S_OK;
+        }
+    }
+}
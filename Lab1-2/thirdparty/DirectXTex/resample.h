@@ -0,0 +1,198 @@
+//-------------------------------------------------------------------------------------
+// resample.h
+//
+// Utility header for the separable resampler shared by the fast resize and mipmap
+// paths (DirectXTexResizeFast.cpp, DirectXTexMipmapsFast.cpp). Pixels are filtered
+// straight from 8-bit RGBA/BGRA or 16-bit RGBA UNORM rows through weight tables.
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        //---------------------------------------------------------------------------------
+        // 8-bit <-> linear float conversion tables
+        //---------------------------------------------------------------------------------
+        constexpr size_t SRGBEncodeSteps = 65536;
+
+        struct ColorTables
+        {
+            float unorm[256];
+            float srgbToLinear[256];
+            float opaque[256];              // alpha of the X8 formats: whatever is stored reads as 1
+            uint8_t linearToSRGB[SRGBEncodeSteps];
+        };
+
+        inline const ColorTables& GetColorTables() noexcept
+        {
+            static const ColorTables* s_tables = []() noexcept
+            {
+                static ColorTables tables;
+                for (size_t i = 0; i < 256; ++i)
+                {
+                    const float v = static_cast<float>(i) / 255.f;
+                    tables.unorm[i] = v;
+                    tables.srgbToLinear[i] = (v <= 0.04045f) ? v / 12.92f : powf((v + 0.055f) / 1.055f, 2.4f);
+                    tables.opaque[i] = 1.f;
+                }
+
+                for (size_t i = 0; i < SRGBEncodeSteps; ++i)
+                {
+                    const float v = static_cast<float>(i) / static_cast<float>(SRGBEncodeSteps - 1);
+                    const float s = (v <= 0.0031308f) ? v * 12.92f : 1.055f * powf(v, 1.f / 2.4f) - 0.055f;
+                    tables.linearToSRGB[i] = static_cast<uint8_t>(std::min(std::max(s * 255.f + 0.5f, 0.f), 255.f));
+                }
+                return &tables;
+            }();
+
+            return *s_tables;
+        }
+
+        struct TexelCodec
+        {
+            size_t bytesPerTexel;   // 4 - 8-bit RGBA/BGRA, 8 - R16G16B16A16_UNORM (stored as is)
+            const float* rgbIn;     // byte -> linear for the color channels
+            const float* alphaIn;
+            const uint8_t* rgbOut;  // 16-bit linear -> sRGB byte, nullptr to store UNORM
+        };
+
+        // Returns false for formats the resampler can't read and write directly
+        inline bool GetTexelCodec(DXGI_FORMAT format, bool srgbIn, bool srgbOut, TexelCodec& codec) noexcept
+        {
+            switch (format)
+            {
+            case DXGI_FORMAT_R8G8B8A8_UNORM:
+            case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8A8_UNORM:
+            case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+            case DXGI_FORMAT_B8G8R8X8_UNORM:
+            case DXGI_FORMAT_B8G8R8X8_UNORM_SRGB:
+                {
+                    const ColorTables& tables = GetColorTables();
+                    codec.bytesPerTexel = 4;
+                    codec.rgbIn = srgbIn ? tables.srgbToLinear : tables.unorm;
+                    codec.alphaIn = (format == DXGI_FORMAT_B8G8R8X8_UNORM || format == DXGI_FORMAT_B8G8R8X8_UNORM_SRGB)
+                        ? tables.opaque : tables.unorm;
+                    codec.rgbOut = srgbOut ? tables.linearToSRGB : nullptr;
+                }
+                return true;
+
+            case DXGI_FORMAT_R16G16B16A16_UNORM:
+                if (srgbIn || srgbOut)
+                    return false;
+
+                codec = {};
+                codec.bytesPerTexel = 8;
+                return true;
+
+            default:
+                return false;
+            }
+        }
+
+        inline XMVECTOR XM_CALLCONV DecodeTexel(uint32_t texel, const TexelCodec& codec) noexcept
+        {
+            return XMVectorSet(
+                codec.rgbIn[texel & 0xFF],
+                codec.rgbIn[(texel >> 8) & 0xFF],
+                codec.rgbIn[(texel >> 16) & 0xFF],
+                codec.alphaIn[texel >> 24]);
+        }
+
+        inline uint32_t XM_CALLCONV EncodeTexel(FXMVECTOR v, const TexelCodec& codec) noexcept
+        {
+            using namespace DirectX::PackedVector;
+
+            // XMStoreUByteN4 truncates, so the half-LSB bias StoreScanline adds rounds here too
+            XMUBYTEN4 unorm;
+            XMStoreUByteN4(&unorm, XMVectorAdd(v, XMVectorReplicate(0.5f / 255.f)));
+            if (!codec.rgbOut)
+                return unorm.v;
+
+            XMUSHORTN4 linear;
+            XMStoreUShortN4(&linear, v);
+            return uint32_t(codec.rgbOut[linear.x])
+                | (uint32_t(codec.rgbOut[linear.y]) << 8)
+                | (uint32_t(codec.rgbOut[linear.z]) << 16)
+                | (unorm.v & 0xFF000000);
+        }
+
+        inline void DecodeRow(
+            _In_reads_bytes_(count * codec.bytesPerTexel) const uint8_t* pSource,
+            size_t count,
+            const TexelCodec& codec,
+            _Out_writes_(count) XMVECTOR* pDest) noexcept
+        {
+            if (codec.bytesPerTexel == 8)
+            {
+                auto sptr = reinterpret_cast<const PackedVector::XMUSHORTN4*>(pSource);
+                for (size_t i = 0; i < count; ++i)
+                    pDest[i] = PackedVector::XMLoadUShortN4(sptr + i);
+            }
+            else
+            {
+                auto sptr = reinterpret_cast<const uint32_t*>(pSource);
+                for (size_t i = 0; i < count; ++i)
+                    pDest[i] = DecodeTexel(sptr[i], codec);
+            }
+        }
+
+        inline void EncodeRow(
+            _In_reads_(count) const XMVECTOR* pSource,
+            size_t count,
+            const TexelCodec& codec,
+            _Out_writes_bytes_(count * codec.bytesPerTexel) uint8_t* pDest) noexcept
+        {
+            if (codec.bytesPerTexel == 8)
+            {
+                auto dptr = reinterpret_cast<PackedVector::XMUSHORTN4*>(pDest);
+                for (size_t i = 0; i < count; ++i)
+                    PackedVector::XMStoreUShortN4(dptr + i, pSource[i]);
+            }
+            else
+            {
+                auto dptr = reinterpret_cast<uint32_t*>(pDest);
+                for (size_t i = 0; i < count; ++i)
+                    dptr[i] = EncodeTexel(pSource[i], codec);
+            }
+        }
+
+        //---------------------------------------------------------------------------------
+        // Per-axis weight tables
+        //---------------------------------------------------------------------------------
+        enum RESAMPLE_KERNEL : uint32_t
+        {
+            RESAMPLE_POINT = 0,     // nearest texel
+            RESAMPLE_BOX,           // average of the covered texels
+            RESAMPLE_LINEAR,        // 2-tap tent, same as the LINEAR scanline filter
+            RESAMPLE_CUBIC,         // 4-tap cubic interpolation, same as the CUBIC scanline filter
+            RESAMPLE_TRIANGLE,      // tent widened to the minification ratio
+            RESAMPLE_KAISER,        // Kaiser-windowed sinc, 3 lobes
+        };
+
+        struct FilterTable
+        {
+            size_t taps;                            // per destination texel
+            std::unique_ptr<uint32_t[]> index;      // source texel, address mode applied
+            std::unique_ptr<float[]> weight;        // normalized
+        };
+
+        bool BuildFilterTable(RESAMPLE_KERNEL kernel, size_t srcSize, size_t dstSize, bool wrap, bool mirror,
+            _Out_ FilterTable& table) noexcept;
+
+        // Filters src into dst (same format) on the worker threads
+        HRESULT ResampleImage(_In_ const Image& src, _In_ const Image& dst,
+            _In_ const FilterTable& tx, _In_ const FilterTable& ty, _In_ const TexelCodec& codec) noexcept;
+    }
+}
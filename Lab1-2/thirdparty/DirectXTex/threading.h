@@ -0,0 +1,88 @@
+//-------------------------------------------------------------------------------------
+// threading.h
+//
+// Utility header with a minimal std::thread based parallel loop, used by the
+// TEX_*_PARALLEL code paths so they don't depend on OpenMP
+//-------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace DirectX
+{
+    namespace Internal
+    {
+        inline size_t GetWorkerThreadCount() noexcept
+        {
+            const unsigned int hw = std::thread::hardware_concurrency();
+            return (hw > 0) ? size_t(hw) : 1u;
+        }
+
+        //---------------------------------------------------------------------------------
+        // Calls func(begin, end) over [0, count) split into chunks of at least 'grain' items.
+        // The calling thread works too. A chunk returning false stops the chunks not yet started.
+        // Returns false if any chunk returned false.
+        // Threads are started per call, so 'grain' should be worth more than starting one:
+        // when count fits in a single grain the loop runs inline and no thread is created.
+        template<typename Fn>
+        bool ParallelFor(size_t count, size_t grain, Fn&& func, size_t maxThreads = 0) noexcept
+        {
+            if (!count)
+                return true;
+
+            grain = std::max<size_t>(grain, 1);
+            if (count <= grain || maxThreads == 1)
+                return func(size_t(0), count);
+            size_t threads = (maxThreads > 0) ? maxThreads : GetWorkerThreadCount();
+
+            // A few chunks per thread keeps the load balanced when blocks differ in cost
+            size_t chunks = std::min<size_t>((count + grain - 1) / grain, threads * 4);
+            const size_t chunkSize = (count + chunks - 1) / chunks;
+            chunks = (count + chunkSize - 1) / chunkSize;
+            threads = std::min<size_t>(threads, chunks);
+
+            std::atomic<size_t> next(0);
+            std::atomic<bool> failed(false);
+
+            auto worker = [&]()
+            {
+                size_t chunk;
+                while (!failed.load(std::memory_order_relaxed)
+                    && (chunk = next.fetch_add(1, std::memory_order_relaxed)) < chunks)
+                {
+                    const size_t begin = chunk * chunkSize;
+                    const size_t end = std::min<size_t>(begin + chunkSize, count);
+                    if (!func(begin, end))
+                        failed = true;
+                }
+            };
+
+            std::vector<std::thread> pool;
+            if (threads > 1)
+            {
+                try
+                {
+                    pool.reserve(threads - 1);
+                    for (size_t i = 1; i < threads; ++i)
+                        pool.emplace_back(worker);
+                }
+                catch (...)
+                {
+                    // Out of threads: whatever was started plus this thread finish the job
+                }
+            }
+
+            worker();
+
+            for (auto& t : pool)
+                t.join();
+
+            return !failed;
+        }
+    }
+}